@@ -0,0 +1,116 @@
+#include <stdlib.h>
+#include "arena.h"
+
+/*****************************************************************************
+* NAME:  arena_init
+* DESCRIPTION: Initialize an empty arena
+* RETURNS: none
+******************************************************************************/
+void
+arena_init
+    (arena_t       *arena       /* [out] arena */
+    ,size_t         block_size  /* [in] minimum size of each block */
+    )
+{
+    arena->p_first = NULL;
+    arena->p_current = NULL;
+    arena->block_size = block_size;
+}
+
+/*****************************************************************************
+* NAME:  arena_alloc
+* DESCRIPTION: Allocate size bytes, aligned to ARENA_ALIGNMENT, from the arena
+* RETURNS: pointer to uninitialized memory, or NULL if memory is exhausted
+******************************************************************************/
+void *
+arena_alloc
+    (arena_t       *arena       /* [in,out] arena */
+    ,size_t         size        /* [in] number of bytes to allocate */
+    )
+{
+    arena_block_t  *block = arena->p_current;
+    arena_block_t  *p_new;
+    size_t          new_size;
+
+    size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+
+    /* use the current block, or a later one kept from before a reset */
+    while (block != NULL && block->size - block->used < size)
+    {
+        block = block->p_next;
+        if (block != NULL)
+        {
+            block->used = 0;
+        }
+    }
+
+    if (block == NULL)
+    {
+        new_size = (size > arena->block_size) ? size : arena->block_size;
+        p_new = malloc(sizeof(arena_block_t) + new_size);
+        if (p_new == NULL)
+        {
+            return NULL;
+        }
+        p_new->size = new_size;
+        p_new->used = 0;
+
+        /* insert after the current block so kept blocks stay in the chain */
+        if (arena->p_current == NULL)
+        {
+            p_new->p_next = arena->p_first;
+            arena->p_first = p_new;
+        }
+        else
+        {
+            p_new->p_next = arena->p_current->p_next;
+            arena->p_current->p_next = p_new;
+        }
+        block = p_new;
+    }
+
+    arena->p_current = block;
+    block->used += size;
+
+    return block->data + block->used - size;
+}
+
+/*****************************************************************************
+* NAME:  arena_reset
+* DESCRIPTION: Release every allocation at once while keeping the blocks
+* RETURNS: none
+******************************************************************************/
+void
+arena_reset
+    (arena_t       *arena       /* [in,out] arena */
+    )
+{
+    arena->p_current = arena->p_first;
+    if (arena->p_first != NULL)
+    {
+        arena->p_first->used = 0;
+    }
+}
+
+/*****************************************************************************
+* NAME:  arena_free
+* DESCRIPTION: Return all blocks held by the arena to the system
+* RETURNS: none
+******************************************************************************/
+void
+arena_free
+    (arena_t       *arena       /* [in,out] arena */
+    )
+{
+    arena_block_t  *block = arena->p_first;
+    arena_block_t  *p_next;
+
+    while (block != NULL)
+    {
+        p_next = block->p_next;
+        free(block);
+        block = p_next;
+    }
+
+    arena_init(arena, arena->block_size);
+}
@@ -0,0 +1,74 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+/* Includes */
+#include <stddef.h>
+
+/* Defines and constants */
+#define ARENA_DEFAULT_BLOCK_SIZE    (64 * 1024)     /* bytes per arena block unless an allocation needs more */
+#define ARENA_ALIGNMENT             (16)            /* alignment of every arena allocation */
+
+/* Enums and structs */
+/* Structure describing one block of arena memory */
+typedef struct arena_block_s {
+    struct arena_block_s   *p_next;     /* next block in the chain, or NULL */
+    size_t                  size;       /* number of usable bytes in data */
+    size_t                  used;       /* number of bytes handed out */
+    _Alignas(ARENA_ALIGNMENT) char data[];  /* allocation space */
+} arena_block_t;
+
+/* Structure describing a bump allocator for the variable-length parts of
+   one file's objects. Nothing is freed individually: the whole arena is
+   reset before the next file, keeping its blocks for reuse, so a batch
+   worker's memory tracks the largest header it has seen. */
+typedef struct {
+    arena_block_t  *p_first;            /* first block in the chain */
+    arena_block_t  *p_current;          /* block currently being allocated from */
+    size_t          block_size;         /* minimum size of a new block */
+} arena_t;
+
+/* Function prototypes */
+/*****************************************************************************
+* NAME:  arena_init
+* DESCRIPTION: Initialize an empty arena; no memory is allocated until the
+*              first call to arena_alloc
+* RETURNS: none
+******************************************************************************/
+void
+arena_init
+    (arena_t       *arena       /* [out] arena */
+    ,size_t         block_size  /* [in] minimum size of each block */
+    );
+
+/*****************************************************************************
+* NAME:  arena_alloc
+* DESCRIPTION: Allocate size bytes, aligned to ARENA_ALIGNMENT, from the arena
+* RETURNS: pointer to uninitialized memory, or NULL if memory is exhausted
+******************************************************************************/
+void *
+arena_alloc
+    (arena_t       *arena       /* [in,out] arena */
+    ,size_t         size        /* [in] number of bytes to allocate */
+    );
+
+/*****************************************************************************
+* NAME:  arena_reset
+* DESCRIPTION: Release every allocation at once while keeping the blocks
+* RETURNS: none
+******************************************************************************/
+void
+arena_reset
+    (arena_t       *arena       /* [in,out] arena */
+    );
+
+/*****************************************************************************
+* NAME:  arena_free
+* DESCRIPTION: Return all blocks held by the arena to the system
+* RETURNS: none
+******************************************************************************/
+void
+arena_free
+    (arena_t       *arena       /* [in,out] arena */
+    );
+
+#endif
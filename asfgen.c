@@ -0,0 +1,710 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "util.h"
+#include "guid.h"
+#include "output.h"
+
+/* Defines and constants */
+#define MAX_STREAMS             (127)               /* stream number field is 7 bits wide */
+#define MAX_VALUE_CHARS         (32766)             /* UTF-16 characters that fit a 16-bit value length with the NUL */
+#define MIN_PACKET_SIZE         (64)                /* room for the packet and payload headers */
+#define MAX_PACKET_SIZE         (65535)
+#define PACKET_HEADER_SIZE      (13)                /* error correction, flags, padding length, send time, duration */
+#define PAYLOAD_HEADER_SIZE     (15)                /* stream, media object, offset, replicated data (8 bytes) */
+#define PACKET_DURATION         (10)                /* milliseconds of media per data packet */
+#define PREROLL                 (3000)              /* milliseconds */
+#define INDEX_INTERVAL          (10000000)          /* 100-nanosecond units between simple index entries */
+#define FLUSH_SIZE              (1024 * 1024)       /* bytes buffered before each write to the output file */
+#define DEFAULT_NUM_PACKETS     (1000)
+#define FILE_SIZE_OFFSET        (70)                /* file offset of the file size field of the file properties object */
+#define DATA_PREFIX_LENGTH      (50)                /* data object fields before the first data packet */
+#define SIMPLE_INDEX_PREFIX_LENGTH  (56)            /* simple index object fields before its entries */
+
+/* Enums and structs */
+/* Structure describing the file to generate */
+typedef struct {
+    const char         *p_filename;         /* name of file to write */
+    int                 num_streams;        /* streams, alternately audio and video */
+    int                 num_codecs;         /* codec list entries */
+    int                 num_descriptors;    /* extended content descriptors */
+    int                 value_chars;        /* UTF-16 characters in each string descriptor value */
+    int                 extension_size;     /* bytes of data in the header extension object */
+    int                 packet_size;        /* fixed data packet size */
+    unsigned long long  num_packets;        /* data packets in the data object */
+    int                 write_index;        /* non-zero to write a simple index object */
+    unsigned long long  seed;               /* seed of the content generator */
+} gen_params_t;
+
+/*****************************************************************************
+* NAME:  next_random
+* DESCRIPTION: Advance the xorshift64 generator that fills names, values and
+*              payloads, so the same parameters always give the same file
+* RETURNS: unsigned long long
+******************************************************************************/
+static unsigned long long
+next_random
+    (unsigned long long    *state       /* [in,out] generator state, never 0 */
+    )
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+
+    return *state;
+}
+
+/*****************************************************************************
+* NAME:  write_uint
+* DESCRIPTION: Append a little-endian unsigned integer
+* RETURNS: none
+******************************************************************************/
+static void
+write_uint
+    (output_t              *out         /* [in,out] buffer receiving the file */
+    ,unsigned long long     value       /* [in] value to write */
+    ,int                    num_bytes   /* [in] width of the integer in bytes */
+    )
+{
+    char   *p = output_reserve(out, (size_t)num_bytes);
+    int     i;
+
+    for (i = 0; i < num_bytes; i++)
+    {
+        p[i] = (char)(value >> (8 * i));
+    }
+    out->length += (size_t)num_bytes;
+}
+
+/*****************************************************************************
+* NAME:  write_zeros
+* DESCRIPTION: Append zero bytes
+* RETURNS: none
+******************************************************************************/
+static void
+write_zeros
+    (output_t      *out         /* [in,out] buffer receiving the file */
+    ,size_t         num_bytes   /* [in] number of bytes */
+    )
+{
+    memset(output_reserve(out, num_bytes), 0, num_bytes);
+    out->length += num_bytes;
+}
+
+/*****************************************************************************
+* NAME:  write_utf16
+* DESCRIPTION: Append a NUL-terminated UTF-16LE string of num_chars
+*              characters taken from an ASCII prefix followed by generated
+*              text mixing ASCII, Latin and CJK characters
+* RETURNS: number of bytes written, including the NUL
+******************************************************************************/
+static size_t
+write_utf16
+    (output_t              *out         /* [in,out] buffer receiving the file */
+    ,const char            *p_prefix    /* [in] ASCII text to start with */
+    ,int                    num_chars   /* [in] number of characters, at least strlen(p_prefix) */
+    ,unsigned long long    *state       /* [in,out] generator state */
+    )
+{
+    static const unsigned int  NON_ASCII[] = { 0x00e9, 0x00fc, 0x00df, 0x0416, 0x65e5, 0x672c };
+    unsigned long long          r;
+    unsigned int                unit;
+    int                         i;
+
+    for (i = 0; i < num_chars; i++)
+    {
+        if (p_prefix[0] != '\0')
+        {
+            unit = (unsigned char)*p_prefix++;
+        }
+        else
+        {
+            /* mostly lower-case words, with an occasional accented or CJK
+               character so the transcoder leaves its ASCII fast path */
+            r = next_random(state);
+            if ((r & 0x3f) == 0)
+            {
+                unit = NON_ASCII[(r >> 8) % (sizeof(NON_ASCII) / sizeof(NON_ASCII[0]))];
+            }
+            else if ((r & 0x7) == 1)
+            {
+                unit = ' ';
+            }
+            else
+            {
+                unit = 'a' + (unsigned int)((r >> 8) % 26);
+            }
+        }
+        write_uint(out, unit, 2);
+    }
+    write_uint(out, 0, 2);
+
+    return (size_t)(num_chars + 1) * 2;
+}
+
+/*****************************************************************************
+* NAME:  patch_uint
+* DESCRIPTION: Overwrite a little-endian unsigned integer already in the
+*              buffer
+* RETURNS: none
+******************************************************************************/
+static void
+patch_uint
+    (output_t              *out         /* [in,out] buffer receiving the file */
+    ,size_t                 offset      /* [in] buffer offset of the integer */
+    ,unsigned long long     value       /* [in] value to write */
+    ,int                    num_bytes   /* [in] width of the integer in bytes */
+    )
+{
+    int     i;
+
+    for (i = 0; i < num_bytes; i++)
+    {
+        out->p_data[offset + (size_t)i] = (char)(value >> (8 * i));
+    }
+}
+
+/*****************************************************************************
+* NAME:  begin_object
+* DESCRIPTION: Append an object's GUID and a placeholder for its size
+* RETURNS: buffer offset of the object, for end_object
+******************************************************************************/
+static size_t
+begin_object
+    (output_t      *out         /* [in,out] buffer receiving the file */
+    ,const char    *guid        /* [in] object's GUID */
+    )
+{
+    size_t  start = out->length;
+
+    output_write(out, guid, GUID_LENGTH_IN_BYTES);
+    write_uint(out, 0, 8);
+
+    return start;
+}
+
+/*****************************************************************************
+* NAME:  end_object
+* DESCRIPTION: Fill in the size of an object that ends at the end of the
+*              buffer
+* RETURNS: none
+******************************************************************************/
+static void
+end_object
+    (output_t      *out         /* [in,out] buffer receiving the file */
+    ,size_t         start       /* [in] value returned by begin_object */
+    )
+{
+    patch_uint(out, start + GUID_LENGTH_IN_BYTES, out->length - start, 8);
+}
+
+/*****************************************************************************
+* NAME:  write_header
+* DESCRIPTION: Append the Header Object and the objects it contains
+* RETURNS: none
+******************************************************************************/
+static void
+write_header
+    (output_t              *out         /* [in,out] buffer receiving the file */
+    ,const gen_params_t    *params      /* [in] file to generate */
+    ,const char            *file_id     /* [in] file id shared with the data and index objects */
+    ,unsigned long long    *state       /* [in,out] generator state */
+    )
+{
+    unsigned long long  duration = params->num_packets * PACKET_DURATION * 10000ULL;
+    unsigned long long  r;
+    unsigned int        bitrate = (unsigned int)((unsigned long long)params->packet_size * 8 * 1000 / PACKET_DURATION);
+    size_t              header_start;
+    size_t              start;
+    size_t              value_start;
+    char                name[32];
+    int                 is_video;
+    int                 i;
+
+    header_start = begin_object(out, ASF_HEADER_OBJECT_GUID);
+    write_uint(out, 5 + (unsigned long long)params->num_streams, 4);
+    write_uint(out, 1, 1);
+    write_uint(out, 2, 1);
+
+    /* file properties object; the file size is patched in by the caller */
+    start = begin_object(out, ASF_FILE_PROPERTIES_OBJECT_GUID);
+    output_write(out, file_id, GUID_LENGTH_IN_BYTES);
+    write_uint(out, 0, 8);
+    write_uint(out, 0, 8);
+    write_uint(out, params->num_packets, 8);
+    write_uint(out, duration + PREROLL * 10000ULL, 8);
+    write_uint(out, duration, 8);
+    write_uint(out, PREROLL, 8);
+    write_uint(out, 0x2, 4);
+    write_uint(out, (unsigned long long)params->packet_size, 4);
+    write_uint(out, (unsigned long long)params->packet_size, 4);
+    write_uint(out, bitrate, 4);
+    end_object(out, start);
+
+    /* stream properties objects with minimal WAVEFORMATEX and video
+       format data */
+    for (i = 1; i <= params->num_streams; i++)
+    {
+        is_video = (i % 2 == 0);
+        start = begin_object(out, ASF_STREAM_PROPERTIES_OBJECT_GUID);
+        output_write(out, is_video ? ASF_VIDEO_MEDIA_GUID : ASF_AUDIO_MEDIA_GUID, GUID_LENGTH_IN_BYTES);
+        output_write(out, ASF_NO_ERROR_CORRECTION_GUID, GUID_LENGTH_IN_BYTES);
+        write_uint(out, 0, 8);
+        write_uint(out, is_video ? 51 : 18, 4);
+        write_uint(out, 0, 4);
+        write_uint(out, (unsigned long long)i, 2);
+        write_uint(out, 0, 4);
+        if (is_video)
+        {
+            write_uint(out, 640, 4);
+            write_uint(out, 480, 4);
+            write_uint(out, 2, 1);
+            write_uint(out, 40, 2);
+            write_uint(out, 40, 4);
+            write_uint(out, 640, 4);
+            write_uint(out, 480, 4);
+            write_uint(out, 1, 2);
+            write_uint(out, 24, 2);
+            output_write(out, "WMV3", 4);
+            write_zeros(out, 20);
+        }
+        else
+        {
+            write_uint(out, 0x161, 2);
+            write_uint(out, 2, 2);
+            write_uint(out, 44100, 4);
+            write_uint(out, 6000, 4);
+            write_uint(out, 2229, 2);
+            write_uint(out, 16, 2);
+            write_uint(out, 0, 2);
+        }
+        end_object(out, start);
+    }
+
+    /* header extension object holding a padding object of the requested
+       size, since its data is a sequence of objects */
+    start = begin_object(out, ASF_HEADER_EXTENSION_OBJECT_GUID);
+    output_write(out, ASF_RESERVED_1_GUID, GUID_LENGTH_IN_BYTES);
+    write_uint(out, 6, 2);
+    write_uint(out, (unsigned long long)params->extension_size, 4);
+    if (params->extension_size > 0)
+    {
+        value_start = begin_object(out, ASF_PADDING_OBJECT_GUID);
+        write_zeros(out, (size_t)params->extension_size - (GUID_LENGTH_IN_BYTES + 8));
+        end_object(out, value_start);
+    }
+    end_object(out, start);
+
+    /* codec list object */
+    start = begin_object(out, ASF_CODEC_LIST_OBJECT_GUID);
+    output_write(out, ASF_RESERVED_2_GUID, GUID_LENGTH_IN_BYTES);
+    write_uint(out, (unsigned long long)params->num_codecs, 4);
+    for (i = 0; i < params->num_codecs; i++)
+    {
+        is_video = (i % 2 == 1);
+        snprintf(name, sizeof(name), is_video ? "Video Codec %d" : "Audio Codec %d", i);
+        write_uint(out, is_video ? 1 : 2, 2);
+        write_uint(out, strlen(name) + 1, 2);
+        write_utf16(out, name, (int)strlen(name), state);
+        write_uint(out, 33, 2);
+        write_utf16(out, "", 32, state);
+        write_uint(out, is_video ? 4 : 2, 2);
+        output_write(out, is_video ? "WMV3" : "\x61\x01", is_video ? 4 : 2);
+    }
+    end_object(out, start);
+
+    /* extended content description object cycling through every value
+       data type */
+    start = begin_object(out, ASF_EXTENDED_CONTENT_DESCRIPTION_OBJECT_GUID);
+    write_uint(out, (unsigned long long)params->num_descriptors, 2);
+    for (i = 0; i < params->num_descriptors; i++)
+    {
+        snprintf(name, sizeof(name), "WM/Generated%d", i);
+        write_uint(out, (strlen(name) + 1) * 2, 2);
+        write_utf16(out, name, (int)strlen(name), state);
+        write_uint(out, (unsigned long long)(i % 6), 2);
+
+        /* the value length is filled in once the value is written */
+        value_start = out->length;
+        write_uint(out, 0, 2);
+        r = next_random(state);
+        switch (i % 6)
+        {
+        case 0:
+            write_utf16(out, "", params->value_chars, state);
+            break;
+        case 1:
+            for (r = 0; r < (unsigned long long)params->value_chars; r++)
+            {
+                write_uint(out, next_random(state), 1);
+            }
+            break;
+        case 2:
+            write_uint(out, r & 1, 4);
+            break;
+        case 3:
+            write_uint(out, r, 4);
+            break;
+        case 4:
+            write_uint(out, r, 8);
+            break;
+        default:
+            write_uint(out, r, 2);
+            break;
+        }
+        patch_uint(out, value_start, out->length - value_start - 2, 2);
+    }
+    end_object(out, start);
+
+    /* stream bitrate properties object */
+    start = begin_object(out, ASF_STREAM_BITRATE_PROPERTIES_OBJECT_GUID);
+    write_uint(out, (unsigned long long)params->num_streams, 2);
+    for (i = 1; i <= params->num_streams; i++)
+    {
+        write_uint(out, (unsigned long long)i, 2);
+        write_uint(out, bitrate / (unsigned int)params->num_streams, 4);
+    }
+    end_object(out, start);
+
+    end_object(out, header_start);
+}
+
+/*****************************************************************************
+* NAME:  write_packet
+* DESCRIPTION: Append one data packet holding a single payload that is a
+*              whole media object of one stream
+* RETURNS: none
+******************************************************************************/
+static void
+write_packet
+    (output_t              *out         /* [in,out] buffer receiving the file */
+    ,const gen_params_t    *params      /* [in] file to generate */
+    ,unsigned long long     number      /* [in] packet number */
+    ,unsigned int          *media_object    /* [in,out] next media object number of each stream */
+    ,unsigned long long    *state       /* [in,out] generator state */
+    )
+{
+    unsigned int        stream = (unsigned int)(number % (unsigned long long)params->num_streams) + 1;
+    unsigned int        send_time = (unsigned int)(number * PACKET_DURATION);
+    unsigned int        payload_size = (unsigned int)params->packet_size - PACKET_HEADER_SIZE - PAYLOAD_HEADER_SIZE;
+    unsigned long long  r;
+    unsigned int        i;
+    char               *p;
+    int                 is_key_frame;
+
+    /* every audio object is independent; video has a key frame every 8 */
+    is_key_frame = (stream % 2 == 1) || (media_object[stream] % 8 == 0);
+
+    /* error correction data, length type flags (WORD padding length),
+       property flags (BYTE replicated data length, DWORD offset, BYTE
+       media object number and stream number) */
+    write_uint(out, 0x82, 1);
+    write_uint(out, 0, 2);
+    write_uint(out, 0x10, 1);
+    write_uint(out, 0x5d, 1);
+    write_uint(out, 0, 2);
+    write_uint(out, send_time, 4);
+    write_uint(out, PACKET_DURATION, 2);
+
+    /* payload header with replicated data (media object size and
+       presentation time) */
+    write_uint(out, stream | (is_key_frame ? 0x80u : 0u), 1);
+    write_uint(out, media_object[stream]++ & 0xff, 1);
+    write_uint(out, 0, 4);
+    write_uint(out, 8, 1);
+    write_uint(out, payload_size, 4);
+    write_uint(out, send_time + PREROLL, 4);
+
+    /* payload data */
+    p = output_reserve(out, payload_size + 8);
+    for (i = 0; i < payload_size; i += 8)
+    {
+        r = next_random(state);
+        memcpy(p + i, &r, 8);
+    }
+    out->length += payload_size;
+}
+
+/*****************************************************************************
+* NAME:  write_simple_index
+* DESCRIPTION: Append a Simple Index Object with an entry every second
+* RETURNS: none
+******************************************************************************/
+static void
+write_simple_index
+    (output_t              *out         /* [in,out] buffer receiving the file */
+    ,const gen_params_t    *params      /* [in] file to generate */
+    ,const char            *file_id     /* [in] file id shared with the header */
+    )
+{
+    unsigned long long  duration_ms = params->num_packets * PACKET_DURATION;
+    unsigned long long  num_entries = duration_ms / 1000 + 1;
+    unsigned long long  packet;
+    unsigned long long  i;
+    size_t              start;
+
+    start = begin_object(out, ASF_SIMPLE_INDEX_OBJECT_GUID);
+    output_write(out, file_id, GUID_LENGTH_IN_BYTES);
+    write_uint(out, INDEX_INTERVAL, 8);
+    write_uint(out, 1, 4);
+    write_uint(out, num_entries, 4);
+    for (i = 0; i < num_entries; i++)
+    {
+        packet = i * 1000 / PACKET_DURATION;
+        if (packet >= params->num_packets)
+        {
+            packet = params->num_packets ? params->num_packets - 1 : 0;
+        }
+        write_uint(out, packet, 4);
+        write_uint(out, 1, 2);
+    }
+    end_object(out, start);
+}
+
+/*****************************************************************************
+* NAME:  parse_size
+* DESCRIPTION: Convert a byte count with an optional K, M or G suffix
+* RETURNS: number of bytes, or 0 if the text is not a valid size
+******************************************************************************/
+static unsigned long long
+parse_size
+    (const char    *p_text      /* [in] size such as 4096, 64K or 20G */
+    )
+{
+    unsigned long long  value;
+    char               *p_end;
+
+    value = strtoull(p_text, &p_end, 10);
+    switch (*p_end)
+    {
+    case 'G':
+    case 'g':
+        value <<= 10;
+        /* fall through */
+    case 'M':
+    case 'm':
+        value <<= 10;
+        /* fall through */
+    case 'K':
+    case 'k':
+        value <<= 10;
+        p_end++;
+        break;
+    default:
+        break;
+    }
+
+    return (*p_end == '\0') ? value : 0;
+}
+
+/*****************************************************************************
+* NAME:  show_usage
+* DESCRIPTION: Display usage to command line
+* RETURNS: none
+******************************************************************************/
+static void
+show_usage
+    (
+    )
+{
+    printf("Usage: asfgen [options] <outputfile>\n");
+    printf("Writes a synthetic ASF file; the same options always give the same bytes.\n");
+    printf("Options:\n");
+    printf("    -s <streams>    number of streams, alternately audio and video (default: 2, max: 127)\n");
+    printf("    -c <count>      number of codec list entries (default: 2)\n");
+    printf("    -d <count>      number of extended content descriptors (default: 6, max: 65535)\n");
+    printf("    -v <chars>      UTF-16 characters in string and byte descriptor values (default: 32)\n");
+    printf("    -x <bytes>      data size of the header extension object (default: 0, else >= 24)\n");
+    printf("    -P <bytes>      data packet size (default: 3200, min: 64, max: 65535)\n");
+    printf("    -n <packets>    number of data packets (default: 1000)\n");
+    printf("    -D <size>       size of the data packets instead of -n, with optional K, M or G suffix\n");
+    printf("    -i              write a simple index object after the data object\n");
+    printf("    -S <seed>       seed of the generated names, values and payloads (default: 1)\n");
+}
+
+/*****************************************************************************
+* NAME:  parse_gen_command_line
+* DESCRIPTION: Parse command-line input
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+parse_gen_command_line
+    (int            argc        /* [in] number of command line arguments */
+    ,char          *p_argv[]    /* [in] array of command line arguments */
+    ,gen_params_t  *params      /* [out] file to generate */
+    )
+{
+    unsigned long long  data_size = 0;
+    int                 option;
+
+    /* set defaults */
+    memset(params, 0, sizeof(gen_params_t));
+    params->num_streams = 2;
+    params->num_codecs = 2;
+    params->num_descriptors = 6;
+    params->value_chars = 32;
+    params->packet_size = 3200;
+    params->num_packets = DEFAULT_NUM_PACKETS;
+    params->seed = 1;
+
+    while ((option = getopt(argc, p_argv, "s:c:d:v:x:P:n:D:iS:")) != -1)
+    {
+        switch (option)
+        {
+        case 's':
+            params->num_streams = atoi(optarg);
+            break;
+        case 'c':
+            params->num_codecs = atoi(optarg);
+            break;
+        case 'd':
+            params->num_descriptors = atoi(optarg);
+            break;
+        case 'v':
+            params->value_chars = atoi(optarg);
+            break;
+        case 'x':
+            params->extension_size = atoi(optarg);
+            break;
+        case 'P':
+            params->packet_size = atoi(optarg);
+            break;
+        case 'n':
+            params->num_packets = strtoull(optarg, NULL, 10);
+            break;
+        case 'D':
+            data_size = parse_size(optarg);
+            if (data_size == 0)
+            {
+                show_usage();
+                return ASFPARSE_ERROR_INVALID_ARG;
+            }
+            break;
+        case 'i':
+            params->write_index = 1;
+            break;
+        case 'S':
+            params->seed = strtoull(optarg, NULL, 0);
+            break;
+        default:
+            show_usage();
+            return ASFPARSE_ERROR_INVALID_ARG;
+        }
+    }
+
+    if (params->num_streams < 1 || params->num_streams > MAX_STREAMS
+        || params->num_codecs < 0
+        || params->num_descriptors < 0 || params->num_descriptors > 65535
+        || params->value_chars < 0 || params->value_chars > MAX_VALUE_CHARS
+        || params->extension_size < 0
+        || (params->extension_size > 0 && params->extension_size < GUID_LENGTH_IN_BYTES + 8)
+        || params->packet_size < MIN_PACKET_SIZE || params->packet_size > MAX_PACKET_SIZE
+        || optind != argc - 1)
+    {
+        show_usage();
+        return ASFPARSE_ERROR_INVALID_ARG;
+    }
+    if (data_size != 0)
+    {
+        params->num_packets = data_size / (unsigned long long)params->packet_size;
+    }
+    if (params->seed == 0)
+    {
+        params->seed = 1;
+    }
+    params->p_filename = p_argv[optind];
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME: main
+* DESCRIPTION: Entry point to application
+******************************************************************************/
+int
+main
+    (int argc
+    ,char* argv[]
+    )
+{
+    asfparse_error_t    error;
+    gen_params_t        params;
+    output_t            out;
+    unsigned long long  state;
+    unsigned long long  data_size;
+    unsigned long long  file_size;
+    unsigned long long  i;
+    unsigned int        media_object[MAX_STREAMS + 1];
+    char                file_id[GUID_LENGTH_IN_BYTES];
+    int                 fd;
+
+    error = parse_gen_command_line(argc, argv, &params);
+    if (error != ASFPARSE_ERROR_OK)
+    {
+        return error;
+    }
+
+    fd = open(params.p_filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        printf("Error opening output file: %s\n", strerror(errno));
+        return ASFPARSE_ERROR_OPEN_FILE;
+    }
+
+    state = params.seed;
+    for (i = 0; i < GUID_LENGTH_IN_BYTES; i++)
+    {
+        file_id[i] = (char)next_random(&state);
+    }
+    memset(media_object, 0, sizeof(media_object));
+    output_init(&out);
+
+    /* the header is built in memory so object sizes can be filled in */
+    write_header(&out, &params, file_id, &state);
+    data_size = DATA_PREFIX_LENGTH + params.num_packets * (unsigned long long)params.packet_size;
+    file_size = out.length + data_size;
+    if (params.write_index)
+    {
+        file_size += SIMPLE_INDEX_PREFIX_LENGTH + (params.num_packets * PACKET_DURATION / 1000 + 1) * 6;
+    }
+    patch_uint(&out, FILE_SIZE_OFFSET, file_size, 8);
+
+    /* the data packets are streamed to the file, so the data object size is
+       worked out up front */
+    output_write(&out, ASF_DATA_OBJECT_GUID, GUID_LENGTH_IN_BYTES);
+    write_uint(&out, data_size, 8);
+    output_write(&out, file_id, GUID_LENGTH_IN_BYTES);
+    write_uint(&out, params.num_packets, 8);
+    write_uint(&out, 0x0101, 2);
+
+    for (i = 0; i < params.num_packets && error == ASFPARSE_ERROR_OK; i++)
+    {
+        write_packet(&out, &params, i, media_object, &state);
+        if (out.length >= FLUSH_SIZE && output_flush(&out, fd) != 0)
+        {
+            error = ASFPARSE_ERROR_OPEN_FILE;
+        }
+    }
+
+    if (params.write_index)
+    {
+        write_simple_index(&out, &params, file_id);
+    }
+    if (error == ASFPARSE_ERROR_OK && output_flush(&out, fd) != 0)
+    {
+        error = ASFPARSE_ERROR_OPEN_FILE;
+    }
+    if (close(fd) != 0 || error != ASFPARSE_ERROR_OK)
+    {
+        printf("Error writing output file\n");
+        error = ASFPARSE_ERROR_OPEN_FILE;
+    }
+
+    output_free(&out);
+
+    return error;
+}
@@ -0,0 +1,1359 @@
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "cursor.h"
+#include "guid.h"
+#include "parse.h"
+#include "packet.h"
+#include "scan.h"
+#include "arena.h"
+#include "instrument.h"
+#include "asfparse.h"
+
+/* Defines and constants */
+#define OBJECT_PREFIX_LENGTH        (GUID_LENGTH_IN_BYTES + 8)  /* object id and object size */
+#define HEADER_PREFIX_LENGTH        (30)                /* Header Object fields before the objects it contains */
+#define DATA_PREFIX_LENGTH          (50)                /* Data Object fields before the first data packet */
+#define PUSH_MAX_UNIT_SIZE          (64 * 1024 * 1024)  /* largest object or data packet the push parser will buffer */
+#define PUSH_UNBOUNDED_SIZE         ((size_t)LLONG_MAX) /* packet bytes of a Data Object of unknown size */
+
+/* Enum describing what the push parser is waiting for */
+typedef enum {
+     PUSH_STATE_IDLE = 0        /* asfparse_push_begin has not been called */
+    ,PUSH_STATE_HEADER_PREFIX   /* start of the Header Object, giving its size */
+    ,PUSH_STATE_HEADER          /* the whole Header Object */
+    ,PUSH_STATE_DATA_PREFIX     /* Data Object fields before the first packet */
+    ,PUSH_STATE_PACKET          /* the next fixed-size data packet */
+    ,PUSH_STATE_OBJECT_PREFIX   /* id and size of a top-level object after the Data Object */
+    ,PUSH_STATE_OBJECT          /* the whole of an index object */
+    ,PUSH_STATE_DONE            /* nothing more is wanted from the stream */
+} push_state_t;
+
+/* Structure describing one call to asfparse_parse_buffer, or one complete
+   unit of a pushed stream */
+typedef struct {
+    const char             *p_data;         /* first byte of the file contents or of the unit */
+    size_t                  size;           /* number of bytes in p_data */
+    long long               base_offset;    /* stream offset of p_data */
+    asfparse_callback_t     callback;       /* function receiving parse events */
+    void                   *p_user;         /* pointer passed through to the callback */
+    int                     stopped;        /* non-zero once the callback asked to stop */
+} parse_run_t;
+
+/* Structure describing a stream fed to the parser in pieces. The parser
+   waits for one unit (an object prefix, an object or a data packet) at a
+   time; only a unit split across feeds is copied, into p_buffer. */
+typedef struct {
+    push_state_t                state;
+    asfparse_error_t            error;              /* first error; sticky until asfparse_push_begin */
+    parse_run_t                 run;
+    long long                   offset;             /* stream offset of the unit being assembled */
+    size_t                      need;               /* size of the unit being assembled */
+    size_t                      skip;               /* bytes to discard before the next unit */
+    char                       *p_buffer;           /* bytes of a unit split across feeds */
+    size_t                      length;             /* number of bytes in p_buffer */
+    size_t                      capacity;           /* allocated size of p_buffer */
+    header_object_t             header;
+    file_properties_object_t    file_properties;
+    data_object_t               data;
+    long long                   data_end;           /* stream offset after the Data Object, or -1 if unknown */
+    unsigned int                packet_size;
+    long long                   packet_number;      /* number of packets reported so far */
+    long long                   num_packets;        /* number of packets in the Data Object */
+    packet_summary_t            summary;            /* payload counts of the packets, if summarised */
+} push_parser_t;
+
+/* Structure describing a parser context */
+struct asfparse_ctx_s {
+    asfparse_options_t  options;        /* what to parse and report */
+    arena_t             arena;          /* variable-length object data of the current file */
+    push_parser_t       push;           /* state of the stream being pushed, if any */
+};
+
+/*****************************************************************************
+* NAME:  report_object
+* DESCRIPTION: Pass an object or packet event to the caller's callback
+* RETURNS: non-zero if the callback asked to stop parsing
+******************************************************************************/
+static int
+report_object
+    (parse_run_t           *run         /* [in,out] current parse */
+    ,asfparse_event_kind_t  kind        /* [in] kind of event */
+    ,object_type_t          type        /* [in] type of the object */
+    ,size_t                 offset      /* [in] offset of the object or packet within run->p_data */
+    ,long long              number      /* [in] object size, or packet number for packet events */
+    ,const void            *object      /* [in] parsed struct */
+    )
+{
+    asfparse_event_t    event;
+
+    memset(&event, 0, sizeof(asfparse_event_t));
+    event.kind = kind;
+    event.type = type;
+    event.offset = run->base_offset + (long long)offset;
+    event.packet_number = -1;
+    event.object = object;
+    if (kind == ASFPARSE_EVENT_DATA_PACKET
+        || kind == ASFPARSE_EVENT_DATA_END
+        || kind == ASFPARSE_EVENT_PACKET_SUMMARY)
+    {
+        event.packet_number = number;
+    }
+    else
+    {
+        event.guid = run->p_data + offset;
+        event.object_size = number;
+    }
+
+    if (run->callback(run->p_user, &event) != 0)
+    {
+        run->stopped = 1;
+    }
+
+    return run->stopped;
+}
+
+/*****************************************************************************
+* NAME:  report_error
+* DESCRIPTION: Pass an error event to the caller's callback
+* RETURNS: the error passed in
+******************************************************************************/
+static asfparse_error_t
+report_error
+    (parse_run_t           *run             /* [in] current parse */
+    ,object_type_t          type            /* [in] object being parsed, or OBJECT_TYPE_NONE */
+    ,asfparse_error_t       error           /* [in] error */
+    ,size_t                 offset          /* [in] offset of the object or packet within run->p_data */
+    ,long long              packet_number   /* [in] number of the bad data packet, or -1 */
+    )
+{
+    asfparse_event_t    event;
+
+    memset(&event, 0, sizeof(asfparse_event_t));
+    event.kind = ASFPARSE_EVENT_ERROR;
+    event.type = type;
+    event.error = error;
+    event.offset = run->base_offset + (long long)offset;
+    event.packet_number = packet_number;
+
+    (void)run->callback(run->p_user, &event);
+
+    return error;
+}
+
+/*****************************************************************************
+* NAME:  parse_header_objects
+* DESCRIPTION: Parse the Header Object and the requested objects it contains,
+*              stopping once every requested object has been found
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+parse_header_objects
+    (asfparse_ctx_t            *ctx             /* [in,out] parser context */
+    ,parse_run_t               *run             /* [in,out] current parse */
+    ,header_object_t           *header          /* [out] struct containing info about header object */
+    ,file_properties_object_t  *file_properties /* [out] struct containing info about file properties object */
+    )
+{
+    asfparse_error_t    error;
+    const char         *object_id;
+    const void         *object;
+    int                 i;
+    cursor_t            cur;
+    cursor_t            peek;
+    size_t              object_start;
+    long long           object_size;
+    object_type_t       object_type = OBJECT_TYPE_NONE;
+    unsigned int        parse_mask;
+    unsigned int        found_mask = 0;
+
+    /* declare structs needed for parsing the header */
+    stream_properties_object_t              stream_properties;
+    header_extension_object_t               header_extension;
+    codec_list_object_t                     codec_list;
+    extended_content_description_object_t   ext_content_descr;
+    stream_bitrate_properties_object_t      stream_bitrate_properties;
+    INSTRUMENT_DECLARE(start);
+
+    /* work out which header objects to parse: those requested, plus the
+       file properties needed to walk the data packets. Stream properties
+       objects can repeat, so asking for them means reading the whole header. */
+    parse_mask = ctx->options.object_mask ? ctx->options.object_mask : ~0u;
+    if (ctx->options.parse_packets || ctx->options.parse_index)
+    {
+        parse_mask |= OBJECT_MASK(OBJECT_TYPE_FILE_PROPERTIES);
+    }
+
+    cursor_init(&cur, run->p_data, run->size);
+
+    /* parse header object */
+    INSTRUMENT_START(start);
+    error = parse_header_object(header, &cur);
+    INSTRUMENT_STOP(INSTRUMENT_PARSE(OBJECT_TYPE_HEADER), start, HEADER_PREFIX_LENGTH);
+    if (error)
+    {
+        return report_error(run, OBJECT_TYPE_HEADER, error, 0, -1);
+    }
+    if (report_object(run, ASFPARSE_EVENT_OBJECT, OBJECT_TYPE_HEADER, 0, header->object_size, header))
+    {
+        return ASFPARSE_ERROR_OK;
+    }
+
+    /* parse the objects it contains */
+    for (i = 0; i < header->num_objects; i++)
+    {
+        /* read object id and size from file to get object type and
+           the offset of the next object */
+        object_start = cur.pos;
+        object_id = cursor_read_bytes(&cur, GUID_LENGTH_IN_BYTES);
+        peek = cur;
+        object_size = cursor_read_uint64(&peek);
+        if (object_id == NULL || peek.overrun)
+        {
+            return report_error(run, OBJECT_TYPE_NONE, ASFPARSE_ERROR_TRUNCATED_OBJECT, object_start, -1);
+        }
+        if (object_size < GUID_LENGTH_IN_BYTES + 8)
+        {
+            return report_error(run, OBJECT_TYPE_NONE, ASFPARSE_ERROR_INVALID_ASF_FILE, object_start, -1);
+        }
+        object_type = OBJECT_TYPE_NONE;
+        object = NULL;
+
+        /* skip objects of unknown type and objects that were not requested
+           using their size, without reading their contents */
+        if (get_object_type(object_id, &object_type) != ASFPARSE_ERROR_OK)
+        {
+            report_object(run, ASFPARSE_EVENT_UNKNOWN_OBJECT, OBJECT_TYPE_NONE, object_start, object_size, NULL);
+        }
+        else if (parse_mask & OBJECT_MASK(object_type))
+        {
+            INSTRUMENT_START(start);
+            switch (object_type)
+            {
+            case OBJECT_TYPE_FILE_PROPERTIES:
+                error = parse_file_properties_object(file_properties, &cur);
+                object = file_properties;
+                break;
+            case OBJECT_TYPE_STREAM_PROPERTIES:
+                error = parse_stream_properties_object(&stream_properties, &cur);
+                object = &stream_properties;
+                break;
+            case OBJECT_TYPE_HEADER_EXTENSION:
+                error = parse_header_extension_object(&header_extension, &cur);
+                object = &header_extension;
+                break;
+            case OBJECT_TYPE_CODEC_LIST:
+                error = parse_codec_list_object(&codec_list, &cur, &ctx->arena);
+                object = &codec_list;
+                break;
+            case OBJECT_TYPE_EXTENDED_CONTENT_DESCRIPTION:
+                error = parse_extended_content_description_object(&ext_content_descr, &cur, &ctx->arena);
+                object = &ext_content_descr;
+                break;
+            case OBJECT_TYPE_STREAM_BITRATE_PROPERTIES:
+                error = parse_stream_bitrate_properties_object(&stream_bitrate_properties, &cur);
+                object = &stream_bitrate_properties;
+                break;
+            case OBJECT_TYPE_NONE:
+            case OBJECT_TYPE_HEADER:
+            default:
+                break;
+            }
+            INSTRUMENT_STOP(INSTRUMENT_PARSE(object_type), start, object_size);
+
+            if (error)
+            {
+                return report_error(run, object_type, error, object_start, -1);
+            }
+            if (object != NULL)
+            {
+                report_object(run, ASFPARSE_EVENT_OBJECT, object_type, object_start, object_size, object);
+            }
+        }
+        if (run->stopped)
+        {
+            break;
+        }
+
+        /* continue with the next object even if a parser consumed less than
+           the declared object size */
+        cursor_seek(&cur, object_start + object_size);
+
+        /* stop reading the header once every requested object was seen */
+        if (object != NULL && object_type != OBJECT_TYPE_STREAM_PROPERTIES)
+        {
+            found_mask |= OBJECT_MASK(object_type);
+        }
+        if ((parse_mask & ~found_mask & HEADER_OBJECTS_MASK) == 0)
+        {
+            break;
+        }
+    }
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  find_data_object
+* DESCRIPTION: Parse the Data Object that immediately follows the Header
+*              Object
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+find_data_object
+    (parse_run_t           *run         /* [in,out] current parse */
+    ,const header_object_t *header      /* [in] struct containing info about header object */
+    ,data_object_t         *data        /* [out] struct containing info about data object */
+    )
+{
+    asfparse_error_t    error;
+    const char         *object_id;
+    cursor_t            cur;
+    INSTRUMENT_DECLARE(start);
+
+    memset(data, 0, sizeof(data_object_t));
+
+    cursor_init(&cur, run->p_data, run->size);
+    cursor_seek(&cur, (size_t)header->object_size);
+    object_id = cursor_read_bytes(&cur, GUID_LENGTH_IN_BYTES);
+    if (object_id == NULL || !guid_equal(object_id, ASF_DATA_OBJECT_GUID))
+    {
+        return report_error(run, OBJECT_TYPE_DATA, ASFPARSE_ERROR_OBJECT_NOT_FOUND, (size_t)header->object_size, -1);
+    }
+
+    INSTRUMENT_START(start);
+    error = parse_data_object(data, &cur);
+    INSTRUMENT_STOP(INSTRUMENT_PARSE(OBJECT_TYPE_DATA), start, DATA_PREFIX_LENGTH);
+    if (error)
+    {
+        return report_error(run, OBJECT_TYPE_DATA, error, (size_t)header->object_size, -1);
+    }
+
+    report_object(run, ASFPARSE_EVENT_OBJECT, OBJECT_TYPE_DATA, (size_t)header->object_size, data->object_size, data);
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  summarize_data_packets
+* DESCRIPTION: Decode every data packet of the Data Object, possibly on
+*              several threads, and report their payload counts at once
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+summarize_data_packets
+    (parse_run_t                       *run             /* [in,out] current parse */
+    ,const data_object_t               *data            /* [in] struct containing info about data object */
+    ,const file_properties_object_t    *file_properties /* [in] struct containing info about file properties object */
+    ,int                                num_threads     /* [in] maximum number of threads to decode with */
+    )
+{
+    asfparse_error_t    error;
+    packet_summary_t    summary;
+    size_t              packet_offset;
+
+    error = packet_scan(&summary, run->p_data, data, file_properties, num_threads, &packet_offset);
+
+    /* the summary and the end of the walk are reported even when it
+       stopped at a bad packet */
+    if (report_object(run, ASFPARSE_EVENT_PACKET_SUMMARY, OBJECT_TYPE_DATA,
+                      data->packets_offset, summary.num_packets, &summary)
+        || report_object(run, ASFPARSE_EVENT_DATA_END, OBJECT_TYPE_DATA,
+                         data->packets_offset, summary.num_packets, data))
+    {
+        return error;
+    }
+    if (error)
+    {
+        report_error(run, OBJECT_TYPE_DATA, error, packet_offset, summary.num_packets);
+    }
+
+    return error;
+}
+
+/*****************************************************************************
+* NAME:  parse_data_packets
+* DESCRIPTION: Decode every data packet of the Data Object and report each
+*              one in turn
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+parse_data_packets
+    (parse_run_t                       *run             /* [in,out] current parse */
+    ,const data_object_t               *data            /* [in] struct containing info about data object */
+    ,const file_properties_object_t    *file_properties /* [in] struct containing info about file properties object */
+    )
+{
+    asfparse_error_t    error;
+    data_packet_t       packet;
+    packet_iterator_t   it;
+    size_t              packet_offset = data->packets_offset;
+
+    error = packet_iterator_init(&it, run->p_data, data, file_properties);
+
+    /* decode every packet in place */
+    while (error == ASFPARSE_ERROR_OK && !packet_iterator_done(&it))
+    {
+        packet_offset = data->packets_offset + it.cur.pos;
+        error = packet_iterator_next(&it, &packet);
+        if (error == ASFPARSE_ERROR_OK
+            && report_object(run, ASFPARSE_EVENT_DATA_PACKET, OBJECT_TYPE_DATA,
+                             packet_offset, it.packet_index - 1, &packet))
+        {
+            return ASFPARSE_ERROR_OK;
+        }
+    }
+
+    /* the walk is reported as finished even when it stopped at a bad packet */
+    if (report_object(run, ASFPARSE_EVENT_DATA_END, OBJECT_TYPE_DATA,
+                      data->packets_offset, it.packet_index, data))
+    {
+        return error;
+    }
+    if (error)
+    {
+        report_error(run, OBJECT_TYPE_DATA, error, packet_offset, it.packet_index);
+    }
+
+    return error;
+}
+
+/*****************************************************************************
+* NAME:  parse_index_objects
+* DESCRIPTION: Parse and report the top-level objects that follow the Data
+*              Object
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+parse_index_objects
+    (parse_run_t           *run         /* [in,out] current parse */
+    ,const data_object_t   *data        /* [in] struct containing info about data object */
+    )
+{
+    asfparse_error_t        error = ASFPARSE_ERROR_OK;
+    const char             *object_id;
+    object_type_t           object_type;
+    cursor_t                cur;
+    cursor_t                peek;
+    size_t                  object_start;
+    long long               object_size;
+    simple_index_object_t   simple_index;
+    index_object_t          index;
+    INSTRUMENT_DECLARE(start);
+
+    /* top-level objects after the Data Object run to the end of the file;
+       start where parse_data_object ended the packets, as a live recording
+       may declare a Data Object size of 0 or one beyond the end of the file */
+    cursor_init(&cur, run->p_data, run->size);
+    cursor_seek(&cur, data->packets_offset + data->packets_size);
+    while (!run->stopped && cursor_remaining(&cur) >= GUID_LENGTH_IN_BYTES + 8)
+    {
+        object_start = cur.pos;
+        object_id = cursor_read_bytes(&cur, GUID_LENGTH_IN_BYTES);
+        peek = cur;
+        object_size = cursor_read_uint64(&peek);
+        if (object_size < GUID_LENGTH_IN_BYTES + 8)
+        {
+            return report_error(run, OBJECT_TYPE_NONE, ASFPARSE_ERROR_INVALID_ASF_FILE, object_start, -1);
+        }
+
+        object_type = OBJECT_TYPE_NONE;
+        if (get_object_type(object_id, &object_type) != ASFPARSE_ERROR_OK)
+        {
+            report_object(run, ASFPARSE_EVENT_UNKNOWN_OBJECT, OBJECT_TYPE_NONE, object_start, object_size, NULL);
+        }
+        else if (object_type == OBJECT_TYPE_SIMPLE_INDEX)
+        {
+            INSTRUMENT_START(start);
+            error = parse_simple_index_object(&simple_index, &cur);
+            INSTRUMENT_STOP(INSTRUMENT_PARSE(object_type), start, object_size);
+            if (error)
+            {
+                return report_error(run, object_type, error, object_start, -1);
+            }
+            report_object(run, ASFPARSE_EVENT_OBJECT, object_type, object_start, object_size, &simple_index);
+        }
+        else if (object_type == OBJECT_TYPE_INDEX)
+        {
+            INSTRUMENT_START(start);
+            error = parse_index_object(&index, &cur);
+            INSTRUMENT_STOP(INSTRUMENT_PARSE(object_type), start, object_size);
+            if (error)
+            {
+                return report_error(run, object_type, error, object_start, -1);
+            }
+            report_object(run, ASFPARSE_EVENT_OBJECT, object_type, object_start, object_size, &index);
+        }
+
+        cursor_seek(&cur, object_start + (size_t)object_size);
+    }
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  push_fail
+* DESCRIPTION: Report an error in the unit being parsed and stop reading the
+*              pushed stream
+* RETURNS: none
+******************************************************************************/
+static void
+push_fail
+    (push_parser_t     *push            /* [in,out] push parser */
+    ,object_type_t      type            /* [in] object being parsed, or OBJECT_TYPE_NONE */
+    ,asfparse_error_t   error           /* [in] error */
+    ,size_t             offset          /* [in] offset of the object or packet within the unit */
+    ,long long          packet_number   /* [in] number of the bad data packet, or -1 */
+    )
+{
+    push->error = report_error(&push->run, type, error, offset, packet_number);
+    push->state = PUSH_STATE_DONE;
+}
+
+/*****************************************************************************
+* NAME:  push_expect
+* DESCRIPTION: Set the next unit the push parser waits for
+* RETURNS: none
+******************************************************************************/
+static void
+push_expect
+    (push_parser_t *push        /* [in,out] push parser */
+    ,push_state_t   state       /* [in] state handling the unit */
+    ,size_t         need        /* [in] size of the unit */
+    )
+{
+    push->state = state;
+    push->need = need;
+}
+
+/*****************************************************************************
+* NAME:  push_reserve
+* DESCRIPTION: Make room for a unit of the given size in the push buffer
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+push_reserve
+    (push_parser_t *push        /* [in,out] push parser */
+    ,size_t         size        /* [in] number of bytes needed */
+    )
+{
+    char   *p_buffer;
+    size_t  capacity = push->capacity ? push->capacity : 4096;
+
+    if (size <= push->capacity)
+    {
+        return ASFPARSE_ERROR_OK;
+    }
+    while (capacity < size)
+    {
+        capacity *= 2;
+    }
+
+    p_buffer = realloc(push->p_buffer, capacity);
+    if (p_buffer == NULL)
+    {
+        return ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
+    push->p_buffer = p_buffer;
+    push->capacity = capacity;
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  push_finish_packets
+* DESCRIPTION: Report the end of the packet walk, then move on to the index
+*              objects if they were requested
+* RETURNS: none
+******************************************************************************/
+static void
+push_finish_packets
+    (asfparse_ctx_t    *ctx         /* [in,out] parser context */
+    ,asfparse_error_t   error       /* [in] error that ended the walk, if any */
+    ,long long          offset      /* [in] stream offset where the walk ended */
+    )
+{
+    push_parser_t  *push = &ctx->push;
+
+    /* packet offsets are absolute, so report from the start of the stream */
+    push->run.p_data = NULL;
+    push->run.size = 0;
+    push->run.base_offset = 0;
+
+    if (ctx->options.packet_threads > 0
+        && report_object(&push->run, ASFPARSE_EVENT_PACKET_SUMMARY, OBJECT_TYPE_DATA,
+                         push->data.packets_offset, push->packet_number, &push->summary))
+    {
+        return;
+    }
+    if (report_object(&push->run, ASFPARSE_EVENT_DATA_END, OBJECT_TYPE_DATA,
+                      push->data.packets_offset, push->packet_number, &push->data))
+    {
+        return;
+    }
+    if (error)
+    {
+        push_fail(push, OBJECT_TYPE_DATA, error, (size_t)offset, push->packet_number);
+        return;
+    }
+
+    if (ctx->options.parse_index && push->data_end >= offset)
+    {
+        push->skip = (size_t)(push->data_end - offset);
+        push_expect(push, PUSH_STATE_OBJECT_PREFIX, OBJECT_PREFIX_LENGTH);
+    }
+    else
+    {
+        push->state = PUSH_STATE_DONE;
+    }
+}
+
+/*****************************************************************************
+* NAME:  push_header
+* DESCRIPTION: Parse a complete Header Object from a pushed stream
+* RETURNS: none
+******************************************************************************/
+static void
+push_header
+    (asfparse_ctx_t    *ctx         /* [in,out] parser context; push->run holds the Header Object */
+    )
+{
+    push_parser_t      *push = &ctx->push;
+    asfparse_error_t    error;
+
+    error = parse_header_objects(ctx, &push->run, &push->header, &push->file_properties);
+    if (error)
+    {
+        push->error = error;
+        push->state = PUSH_STATE_DONE;
+    }
+    else if (ctx->options.parse_packets || ctx->options.parse_index)
+    {
+        push_expect(push, PUSH_STATE_DATA_PREFIX, DATA_PREFIX_LENGTH);
+    }
+    else
+    {
+        push->state = PUSH_STATE_DONE;
+    }
+}
+
+/*****************************************************************************
+* NAME:  push_header_prefix
+* DESCRIPTION: Read the size of the Header Object from the start of a pushed
+*              stream
+* RETURNS: non-zero to keep the unit and wait for the rest of the object
+******************************************************************************/
+static int
+push_header_prefix
+    (asfparse_ctx_t    *ctx         /* [in,out] parser context */
+    ,const char        *p_unit      /* [in] first bytes of the Header Object */
+    ,size_t             length      /* [in] number of bytes in p_unit */
+    )
+{
+    push_parser_t  *push = &ctx->push;
+    const char     *object_id;
+    long long       object_size;
+    cursor_t        cur;
+
+    cursor_init(&cur, p_unit, length);
+    object_id = cursor_read_bytes(&cur, GUID_LENGTH_IN_BYTES);
+    object_size = cursor_read_uint64(&cur);
+    if (!guid_equal(object_id, ASF_HEADER_OBJECT_GUID) || object_size < HEADER_PREFIX_LENGTH)
+    {
+        push_fail(push, OBJECT_TYPE_HEADER, ASFPARSE_ERROR_INVALID_ASF_FILE, 0, -1);
+        return 0;
+    }
+    if (object_size > PUSH_MAX_UNIT_SIZE)
+    {
+        push_fail(push, OBJECT_TYPE_HEADER, ASFPARSE_ERROR_OUT_OF_MEMORY, 0, -1);
+        return 0;
+    }
+
+    if ((size_t)object_size > length)
+    {
+        push_expect(push, PUSH_STATE_HEADER, (size_t)object_size);
+        return 1;
+    }
+
+    /* a header without any objects is complete already */
+    push_header(ctx);
+    return 0;
+}
+
+/*****************************************************************************
+* NAME:  push_data_prefix
+* DESCRIPTION: Parse the Data Object fields that precede its data packets
+* RETURNS: none
+******************************************************************************/
+static void
+push_data_prefix
+    (asfparse_ctx_t    *ctx         /* [in,out] parser context */
+    ,const char        *p_unit      /* [in] first bytes of the Data Object */
+    ,size_t             length      /* [in] number of bytes in p_unit */
+    )
+{
+    push_parser_t      *push = &ctx->push;
+    data_object_t      *data = &push->data;
+    asfparse_error_t    error;
+    const char         *object_id;
+    cursor_t            cur;
+    INSTRUMENT_DECLARE(start);
+
+    cursor_init(&cur, p_unit, length);
+    object_id = cursor_read_bytes(&cur, GUID_LENGTH_IN_BYTES);
+    if (!guid_equal(object_id, ASF_DATA_OBJECT_GUID))
+    {
+        push_fail(push, OBJECT_TYPE_DATA, ASFPARSE_ERROR_OBJECT_NOT_FOUND, 0, -1);
+        return;
+    }
+
+    INSTRUMENT_START(start);
+    error = parse_data_object(data, &cur);
+    INSTRUMENT_STOP(INSTRUMENT_PARSE(OBJECT_TYPE_DATA), start, length);
+    if (error)
+    {
+        push_fail(push, OBJECT_TYPE_DATA, error, 0, -1);
+        return;
+    }
+
+    /* only the fields before the packets are buffered, so place the packets
+       in the stream from the declared size; a live stream may not know it,
+       and a size whose end does not fit in a stream offset is treated alike */
+    data->packets_offset = (size_t)push->offset + DATA_PREFIX_LENGTH;
+    if (data->object_size >= DATA_PREFIX_LENGTH && data->object_size <= LLONG_MAX - push->offset)
+    {
+        data->packets_size = (size_t)data->object_size - DATA_PREFIX_LENGTH;
+        push->data_end = push->offset + data->object_size;
+    }
+    else
+    {
+        data->packets_size = PUSH_UNBOUNDED_SIZE;
+        push->data_end = -1;
+    }
+
+    if (report_object(&push->run, ASFPARSE_EVENT_OBJECT, OBJECT_TYPE_DATA, 0, data->object_size, data))
+    {
+        return;
+    }
+
+    if (ctx->options.parse_packets)
+    {
+        error = packet_layout(data, &push->file_properties, &push->packet_size, &push->num_packets);
+
+        /* variable-size packets can only be framed by decoding them */
+        if (error == ASFPARSE_ERROR_OK && push->packet_size == 0)
+        {
+            error = ASFPARSE_ERROR_UNSUPPORTED_OBJECT_TYPE;
+        }
+        /* each packet is buffered whole, so its size is bounded like an object's */
+        else if (error == ASFPARSE_ERROR_OK && push->packet_size > PUSH_MAX_UNIT_SIZE)
+        {
+            error = ASFPARSE_ERROR_INVALID_ASF_FILE;
+        }
+        if (error || push->num_packets == 0)
+        {
+            push_finish_packets(ctx, error, (long long)data->packets_offset);
+            return;
+        }
+        push_expect(push, PUSH_STATE_PACKET, push->packet_size);
+    }
+    else if (ctx->options.parse_index && push->data_end >= 0)
+    {
+        push->skip = data->packets_size;
+        push_expect(push, PUSH_STATE_OBJECT_PREFIX, OBJECT_PREFIX_LENGTH);
+    }
+    else
+    {
+        push->state = PUSH_STATE_DONE;
+    }
+}
+
+/*****************************************************************************
+* NAME:  push_packet
+* DESCRIPTION: Decode and report one data packet of a pushed stream
+* RETURNS: none
+******************************************************************************/
+static void
+push_packet
+    (asfparse_ctx_t    *ctx         /* [in,out] parser context */
+    ,const char        *p_unit      /* [in] data packet */
+    ,size_t             length      /* [in] number of bytes in p_unit */
+    )
+{
+    push_parser_t      *push = &ctx->push;
+    asfparse_error_t    error;
+    data_packet_t       packet;
+    cursor_t            cur;
+    INSTRUMENT_DECLARE(start);
+
+    cursor_init(&cur, p_unit, length);
+    INSTRUMENT_START(start);
+    error = parse_data_packet(&packet, &cur, push->packet_size);
+    INSTRUMENT_STOP(INSTRUMENT_PARSE_DATA_PACKET, start, length);
+    if (error)
+    {
+        push_finish_packets(ctx, error, push->offset);
+        return;
+    }
+
+    /* packets arrive one at a time, so a summary is gathered on this thread */
+    if (ctx->options.packet_threads > 0)
+    {
+        packet_summary_add(&push->summary, &packet);
+    }
+    else if (report_object(&push->run, ASFPARSE_EVENT_DATA_PACKET, OBJECT_TYPE_DATA, 0, push->packet_number, &packet))
+    {
+        return;
+    }
+
+    push->packet_number++;
+    if (push->packet_number == push->num_packets)
+    {
+        push_finish_packets(ctx, ASFPARSE_ERROR_OK, push->offset + (long long)length);
+    }
+}
+
+/*****************************************************************************
+* NAME:  push_object
+* DESCRIPTION: Parse and report a complete index object of a pushed stream
+* RETURNS: none
+******************************************************************************/
+static void
+push_object
+    (asfparse_ctx_t    *ctx         /* [in,out] parser context */
+    ,const char        *p_unit      /* [in] index object */
+    ,size_t             length      /* [in] number of bytes in p_unit */
+    )
+{
+    push_parser_t          *push = &ctx->push;
+    asfparse_error_t        error;
+    object_type_t           object_type = OBJECT_TYPE_NONE;
+    const void             *object;
+    cursor_t                cur;
+    simple_index_object_t   simple_index;
+    index_object_t          index;
+    INSTRUMENT_DECLARE(start);
+
+    cursor_init(&cur, p_unit, length);
+    get_object_type(cursor_read_bytes(&cur, GUID_LENGTH_IN_BYTES), &object_type);
+    INSTRUMENT_START(start);
+    if (object_type == OBJECT_TYPE_SIMPLE_INDEX)
+    {
+        error = parse_simple_index_object(&simple_index, &cur);
+        object = &simple_index;
+    }
+    else
+    {
+        error = parse_index_object(&index, &cur);
+        object = &index;
+    }
+    INSTRUMENT_STOP(INSTRUMENT_PARSE(object_type), start, length);
+    if (error)
+    {
+        push_fail(push, object_type, error, 0, -1);
+        return;
+    }
+
+    report_object(&push->run, ASFPARSE_EVENT_OBJECT, object_type, 0, (long long)length, object);
+    push_expect(push, PUSH_STATE_OBJECT_PREFIX, OBJECT_PREFIX_LENGTH);
+}
+
+/*****************************************************************************
+* NAME:  push_object_prefix
+* DESCRIPTION: Identify a top-level object after the Data Object, skipping
+*              all but the index objects
+* RETURNS: non-zero to keep the unit and wait for the rest of the object
+******************************************************************************/
+static int
+push_object_prefix
+    (asfparse_ctx_t    *ctx         /* [in,out] parser context */
+    ,const char        *p_unit      /* [in] object id and size */
+    ,size_t             length      /* [in] number of bytes in p_unit */
+    )
+{
+    push_parser_t  *push = &ctx->push;
+    const char     *object_id;
+    object_type_t   object_type = OBJECT_TYPE_NONE;
+    long long       object_size;
+    cursor_t        cur;
+
+    cursor_init(&cur, p_unit, length);
+    object_id = cursor_read_bytes(&cur, GUID_LENGTH_IN_BYTES);
+    object_size = cursor_read_uint64(&cur);
+    if (object_size < OBJECT_PREFIX_LENGTH)
+    {
+        push_fail(push, OBJECT_TYPE_NONE, ASFPARSE_ERROR_INVALID_ASF_FILE, 0, -1);
+        return 0;
+    }
+
+    if (get_object_type(object_id, &object_type) != ASFPARSE_ERROR_OK)
+    {
+        report_object(&push->run, ASFPARSE_EVENT_UNKNOWN_OBJECT, OBJECT_TYPE_NONE, 0, object_size, NULL);
+    }
+    else if (object_type == OBJECT_TYPE_SIMPLE_INDEX || object_type == OBJECT_TYPE_INDEX)
+    {
+        if (object_size > PUSH_MAX_UNIT_SIZE)
+        {
+            push_fail(push, object_type, ASFPARSE_ERROR_OUT_OF_MEMORY, 0, -1);
+            return 0;
+        }
+        if ((size_t)object_size > length)
+        {
+            push_expect(push, PUSH_STATE_OBJECT, (size_t)object_size);
+            return 1;
+        }
+        push_object(ctx, p_unit, length);
+        return 0;
+    }
+
+    push->skip = (size_t)object_size - OBJECT_PREFIX_LENGTH;
+    return 0;
+}
+
+/*****************************************************************************
+* NAME:  push_unit
+* DESCRIPTION: Handle a complete unit of a pushed stream
+* RETURNS: non-zero to keep the unit and wait for the rest of the object
+******************************************************************************/
+static int
+push_unit
+    (asfparse_ctx_t    *ctx         /* [in,out] parser context */
+    ,const char        *p_unit      /* [in] unit of push->need bytes */
+    ,size_t             length      /* [in] number of bytes in p_unit */
+    )
+{
+    push_parser_t  *push = &ctx->push;
+    int             keep = 0;
+
+    push->run.p_data = p_unit;
+    push->run.size = length;
+    push->run.base_offset = push->offset;
+
+    switch (push->state)
+    {
+    case PUSH_STATE_HEADER_PREFIX:
+        keep = push_header_prefix(ctx, p_unit, length);
+        break;
+    case PUSH_STATE_HEADER:
+        push_header(ctx);
+        break;
+    case PUSH_STATE_DATA_PREFIX:
+        push_data_prefix(ctx, p_unit, length);
+        break;
+    case PUSH_STATE_PACKET:
+        push_packet(ctx, p_unit, length);
+        break;
+    case PUSH_STATE_OBJECT_PREFIX:
+        keep = push_object_prefix(ctx, p_unit, length);
+        break;
+    case PUSH_STATE_OBJECT:
+        push_object(ctx, p_unit, length);
+        break;
+    case PUSH_STATE_IDLE:
+    case PUSH_STATE_DONE:
+    default:
+        break;
+    }
+
+    if (push->run.stopped)
+    {
+        push->state = PUSH_STATE_DONE;
+    }
+
+    return keep;
+}
+
+/*****************************************************************************
+* NAME:  asfparse_create
+* DESCRIPTION: Create a parser context
+* RETURNS: new context, or NULL if memory is exhausted
+******************************************************************************/
+asfparse_ctx_t *
+asfparse_create
+    (const asfparse_options_t  *options     /* [in] parse options, or NULL for defaults */
+    )
+{
+    asfparse_ctx_t *ctx;
+
+    ctx = malloc(sizeof(asfparse_ctx_t));
+    if (ctx == NULL)
+    {
+        return NULL;
+    }
+
+    memset(ctx, 0, sizeof(asfparse_ctx_t));
+    if (options != NULL)
+    {
+        ctx->options = *options;
+    }
+    arena_init(&ctx->arena, ARENA_DEFAULT_BLOCK_SIZE);
+
+    return ctx;
+}
+
+/*****************************************************************************
+* NAME:  asfparse_destroy
+* DESCRIPTION: Release a parser context and everything it holds
+* RETURNS: none
+******************************************************************************/
+void
+asfparse_destroy
+    (asfparse_ctx_t    *ctx     /* [in] parser context */
+    )
+{
+    if (ctx != NULL)
+    {
+        arena_free(&ctx->arena);
+        free(ctx->push.p_buffer);
+        free(ctx);
+    }
+}
+
+/*****************************************************************************
+* NAME:  asfparse_parse_file
+* DESCRIPTION: Map an ASF file and report its objects to a callback
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+asfparse_parse_file
+    (asfparse_ctx_t        *ctx         /* [in,out] parser context */
+    ,const char            *p_filename  /* [in] name of ASF file to parse */
+    ,asfparse_callback_t    callback    /* [in] function receiving parse events */
+    ,void                  *p_user      /* [in] pointer passed through to the callback */
+    )
+{
+    asfparse_error_t    error;
+    mapped_file_t       file;
+    parse_run_t         run;
+
+    if (ctx == NULL || p_filename == NULL || callback == NULL)
+    {
+        return ASFPARSE_ERROR_INVALID_ARG;
+    }
+
+    /* map ASF file into memory */
+    error = map_file(p_filename, &file);
+    if (error)
+    {
+        memset(&run, 0, sizeof(parse_run_t));
+        run.callback = callback;
+        run.p_user = p_user;
+        return report_error(&run, OBJECT_TYPE_NONE, error, 0, -1);
+    }
+
+    error = asfparse_parse_buffer(ctx, file.p_data, file.size, callback, p_user);
+
+    /* ensure file is released after parsing */
+    unmap_file(&file);
+
+    return error;
+}
+
+/*****************************************************************************
+* NAME:  asfparse_parse_buffer
+* DESCRIPTION: Report the objects of an ASF file held in memory to a callback
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+asfparse_parse_buffer
+    (asfparse_ctx_t        *ctx         /* [in,out] parser context */
+    ,const char            *p_data      /* [in] ASF file contents */
+    ,size_t                 size        /* [in] number of bytes in p_data */
+    ,asfparse_callback_t    callback    /* [in] function receiving parse events */
+    ,void                  *p_user      /* [in] pointer passed through to the callback */
+    )
+{
+    asfparse_error_t            error;
+    parse_run_t                 run;
+    header_object_t             header;
+    file_properties_object_t    file_properties;
+    data_object_t               data;
+
+    if (ctx == NULL || callback == NULL || (p_data == NULL && size != 0))
+    {
+        return ASFPARSE_ERROR_INVALID_ARG;
+    }
+
+    memset(&run, 0, sizeof(parse_run_t));
+    run.p_data = p_data;
+    run.size = size;
+    run.callback = callback;
+    run.p_user = p_user;
+
+    memset(&header, 0, sizeof(header_object_t));
+    memset(&file_properties, 0, sizeof(file_properties_object_t));
+
+    /* the previous file's object data is no longer referenced */
+    arena_reset(&ctx->arena);
+
+    error = parse_header_objects(ctx, &run, &header, &file_properties);
+
+    /* parse what follows the Header Object if requested */
+    if (error == ASFPARSE_ERROR_OK && !run.stopped
+        && (ctx->options.parse_packets || ctx->options.parse_index))
+    {
+        error = find_data_object(&run, &header, &data);
+        if (error == ASFPARSE_ERROR_OK && !run.stopped && ctx->options.parse_packets)
+        {
+            if (ctx->options.packet_threads > 0)
+            {
+                error = summarize_data_packets(&run, &data, &file_properties, ctx->options.packet_threads);
+            }
+            else
+            {
+                error = parse_data_packets(&run, &data, &file_properties);
+            }
+        }
+        if (error == ASFPARSE_ERROR_OK && !run.stopped && ctx->options.parse_index)
+        {
+            error = parse_index_objects(&run, &data);
+        }
+    }
+
+    return error;
+}
+
+/*****************************************************************************
+* NAME:  asfparse_push_begin
+* DESCRIPTION: Start parsing an ASF stream that will be passed to
+*              asfparse_push_feed in pieces
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+asfparse_push_begin
+    (asfparse_ctx_t        *ctx         /* [in,out] parser context */
+    ,asfparse_callback_t    callback    /* [in] function receiving parse events */
+    ,void                  *p_user      /* [in] pointer passed through to the callback */
+    )
+{
+    push_parser_t  *push;
+    char           *p_buffer;
+    size_t          capacity;
+
+    if (ctx == NULL || callback == NULL)
+    {
+        return ASFPARSE_ERROR_INVALID_ARG;
+    }
+
+    /* keep the buffer of the previous stream */
+    push = &ctx->push;
+    p_buffer = push->p_buffer;
+    capacity = push->capacity;
+    memset(push, 0, sizeof(push_parser_t));
+    push->p_buffer = p_buffer;
+    push->capacity = capacity;
+    push->run.callback = callback;
+    push->run.p_user = p_user;
+    push->data_end = -1;
+    push_expect(push, PUSH_STATE_HEADER_PREFIX, HEADER_PREFIX_LENGTH);
+
+    arena_reset(&ctx->arena);
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  asfparse_push_feed
+* DESCRIPTION: Parse the next piece of a pushed stream
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+asfparse_push_feed
+    (asfparse_ctx_t    *ctx         /* [in,out] parser context */
+    ,const char        *p_data      /* [in] next bytes of the stream */
+    ,size_t             size        /* [in] number of bytes in p_data, any amount */
+    )
+{
+    push_parser_t      *push;
+    const char         *p_unit;
+    size_t              length;
+    size_t              n;
+
+    if (ctx == NULL || ctx->push.state == PUSH_STATE_IDLE || (p_data == NULL && size != 0))
+    {
+        return ASFPARSE_ERROR_INVALID_ARG;
+    }
+    push = &ctx->push;
+
+    while (size > 0 && push->state != PUSH_STATE_DONE)
+    {
+        /* discard objects and packets that were not requested */
+        if (push->skip > 0)
+        {
+            n = (push->skip < size) ? push->skip : size;
+            push->skip -= n;
+            push->offset += (long long)n;
+            p_data += n;
+            size -= n;
+            continue;
+        }
+
+        /* parse a unit in place when it lies within this piece, and only
+           copy one that is split across pieces */
+        if (push->length == 0 && size >= push->need)
+        {
+            p_unit = p_data;
+            length = push->need;
+            p_data += length;
+            size -= length;
+        }
+        else
+        {
+            if (push_reserve(push, push->need) != ASFPARSE_ERROR_OK)
+            {
+                push->run.base_offset = push->offset;
+                push_fail(push, OBJECT_TYPE_NONE, ASFPARSE_ERROR_OUT_OF_MEMORY, 0, -1);
+                break;
+            }
+            n = push->need - push->length;
+            if (n > size)
+            {
+                n = size;
+            }
+            memcpy(push->p_buffer + push->length, p_data, n);
+            push->length += n;
+            p_data += n;
+            size -= n;
+            if (push->length < push->need)
+            {
+                continue;
+            }
+            p_unit = push->p_buffer;
+            length = push->length;
+        }
+
+        if (push_unit(ctx, p_unit, length))
+        {
+            /* the unit is the start of a larger object */
+            if (p_unit != push->p_buffer)
+            {
+                if (push_reserve(push, push->need) != ASFPARSE_ERROR_OK)
+                {
+                    push_fail(push, OBJECT_TYPE_NONE, ASFPARSE_ERROR_OUT_OF_MEMORY, 0, -1);
+                    break;
+                }
+                memcpy(push->p_buffer, p_unit, length);
+            }
+            push->length = length;
+        }
+        else
+        {
+            push->offset += (long long)length;
+            push->length = 0;
+        }
+    }
+
+    return push->error;
+}
+
+/*****************************************************************************
+* NAME:  asfparse_push_end
+* DESCRIPTION: Finish parsing a pushed stream at the end of its input
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+asfparse_push_end
+    (asfparse_ctx_t    *ctx         /* [in,out] parser context */
+    )
+{
+    push_parser_t  *push;
+    object_type_t   object_type = OBJECT_TYPE_NONE;
+
+    if (ctx == NULL || ctx->push.state == PUSH_STATE_IDLE)
+    {
+        return ASFPARSE_ERROR_INVALID_ARG;
+    }
+    push = &ctx->push;
+
+    push->run.p_data = push->p_buffer;
+    push->run.size = push->length;
+    push->run.base_offset = push->offset;
+
+    /* like a mapped file, a stream may end partway through the data
+       packets or the objects after them */
+    switch (push->state)
+    {
+    case PUSH_STATE_HEADER_PREFIX:
+        push_fail(push, OBJECT_TYPE_HEADER, ASFPARSE_ERROR_TRUNCATED_OBJECT, 0, -1);
+        break;
+    case PUSH_STATE_HEADER:
+        /* report the objects that did arrive before the one cut short */
+        push_header(ctx);
+        if (push->state == PUSH_STATE_DATA_PREFIX)
+        {
+            push_fail(push, OBJECT_TYPE_DATA, ASFPARSE_ERROR_OBJECT_NOT_FOUND, (size_t)push->header.object_size, -1);
+        }
+        break;
+    case PUSH_STATE_DATA_PREFIX:
+        push_fail(push, OBJECT_TYPE_DATA,
+                  (push->length < GUID_LENGTH_IN_BYTES) ? ASFPARSE_ERROR_OBJECT_NOT_FOUND : ASFPARSE_ERROR_TRUNCATED_OBJECT,
+                  0, -1);
+        break;
+    case PUSH_STATE_PACKET:
+        push_finish_packets(ctx, ASFPARSE_ERROR_OK, push->offset);
+        break;
+    case PUSH_STATE_OBJECT:
+        get_object_type(push->p_buffer, &object_type);
+        push_fail(push, object_type, ASFPARSE_ERROR_TRUNCATED_OBJECT, 0, -1);
+        break;
+    case PUSH_STATE_OBJECT_PREFIX:
+    case PUSH_STATE_IDLE:
+    case PUSH_STATE_DONE:
+    default:
+        break;
+    }
+    push->state = PUSH_STATE_DONE;
+    push->length = 0;
+
+    return push->error;
+}
+
+/*****************************************************************************
+* NAME:  asfparse_push_done
+* DESCRIPTION: Check whether a pushed stream needs any more input
+* RETURNS: non-zero once everything requested has been reported, the
+*          callback asked to stop or an error occurred
+******************************************************************************/
+int
+asfparse_push_done
+    (const asfparse_ctx_t  *ctx     /* [in] parser context */
+    )
+{
+    return ctx == NULL || ctx->push.state == PUSH_STATE_DONE;
+}
+
+/*****************************************************************************
+* NAME:  asfparse_error_string
+* DESCRIPTION: Describe an error code
+* RETURNS: constant NUL-terminated string
+******************************************************************************/
+const char *
+asfparse_error_string
+    (asfparse_error_t   error   /* [in] error code */
+    )
+{
+    switch (error)
+    {
+    case ASFPARSE_ERROR_OK:
+        return "no error";
+    case ASFPARSE_ERROR_INVALID_ARG:
+        return "invalid argument";
+    case ASFPARSE_ERROR_OPEN_FILE:
+        return "cannot open file";
+    case ASFPARSE_ERROR_INVALID_ASF_FILE:
+        return "invalid ASF file";
+    case ASFPARSE_ERROR_UNSUPPORTED_OBJECT_TYPE:
+        return "unsupported object type";
+    case ASFPARSE_ERROR_TRUNCATED_OBJECT:
+        return "truncated object";
+    case ASFPARSE_ERROR_OUT_OF_MEMORY:
+        return "out of memory";
+    case ASFPARSE_ERROR_OBJECT_NOT_FOUND:
+        return "object not found";
+    case ASFPARSE_ERROR_WRITE_FILE:
+        return "cannot write file";
+    default:
+        return "unknown error";
+    }
+}
@@ -0,0 +1,176 @@
+#ifndef ASFPARSE_H
+#define ASFPARSE_H
+
+/* Includes */
+#include <stddef.h>
+#include "util.h"
+#include "packet.h"
+
+/* Enums and structs */
+/* Enum describing the kinds of event reported while parsing a file */
+typedef enum {
+     ASFPARSE_EVENT_OBJECT = 0          /* an object was parsed; object points to its struct */
+    ,ASFPARSE_EVENT_UNKNOWN_OBJECT      /* an object of unsupported type was skipped */
+    ,ASFPARSE_EVENT_DATA_PACKET         /* a data packet was decoded; object points to a data_packet_t */
+    ,ASFPARSE_EVENT_DATA_END            /* the packet walk finished, possibly at a bad packet; object points to the data_object_t */
+    ,ASFPARSE_EVENT_ERROR               /* parsing failed; error and type describe where */
+    ,ASFPARSE_EVENT_PACKET_SUMMARY      /* the data packets were summarised instead of reported one by one; object points to a packet_summary_t */
+} asfparse_event_kind_t;
+
+/* Structure describing an event passed to the caller's callback. All
+   pointers are valid only until the callback returns. */
+typedef struct {
+    asfparse_event_kind_t   kind;
+    object_type_t           type;           /* object the event refers to, OBJECT_TYPE_NONE if unknown */
+    asfparse_error_t        error;          /* reason for an ASFPARSE_EVENT_ERROR */
+    const char             *guid;           /* object's GUID, or NULL */
+    long long               offset;         /* file offset of the object or data packet */
+    long long               object_size;    /* size of the object in bytes */
+    long long               packet_number;  /* index of the data packet, number of packets for DATA_END and PACKET_SUMMARY, else -1 */
+    const void             *object;         /* parsed struct whose type depends on kind and type */
+} asfparse_event_t;
+
+/* Callback receiving parse events; return non-zero to stop parsing early */
+typedef int (*asfparse_callback_t)
+    (void                      *p_user      /* [in] caller's pointer given to asfparse_parse_* */
+    ,const asfparse_event_t    *event       /* [in] event */
+    );
+
+/* Structure describing what a parser context reads and reports. Reading the
+   header stops once every object in object_mask was found; the File
+   Properties Object is also parsed when packets or the index are requested,
+   since walking the Data Object needs it. When packet_threads is set, the
+   packets are reported as a single PACKET_SUMMARY event before DATA_END,
+   and the fixed-size packets of a large file held in memory are decoded on
+   up to that many threads. */
+typedef struct {
+    unsigned int    object_mask;            /* OBJECT_MASK bits of header objects to parse, 0 for all */
+    int             parse_packets;          /* non-zero to decode and report every data packet */
+    int             parse_index;            /* non-zero to parse the index objects after the Data Object */
+    int             packet_threads;         /* threads to summarise the data packets on, 0 to report each packet */
+} asfparse_options_t;
+
+/* Opaque parser context. A context holds no global state and may be used
+   by one thread at a time; use one context per thread to parse in parallel.
+   A context parses either a whole file or buffer at once, or a stream pushed
+   to it in pieces with asfparse_push_begin, asfparse_push_feed and
+   asfparse_push_end. */
+typedef struct asfparse_ctx_s asfparse_ctx_t;
+
+/* Function prototypes */
+/*****************************************************************************
+* NAME:  asfparse_create
+* DESCRIPTION: Create a parser context
+* RETURNS: new context, or NULL if memory is exhausted
+******************************************************************************/
+asfparse_ctx_t *
+asfparse_create
+    (const asfparse_options_t  *options     /* [in] parse options, or NULL for defaults */
+    );
+
+/*****************************************************************************
+* NAME:  asfparse_destroy
+* DESCRIPTION: Release a parser context and everything it holds
+* RETURNS: none
+******************************************************************************/
+void
+asfparse_destroy
+    (asfparse_ctx_t    *ctx     /* [in] parser context */
+    );
+
+/*****************************************************************************
+* NAME:  asfparse_parse_file
+* DESCRIPTION: Map an ASF file and report its objects to a callback
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+asfparse_parse_file
+    (asfparse_ctx_t        *ctx         /* [in,out] parser context */
+    ,const char            *p_filename  /* [in] name of ASF file to parse */
+    ,asfparse_callback_t    callback    /* [in] function receiving parse events */
+    ,void                  *p_user      /* [in] pointer passed through to the callback */
+    );
+
+/*****************************************************************************
+* NAME:  asfparse_parse_buffer
+* DESCRIPTION: Report the objects of an ASF file (or a prefix of one, such as
+*              just its Header Object) held in memory to a callback
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+asfparse_parse_buffer
+    (asfparse_ctx_t        *ctx         /* [in,out] parser context */
+    ,const char            *p_data      /* [in] ASF file contents */
+    ,size_t                 size        /* [in] number of bytes in p_data */
+    ,asfparse_callback_t    callback    /* [in] function receiving parse events */
+    ,void                  *p_user      /* [in] pointer passed through to the callback */
+    );
+
+/*****************************************************************************
+* NAME:  asfparse_push_begin
+* DESCRIPTION: Start parsing an ASF stream, such as a pipe or a live
+*              broadcast, that will be passed to asfparse_push_feed in pieces.
+*              Events are reported as soon as each object or data packet is
+*              complete, with offsets counted from the start of the stream.
+*              Only an object or packet split across pieces is copied, so
+*              memory use is bounded by the largest Header Object, data
+*              packet or index object. Data packets are reported only for
+*              files with fixed-size packets.
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+asfparse_push_begin
+    (asfparse_ctx_t        *ctx         /* [in,out] parser context */
+    ,asfparse_callback_t    callback    /* [in] function receiving parse events */
+    ,void                  *p_user      /* [in] pointer passed through to the callback */
+    );
+
+/*****************************************************************************
+* NAME:  asfparse_push_feed
+* DESCRIPTION: Parse the next piece of a pushed stream. Pieces may be of any
+*              size and need not end on object boundaries. Input after an
+*              error, after the callback asked to stop, or after everything
+*              requested was reported is ignored.
+* RETURNS: asfparse_error_t; an error is returned again by later calls
+******************************************************************************/
+asfparse_error_t
+asfparse_push_feed
+    (asfparse_ctx_t    *ctx         /* [in,out] parser context */
+    ,const char        *p_data      /* [in] next bytes of the stream */
+    ,size_t             size        /* [in] number of bytes in p_data */
+    );
+
+/*****************************************************************************
+* NAME:  asfparse_push_end
+* DESCRIPTION: Finish parsing a pushed stream at the end of its input,
+*              reporting the end of the data packets or a truncated object
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+asfparse_push_end
+    (asfparse_ctx_t    *ctx         /* [in,out] parser context */
+    );
+
+/*****************************************************************************
+* NAME:  asfparse_push_done
+* DESCRIPTION: Check whether a pushed stream needs any more input, so that a
+*              caller wanting only the header can stop reading early
+* RETURNS: non-zero once everything requested has been reported, the
+*          callback asked to stop or an error occurred
+******************************************************************************/
+int
+asfparse_push_done
+    (const asfparse_ctx_t  *ctx     /* [in] parser context */
+    );
+
+/*****************************************************************************
+* NAME:  asfparse_error_string
+* DESCRIPTION: Describe an error code
+* RETURNS: constant NUL-terminated string
+******************************************************************************/
+const char *
+asfparse_error_string
+    (asfparse_error_t   error   /* [in] error code */
+    );
+
+#endif
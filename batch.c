@@ -0,0 +1,528 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "batch.h"
+#include "cache.h"
+#include "output.h"
+#include "prefetch.h"
+#include "process.h"
+
+/* Enums and structs */
+/* Structure describing one file in flight. Slots form a ring that doubles as
+   the reorder buffer: a slot is reused only after its output was written. */
+typedef struct {
+    char               *p_filename;     /* name of file to parse (owned) */
+    output_t            out;            /* formatted output, reused across files */
+    asfparse_error_t    error;          /* result of process_file */
+    int                 done;           /* non-zero once a worker finished the file */
+    header_cache_key_t  key;            /* header cache key taken before the file was read */
+    int                 have_key;       /* non-zero if key is valid */
+} batch_slot_t;
+
+/* Structure describing the state shared between the submitting thread and
+   the workers. Sequence numbers increase monotonically; a file with sequence
+   number n lives in slot n % num_slots. */
+typedef struct {
+    const params_t     *params;         /* user-defined parameters */
+    batch_slot_t       *slots;          /* ring of file slots */
+    size_t              num_slots;      /* number of entries in slots */
+    unsigned long long  num_submitted;  /* files handed to workers so far */
+    unsigned long long  num_claimed;    /* files picked up by a worker so far */
+    unsigned long long  num_written;    /* files whose output was written so far */
+    int                 finished;       /* non-zero once all input was submitted */
+    pthread_mutex_t     lock;
+    pthread_cond_t      work_ready;     /* signalled when a file is submitted or input ends */
+    pthread_cond_t      slot_done;      /* signalled when a worker finishes a file */
+} batch_t;
+
+/*****************************************************************************
+* NAME:  batch_worker
+* DESCRIPTION: Worker thread body: parse submitted files until input ends
+* RETURNS: NULL
+******************************************************************************/
+static void *
+batch_worker
+    (void  *arg     /* [in] batch_t shared state */
+    )
+{
+    batch_t        *batch = arg;
+    batch_slot_t   *slot;
+    asfparse_ctx_t *ctx;
+
+    /* each worker keeps one parser context for all of its files */
+    ctx = process_create_context(batch->params);
+
+    for (;;)
+    {
+        pthread_mutex_lock(&batch->lock);
+        while (batch->num_claimed == batch->num_submitted && !batch->finished)
+        {
+            pthread_cond_wait(&batch->work_ready, &batch->lock);
+        }
+        if (batch->num_claimed == batch->num_submitted)
+        {
+            pthread_mutex_unlock(&batch->lock);
+            break;
+        }
+        slot = &batch->slots[batch->num_claimed++ % batch->num_slots];
+
+        /* a file whose name could not be copied was finished on submission */
+        if (slot->done)
+        {
+            pthread_mutex_unlock(&batch->lock);
+            continue;
+        }
+        pthread_mutex_unlock(&batch->lock);
+
+        output_reset(&slot->out);
+        slot->error = (ctx != NULL) ? process_file(slot->p_filename, batch->params, ctx, &slot->out)
+                                    : ASFPARSE_ERROR_OUT_OF_MEMORY;
+
+        pthread_mutex_lock(&batch->lock);
+        slot->done = 1;
+        pthread_cond_broadcast(&batch->slot_done);
+        pthread_mutex_unlock(&batch->lock);
+    }
+
+    asfparse_destroy(ctx);
+
+    return NULL;
+}
+
+/*****************************************************************************
+* NAME:  write_completed
+* DESCRIPTION: Write the output of finished files in input order, stopping at
+*              the first file that is still being parsed. If wait_for_all is
+*              set, block until every submitted file has been written.
+* RETURNS: none
+******************************************************************************/
+static void
+write_completed
+    (batch_t           *batch          /* [in,out] shared batch state */
+    ,int                wait_for_all   /* [in] non-zero to drain every submitted file */
+    ,asfparse_error_t  *first_error    /* [in,out] first failure in input order */
+    )
+{
+    batch_slot_t   *slot;
+
+    pthread_mutex_lock(&batch->lock);
+    while (batch->num_written < batch->num_submitted)
+    {
+        slot = &batch->slots[batch->num_written % batch->num_slots];
+        if (!slot->done)
+        {
+            if (!wait_for_all)
+            {
+                break;
+            }
+            pthread_cond_wait(&batch->slot_done, &batch->lock);
+            continue;
+        }
+        pthread_mutex_unlock(&batch->lock);
+
+        /* the slot is not reused until num_written advances, so it can be
+           written without holding the lock */
+        output_flush(&slot->out, STDOUT_FILENO);
+        if (*first_error == ASFPARSE_ERROR_OK)
+        {
+            *first_error = slot->error;
+        }
+
+        pthread_mutex_lock(&batch->lock);
+        batch->num_written++;
+    }
+    pthread_mutex_unlock(&batch->lock);
+}
+
+/*****************************************************************************
+* NAME:  run_workers
+* DESCRIPTION: Parse every input file on a pool of worker threads, writing
+*              finished output in input order
+* RETURNS: none
+******************************************************************************/
+static void
+run_workers
+    (batch_t           *batch          /* [in,out] shared batch state */
+    ,path_source_t     *source         /* [in,out] source of input file names */
+    ,asfparse_error_t  *first_error    /* [in,out] first failure in input order */
+    )
+{
+    batch_slot_t   *slot;
+    pthread_t       threads[MAX_NUM_THREADS];
+    const char     *p_path;
+    int             num_threads = 0;
+
+    for (num_threads = 0; num_threads < batch->params->num_threads; num_threads++)
+    {
+        if (pthread_create(&threads[num_threads], NULL, batch_worker, batch) != 0)
+        {
+            break;
+        }
+    }
+
+    if (num_threads == 0)
+    {
+        printf("Error starting worker threads\n");
+        *first_error = ASFPARSE_ERROR_INVALID_ARG;
+    }
+
+    /* submit every input, writing finished output whenever the ring is full */
+    while (num_threads > 0 && (p_path = path_source_next(source)) != NULL)
+    {
+        pthread_mutex_lock(&batch->lock);
+        while (batch->num_submitted - batch->num_written == batch->num_slots)
+        {
+            pthread_mutex_unlock(&batch->lock);
+            write_completed(batch, 0, first_error);
+            pthread_mutex_lock(&batch->lock);
+            if (batch->num_submitted - batch->num_written == batch->num_slots)
+            {
+                pthread_cond_wait(&batch->slot_done, &batch->lock);
+            }
+        }
+
+        slot = &batch->slots[batch->num_submitted % batch->num_slots];
+        free(slot->p_filename);
+        slot->p_filename = strdup(p_path);
+        slot->done = 0;
+        if (slot->p_filename == NULL)
+        {
+            output_reset(&slot->out);
+            slot->error = ASFPARSE_ERROR_OUT_OF_MEMORY;
+            slot->done = 1;
+        }
+        batch->num_submitted++;
+        pthread_cond_signal(&batch->work_ready);
+        pthread_mutex_unlock(&batch->lock);
+
+        write_completed(batch, 0, first_error);
+    }
+
+    /* let idle workers exit, then drain the remaining output */
+    pthread_mutex_lock(&batch->lock);
+    batch->finished = 1;
+    pthread_cond_broadcast(&batch->work_ready);
+    pthread_mutex_unlock(&batch->lock);
+
+    write_completed(batch, 1, first_error);
+
+    while (num_threads > 0)
+    {
+        pthread_join(threads[--num_threads], NULL);
+    }
+}
+
+/*****************************************************************************
+* NAME:  run_prefetch
+* DESCRIPTION: Parse the header of every input file on this thread while the
+*              I/O engine keeps many header reads in flight, writing finished
+*              output in input order. Files found unchanged in the header
+*              cache are parsed from it without being opened.
+* RETURNS: none
+******************************************************************************/
+static void
+run_prefetch
+    (batch_t           *batch          /* [in,out] shared batch state */
+    ,path_source_t     *source         /* [in,out] source of input file names */
+    ,prefetch_t        *engine         /* [in,out] I/O engine */
+    ,asfparse_ctx_t    *ctx            /* [in,out] parser context */
+    ,header_cache_t    *cache          /* [in,out] header cache, or NULL */
+    ,asfparse_error_t  *first_error    /* [in,out] first failure in input order */
+    )
+{
+    batch_slot_t       *slot;
+    prefetch_result_t   result;
+    const char         *p_path = path_source_next(source);
+    const char         *p_header;
+    size_t              header_size;
+    size_t              num_in_flight = 0;
+    unsigned long long  i;
+    int                 engine_failed = 0;
+
+    while (p_path != NULL || num_in_flight > 0)
+    {
+        /* keep the engine busy while the reorder ring has room */
+        while (p_path != NULL && batch->num_submitted - batch->num_written < batch->num_slots)
+        {
+            slot = &batch->slots[batch->num_submitted % batch->num_slots];
+            free(slot->p_filename);
+            slot->p_filename = strdup(p_path);
+            slot->done = 0;
+            batch->num_submitted++;
+            slot->have_key = (cache != NULL && slot->p_filename != NULL
+                              && header_cache_stat(slot->p_filename, &slot->key) == ASFPARSE_ERROR_OK);
+            if (slot->have_key && header_cache_lookup(cache, &slot->key, &p_header, &header_size))
+            {
+                output_reset(&slot->out);
+                slot->error = process_buffer(slot->p_filename, p_header, header_size, batch->params, ctx, &slot->out);
+                slot->done = 1;
+            }
+            else if (!engine_failed && slot->p_filename != NULL
+                     && prefetch_submit(engine, slot->p_filename, slot) == ASFPARSE_ERROR_OK)
+            {
+                num_in_flight++;
+            }
+            else
+            {
+                output_reset(&slot->out);
+                slot->error = (slot->p_filename != NULL) ? process_file(slot->p_filename, batch->params, ctx, &slot->out)
+                                                         : ASFPARSE_ERROR_OUT_OF_MEMORY;
+                slot->done = 1;
+            }
+            p_path = path_source_next(source);
+        }
+
+        /* parse headers in the order their reads finish */
+        if (num_in_flight > 0 && prefetch_wait(engine, &result) == ASFPARSE_ERROR_OK)
+        {
+            num_in_flight--;
+            slot = result.p_tag;
+            output_reset(&slot->out);
+
+            /* a file that could not be read is parsed the usual way, which
+               reports the failure exactly as for a single file */
+            if (result.error == ASFPARSE_ERROR_OK)
+            {
+                slot->error = process_buffer(slot->p_filename, result.p_data, result.size, batch->params, ctx, &slot->out);
+
+                /* the cache only saves work, so failing to add to it is not
+                   an error of the file */
+                if (slot->error == ASFPARSE_ERROR_OK && slot->have_key)
+                {
+                    header_cache_insert(cache, &slot->key, slot->p_filename, result.p_data, result.size);
+                }
+            }
+            else
+            {
+                slot->error = process_file(slot->p_filename, batch->params, ctx, &slot->out);
+            }
+            free(result.p_data);
+            slot->done = 1;
+        }
+        else if (num_in_flight > 0)
+        {
+            /* the engine has failed and its reads will never be returned:
+               parse the files still in flight the usual way, as there are
+               no workers to finish them, and stop submitting to it */
+            for (i = batch->num_written; i < batch->num_submitted; i++)
+            {
+                slot = &batch->slots[i % batch->num_slots];
+                if (!slot->done)
+                {
+                    output_reset(&slot->out);
+                    slot->error = process_file(slot->p_filename, batch->params, ctx, &slot->out);
+                    slot->done = 1;
+                }
+            }
+            num_in_flight = 0;
+            engine_failed = 1;
+        }
+
+        write_completed(batch, 0, first_error);
+    }
+
+    write_completed(batch, 1, first_error);
+}
+
+/*****************************************************************************
+* NAME:  path_source_open
+* DESCRIPTION: Start reading input file names from the command line and
+*              then from the list file named in params, if any
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+path_source_open
+    (path_source_t     *source      /* [out] source of input file names */
+    ,const params_t    *params      /* [in] structure containing user-defined parameters */
+    )
+{
+    memset(source, 0, sizeof(path_source_t));
+    source->params = params;
+    if (params->p_list_filename == NULL)
+    {
+        return ASFPARSE_ERROR_OK;
+    }
+
+    if (strcmp(params->p_list_filename, "-") == 0)
+    {
+        source->p_list = stdin;
+    }
+    else
+    {
+        source->p_list = fopen(params->p_list_filename, "r");
+        if (source->p_list == NULL)
+        {
+            return ASFPARSE_ERROR_OPEN_FILE;
+        }
+    }
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  path_source_next
+* DESCRIPTION: Get the next input file name, first from the command line and
+*              then from the list file if one was given
+* RETURNS: pointer to a NUL-terminated name valid until the next call, or
+*          NULL when there are no more names
+******************************************************************************/
+const char *
+path_source_next
+    (path_source_t     *source      /* [in,out] source of input file names */
+    )
+{
+    ssize_t     length;
+    int         delimiter = source->params->null_separated ? '\0' : '\n';
+
+    if (source->next_argument < source->params->num_filenames)
+    {
+        return source->params->pp_filenames[source->next_argument++];
+    }
+
+    if (source->p_list == NULL)
+    {
+        return NULL;
+    }
+
+    while ((length = getdelim(&source->p_line, &source->line_capacity, delimiter, source->p_list)) > 0)
+    {
+        /* strip the delimiter and skip empty entries */
+        if (source->p_line[length - 1] == (char)delimiter)
+        {
+            source->p_line[--length] = '\0';
+        }
+        if (length > 0)
+        {
+            return source->p_line;
+        }
+    }
+
+    return NULL;
+}
+
+/*****************************************************************************
+* NAME:  path_source_close
+* DESCRIPTION: Release a source of input file names
+* RETURNS: none
+******************************************************************************/
+void
+path_source_close
+    (path_source_t     *source      /* [in,out] source of input file names */
+    )
+{
+    free(source->p_line);
+    source->p_line = NULL;
+    if (source->p_list != NULL && source->p_list != stdin)
+    {
+        fclose(source->p_list);
+    }
+    source->p_list = NULL;
+}
+
+/*****************************************************************************
+* NAME:  run_batch
+* DESCRIPTION: Parse every input file named in params on a pool of worker
+*              threads and write each file's output to stdout in input order
+* RETURNS: asfparse_error_t of the first file (in input order) that failed,
+*          or ASFPARSE_ERROR_OK
+******************************************************************************/
+asfparse_error_t
+run_batch
+    (const params_t    *params      /* [in] structure containing user-defined parameters */
+    )
+{
+    asfparse_error_t    first_error = ASFPARSE_ERROR_OK;
+    batch_t             batch;
+    path_source_t       source;
+    prefetch_t         *engine = NULL;
+    asfparse_ctx_t     *ctx = NULL;
+    header_cache_t     *cache = NULL;
+    int                 io_depth = params->io_depth;
+    size_t              i;
+
+    /* open the list of input names, if any */
+    if (path_source_open(&source, params) != ASFPARSE_ERROR_OK)
+    {
+        printf("Error opening list file\n");
+        return ASFPARSE_ERROR_OPEN_FILE;
+    }
+
+    /* the cache is only checked by the thread that parses prefetched
+       headers, so it needs at least one read in flight */
+    if (params->p_cache_filename != NULL)
+    {
+        if (header_cache_open(params->p_cache_filename, &cache) != ASFPARSE_ERROR_OK)
+        {
+            printf("Error opening cache file\n");
+            path_source_close(&source);
+            return ASFPARSE_ERROR_OPEN_FILE;
+        }
+        if (io_depth == 0)
+        {
+            io_depth = 1;
+        }
+    }
+
+    /* reading only headers is bound by I/O latency rather than parsing,
+       so keep many reads in flight from this thread instead */
+    if (io_depth > 0 && !params->parse_packets && !params->parse_index)
+    {
+        engine = prefetch_create((unsigned int)io_depth);
+        ctx = process_create_context(params);
+        if (engine == NULL || ctx == NULL)
+        {
+            prefetch_destroy(engine);
+            asfparse_destroy(ctx);
+            engine = NULL;
+            ctx = NULL;
+        }
+    }
+
+    /* set up the slot ring */
+    memset(&batch, 0, sizeof(batch_t));
+    batch.params = params;
+    batch.num_slots = (engine != NULL) ? (size_t)io_depth * BATCH_SLOTS_PER_READ
+                                       : (size_t)params->num_threads * BATCH_SLOTS_PER_THREAD;
+    batch.slots = calloc(batch.num_slots, sizeof(batch_slot_t));
+    if (batch.slots == NULL)
+    {
+        prefetch_destroy(engine);
+        asfparse_destroy(ctx);
+        header_cache_close(cache);
+        path_source_close(&source);
+        return ASFPARSE_ERROR_OPEN_FILE;
+    }
+    pthread_mutex_init(&batch.lock, NULL);
+    pthread_cond_init(&batch.work_ready, NULL);
+    pthread_cond_init(&batch.slot_done, NULL);
+
+    if (engine != NULL)
+    {
+        run_prefetch(&batch, &source, engine, ctx, cache, &first_error);
+        prefetch_destroy(engine);
+        asfparse_destroy(ctx);
+    }
+    else
+    {
+        run_workers(&batch, &source, &first_error);
+    }
+
+    /* release resources */
+    for (i = 0; i < batch.num_slots; i++)
+    {
+        free(batch.slots[i].p_filename);
+        output_free(&batch.slots[i].out);
+    }
+    free(batch.slots);
+    header_cache_close(cache);
+    pthread_cond_destroy(&batch.slot_done);
+    pthread_cond_destroy(&batch.work_ready);
+    pthread_mutex_destroy(&batch.lock);
+
+    path_source_close(&source);
+
+    return first_error;
+}
@@ -0,0 +1,71 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+/* Includes */
+#include <stdio.h>
+#include "cli.h"
+
+/* Defines and constants */
+#define BATCH_SLOTS_PER_THREAD  (4)     /* files in flight per worker thread; bounds the reorder buffer */
+#define BATCH_SLOTS_PER_READ    (2)     /* files in the reorder buffer per header read in flight */
+
+/* Enums and structs */
+/* Structure describing where input file names come from */
+typedef struct {
+    const params_t     *params;         /* command-line file names and list options */
+    int                 next_argument;  /* index of next entry in params->pp_filenames */
+    FILE               *p_list;         /* open list file, or NULL */
+    char               *p_line;         /* getdelim() line buffer */
+    size_t              line_capacity;  /* size of p_line */
+} path_source_t;
+
+/* Function prototypes */
+/*****************************************************************************
+* NAME:  path_source_open
+* DESCRIPTION: Start reading input file names from the command line and
+*              then from the list file named in params, if any
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+path_source_open
+    (path_source_t     *source      /* [out] source of input file names */
+    ,const params_t    *params      /* [in] structure containing user-defined parameters */
+    );
+
+/*****************************************************************************
+* NAME:  path_source_next
+* DESCRIPTION: Get the next input file name, first from the command line and
+*              then from the list file if one was given
+* RETURNS: pointer to a NUL-terminated name valid until the next call, or
+*          NULL when there are no more names
+******************************************************************************/
+const char *
+path_source_next
+    (path_source_t     *source      /* [in,out] source of input file names */
+    );
+
+/*****************************************************************************
+* NAME:  path_source_close
+* DESCRIPTION: Release a source of input file names
+* RETURNS: none
+******************************************************************************/
+void
+path_source_close
+    (path_source_t     *source      /* [in,out] source of input file names */
+    );
+
+/*****************************************************************************
+* NAME:  run_batch
+* DESCRIPTION: Parse every input file named in params on a pool of worker
+*              threads, or, when only headers are needed, with many header
+*              reads in flight, and write each file's output to stdout in
+*              input order
+* RETURNS: asfparse_error_t of the first file (in input order) that failed,
+*          or ASFPARSE_ERROR_OK
+******************************************************************************/
+asfparse_error_t
+run_batch
+    (const params_t    *params      /* [in] structure containing user-defined parameters */
+    );
+
+#endif
@@ -0,0 +1,856 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "util.h"
+#include "guid.h"
+#include "arena.h"
+#include "asfparse.h"
+#include "cursor.h"
+#include "packet.h"
+#include "parse.h"
+#include "scan.h"
+
+/* Defines and constants */
+#define DEFAULT_BASELINE        "bench_baseline.txt"
+#define DEFAULT_TOLERANCE       (20)                /* percent a median may worsen before it counts as a regression */
+#define MIN_SAMPLE_NS           (2000000)           /* shortest timed sample; short operations are repeated to reach it */
+#define MICRO_SAMPLES           (101)               /* samples per microbenchmark and header scan */
+#define DATA_SCAN_SAMPLES       (11)                /* samples of the Data Object scan, which takes much longer */
+#define MAX_NAME_LENGTH         (64)
+#define MAX_BENCHMARKS          (32)
+#define HEADER_PREFIX_LENGTH    (30)                /* header object fields before its first child object */
+#define DATA_PREFIX_LENGTH      (50)                /* data object fields before the first data packet */
+
+/* Enums and structs */
+/* Enum describing the unit a benchmark is reported in */
+typedef enum {
+     BENCH_UNIT_NS_PER_OP = 0   /* nanoseconds per call, lower is better */
+    ,BENCH_UNIT_FILES_PER_SEC   /* files parsed per second, higher is better */
+    ,BENCH_UNIT_MB_PER_SEC      /* megabytes parsed per second, higher is better */
+} bench_unit_t;
+
+/* Structure describing the input files and the objects located in them */
+typedef struct {
+    const char         *p_header_filename;  /* file with a large header, a few packets and a simple index */
+    const char         *p_data_filename;    /* file with a large Data Object */
+    mapped_file_t       header_file;
+    long long           offsets[NUM_OBJECT_TYPES];  /* file offset of the first object of each type, or -1 */
+    unsigned int        packet_size;        /* fixed size of the data packets in the header file */
+    long long           num_packets;        /* number of data packets in the header file */
+    long long           data_file_size;     /* bytes in the data file */
+    arena_t             arena;              /* arena reset after each codec list or descriptor parse */
+    asfparse_ctx_t     *header_ctx;         /* context parsing the header only */
+    asfparse_ctx_t     *data_ctx;           /* context decoding every data packet */
+    asfparse_ctx_t     *summary_ctx;        /* context summarising the data packets on every CPU */
+} bench_fixture_t;
+
+typedef struct bench_s bench_t;
+
+/* Function running a benchmark's operation iterations times */
+typedef asfparse_error_t (*bench_fn_t)
+    (bench_fixture_t       *fixture     /* [in,out] input files */
+    ,const bench_t         *bench       /* [in] benchmark being run */
+    ,unsigned long long     iterations  /* [in] number of operations */
+    );
+
+/* Structure describing one benchmark */
+struct bench_s {
+    const char     *p_name;             /* name in reports and the baseline file */
+    bench_fn_t      fn;
+    object_type_t   object_type;        /* object parsed by bench_object_parser */
+    bench_unit_t    unit;
+    int             num_samples;
+};
+
+/* Structure describing the measurements of one benchmark, in its unit */
+typedef struct {
+    double          median;
+    double          p99;                /* the slowest percentile, so below the median for throughput */
+} bench_result_t;
+
+/* Structure describing an entry of the baseline file */
+typedef struct {
+    char            name[MAX_NAME_LENGTH];
+    double          median;
+} baseline_entry_t;
+
+/* Structure describing command-line input */
+typedef struct {
+    const char     *p_baseline_filename;
+    int             write_baseline;     /* non-zero to store this run as the new baseline */
+    int             tolerance;          /* percent */
+    const char     *p_header_filename;
+    const char     *p_data_filename;
+} bench_params_t;
+
+/* Function prototypes */
+static asfparse_error_t bench_object_type(bench_fixture_t *fixture, const bench_t *bench, unsigned long long iterations);
+static asfparse_error_t bench_object_parser(bench_fixture_t *fixture, const bench_t *bench, unsigned long long iterations);
+static asfparse_error_t bench_data_packet(bench_fixture_t *fixture, const bench_t *bench, unsigned long long iterations);
+static asfparse_error_t bench_header_scan(bench_fixture_t *fixture, const bench_t *bench, unsigned long long iterations);
+static asfparse_error_t bench_data_scan(bench_fixture_t *fixture, const bench_t *bench, unsigned long long iterations);
+static asfparse_error_t bench_parallel_scan(bench_fixture_t *fixture, const bench_t *bench, unsigned long long iterations);
+
+/* Benchmarks, in the order they are run and reported */
+static const bench_t BENCHMARKS[] =
+{
+     { "get_object_type",                              bench_object_type,   OBJECT_TYPE_NONE,                         BENCH_UNIT_NS_PER_OP,     MICRO_SAMPLES }
+    ,{ "parse_header_object",                          bench_object_parser, OBJECT_TYPE_HEADER,                       BENCH_UNIT_NS_PER_OP,     MICRO_SAMPLES }
+    ,{ "parse_file_properties_object",                 bench_object_parser, OBJECT_TYPE_FILE_PROPERTIES,              BENCH_UNIT_NS_PER_OP,     MICRO_SAMPLES }
+    ,{ "parse_stream_properties_object",               bench_object_parser, OBJECT_TYPE_STREAM_PROPERTIES,            BENCH_UNIT_NS_PER_OP,     MICRO_SAMPLES }
+    ,{ "parse_header_extension_object",                bench_object_parser, OBJECT_TYPE_HEADER_EXTENSION,             BENCH_UNIT_NS_PER_OP,     MICRO_SAMPLES }
+    ,{ "parse_codec_list_object",                      bench_object_parser, OBJECT_TYPE_CODEC_LIST,                   BENCH_UNIT_NS_PER_OP,     MICRO_SAMPLES }
+    ,{ "parse_extended_content_description_object",    bench_object_parser, OBJECT_TYPE_EXTENDED_CONTENT_DESCRIPTION, BENCH_UNIT_NS_PER_OP,     MICRO_SAMPLES }
+    ,{ "parse_stream_bitrate_properties_object",       bench_object_parser, OBJECT_TYPE_STREAM_BITRATE_PROPERTIES,    BENCH_UNIT_NS_PER_OP,     MICRO_SAMPLES }
+    ,{ "parse_data_object",                            bench_object_parser, OBJECT_TYPE_DATA,                         BENCH_UNIT_NS_PER_OP,     MICRO_SAMPLES }
+    ,{ "parse_simple_index_object",                    bench_object_parser, OBJECT_TYPE_SIMPLE_INDEX,                 BENCH_UNIT_NS_PER_OP,     MICRO_SAMPLES }
+    ,{ "parse_data_packet",                            bench_data_packet,   OBJECT_TYPE_NONE,                         BENCH_UNIT_NS_PER_OP,     MICRO_SAMPLES }
+    ,{ "header_scan",                                  bench_header_scan,   OBJECT_TYPE_NONE,                         BENCH_UNIT_FILES_PER_SEC, MICRO_SAMPLES }
+    ,{ "data_scan",                                    bench_data_scan,     OBJECT_TYPE_NONE,                         BENCH_UNIT_MB_PER_SEC,    DATA_SCAN_SAMPLES }
+    ,{ "parallel_data_scan",                           bench_parallel_scan, OBJECT_TYPE_NONE,                         BENCH_UNIT_MB_PER_SEC,    DATA_SCAN_SAMPLES }
+};
+
+#define NUM_BENCHMARKS  (sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]))
+
+static const char *UNIT_NAMES[] = { "ns/op", "files/s", "MB/s" };
+
+/*****************************************************************************
+* NAME:  now_ns
+* DESCRIPTION: Read the monotonic clock
+* RETURNS: nanoseconds since an arbitrary point
+******************************************************************************/
+static double
+now_ns
+    (
+    )
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/*****************************************************************************
+* NAME:  compare_doubles
+* DESCRIPTION: Order two doubles for qsort
+* RETURNS: negative, zero or positive
+******************************************************************************/
+static int
+compare_doubles
+    (const void    *p_a     /* [in] first double */
+    ,const void    *p_b     /* [in] second double */
+    )
+{
+    double  a = *(const double *)p_a;
+    double  b = *(const double *)p_b;
+
+    return (a > b) - (a < b);
+}
+
+/*****************************************************************************
+* NAME:  count_event
+* DESCRIPTION: Callback counting the events of an end-to-end parse
+* RETURNS: 0 to keep parsing
+******************************************************************************/
+static int
+count_event
+    (void                      *p_user      /* [in] long long event count */
+    ,const asfparse_event_t    *event       /* [in] event */
+    )
+{
+    (*(long long *)p_user)++;
+
+    return event->kind == ASFPARSE_EVENT_ERROR;
+}
+
+/*****************************************************************************
+* NAME:  bench_object_type
+* DESCRIPTION: Classify every GUID of the registry in turn; objects that are
+*              skipped fail the lookup, as unknown objects do
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+bench_object_type
+    (bench_fixture_t       *fixture     /* [in,out] input files */
+    ,const bench_t         *bench       /* [in] benchmark being run */
+    ,unsigned long long     iterations  /* [in] number of operations */
+    )
+{
+    object_type_t       object_type;
+    unsigned long long  num_found = 0;
+    unsigned long long  i;
+    int                 j = 0;
+
+    (void)fixture;
+    (void)bench;
+
+    for (i = 0; i < iterations; i++)
+    {
+        if (get_object_type(GUID_REGISTRY[j].guid, &object_type) == ASFPARSE_ERROR_OK)
+        {
+            num_found++;
+        }
+        j = (j + 1 < NUM_GUIDS) ? j + 1 : 0;
+    }
+
+    return (num_found > 0) ? ASFPARSE_ERROR_OK : ASFPARSE_ERROR_OBJECT_NOT_FOUND;
+}
+
+/*****************************************************************************
+* NAME:  bench_object_parser
+* DESCRIPTION: Parse the first object of bench->object_type in the header
+*              file, as the parser does after reading its GUID
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+bench_object_parser
+    (bench_fixture_t       *fixture     /* [in,out] input files */
+    ,const bench_t         *bench       /* [in] benchmark being run */
+    ,unsigned long long     iterations  /* [in] number of operations */
+    )
+{
+    asfparse_error_t                        error = ASFPARSE_ERROR_OK;
+    cursor_t                                cur;
+    size_t                                  offset = (size_t)fixture->offsets[bench->object_type];
+    unsigned long long                      i;
+
+    /* declare structs filled by the parsers */
+    header_object_t                         header;
+    file_properties_object_t                file_properties;
+    stream_properties_object_t              stream_properties;
+    header_extension_object_t               header_extension;
+    codec_list_object_t                     codec_list;
+    extended_content_description_object_t   ext_content_descr;
+    stream_bitrate_properties_object_t      stream_bitrate_properties;
+    data_object_t                           data;
+    simple_index_object_t                   simple_index;
+
+    for (i = 0; i < iterations && error == ASFPARSE_ERROR_OK; i++)
+    {
+        cursor_init(&cur, fixture->header_file.p_data + offset, fixture->header_file.size - offset);
+        if (bench->object_type != OBJECT_TYPE_HEADER)
+        {
+            cursor_skip(&cur, GUID_LENGTH_IN_BYTES);
+        }
+
+        switch (bench->object_type)
+        {
+        case OBJECT_TYPE_HEADER:
+            error = parse_header_object(&header, &cur);
+            break;
+        case OBJECT_TYPE_FILE_PROPERTIES:
+            error = parse_file_properties_object(&file_properties, &cur);
+            break;
+        case OBJECT_TYPE_STREAM_PROPERTIES:
+            error = parse_stream_properties_object(&stream_properties, &cur);
+            break;
+        case OBJECT_TYPE_HEADER_EXTENSION:
+            error = parse_header_extension_object(&header_extension, &cur);
+            break;
+        case OBJECT_TYPE_CODEC_LIST:
+            error = parse_codec_list_object(&codec_list, &cur, &fixture->arena);
+            arena_reset(&fixture->arena);
+            break;
+        case OBJECT_TYPE_EXTENDED_CONTENT_DESCRIPTION:
+            error = parse_extended_content_description_object(&ext_content_descr, &cur, &fixture->arena);
+            arena_reset(&fixture->arena);
+            break;
+        case OBJECT_TYPE_STREAM_BITRATE_PROPERTIES:
+            error = parse_stream_bitrate_properties_object(&stream_bitrate_properties, &cur);
+            break;
+        case OBJECT_TYPE_DATA:
+            error = parse_data_object(&data, &cur);
+            break;
+        case OBJECT_TYPE_SIMPLE_INDEX:
+            error = parse_simple_index_object(&simple_index, &cur);
+            break;
+        default:
+            error = ASFPARSE_ERROR_UNSUPPORTED_OBJECT_TYPE;
+            break;
+        }
+    }
+
+    return error;
+}
+
+/*****************************************************************************
+* NAME:  bench_data_packet
+* DESCRIPTION: Decode the data packets of the header file in turn
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+bench_data_packet
+    (bench_fixture_t       *fixture     /* [in,out] input files */
+    ,const bench_t         *bench       /* [in] benchmark being run */
+    ,unsigned long long     iterations  /* [in] number of operations */
+    )
+{
+    asfparse_error_t    error = ASFPARSE_ERROR_OK;
+    data_packet_t       packet;
+    cursor_t            cur;
+    const char         *p_packets;
+    unsigned long long  i;
+
+    (void)bench;
+
+    p_packets = fixture->header_file.p_data + fixture->offsets[OBJECT_TYPE_DATA] + DATA_PREFIX_LENGTH;
+    for (i = 0; i < iterations && error == ASFPARSE_ERROR_OK; i++)
+    {
+        cursor_init(&cur, p_packets + (i % (unsigned long long)fixture->num_packets) * fixture->packet_size,
+                    fixture->packet_size);
+        error = parse_data_packet(&packet, &cur, fixture->packet_size);
+    }
+
+    return error;
+}
+
+/*****************************************************************************
+* NAME:  bench_header_scan
+* DESCRIPTION: Open, map and parse the header of the header file, as a
+*              header-only scan of many files does for each file
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+bench_header_scan
+    (bench_fixture_t       *fixture     /* [in,out] input files */
+    ,const bench_t         *bench       /* [in] benchmark being run */
+    ,unsigned long long     iterations  /* [in] number of operations */
+    )
+{
+    asfparse_error_t    error = ASFPARSE_ERROR_OK;
+    long long           num_events = 0;
+    unsigned long long  i;
+
+    (void)bench;
+
+    for (i = 0; i < iterations && error == ASFPARSE_ERROR_OK; i++)
+    {
+        error = asfparse_parse_file(fixture->header_ctx, fixture->p_header_filename, count_event, &num_events);
+    }
+
+    return error;
+}
+
+/*****************************************************************************
+* NAME:  bench_data_scan
+* DESCRIPTION: Parse the data file decoding every data packet
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+bench_data_scan
+    (bench_fixture_t       *fixture     /* [in,out] input files */
+    ,const bench_t         *bench       /* [in] benchmark being run */
+    ,unsigned long long     iterations  /* [in] number of operations */
+    )
+{
+    asfparse_error_t    error = ASFPARSE_ERROR_OK;
+    long long           num_events = 0;
+    unsigned long long  i;
+
+    (void)bench;
+
+    for (i = 0; i < iterations && error == ASFPARSE_ERROR_OK; i++)
+    {
+        error = asfparse_parse_file(fixture->data_ctx, fixture->p_data_filename, count_event, &num_events);
+    }
+
+    return error;
+}
+
+/*****************************************************************************
+* NAME:  bench_parallel_scan
+* DESCRIPTION: Parse the data file summarising the data packets on as many
+*              threads as there are CPUs
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+bench_parallel_scan
+    (bench_fixture_t       *fixture     /* [in,out] input files */
+    ,const bench_t         *bench       /* [in] benchmark being run */
+    ,unsigned long long     iterations  /* [in] number of operations */
+    )
+{
+    asfparse_error_t    error = ASFPARSE_ERROR_OK;
+    long long           num_events = 0;
+    unsigned long long  i;
+
+    (void)bench;
+
+    for (i = 0; i < iterations && error == ASFPARSE_ERROR_OK; i++)
+    {
+        error = asfparse_parse_file(fixture->summary_ctx, fixture->p_data_filename, count_event, &num_events);
+    }
+
+    return error;
+}
+
+/*****************************************************************************
+* NAME:  locate_objects
+* DESCRIPTION: Find the objects of the header file and the layout of its
+*              data packets
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+locate_objects
+    (bench_fixture_t   *fixture     /* [in,out] input files */
+    )
+{
+    asfparse_error_t            error;
+    file_properties_object_t    file_properties;
+    data_object_t               data;
+    object_type_t               object_type;
+    cursor_t                    cur;
+    const char                 *object_id;
+    size_t                      object_start;
+    long long                   object_size;
+    int                         i;
+
+    for (i = 0; i < NUM_OBJECT_TYPES; i++)
+    {
+        fixture->offsets[i] = -1;
+    }
+
+    /* the header objects follow the Header Object prefix and are followed
+       in turn by the Data Object and the index objects, so one walk over
+       the object sizes visits every object */
+    fixture->offsets[OBJECT_TYPE_HEADER] = 0;
+    cursor_init(&cur, fixture->header_file.p_data, fixture->header_file.size);
+    cursor_seek(&cur, HEADER_PREFIX_LENGTH);
+
+    while (!cur.overrun && cur.pos < fixture->header_file.size)
+    {
+        object_start = cur.pos;
+        object_id = cursor_read_bytes(&cur, GUID_LENGTH_IN_BYTES);
+        object_size = cursor_read_uint64(&cur);
+        if (cur.overrun || object_size < GUID_LENGTH_IN_BYTES + 8)
+        {
+            return ASFPARSE_ERROR_INVALID_ASF_FILE;
+        }
+        if (get_object_type(object_id, &object_type) == ASFPARSE_ERROR_OK && fixture->offsets[object_type] < 0)
+        {
+            fixture->offsets[object_type] = (long long)object_start;
+        }
+        cursor_seek(&cur, object_start + (size_t)object_size);
+    }
+
+    for (i = 0; i < NUM_OBJECT_TYPES; i++)
+    {
+        if (fixture->offsets[i] < 0 && i != OBJECT_TYPE_NONE && i != OBJECT_TYPE_INDEX)
+        {
+            return ASFPARSE_ERROR_OBJECT_NOT_FOUND;
+        }
+    }
+
+    /* work out where the data packets are */
+    cursor_init(&cur, fixture->header_file.p_data, fixture->header_file.size);
+    cursor_seek(&cur, (size_t)fixture->offsets[OBJECT_TYPE_FILE_PROPERTIES] + GUID_LENGTH_IN_BYTES);
+    error = parse_file_properties_object(&file_properties, &cur);
+    if (error == ASFPARSE_ERROR_OK)
+    {
+        cursor_seek(&cur, (size_t)fixture->offsets[OBJECT_TYPE_DATA] + GUID_LENGTH_IN_BYTES);
+        error = parse_data_object(&data, &cur);
+    }
+    if (error == ASFPARSE_ERROR_OK)
+    {
+        error = packet_layout(&data, &file_properties, &fixture->packet_size, &fixture->num_packets);
+    }
+    if (error == ASFPARSE_ERROR_OK && (fixture->packet_size == 0 || fixture->num_packets == 0))
+    {
+        error = ASFPARSE_ERROR_UNSUPPORTED_OBJECT_TYPE;
+    }
+
+    return error;
+}
+
+/*****************************************************************************
+* NAME:  setup_fixture
+* DESCRIPTION: Map the input files and create the parser contexts
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+setup_fixture
+    (bench_fixture_t       *fixture     /* [out] input files */
+    ,const bench_params_t  *params      /* [in] command-line input */
+    )
+{
+    asfparse_error_t    error;
+    asfparse_options_t  options;
+    mapped_file_t       data_file;
+    long                num_cpus;
+
+    memset(fixture, 0, sizeof(bench_fixture_t));
+    fixture->p_header_filename = params->p_header_filename;
+    fixture->p_data_filename = params->p_data_filename;
+    arena_init(&fixture->arena, ARENA_DEFAULT_BLOCK_SIZE);
+
+    error = map_file(params->p_header_filename, &fixture->header_file);
+    if (error != ASFPARSE_ERROR_OK)
+    {
+        printf("Error opening %s: %s\n", params->p_header_filename, asfparse_error_string(error));
+        return error;
+    }
+    error = locate_objects(fixture);
+    if (error != ASFPARSE_ERROR_OK)
+    {
+        printf("Error in %s: %s\n", params->p_header_filename, asfparse_error_string(error));
+        return error;
+    }
+
+    error = map_file(params->p_data_filename, &data_file);
+    if (error != ASFPARSE_ERROR_OK)
+    {
+        printf("Error opening %s: %s\n", params->p_data_filename, asfparse_error_string(error));
+        return error;
+    }
+    fixture->data_file_size = (long long)data_file.size;
+    unmap_file(&data_file);
+
+    memset(&options, 0, sizeof(asfparse_options_t));
+    fixture->header_ctx = asfparse_create(&options);
+    options.parse_packets = 1;
+    fixture->data_ctx = asfparse_create(&options);
+    num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    options.packet_threads = (num_cpus > 0 && num_cpus < SCAN_MAX_THREADS) ? (int)num_cpus : 1;
+    fixture->summary_ctx = asfparse_create(&options);
+    if (fixture->header_ctx == NULL || fixture->data_ctx == NULL || fixture->summary_ctx == NULL)
+    {
+        return ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  cleanup_fixture
+* DESCRIPTION: Release everything held by a fixture
+* RETURNS: none
+******************************************************************************/
+static void
+cleanup_fixture
+    (bench_fixture_t   *fixture     /* [in,out] input files */
+    )
+{
+    if (fixture->header_file.p_data != NULL)
+    {
+        unmap_file(&fixture->header_file);
+    }
+    if (fixture->header_ctx != NULL)
+    {
+        asfparse_destroy(fixture->header_ctx);
+    }
+    if (fixture->data_ctx != NULL)
+    {
+        asfparse_destroy(fixture->data_ctx);
+    }
+    if (fixture->summary_ctx != NULL)
+    {
+        asfparse_destroy(fixture->summary_ctx);
+    }
+    arena_free(&fixture->arena);
+}
+
+/*****************************************************************************
+* NAME:  run_benchmark
+* DESCRIPTION: Time a benchmark. The number of operations per sample is
+*              doubled until a sample takes MIN_SAMPLE_NS, then num_samples
+*              samples are taken and converted to the benchmark's unit.
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+run_benchmark
+    (bench_fixture_t   *fixture     /* [in,out] input files */
+    ,const bench_t     *bench       /* [in] benchmark to run */
+    ,bench_result_t    *result      /* [out] measurements */
+    )
+{
+    asfparse_error_t    error;
+    unsigned long long  iterations = 1;
+    double              samples[MICRO_SAMPLES];
+    double              start;
+    double              elapsed;
+    double              median;
+    double              p99;
+    int                 i;
+
+    /* calibrate; this also warms the caches and the page cache */
+    for (;;)
+    {
+        start = now_ns();
+        error = bench->fn(fixture, bench, iterations);
+        elapsed = now_ns() - start;
+        if (error != ASFPARSE_ERROR_OK || elapsed >= MIN_SAMPLE_NS)
+        {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    for (i = 0; i < bench->num_samples && error == ASFPARSE_ERROR_OK; i++)
+    {
+        start = now_ns();
+        error = bench->fn(fixture, bench, iterations);
+        samples[i] = (now_ns() - start) / (double)iterations;
+    }
+    if (error != ASFPARSE_ERROR_OK)
+    {
+        return error;
+    }
+
+    /* samples are nanoseconds per operation, so the 99th percentile is the
+       slow end whatever the unit */
+    qsort(samples, (size_t)bench->num_samples, sizeof(double), compare_doubles);
+    median = samples[bench->num_samples / 2];
+    p99 = samples[(bench->num_samples * 99) / 100];
+
+    switch (bench->unit)
+    {
+    case BENCH_UNIT_FILES_PER_SEC:
+        result->median = 1e9 / median;
+        result->p99 = 1e9 / p99;
+        break;
+    case BENCH_UNIT_MB_PER_SEC:
+        result->median = (double)fixture->data_file_size * 1e3 / median;
+        result->p99 = (double)fixture->data_file_size * 1e3 / p99;
+        break;
+    default:
+        result->median = median;
+        result->p99 = p99;
+        break;
+    }
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  read_baseline
+* DESCRIPTION: Read the baseline file, lines of "name median unit" with
+*              comments starting with '#'
+* RETURNS: number of entries read, or -1 if the file cannot be opened
+******************************************************************************/
+static int
+read_baseline
+    (const char        *p_filename  /* [in] name of baseline file */
+    ,baseline_entry_t  *entries     /* [out] MAX_BENCHMARKS entries */
+    )
+{
+    FILE   *p_file = fopen(p_filename, "r");
+    char    line[256];
+    int     num_entries = 0;
+
+    if (p_file == NULL)
+    {
+        return -1;
+    }
+
+    while (num_entries < MAX_BENCHMARKS && fgets(line, sizeof(line), p_file) != NULL)
+    {
+        if (line[0] != '#'
+            && sscanf(line, "%63s %lf", entries[num_entries].name, &entries[num_entries].median) == 2)
+        {
+            num_entries++;
+        }
+    }
+    fclose(p_file);
+
+    return num_entries;
+}
+
+/*****************************************************************************
+* NAME:  write_baseline
+* DESCRIPTION: Store the medians of this run as the baseline
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+write_baseline
+    (const char            *p_filename  /* [in] name of baseline file */
+    ,const bench_result_t  *results     /* [in] one result per benchmark */
+    )
+{
+    FILE           *p_file = fopen(p_filename, "w");
+    unsigned int    i;
+
+    if (p_file == NULL)
+    {
+        printf("Error writing %s: %s\n", p_filename, strerror(errno));
+        return ASFPARSE_ERROR_OPEN_FILE;
+    }
+
+    fprintf(p_file, "# asfbench baseline: name median unit. Regenerate with 'make bench-baseline'.\n");
+    for (i = 0; i < NUM_BENCHMARKS; i++)
+    {
+        fprintf(p_file, "%s %.3f %s\n", BENCHMARKS[i].p_name, results[i].median, UNIT_NAMES[BENCHMARKS[i].unit]);
+    }
+
+    return (fclose(p_file) == 0) ? ASFPARSE_ERROR_OK : ASFPARSE_ERROR_OPEN_FILE;
+}
+
+/*****************************************************************************
+* NAME:  show_usage
+* DESCRIPTION: Display usage to command line
+* RETURNS: none
+******************************************************************************/
+static void
+show_usage
+    (
+    )
+{
+    printf("Usage: asfbench [options] <headerfile> <datafile>\n");
+    printf("Times each object parser on the objects of headerfile, header-only scans of\n");
+    printf("headerfile and full Data Object scans of datafile, and compares the medians\n");
+    printf("with a baseline file.\n");
+    printf("Options:\n");
+    printf("    -b <file>       baseline file (default: %s)\n", DEFAULT_BASELINE);
+    printf("    -t <percent>    how much a median may worsen before the run fails (default: %d)\n", DEFAULT_TOLERANCE);
+    printf("    -w              write this run to the baseline file instead of comparing\n");
+}
+
+/*****************************************************************************
+* NAME:  parse_bench_command_line
+* DESCRIPTION: Parse command-line input
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+parse_bench_command_line
+    (int                argc        /* [in] number of command line arguments */
+    ,char              *p_argv[]    /* [in] array of command line arguments */
+    ,bench_params_t    *params      /* [out] command-line input */
+    )
+{
+    int option;
+
+    /* set defaults */
+    memset(params, 0, sizeof(bench_params_t));
+    params->p_baseline_filename = DEFAULT_BASELINE;
+    params->tolerance = DEFAULT_TOLERANCE;
+
+    while ((option = getopt(argc, p_argv, "b:t:w")) != -1)
+    {
+        switch (option)
+        {
+        case 'b':
+            params->p_baseline_filename = optarg;
+            break;
+        case 't':
+            params->tolerance = atoi(optarg);
+            break;
+        case 'w':
+            params->write_baseline = 1;
+            break;
+        default:
+            show_usage();
+            return ASFPARSE_ERROR_INVALID_ARG;
+        }
+    }
+
+    if (params->tolerance <= 0 || optind != argc - 2)
+    {
+        show_usage();
+        return ASFPARSE_ERROR_INVALID_ARG;
+    }
+    params->p_header_filename = p_argv[optind];
+    params->p_data_filename = p_argv[optind + 1];
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME: main
+* DESCRIPTION: Entry point to application
+******************************************************************************/
+int
+main
+    (int argc
+    ,char* argv[]
+    )
+{
+    asfparse_error_t    error;
+    bench_params_t      params;
+    bench_fixture_t     fixture;
+    bench_result_t      results[NUM_BENCHMARKS];
+    baseline_entry_t    baseline[MAX_BENCHMARKS];
+    int                 num_baseline;
+    int                 num_regressions = 0;
+    double              slowdown;
+    const char         *p_status;
+    unsigned int        i;
+    int                 j;
+
+    error = parse_bench_command_line(argc, argv, &params);
+    if (error != ASFPARSE_ERROR_OK)
+    {
+        return error;
+    }
+
+    num_baseline = params.write_baseline ? -1 : read_baseline(params.p_baseline_filename, baseline);
+
+    error = setup_fixture(&fixture, &params);
+    if (error == ASFPARSE_ERROR_OK)
+    {
+        printf("%-44s %12s %12s %-8s %12s %8s\n", "benchmark", "median", "p99", "unit", "baseline", "change");
+    }
+    for (i = 0; i < NUM_BENCHMARKS && error == ASFPARSE_ERROR_OK; i++)
+    {
+        error = run_benchmark(&fixture, &BENCHMARKS[i], &results[i]);
+        if (error != ASFPARSE_ERROR_OK)
+        {
+            printf("Error in %s: %s\n", BENCHMARKS[i].p_name, asfparse_error_string(error));
+            break;
+        }
+
+        printf("%-44s %12.1f %12.1f %-8s", BENCHMARKS[i].p_name, results[i].median, results[i].p99,
+               UNIT_NAMES[BENCHMARKS[i].unit]);
+
+        for (j = 0; j < num_baseline && strcmp(baseline[j].name, BENCHMARKS[i].p_name) != 0; j++)
+        {
+        }
+        if (j >= num_baseline || baseline[j].median <= 0)
+        {
+            printf(" %12s %8s\n", "-", "-");
+            continue;
+        }
+
+        /* a regression is a median that got slower by more than the
+           tolerance, whichever direction the unit runs */
+        slowdown = (BENCHMARKS[i].unit == BENCH_UNIT_NS_PER_OP)
+                 ? results[i].median / baseline[j].median
+                 : baseline[j].median / results[i].median;
+        p_status = "";
+        if (slowdown > 1.0 + params.tolerance / 100.0)
+        {
+            p_status = "  REGRESSION";
+            num_regressions++;
+        }
+        printf(" %12.1f %+7.1f%%%s\n", baseline[j].median,
+               (results[i].median / baseline[j].median - 1.0) * 100.0, p_status);
+    }
+
+    if (error == ASFPARSE_ERROR_OK)
+    {
+        if (num_baseline < 0)
+        {
+            if (!params.write_baseline)
+            {
+                printf("No baseline in %s; storing this run as the baseline\n", params.p_baseline_filename);
+            }
+            error = write_baseline(params.p_baseline_filename, results);
+            if (error == ASFPARSE_ERROR_OK)
+            {
+                printf("Wrote baseline %s\n", params.p_baseline_filename);
+            }
+        }
+        else if (num_regressions > 0)
+        {
+            printf("%d benchmark(s) regressed by more than %d%% against %s\n",
+                   num_regressions, params.tolerance, params.p_baseline_filename);
+        }
+    }
+
+    cleanup_fixture(&fixture);
+
+    return (error == ASFPARSE_ERROR_OK && num_regressions > 0) ? EXIT_FAILURE : error;
+}
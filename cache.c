@@ -0,0 +1,906 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "cache.h"
+
+/* Defines and constants */
+#define CACHE_MAGIC             "ASFHCACH"  /* first bytes of a cache file */
+#define CACHE_MAGIC_LENGTH      (8)
+#define CACHE_VERSION           (1)
+#define CACHE_TABLE_OFFSET      (4096)      /* the file header has the first page to itself */
+#define CACHE_RECORD_ALIGN      (8)         /* records start on this boundary */
+#define HEADER_SIZE_OFFSET      (16)        /* Header Object size field follows its GUID */
+#define HEADER_MIN_SIZE         (24)        /* GUID and size */
+
+/* Enums and structs */
+/* Structure describing the start of a cache file. The file is laid out as
+   this header, the slot table from CACHE_TABLE_OFFSET, then the records,
+   all in the byte order of the machine that wrote it. */
+typedef struct {
+    char                magic[CACHE_MAGIC_LENGTH];
+    unsigned int        version;
+    unsigned int        slot_size;          /* sizeof(cache_slot_t), to reject another layout */
+    unsigned long long  num_slots;          /* power of two */
+    unsigned long long  num_entries;        /* slots in use */
+    unsigned long long  data_end;           /* file offset after the last record */
+} cache_file_header_t;
+
+/* Structure describing one slot of the open-addressed table. A writer fills
+   in the key before storing the record offset with release ordering, so a
+   reader that sees a record also sees its key. Slots are never changed once
+   in use; compaction writes a new file instead. */
+typedef struct {
+    header_cache_key_t  key;
+    unsigned long long  record;             /* file offset of the record, or 0 if the slot is free */
+} cache_slot_t;
+
+/* Structure describing the start of a record, which is followed by the
+   NUL-terminated name of the file and then its Header Object */
+typedef struct {
+    unsigned int        path_length;        /* bytes in the name, including the NUL */
+    unsigned int        header_length;      /* bytes in the Header Object */
+} cache_record_t;
+
+/* Structure describing an open cache file */
+struct header_cache_s {
+    char                   *p_filename;     /* name of cache file (owned) */
+    char                   *p_directory;    /* working directory that relative file names are stored under, or NULL */
+    int                     fd;             /* open cache file, or -1 */
+    int                     is_writable;    /* non-zero if entries can be added */
+    unsigned long long      device;         /* device of the open file, to notice it being replaced */
+    unsigned long long      inode;          /* inode of the open file */
+    char                   *p_map;          /* shared mapping of the whole file, or NULL */
+    size_t                  map_size;       /* number of bytes mapped */
+    cache_file_header_t    *header;         /* file header, at the start of p_map */
+    cache_slot_t           *slots;          /* slot table, in p_map */
+};
+
+/*****************************************************************************
+* NAME:  mix64
+* DESCRIPTION: Scramble the bits of a 64-bit value (the splitmix64 finalizer)
+* RETURNS: scrambled value
+******************************************************************************/
+static unsigned long long
+mix64
+    (unsigned long long     x       /* [in] value */
+    )
+{
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+
+    return x ^ (x >> 31);
+}
+
+/*****************************************************************************
+* NAME:  hash_key
+* DESCRIPTION: Hash a cache key
+* RETURNS: hash value
+******************************************************************************/
+static unsigned long long
+hash_key
+    (const header_cache_key_t  *key     /* [in] key of a file */
+    )
+{
+    unsigned long long  h;
+
+    h = mix64(key->inode);
+    h = mix64(h ^ key->device);
+    h = mix64(h ^ key->size);
+
+    return mix64(h ^ (unsigned long long)key->mtime);
+}
+
+/*****************************************************************************
+* NAME:  key_equal
+* DESCRIPTION: Compare two cache keys
+* RETURNS: non-zero if they are the same
+******************************************************************************/
+static int
+key_equal
+    (const header_cache_key_t  *a       /* [in] key */
+    ,const header_cache_key_t  *b       /* [in] key */
+    )
+{
+    return a->inode == b->inode && a->device == b->device
+        && a->size == b->size && a->mtime == b->mtime;
+}
+
+/*****************************************************************************
+* NAME:  write_at
+* DESCRIPTION: Write size bytes at an offset, retrying short writes
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+write_at
+    (int            fd          /* [in] open file */
+    ,const char    *p_src       /* [in] bytes to write */
+    ,size_t         size        /* [in] number of bytes */
+    ,off_t          offset      /* [in] file offset of the first byte */
+    )
+{
+    size_t  total = 0;
+    ssize_t n;
+
+    while (total < size)
+    {
+        n = pwrite(fd, p_src + total, size - total, offset + (off_t)total);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return ASFPARSE_ERROR_WRITE_FILE;
+        }
+        total += (size_t)n;
+    }
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  init_file
+* DESCRIPTION: Lay out an empty cache file with a table of num_slots slots
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+init_file
+    (int                    fd          /* [in] open, empty file */
+    ,unsigned long long     num_slots   /* [in] power of two */
+    )
+{
+    cache_file_header_t header;
+    off_t               table_end = CACHE_TABLE_OFFSET + (off_t)(num_slots * sizeof(cache_slot_t));
+
+    /* the table is a hole in the file until slots are used */
+    if (ftruncate(fd, table_end) != 0)
+    {
+        return ASFPARSE_ERROR_WRITE_FILE;
+    }
+
+    memset(&header, 0, sizeof(cache_file_header_t));
+    memcpy(header.magic, CACHE_MAGIC, CACHE_MAGIC_LENGTH);
+    header.version = CACHE_VERSION;
+    header.slot_size = sizeof(cache_slot_t);
+    header.num_slots = num_slots;
+    header.data_end = (unsigned long long)table_end;
+
+    return write_at(fd, (const char *)&header, sizeof(cache_file_header_t), 0);
+}
+
+/*****************************************************************************
+* NAME:  unmap_cache
+* DESCRIPTION: Release the mapping of a cache file
+* RETURNS: none
+******************************************************************************/
+static void
+unmap_cache
+    (header_cache_t    *cache       /* [in,out] cache handle */
+    )
+{
+    if (cache->p_map != NULL)
+    {
+        munmap(cache->p_map, cache->map_size);
+    }
+    cache->p_map = NULL;
+    cache->map_size = 0;
+    cache->header = NULL;
+    cache->slots = NULL;
+}
+
+/*****************************************************************************
+* NAME:  map_cache
+* DESCRIPTION: Map the whole of the open cache file, as far as it has been
+*              written, and check that it is a cache file
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+map_cache
+    (header_cache_t    *cache       /* [in,out] cache handle with an open file */
+    )
+{
+    const cache_file_header_t  *header;
+    struct stat                 st;
+    void                       *p_map;
+    int                         prot = cache->is_writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+
+    unmap_cache(cache);
+    if (fstat(cache->fd, &st) != 0)
+    {
+        return ASFPARSE_ERROR_OPEN_FILE;
+    }
+    if ((unsigned long long)st.st_size < CACHE_TABLE_OFFSET)
+    {
+        return ASFPARSE_ERROR_INVALID_ARG;
+    }
+
+    p_map = mmap(NULL, (size_t)st.st_size, prot, MAP_SHARED, cache->fd, 0);
+    if (p_map == MAP_FAILED)
+    {
+        return ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
+    cache->p_map = p_map;
+    cache->map_size = (size_t)st.st_size;
+
+    header = p_map;
+    if (memcmp(header->magic, CACHE_MAGIC, CACHE_MAGIC_LENGTH) != 0
+        || header->version != CACHE_VERSION
+        || header->slot_size != sizeof(cache_slot_t)
+        || header->num_slots == 0
+        || (header->num_slots & (header->num_slots - 1)) != 0
+        || header->num_slots > (cache->map_size - CACHE_TABLE_OFFSET) / sizeof(cache_slot_t))
+    {
+        unmap_cache(cache);
+        return ASFPARSE_ERROR_INVALID_ARG;
+    }
+    cache->header = p_map;
+    cache->slots = (cache_slot_t *)(cache->p_map + CACHE_TABLE_OFFSET);
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  close_file
+* DESCRIPTION: Unmap and close the cache file of a handle, which releases
+*              any lock held on it
+* RETURNS: none
+******************************************************************************/
+static void
+close_file
+    (header_cache_t    *cache       /* [in,out] cache handle */
+    )
+{
+    unmap_cache(cache);
+    if (cache->fd >= 0)
+    {
+        close(cache->fd);
+    }
+    cache->fd = -1;
+}
+
+/*****************************************************************************
+* NAME:  open_file
+* DESCRIPTION: Open and map the cache file named in a handle, creating it if
+*              it does not exist
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+open_file
+    (header_cache_t    *cache       /* [in,out] cache handle with no open file */
+    )
+{
+    asfparse_error_t    error = ASFPARSE_ERROR_OK;
+    struct stat         st;
+
+    cache->is_writable = 1;
+    cache->fd = open(cache->p_filename, O_RDWR | O_CREAT, 0644);
+    if (cache->fd < 0 && (errno == EACCES || errno == EROFS || errno == EPERM))
+    {
+        cache->is_writable = 0;
+        cache->fd = open(cache->p_filename, O_RDONLY);
+    }
+    if (cache->fd < 0 || fstat(cache->fd, &st) != 0)
+    {
+        close_file(cache);
+        return ASFPARSE_ERROR_OPEN_FILE;
+    }
+
+    /* whoever takes the lock first lays out a new file */
+    if (cache->is_writable && st.st_size == 0)
+    {
+        flock(cache->fd, LOCK_EX);
+        if (fstat(cache->fd, &st) != 0)
+        {
+            error = ASFPARSE_ERROR_OPEN_FILE;
+        }
+        else if (st.st_size == 0)
+        {
+            error = init_file(cache->fd, CACHE_MIN_SLOTS);
+        }
+        flock(cache->fd, LOCK_UN);
+    }
+    cache->device = (unsigned long long)st.st_dev;
+    cache->inode = (unsigned long long)st.st_ino;
+
+    if (error == ASFPARSE_ERROR_OK)
+    {
+        error = map_cache(cache);
+    }
+    if (error)
+    {
+        close_file(cache);
+    }
+
+    return error;
+}
+
+/*****************************************************************************
+* NAME:  reopen_if_replaced
+* DESCRIPTION: Switch to a newer cache file if the open one was replaced by
+*              compaction in this or another process
+* RETURNS: non-zero if the handle now refers to a different file
+******************************************************************************/
+static int
+reopen_if_replaced
+    (header_cache_t    *cache       /* [in,out] cache handle */
+    )
+{
+    struct stat     st;
+
+    if (stat(cache->p_filename, &st) != 0
+        || ((unsigned long long)st.st_dev == cache->device && (unsigned long long)st.st_ino == cache->inode))
+    {
+        return 0;
+    }
+
+    close_file(cache);
+
+    return open_file(cache) == ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  lock_current
+* DESCRIPTION: Take the writer lock on the cache file that currently has
+*              the cache's name, reopening it if it was replaced
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+lock_current
+    (header_cache_t    *cache       /* [in,out] cache handle */
+    )
+{
+    for (;;)
+    {
+        if (cache->fd < 0 && open_file(cache) != ASFPARSE_ERROR_OK)
+        {
+            return ASFPARSE_ERROR_OPEN_FILE;
+        }
+        if (flock(cache->fd, LOCK_EX) != 0)
+        {
+            return ASFPARSE_ERROR_WRITE_FILE;
+        }
+
+        /* a compaction that held the lock first may have renamed a new
+           file over this one */
+        if (!reopen_if_replaced(cache))
+        {
+            break;
+        }
+    }
+
+    /* records added since the file was mapped lie beyond the mapping */
+    if (cache->header == NULL || cache->header->data_end > cache->map_size)
+    {
+        if (map_cache(cache) != ASFPARSE_ERROR_OK)
+        {
+            flock(cache->fd, LOCK_UN);
+            return ASFPARSE_ERROR_OPEN_FILE;
+        }
+    }
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  find_slot
+* DESCRIPTION: Probe the table for a key
+* RETURNS: the slot holding the key, or the free slot that ends its probe
+*          sequence, or NULL if the table is full
+******************************************************************************/
+static cache_slot_t *
+find_slot
+    (const header_cache_t      *cache   /* [in] cache handle with a mapped file */
+    ,const header_cache_key_t  *key     /* [in] key of a file */
+    )
+{
+    cache_slot_t           *slot;
+    unsigned long long      mask = cache->header->num_slots - 1;
+    unsigned long long      i = hash_key(key) & mask;
+    unsigned long long      n;
+
+    for (n = 0; n <= mask; n++)
+    {
+        slot = &cache->slots[i];
+        if (__atomic_load_n(&slot->record, __ATOMIC_ACQUIRE) == 0 || key_equal(&slot->key, key))
+        {
+            return slot;
+        }
+        i = (i + 1) & mask;
+    }
+
+    return NULL;
+}
+
+/*****************************************************************************
+* NAME:  get_record
+* DESCRIPTION: Find a record in the mapping, mapping the file again if the
+*              record was added after it was mapped
+* RETURNS: the record, or NULL if it does not lie within the file
+******************************************************************************/
+static const cache_record_t *
+get_record
+    (header_cache_t        *cache       /* [in,out] cache handle */
+    ,unsigned long long     offset      /* [in] file offset of the record */
+    )
+{
+    const cache_record_t   *record;
+    int                     attempt;
+
+    for (attempt = 0; attempt < 2; attempt++)
+    {
+        if (offset <= cache->map_size && cache->map_size - offset >= sizeof(cache_record_t))
+        {
+            record = (const cache_record_t *)(cache->p_map + offset);
+            if (record->path_length > 0
+                && (unsigned long long)record->path_length + record->header_length
+                   <= cache->map_size - offset - sizeof(cache_record_t))
+            {
+                return record;
+            }
+        }
+        if (attempt == 0 && map_cache(cache) != ASFPARSE_ERROR_OK)
+        {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+/*****************************************************************************
+* NAME:  append_record
+* DESCRIPTION: Write a record after the last one and fill in a free slot
+*              with it. The writer lock must be held.
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+append_record
+    (header_cache_t            *cache       /* [in,out] cache handle */
+    ,cache_slot_t              *slot        /* [in,out] free slot */
+    ,const header_cache_key_t  *key         /* [in] key of the file */
+    ,const char                *p_record    /* [in] whole record */
+    ,size_t                     length      /* [in] number of bytes in p_record */
+    )
+{
+    asfparse_error_t    error;
+    unsigned long long  offset;
+
+    offset = (cache->header->data_end + CACHE_RECORD_ALIGN - 1) & ~(unsigned long long)(CACHE_RECORD_ALIGN - 1);
+    error = write_at(cache->fd, p_record, length, (off_t)offset);
+    if (error)
+    {
+        return error;
+    }
+
+    /* move the end first, so a writer that dies before the slot is filled
+       leaves a gap rather than a record that the next one overwrites */
+    cache->header->data_end = offset + length;
+    slot->key = *key;
+    __atomic_store_n(&slot->record, offset, __ATOMIC_RELEASE);
+    cache->header->num_entries++;
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  rebuild
+* DESCRIPTION: Copy the records of a cache file into a new file with a table
+*              of num_slots slots, rename it over the old one and switch the
+*              handle to it, still holding the writer lock. The writer lock
+*              on the old file must be held.
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+rebuild
+    (header_cache_t        *cache       /* [in,out] cache handle */
+    ,unsigned long long     num_slots   /* [in] power of two */
+    ,const unsigned char   *keep        /* [in] bit per slot of the entries to copy, or NULL for all */
+    )
+{
+    asfparse_error_t        error;
+    header_cache_t          new_cache;
+    const cache_record_t   *record;
+    cache_slot_t           *slot;
+    char                   *p_tmp_filename;
+    unsigned long long      offset;
+    unsigned long long      i;
+    struct stat             st;
+
+    p_tmp_filename = malloc(strlen(cache->p_filename) + 32);
+    if (p_tmp_filename == NULL)
+    {
+        return ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
+    sprintf(p_tmp_filename, "%s.%ld.tmp", cache->p_filename, (long)getpid());
+
+    memset(&new_cache, 0, sizeof(header_cache_t));
+    new_cache.p_filename = p_tmp_filename;
+    new_cache.is_writable = 1;
+    new_cache.fd = open(p_tmp_filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (new_cache.fd < 0)
+    {
+        free(p_tmp_filename);
+        return ASFPARSE_ERROR_WRITE_FILE;
+    }
+
+    /* the new file is locked before anyone can open it by name */
+    flock(new_cache.fd, LOCK_EX);
+    error = init_file(new_cache.fd, num_slots);
+    if (error == ASFPARSE_ERROR_OK)
+    {
+        error = map_cache(&new_cache);
+    }
+
+    for (i = 0; error == ASFPARSE_ERROR_OK && i < cache->header->num_slots; i++)
+    {
+        offset = cache->slots[i].record;
+        if (offset == 0 || (keep != NULL && !(keep[i / 8] & (1u << (i % 8)))))
+        {
+            continue;
+        }
+        record = get_record(cache, offset);
+        slot = find_slot(&new_cache, &cache->slots[i].key);
+        if (cache->header == NULL)
+        {
+            /* the old file could not be mapped again */
+            error = ASFPARSE_ERROR_OPEN_FILE;
+        }
+        else if (record != NULL && slot != NULL && slot->record == 0)
+        {
+            error = append_record(&new_cache, slot, &cache->slots[i].key, (const char *)record,
+                                  sizeof(cache_record_t) + record->path_length + record->header_length);
+        }
+    }
+
+    if (error == ASFPARSE_ERROR_OK
+        && (fsync(new_cache.fd) != 0 || rename(p_tmp_filename, cache->p_filename) != 0))
+    {
+        error = ASFPARSE_ERROR_WRITE_FILE;
+    }
+    if (error)
+    {
+        close_file(&new_cache);
+        unlink(p_tmp_filename);
+        free(p_tmp_filename);
+        return error;
+    }
+
+    /* closing the old file releases its lock; anyone waiting on it finds
+       that it was replaced */
+    close_file(cache);
+    fstat(new_cache.fd, &st);
+    cache->fd = new_cache.fd;
+    cache->is_writable = 1;
+    cache->device = (unsigned long long)st.st_dev;
+    cache->inode = (unsigned long long)st.st_ino;
+    cache->p_map = new_cache.p_map;
+    cache->map_size = new_cache.map_size;
+    cache->header = new_cache.header;
+    cache->slots = new_cache.slots;
+    free(p_tmp_filename);
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  header_cache_open
+* DESCRIPTION: Open a cache file, creating an empty one if it does not exist
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+header_cache_open
+    (const char        *p_filename  /* [in] name of cache file */
+    ,header_cache_t   **cache       /* [out] new handle */
+    )
+{
+    asfparse_error_t    error;
+    header_cache_t     *new_cache;
+
+    *cache = NULL;
+    new_cache = calloc(1, sizeof(header_cache_t));
+    if (new_cache == NULL)
+    {
+        return ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
+    new_cache->fd = -1;
+    new_cache->p_filename = strdup(p_filename);
+    if (new_cache->p_filename == NULL)
+    {
+        free(new_cache);
+        return ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
+
+    /* compaction checks the files named in the records, maybe from
+       another directory */
+    new_cache->p_directory = getcwd(NULL, 0);
+
+    error = open_file(new_cache);
+    if (error)
+    {
+        header_cache_close(new_cache);
+        return error;
+    }
+    *cache = new_cache;
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  header_cache_close
+* DESCRIPTION: Release a cache handle
+* RETURNS: none
+******************************************************************************/
+void
+header_cache_close
+    (header_cache_t    *cache       /* [in] cache handle, or NULL */
+    )
+{
+    if (cache == NULL)
+    {
+        return;
+    }
+    close_file(cache);
+    free(cache->p_filename);
+    free(cache->p_directory);
+    free(cache);
+}
+
+/*****************************************************************************
+* NAME:  header_cache_stat
+* DESCRIPTION: Get the cache key of a regular file with one stat() call
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+header_cache_stat
+    (const char            *p_filename  /* [in] name of file */
+    ,header_cache_key_t    *key         /* [out] key of the file */
+    )
+{
+    struct stat     st;
+
+    if (stat(p_filename, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        return ASFPARSE_ERROR_OPEN_FILE;
+    }
+
+    key->device = (unsigned long long)st.st_dev;
+    key->inode = (unsigned long long)st.st_ino;
+    key->size = (unsigned long long)st.st_size;
+#if defined(__APPLE__)
+    key->mtime = (long long)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    key->mtime = (long long)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  header_cache_lookup
+* DESCRIPTION: Find the Header Object stored for a file
+* RETURNS: non-zero if the file was found
+******************************************************************************/
+int
+header_cache_lookup
+    (header_cache_t            *cache       /* [in,out] cache handle */
+    ,const header_cache_key_t  *key         /* [in] key of the file */
+    ,const char               **pp_header   /* [out] Header Object of the file */
+    ,size_t                    *size        /* [out] number of bytes in the Header Object */
+    )
+{
+    const cache_record_t   *record;
+    cache_slot_t           *slot;
+    unsigned long long      offset;
+    int                     attempt;
+
+    /* a miss may only mean the file was compacted away under this handle */
+    for (attempt = 0; attempt < 2; attempt++)
+    {
+        if (cache->header != NULL)
+        {
+            /* a free slot may be filled by another process at any time, so
+               its key is only read after its record */
+            slot = find_slot(cache, key);
+            offset = (slot != NULL) ? __atomic_load_n(&slot->record, __ATOMIC_ACQUIRE) : 0;
+            if (offset != 0 && key_equal(&slot->key, key))
+            {
+                record = get_record(cache, offset);
+                if (record == NULL)
+                {
+                    return 0;
+                }
+                *pp_header = (const char *)(record + 1) + record->path_length;
+                *size = record->header_length;
+                return 1;
+            }
+        }
+        if (attempt == 0 && !reopen_if_replaced(cache))
+        {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************
+* NAME:  header_cache_insert
+* DESCRIPTION: Store the Header Object at the start of p_data for a file,
+*              doubling the table first if it is full
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+header_cache_insert
+    (header_cache_t            *cache       /* [in,out] cache handle */
+    ,const header_cache_key_t  *key         /* [in] key of the file */
+    ,const char                *p_filename  /* [in] name of the file, kept for compaction */
+    ,const char                *p_data      /* [in] bytes read from the start of the file */
+    ,size_t                     size        /* [in] number of bytes in p_data */
+    )
+{
+    asfparse_error_t    error;
+    header_cache_key_t  current;
+    cache_record_t      record;
+    cache_slot_t       *slot;
+    char               *p_record;
+    char               *p_path;
+    unsigned long long  header_length;
+    size_t              directory_length;
+    size_t              length;
+
+    if (!cache->is_writable || size < HEADER_MIN_SIZE)
+    {
+        return ASFPARSE_ERROR_OK;
+    }
+    header_length = load_uint64_le(p_data + HEADER_SIZE_OFFSET);
+    if (header_length < HEADER_MIN_SIZE || header_length > size)
+    {
+        return ASFPARSE_ERROR_OK;
+    }
+
+    /* a file written to while it was being read is left for next time */
+    if (header_cache_stat(p_filename, &current) != ASFPARSE_ERROR_OK || !key_equal(&current, key))
+    {
+        return ASFPARSE_ERROR_OK;
+    }
+
+    /* build the record before taking the lock, naming the file by its
+       absolute path */
+    directory_length = (p_filename[0] != '/' && cache->p_directory != NULL) ? strlen(cache->p_directory) + 1 : 0;
+    record.path_length = (unsigned int)(directory_length + strlen(p_filename) + 1);
+    record.header_length = (unsigned int)header_length;
+    length = sizeof(cache_record_t) + record.path_length + record.header_length;
+    p_record = malloc(length);
+    if (p_record == NULL)
+    {
+        return ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
+    p_path = p_record + sizeof(cache_record_t);
+    memcpy(p_record, &record, sizeof(cache_record_t));
+    if (directory_length > 0)
+    {
+        memcpy(p_path, cache->p_directory, directory_length - 1);
+        p_path[directory_length - 1] = '/';
+    }
+    memcpy(p_path + directory_length, p_filename, record.path_length - directory_length);
+    memcpy(p_path + record.path_length, p_data, record.header_length);
+
+    error = lock_current(cache);
+    if (error)
+    {
+        free(p_record);
+        return error;
+    }
+
+    if ((cache->header->num_entries + 1) * 100 > cache->header->num_slots * CACHE_MAX_LOAD_PERCENT)
+    {
+        error = rebuild(cache, cache->header->num_slots * 2, NULL);
+    }
+    if (error == ASFPARSE_ERROR_OK)
+    {
+        /* another process may have stored the file in the meantime */
+        slot = find_slot(cache, key);
+        if (slot != NULL && slot->record == 0)
+        {
+            error = append_record(cache, slot, key, p_record, length);
+        }
+    }
+
+    flock(cache->fd, LOCK_UN);
+    free(p_record);
+
+    return error;
+}
+
+/*****************************************************************************
+* NAME:  header_cache_compact
+* DESCRIPTION: Rewrite a cache file without the entries of files that were
+*              removed or changed since they were stored
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+header_cache_compact
+    (const char        *p_filename  /* [in] name of cache file */
+    ,long long         *num_kept    /* [out] entries kept */
+    ,long long         *num_dropped /* [out] entries removed */
+    )
+{
+    asfparse_error_t        error;
+    header_cache_t         *cache;
+    header_cache_key_t      key;
+    const cache_record_t   *record;
+    unsigned char          *keep;
+    unsigned long long      num_slots = CACHE_MIN_SLOTS;
+    unsigned long long      i;
+
+    *num_kept = 0;
+    *num_dropped = 0;
+
+    error = header_cache_open(p_filename, &cache);
+    if (error)
+    {
+        return error;
+    }
+    if (!cache->is_writable)
+    {
+        header_cache_close(cache);
+        return ASFPARSE_ERROR_WRITE_FILE;
+    }
+    error = lock_current(cache);
+    if (error)
+    {
+        header_cache_close(cache);
+        return error;
+    }
+
+    keep = calloc((size_t)(cache->header->num_slots / 8 + 1), 1);
+    if (keep == NULL)
+    {
+        flock(cache->fd, LOCK_UN);
+        header_cache_close(cache);
+        return ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
+
+    /* an entry is kept while the file it was stored for is unchanged */
+    for (i = 0; cache->header != NULL && i < cache->header->num_slots; i++)
+    {
+        if (cache->slots[i].record == 0)
+        {
+            continue;
+        }
+        record = get_record(cache, cache->slots[i].record);
+        if (record != NULL
+            && ((const char *)(record + 1))[record->path_length - 1] == '\0'
+            && header_cache_stat((const char *)(record + 1), &key) == ASFPARSE_ERROR_OK
+            && key_equal(&key, &cache->slots[i].key))
+        {
+            keep[i / 8] |= (unsigned char)(1u << (i % 8));
+            (*num_kept)++;
+        }
+        else
+        {
+            (*num_dropped)++;
+        }
+    }
+
+    /* leave the table half empty so it takes as many entries again before
+       it is doubled */
+    while (num_slots < (unsigned long long)*num_kept * 2)
+    {
+        num_slots *= 2;
+    }
+    error = (cache->header != NULL) ? rebuild(cache, num_slots, keep) : ASFPARSE_ERROR_OPEN_FILE;
+
+    flock(cache->fd, LOCK_UN);
+    free(keep);
+    header_cache_close(cache);
+
+    return error;
+}
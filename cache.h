@@ -0,0 +1,109 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+/* Includes */
+#include <stddef.h>
+#include "util.h"
+
+/* Defines and constants */
+#define CACHE_MIN_SLOTS         (65536)     /* slots in a new or compacted cache file */
+#define CACHE_MAX_LOAD_PERCENT  (75)        /* fill level at which the table is doubled */
+
+/* Enums and structs */
+/* Structure describing what identifies an unchanged file. A file whose
+   contents change gets a new size or modification time, and so a new key. */
+typedef struct {
+    unsigned long long  device;
+    unsigned long long  inode;
+    unsigned long long  size;           /* bytes */
+    long long           mtime;          /* modification time (ns since the epoch) */
+} header_cache_key_t;
+
+/* Opaque handle on a cache file holding the Header Objects of parsed files,
+   in an open-addressed hash table mapped into memory. Any number of
+   processes may read and add to the same file; lookups take no locks.
+   A handle must only be used by one thread at a time. */
+typedef struct header_cache_s header_cache_t;
+
+/* Function prototypes */
+/*****************************************************************************
+* NAME:  header_cache_open
+* DESCRIPTION: Open a cache file, creating an empty one if it does not exist.
+*              A file that cannot be written to is opened for lookups only.
+* RETURNS: asfparse_error_t; ASFPARSE_ERROR_INVALID_ARG if the file is not a
+*          cache file
+******************************************************************************/
+asfparse_error_t
+header_cache_open
+    (const char        *p_filename  /* [in] name of cache file */
+    ,header_cache_t   **cache       /* [out] new handle */
+    );
+
+/*****************************************************************************
+* NAME:  header_cache_close
+* DESCRIPTION: Release a cache handle
+* RETURNS: none
+******************************************************************************/
+void
+header_cache_close
+    (header_cache_t    *cache       /* [in] cache handle, or NULL */
+    );
+
+/*****************************************************************************
+* NAME:  header_cache_stat
+* DESCRIPTION: Get the cache key of a regular file with one stat() call
+* RETURNS: asfparse_error_t; ASFPARSE_ERROR_OPEN_FILE if the file cannot be
+*          found or is not a regular file
+******************************************************************************/
+asfparse_error_t
+header_cache_stat
+    (const char            *p_filename  /* [in] name of file */
+    ,header_cache_key_t    *key         /* [out] key of the file */
+    );
+
+/*****************************************************************************
+* NAME:  header_cache_lookup
+* DESCRIPTION: Find the Header Object stored for a file. The bytes stay valid
+*              until the next call with the same handle.
+* RETURNS: non-zero if the file was found
+******************************************************************************/
+int
+header_cache_lookup
+    (header_cache_t            *cache       /* [in,out] cache handle */
+    ,const header_cache_key_t  *key         /* [in] key of the file */
+    ,const char               **pp_header   /* [out] Header Object of the file */
+    ,size_t                    *size        /* [out] number of bytes in the Header Object */
+    );
+
+/*****************************************************************************
+* NAME:  header_cache_insert
+* DESCRIPTION: Store the Header Object at the start of p_data for a file,
+*              doubling the table first if it is full. Nothing is stored if
+*              the handle is for lookups only, p_data does not hold a whole
+*              Header Object or the file no longer has the given key.
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+header_cache_insert
+    (header_cache_t            *cache       /* [in,out] cache handle */
+    ,const header_cache_key_t  *key         /* [in] key of the file */
+    ,const char                *p_filename  /* [in] name of the file, kept for compaction */
+    ,const char                *p_data      /* [in] bytes read from the start of the file */
+    ,size_t                     size        /* [in] number of bytes in p_data */
+    );
+
+/*****************************************************************************
+* NAME:  header_cache_compact
+* DESCRIPTION: Rewrite a cache file without the entries of files that were
+*              removed or changed since they were stored, sizing the table
+*              for the entries kept, and replace the file with the result
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+header_cache_compact
+    (const char        *p_filename  /* [in] name of cache file */
+    ,long long         *num_kept    /* [out] entries kept */
+    ,long long         *num_dropped /* [out] entries removed */
+    );
+
+#endif
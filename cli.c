@@ -0,0 +1,448 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "cli.h"
+#include "lru.h"
+#include "watch.h"
+#include "packet.h"
+#include "index.h"
+
+/*****************************************************************************
+* NAME:  display_banner
+* DESCRIPTION: Display version and configuration info
+* RETURNS: none
+******************************************************************************/
+void
+display_banner
+    (
+    )
+{
+    /* display version info */
+    printf("\nASF File Parser\nVersion 0.1\n");
+    printf("\n--------------------------------------------------\n");
+
+}
+
+/*****************************************************************************
+* NAME: show_usage
+* DESCRIPTION: Display usage to command line
+* RETURNS: none
+******************************************************************************/
+void
+show_usage
+    (
+    )
+{
+    display_banner();
+    printf("Usage: asfparse [options] <inputfile> [<inputfile> ...]\n");
+    printf("An input file of \"-\" parses an ASF stream from stdin as it arrives.\n");
+    printf("Options:\n");
+    printf("    -j <threads>    number of worker threads in batch mode, or that decode the data packets\n");
+    printf("                    of a single file with -p (default: number of CPUs)\n");
+    printf("    -q <depth>      header reads kept in flight in batch mode when neither -p nor -i is\n");
+    printf("                    given (default: 256; 0 reads each file on a worker thread)\n");
+    printf("    -l <listfile>   also parse the files named in listfile, one per line (\"-\" for stdin)\n");
+    printf("    -0              list entries are separated by NUL instead of newline (implies -l - if\n");
+    printf("                    no list file is given)\n");
+    printf("    -p              walk the data packets and display payload counts per stream\n");
+    printf("    -a              analyze the data packets and display the bitrate, presentation time\n");
+    printf("                    gaps and jitter and key frame interval of each stream (implies -p)\n");
+    printf("    -x <stream>     write the media objects of stream number <stream> of a single input file\n");
+    printf("                    to the file given with -O instead of displaying the objects\n");
+    printf("    -O <file>       file receiving the stream extracted with -x (\"-\" for stdout)\n");
+    printf("    -C <cachefile>  answer files unchanged since their headers were stored in cachefile\n");
+    printf("                    without opening them, and store the headers of the others; only\n");
+    printf("                    when neither -p nor -i is given\n");
+    printf("    -c              compact the cache file given with -C, dropping the entries of removed\n");
+    printf("                    or changed files, instead of parsing\n");
+    printf("    -D <socket>     run as a daemon answering the file names sent to the UNIX domain socket\n");
+    printf("                    <socket> with their JSON output; an HTTP GET of /metrics on the same\n");
+    printf("                    socket returns Prometheus metrics\n");
+    printf("    -L <entries>    files whose output the daemon remembers (default: 65536)\n");
+    printf("    -Q <socket>     send the input file names to the daemon on <socket> and display its\n");
+    printf("                    answers, or display its metrics if no input is given\n");
+    printf("    -w              watch the input directories and their subdirectories and write a JSON\n");
+    printf("                    record for each .asf, .wmv or .wma file added, changed or removed\n");
+    printf("    -W <ms>         time without writes after which a changed file is parsed with -w\n");
+    printf("                    (default: 1000)\n");
+    printf("    -I <indexfile>  build a search index of the extended content descriptions of the input\n");
+    printf("                    files in indexfile instead of displaying them\n");
+    printf("    -T              with -I, look up the input arguments in the search index as terms\n");
+    printf("                    (\"jazz\", \"wm/genre=jazz\", \"wm/genre=\" or a prefix such as \"jaz*\") and\n");
+    printf("                    display the files holding all of them\n");
+    printf("    -E <exportfile> write the file properties, stream properties and codec list of the input\n");
+    printf("                    files to the column-oriented exportfile instead of displaying them\n");
+    printf("    -i              display the index objects that follow the data object\n");
+    printf("    -s <time>       find the data packet to start from to present <time> ms (implies -i)\n");
+    printf("    -o <objects>    only display the listed objects and stop reading once all are found;\n");
+    printf("                    a comma-separated list of header, file_properties, stream_properties,\n");
+    printf("                    header_extension, codec_list, extended_content_description,\n");
+    printf("                    stream_bitrate_properties, data (implies -p), simple_index and\n");
+    printf("                    index (imply -i)\n");
+    printf("    -f <format>     output format: text (default) or json, which writes one JSON object\n");
+    printf("                    per file on its own line\n");
+    printf("    -S              write the time spent parsing each object type, formatting output and\n");
+    printf("                    in I/O, and the bytes and calls of each kind of read, to stderr at\n");
+    printf("                    exit (only in builds made with make INSTRUMENT=1)\n");
+}
+
+/*****************************************************************************
+* NAME: parse_command_line
+* DESCRIPTION: Parse command-line input
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+parse_command_line
+    (int        argc        /* [in] number of command line arguments */
+    ,char      *p_argv[]    /* [in] array of command line arguments */
+    ,params_t  *params      /* [out] structure containing user-defined parameters */
+    )
+{
+    int     option;
+    long    num_cpus;
+
+    /* set defaults */
+    num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    params->num_threads = (num_cpus > 0 && num_cpus < MAX_NUM_THREADS) ? (int)num_cpus : 1;
+    params->io_depth = DEFAULT_IO_DEPTH;
+    params->p_list_filename = NULL;
+    params->null_separated = 0;
+    params->parse_packets = 0;
+    params->packet_threads = 1;
+    params->parse_index = 0;
+    params->analyze = 0;
+    params->extract_stream = 0;
+    params->p_extract_filename = NULL;
+    params->p_cache_filename = NULL;
+    params->compact_cache = 0;
+    params->p_daemon_socket = NULL;
+    params->p_query_socket = NULL;
+    params->lru_entries = LRU_DEFAULT_ENTRIES;
+    params->watch = 0;
+    params->settle_ms = WATCH_DEFAULT_SETTLE_MS;
+    params->p_search_filename = NULL;
+    params->search_query = 0;
+    params->p_export_filename = NULL;
+    params->stats = 0;
+    params->seek_time = -1;
+    params->object_mask = 0;
+    params->output_format = OUTPUT_FORMAT_TEXT;
+
+    /* parse options */
+    while ((option = getopt(argc, p_argv, "j:q:l:0paix:O:C:cD:Q:L:wW:I:TE:Ss:o:f:")) != -1)
+    {
+        switch (option)
+        {
+        case 'j':
+            params->num_threads = atoi(optarg);
+            if (params->num_threads < 1 || params->num_threads > MAX_NUM_THREADS)
+            {
+                show_usage();
+                return ASFPARSE_ERROR_INVALID_ARG;
+            }
+            break;
+        case 'q':
+            params->io_depth = atoi(optarg);
+            if (params->io_depth < 0 || params->io_depth > MAX_IO_DEPTH)
+            {
+                show_usage();
+                return ASFPARSE_ERROR_INVALID_ARG;
+            }
+            break;
+        case 'l':
+            params->p_list_filename = optarg;
+            break;
+        case '0':
+            params->null_separated = 1;
+            break;
+        case 'p':
+            params->parse_packets = 1;
+            break;
+        case 'a':
+            params->analyze = 1;
+            params->parse_packets = 1;
+            break;
+        case 'i':
+            params->parse_index = 1;
+            break;
+        case 'x':
+            params->extract_stream = atoi(optarg);
+            if (params->extract_stream < 1 || params->extract_stream > MAX_STREAM_NUMBER)
+            {
+                show_usage();
+                return ASFPARSE_ERROR_INVALID_ARG;
+            }
+            break;
+        case 'O':
+            params->p_extract_filename = optarg;
+            break;
+        case 'C':
+            params->p_cache_filename = optarg;
+            break;
+        case 'c':
+            params->compact_cache = 1;
+            break;
+        case 'D':
+            params->p_daemon_socket = optarg;
+            params->output_format = OUTPUT_FORMAT_JSON;
+            break;
+        case 'Q':
+            params->p_query_socket = optarg;
+            params->output_format = OUTPUT_FORMAT_JSON;
+            break;
+        case 'I':
+            params->p_search_filename = optarg;
+            break;
+        case 'T':
+            params->search_query = 1;
+            break;
+        case 'E':
+            params->p_export_filename = optarg;
+            break;
+        case 'S':
+#if defined(ASFPARSE_INSTRUMENT)
+            params->stats = 1;
+            break;
+#else
+            show_usage();
+            return ASFPARSE_ERROR_INVALID_ARG;
+#endif
+        case 'w':
+            params->watch = 1;
+            params->output_format = OUTPUT_FORMAT_JSON;
+            break;
+        case 'W':
+            params->settle_ms = atoi(optarg);
+            if (params->settle_ms < 0 || params->settle_ms > WATCH_MAX_SETTLE_MS)
+            {
+                show_usage();
+                return ASFPARSE_ERROR_INVALID_ARG;
+            }
+            break;
+        case 'L':
+            params->lru_entries = atoi(optarg);
+            if (params->lru_entries < 1 || params->lru_entries > LRU_MAX_ENTRIES)
+            {
+                show_usage();
+                return ASFPARSE_ERROR_INVALID_ARG;
+            }
+            break;
+        case 'o':
+            if (parse_object_list(optarg, params) != ASFPARSE_ERROR_OK)
+            {
+                show_usage();
+                return ASFPARSE_ERROR_INVALID_ARG;
+            }
+            break;
+        case 'f':
+            if (strcmp(optarg, "text") == 0)
+            {
+                params->output_format = OUTPUT_FORMAT_TEXT;
+            }
+            else if (strcmp(optarg, "json") == 0)
+            {
+                params->output_format = OUTPUT_FORMAT_JSON;
+            }
+            else
+            {
+                show_usage();
+                return ASFPARSE_ERROR_INVALID_ARG;
+            }
+            break;
+        case 's':
+            params->seek_time = atoll(optarg);
+            params->parse_index = 1;
+            if (params->seek_time < 0 || params->seek_time > SEEK_MAX_TIME)
+            {
+                show_usage();
+                return ASFPARSE_ERROR_INVALID_ARG;
+            }
+            break;
+        default:
+            show_usage();
+            return ASFPARSE_ERROR_INVALID_ARG;
+        }
+    }
+
+    if (params->null_separated && params->p_list_filename == NULL)
+    {
+        params->p_list_filename = "-";
+    }
+
+    /* remaining arguments are input file names; at least one input is
+       required unless the cache is being compacted, a daemon is started or
+       a daemon's metrics are fetched */
+    params->pp_filenames = &p_argv[optind];
+    params->num_filenames = argc - optind;
+    if (params->p_daemon_socket != NULL || params->p_query_socket != NULL)
+    {
+        /* the daemon answers JSON only and keeps its own results and
+           metrics */
+        if ((params->p_daemon_socket != NULL && params->p_query_socket != NULL)
+            || params->watch
+            || params->p_search_filename != NULL
+            || params->search_query
+            || params->p_export_filename != NULL
+            || params->stats
+            || (params->p_daemon_socket != NULL && (params->num_filenames != 0 || params->p_list_filename != NULL))
+            || params->extract_stream != 0
+            || params->p_extract_filename != NULL
+            || params->p_cache_filename != NULL
+            || params->compact_cache)
+        {
+            show_usage();
+            return ASFPARSE_ERROR_INVALID_ARG;
+        }
+        params->output_format = OUTPUT_FORMAT_JSON;
+        return ASFPARSE_ERROR_OK;
+    }
+    if (params->compact_cache)
+    {
+        if (params->p_cache_filename == NULL
+            || params->num_filenames != 0
+            || params->p_list_filename != NULL
+            || params->stats)
+        {
+            show_usage();
+            return ASFPARSE_ERROR_INVALID_ARG;
+        }
+        return ASFPARSE_ERROR_OK;
+    }
+    if (params->num_filenames == 0 && params->p_list_filename == NULL)
+    {
+        show_usage();
+        return ASFPARSE_ERROR_INVALID_ARG;
+    }
+
+    /* the search index holds descriptors only, and a query takes its terms
+       from the command line */
+    if (params->p_search_filename != NULL || params->search_query)
+    {
+        if (params->p_search_filename == NULL
+            || (params->search_query && params->p_list_filename != NULL)
+            || params->parse_packets
+            || params->parse_index
+            || params->extract_stream != 0
+            || params->p_extract_filename != NULL
+            || params->p_cache_filename != NULL
+            || params->watch
+            || params->p_export_filename != NULL)
+        {
+            show_usage();
+            return ASFPARSE_ERROR_INVALID_ARG;
+        }
+        return ASFPARSE_ERROR_OK;
+    }
+
+    /* the export holds three header objects of each file */
+    if (params->p_export_filename != NULL)
+    {
+        if (params->parse_packets
+            || params->parse_index
+            || params->extract_stream != 0
+            || params->p_extract_filename != NULL
+            || params->p_cache_filename != NULL
+            || params->watch)
+        {
+            show_usage();
+            return ASFPARSE_ERROR_INVALID_ARG;
+        }
+        return ASFPARSE_ERROR_OK;
+    }
+
+    /* watched directories are named on the command line, change records
+       are JSON, and watching never finishes to report statistics */
+    if (params->watch)
+    {
+        if (params->num_filenames == 0
+            || params->p_list_filename != NULL
+            || params->stats
+            || params->extract_stream != 0
+            || params->p_extract_filename != NULL
+            || params->p_cache_filename != NULL)
+        {
+            show_usage();
+            return ASFPARSE_ERROR_INVALID_ARG;
+        }
+        params->output_format = OUTPUT_FORMAT_JSON;
+        return ASFPARSE_ERROR_OK;
+    }
+
+    /* a stream is extracted from exactly one file, to a named output */
+    if ((params->extract_stream != 0 || params->p_extract_filename != NULL)
+        && (params->extract_stream == 0
+            || params->p_extract_filename == NULL
+            || params->num_filenames != 1
+            || params->p_list_filename != NULL))
+    {
+        show_usage();
+        return ASFPARSE_ERROR_INVALID_ARG;
+    }
+
+    /* the cache holds Header Objects only */
+    if (params->p_cache_filename != NULL
+        && (params->parse_packets || params->parse_index || params->extract_stream != 0))
+    {
+        show_usage();
+        return ASFPARSE_ERROR_INVALID_ARG;
+    }
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME: parse_object_list
+* DESCRIPTION: Convert a comma-separated list of object names into an object
+*              mask, enabling data packet and index parsing if requested
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+parse_object_list
+    (const char    *p_list      /* [in] comma-separated object names */
+    ,params_t      *params      /* [in,out] structure containing user-defined parameters */
+    )
+{
+    const char     *p_end;
+    const char     *p_name;
+    size_t          length;
+    object_type_t   type;
+
+    while (*p_list != '\0')
+    {
+        p_end = strchr(p_list, ',');
+        length = (p_end != NULL) ? (size_t)(p_end - p_list) : strlen(p_list);
+
+        /* object names are the short names of the object types */
+        for (type = OBJECT_TYPE_HEADER; type < NUM_OBJECT_TYPES; type++)
+        {
+            p_name = get_object_name(type);
+            if (strlen(p_name) == length && strncmp(p_name, p_list, length) == 0)
+            {
+                break;
+            }
+        }
+        if (type == NUM_OBJECT_TYPES)
+        {
+            return ASFPARSE_ERROR_INVALID_ARG;
+        }
+
+        params->object_mask |= OBJECT_MASK(type);
+        if (type == OBJECT_TYPE_DATA)
+        {
+            params->parse_packets = 1;
+        }
+        else if (type == OBJECT_TYPE_SIMPLE_INDEX || type == OBJECT_TYPE_INDEX)
+        {
+            params->parse_index = 1;
+        }
+
+        p_list += length;
+        if (*p_list == ',')
+        {
+            p_list++;
+        }
+    }
+
+    return ASFPARSE_ERROR_OK;
+}
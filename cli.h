@@ -0,0 +1,94 @@
+#ifndef CLI_H
+#define CLI_H
+
+/* Includes */
+#include "util.h"
+
+/* Defines and constants */
+#define MAX_NUM_THREADS         (256)                   /* maximum number of worker threads in batch mode */
+#define DEFAULT_IO_DEPTH        (256)                   /* header reads in flight in batch mode */
+#define MAX_IO_DEPTH            (4096)                  /* maximum number of header reads in flight */
+
+/* Enums and structs */
+/* Enum describing output formats */
+typedef enum {
+     OUTPUT_FORMAT_TEXT = 0             /* human-readable text */
+    ,OUTPUT_FORMAT_JSON                 /* one JSON object per file and line (NDJSON for several files) */
+} output_format_t;
+
+/* Structure describing user-defined parameters */
+typedef struct {
+    char          **pp_filenames;       /* input file names given on the command line */
+    int             num_filenames;      /* number of entries in pp_filenames */
+    const char     *p_list_filename;    /* file listing further input names ("-" for stdin), or NULL */
+    int             null_separated;     /* non-zero if list entries are separated by NUL, not newline */
+    int             num_threads;        /* number of worker threads used in batch mode */
+    int             io_depth;           /* header reads kept in flight in batch mode, 0 to use the workers */
+    int             parse_packets;      /* non-zero to walk the data packets in the Data Object */
+    int             packet_threads;     /* number of threads decoding the data packets of one file */
+    int             parse_index;        /* non-zero to parse the index objects after the Data Object */
+    int             analyze;            /* non-zero to gather bitrate, timing and key frame statistics per stream */
+    int             extract_stream;     /* stream number whose media objects to write out, or 0 */
+    const char     *p_extract_filename; /* file receiving the extracted stream ("-" for stdout), or NULL */
+    const char     *p_cache_filename;   /* header cache file, or NULL */
+    int             compact_cache;      /* non-zero to compact the header cache instead of parsing */
+    const char     *p_daemon_socket;    /* socket on which to serve requests as a daemon, or NULL */
+    const char     *p_query_socket;     /* socket of a daemon to send the input names to, or NULL */
+    int             lru_entries;        /* files whose output the daemon remembers */
+    int             watch;              /* non-zero to watch the input directories for changes */
+    int             settle_ms;          /* time (ms) without writes after which a watched file is parsed */
+    const char     *p_search_filename;  /* search index file to build or query, or NULL */
+    int             search_query;       /* non-zero to query the search index with the input terms */
+    const char     *p_export_filename;  /* column-oriented file to export the input files to, or NULL */
+    int             stats;              /* non-zero to write parse timings and I/O counters to stderr */
+    long long       seek_time;          /* presentation time (ms) to look up in the index, or -1 */
+    unsigned int    object_mask;        /* OBJECT_MASK bits of the objects to display, 0 for all */
+    output_format_t output_format;      /* format of the output */
+} params_t;
+
+/* Function prototypes */
+/*****************************************************************************
+* NAME:  display_banner
+* DESCRIPTION: Display version and configuration info
+* RETURNS: none
+******************************************************************************/
+void
+display_banner
+    (
+    );
+
+/*****************************************************************************
+* NAME: show_usage
+* DESCRIPTION: Display usage to command line
+* RETURNS: none
+******************************************************************************/
+void
+show_usage
+    (
+    );
+
+/*****************************************************************************
+* NAME: parse_command_line
+* DESCRIPTION: Parse command-line input
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+parse_command_line
+    (int        argc        /* [in] number of command line arguments */
+    ,char      *p_argv[]    /* [in] array of command line arguments */
+    ,params_t  *params      /* [out] structure containing user-defined parameters */
+    );
+
+/*****************************************************************************
+* NAME: parse_object_list
+* DESCRIPTION: Convert a comma-separated list of object names into an object
+*              mask, enabling data packet and index parsing if requested
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+parse_object_list
+    (const char    *p_list      /* [in] comma-separated object names */
+    ,params_t      *params      /* [in,out] structure containing user-defined parameters */
+    );
+
+#endif
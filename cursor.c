@@ -0,0 +1,151 @@
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "cursor.h"
+#include "instrument.h"
+
+/*****************************************************************************
+* NAME:  read_fd_to_buffer
+* DESCRIPTION: Read everything from a file descriptor into a heap buffer, for
+*              inputs such as pipes that cannot be mapped
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+read_fd_to_buffer
+    (int            fd          /* [in] open file descriptor */
+    ,mapped_file_t *file        /* [out] struct describing the file contents */
+    )
+{
+    char       *p_buffer = NULL;
+    char       *p_grown;
+    size_t      capacity = 0;
+    size_t      size = 0;
+    ssize_t     num_read;
+    INSTRUMENT_DECLARE(start);
+
+    for (;;)
+    {
+        if (size == capacity)
+        {
+            capacity = (capacity == 0) ? 65536 : capacity * 2;
+            p_grown = realloc(p_buffer, capacity);
+            if (p_grown == NULL)
+            {
+                free(p_buffer);
+                return ASFPARSE_ERROR_OPEN_FILE;
+            }
+            p_buffer = p_grown;
+        }
+
+        INSTRUMENT_START(start);
+        num_read = read(fd, p_buffer + size, capacity - size);
+        INSTRUMENT_STOP(INSTRUMENT_IO_READ, start, (num_read > 0) ? num_read : 0);
+        if (num_read < 0)
+        {
+            free(p_buffer);
+            return ASFPARSE_ERROR_OPEN_FILE;
+        }
+        if (num_read == 0)
+        {
+            break;
+        }
+        size += (size_t)num_read;
+    }
+
+    file->p_data = p_buffer;
+    file->size = size;
+    file->is_mapped = 0;
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  map_file
+* DESCRIPTION: Map the contents of a file into memory. Regular files are
+*              mapped read-only so parsers read fields in place; anything
+*              else is read into a heap buffer.
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+map_file
+    (const char    *p_filename  /* [in] name of file to map */
+    ,mapped_file_t *file        /* [out] struct describing the mapped file */
+    )
+{
+    asfparse_error_t    error;
+    struct stat         st;
+    void               *p_map;
+    int                 fd;
+    INSTRUMENT_DECLARE(start);
+
+    file->p_data = NULL;
+    file->size = 0;
+    file->is_mapped = 0;
+
+    INSTRUMENT_START(start);
+    fd = open(p_filename, O_RDONLY);
+    INSTRUMENT_STOP(INSTRUMENT_IO_OPEN, start, 0);
+    if (fd < 0)
+    {
+        return ASFPARSE_ERROR_OPEN_FILE;
+    }
+
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return ASFPARSE_ERROR_OPEN_FILE;
+    }
+
+    /* an empty file has nothing to map; parsing it will report truncation */
+    if (S_ISREG(st.st_mode) && st.st_size == 0)
+    {
+        close(fd);
+        return ASFPARSE_ERROR_OK;
+    }
+
+    if (S_ISREG(st.st_mode))
+    {
+        INSTRUMENT_START(start);
+        p_map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        INSTRUMENT_STOP(INSTRUMENT_IO_MMAP, start, (p_map != MAP_FAILED) ? st.st_size : 0);
+        if (p_map != MAP_FAILED)
+        {
+            file->p_data = p_map;
+            file->size = (size_t)st.st_size;
+            file->is_mapped = 1;
+            close(fd);
+            return ASFPARSE_ERROR_OK;
+        }
+    }
+
+    error = read_fd_to_buffer(fd, file);
+    close(fd);
+
+    return error;
+}
+
+/*****************************************************************************
+* NAME:  unmap_file
+* DESCRIPTION: Release a file previously mapped with map_file
+* RETURNS: none
+******************************************************************************/
+void
+unmap_file
+    (mapped_file_t *file        /* [in,out] struct describing the mapped file */
+    )
+{
+    if (file->is_mapped)
+    {
+        munmap((void *)file->p_data, file->size);
+    }
+    else
+    {
+        free((void *)file->p_data);
+    }
+
+    file->p_data = NULL;
+    file->size = 0;
+    file->is_mapped = 0;
+}
@@ -0,0 +1,201 @@
+#ifndef CURSOR_H
+#define CURSOR_H
+
+/* Includes */
+#include <stddef.h>
+#include "util.h"
+
+/* Enums and structs */
+/* Structure describing an input file held in memory, either mapped with
+   mmap() or, for inputs that cannot be mapped, read into a heap buffer */
+typedef struct {
+    const char     *p_data;         /* first byte of the file contents */
+    size_t          size;           /* number of bytes in the file */
+    int             is_mapped;      /* non-zero if p_data must be released with munmap() */
+} mapped_file_t;
+
+/* Structure describing a bounds-checked read position over a block of
+   memory. Reads past the end return zeroed values and set the overrun flag,
+   so a parser can decode a whole object and check for truncation once. */
+typedef struct {
+    const char     *p_base;         /* first byte of the readable region */
+    size_t          size;           /* number of readable bytes */
+    size_t          pos;            /* offset of the next byte to read */
+    int             overrun;        /* non-zero once a read went past the end */
+} cursor_t;
+
+/* Function prototypes */
+/*****************************************************************************
+* NAME:  map_file
+* DESCRIPTION: Map the contents of a file into memory
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+map_file
+    (const char    *p_filename  /* [in] name of file to map */
+    ,mapped_file_t *file        /* [out] struct describing the mapped file */
+    );
+
+/*****************************************************************************
+* NAME:  unmap_file
+* DESCRIPTION: Release a file previously mapped with map_file
+* RETURNS: none
+******************************************************************************/
+void
+unmap_file
+    (mapped_file_t *file        /* [in,out] struct describing the mapped file */
+    );
+
+/*****************************************************************************
+* NAME:  cursor_init
+* DESCRIPTION: Set up a cursor over a block of memory
+* RETURNS: none
+******************************************************************************/
+static inline void
+cursor_init
+    (cursor_t      *cur         /* [out] cursor to initialize */
+    ,const char    *p_base      /* [in] first byte of the readable region */
+    ,size_t         size        /* [in] number of readable bytes */
+    )
+{
+    cur->p_base = p_base;
+    cur->size = size;
+    cur->pos = 0;
+    cur->overrun = 0;
+}
+
+/*****************************************************************************
+* NAME:  cursor_remaining
+* DESCRIPTION: Get the number of bytes left to read
+* RETURNS: size_t
+******************************************************************************/
+static inline size_t
+cursor_remaining
+    (const cursor_t    *cur     /* [in] cursor */
+    )
+{
+    return cur->size - cur->pos;
+}
+
+/*****************************************************************************
+* NAME:  cursor_seek
+* DESCRIPTION: Move the cursor to an absolute offset within its region
+* RETURNS: none
+******************************************************************************/
+static inline void
+cursor_seek
+    (cursor_t      *cur         /* [in,out] cursor */
+    ,size_t         pos         /* [in] offset of the next byte to read */
+    )
+{
+    if (pos > cur->size)
+    {
+        cur->pos = cur->size;
+        cur->overrun = 1;
+    }
+    else
+    {
+        cur->pos = pos;
+    }
+}
+
+/*****************************************************************************
+* NAME:  cursor_read_bytes
+* DESCRIPTION: Consume num_bytes bytes without copying them
+* RETURNS: pointer to the first consumed byte, or NULL on overrun
+******************************************************************************/
+static inline const char *
+cursor_read_bytes
+    (cursor_t      *cur         /* [in,out] cursor */
+    ,size_t         num_bytes   /* [in] number of bytes to consume */
+    )
+{
+    const char *p;
+
+    if (num_bytes > cur->size - cur->pos)
+    {
+        cur->pos = cur->size;
+        cur->overrun = 1;
+        return NULL;
+    }
+
+    p = cur->p_base + cur->pos;
+    cur->pos += num_bytes;
+    return p;
+}
+
+/*****************************************************************************
+* NAME:  cursor_skip
+* DESCRIPTION: Advance the cursor by num_bytes bytes
+* RETURNS: none
+******************************************************************************/
+static inline void
+cursor_skip
+    (cursor_t      *cur         /* [in,out] cursor */
+    ,size_t         num_bytes   /* [in] number of bytes to skip */
+    )
+{
+    (void)cursor_read_bytes(cur, num_bytes);
+}
+
+/*****************************************************************************
+* NAME:  cursor_read_uint8
+* DESCRIPTION: Consume a byte
+* RETURNS: unsigned int (0 on overrun)
+******************************************************************************/
+static inline unsigned int
+cursor_read_uint8
+    (cursor_t      *cur         /* [in,out] cursor */
+    )
+{
+    const char *p = cursor_read_bytes(cur, 1);
+
+    return (p != NULL) ? (unsigned char)*p : 0;
+}
+
+/*****************************************************************************
+* NAME:  cursor_read_uint16
+* DESCRIPTION: Consume a little-endian 16-bit integer
+* RETURNS: unsigned int (0 on overrun)
+******************************************************************************/
+static inline unsigned int
+cursor_read_uint16
+    (cursor_t      *cur         /* [in,out] cursor */
+    )
+{
+    const char *p = cursor_read_bytes(cur, 2);
+
+    return (p != NULL) ? load_uint16_le(p) : 0;
+}
+
+/*****************************************************************************
+* NAME:  cursor_read_uint32
+* DESCRIPTION: Consume a little-endian 32-bit integer
+* RETURNS: unsigned int (0 on overrun)
+******************************************************************************/
+static inline unsigned int
+cursor_read_uint32
+    (cursor_t      *cur         /* [in,out] cursor */
+    )
+{
+    const char *p = cursor_read_bytes(cur, 4);
+
+    return (p != NULL) ? load_uint32_le(p) : 0;
+}
+
+/*****************************************************************************
+* NAME:  cursor_read_uint64
+* DESCRIPTION: Consume a little-endian 64-bit integer
+* RETURNS: unsigned long long (0 on overrun)
+******************************************************************************/
+static inline unsigned long long
+cursor_read_uint64
+    (cursor_t      *cur         /* [in,out] cursor */
+    )
+{
+    const char *p = cursor_read_bytes(cur, 8);
+
+    return (p != NULL) ? load_uint64_le(p) : 0;
+}
+
+#endif
@@ -0,0 +1,1004 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "batch.h"
+#include "cache.h"
+#include "lru.h"
+#include "output.h"
+#include "process.h"
+#include "daemon.h"
+
+/* Defines and constants */
+#define NUM_LATENCY_BUCKETS     (13)            /* finite parse latency histogram buckets */
+#define HTTP_REQUEST_PREFIX     "GET "          /* start of a metrics scrape rather than a file name */
+#define HTTP_REQUEST_PREFIX_LENGTH  (4)
+#define ERROR_MEMBER            ",\"error\":{\"code\":"     /* JSON member holding a file's error */
+#define RECEIVE_CHUNK_SIZE      (64 * 1024)     /* bytes the client reads at a time */
+
+/* Upper bounds of the parse latency histogram buckets (us) */
+static const unsigned long long latency_bounds[NUM_LATENCY_BUCKETS] =
+    {100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000};
+
+/* Set by the signal handler to stop accepting connections */
+static volatile sig_atomic_t stop_requested = 0;
+static int listen_fd = -1;
+
+/* Enums and structs */
+/* Structure describing the counters exported as metrics, each updated with
+   an atomic add */
+typedef struct {
+    unsigned long long  connections;                        /* connections accepted */
+    unsigned long long  requests;                           /* batches of names answered */
+    unsigned long long  queries;                            /* names answered */
+    unsigned long long  hits;                               /* names answered from the LRU */
+    unsigned long long  misses;                             /* names parsed */
+    unsigned long long  errors;                             /* names whose parse failed */
+    unsigned long long  parse_ns;                           /* time spent parsing */
+    unsigned long long  parse_buckets[NUM_LATENCY_BUCKETS + 1]; /* parses per bucket, the last one unbounded */
+} daemon_metrics_t;
+
+/* Structure describing one file name of a batch */
+typedef struct daemon_query_s {
+    struct daemon_query_s  *next;           /* next query waiting for a worker */
+    const char             *p_filename;     /* name, in the connection's receive buffer */
+    header_cache_key_t      key;            /* identity of the file when the name arrived */
+    int                     have_key;       /* non-zero if key is valid */
+    int                     is_hit;         /* non-zero if out was filled from the LRU */
+    output_t                out;            /* JSON answer, one line */
+    asfparse_error_t        error;          /* result of parsing the file */
+    int                    *p_pending;      /* queries of the batch not yet parsed */
+} daemon_query_t;
+
+/* Structure describing the state shared by the connection and worker
+   threads */
+typedef struct {
+    const params_t     *params;             /* user-defined parameters */
+    lru_t               lru;                /* answers of recently asked files */
+    daemon_metrics_t    metrics;
+    int                 num_connections;    /* connections being served */
+    int                 stopping;           /* non-zero once the workers are to exit */
+    pthread_mutex_t     lock;               /* protects the queue and the pending counts */
+    pthread_cond_t      work_ready;         /* signalled when queries are queued */
+    pthread_cond_t      query_done;         /* signalled when a worker finishes a query */
+    daemon_query_t     *queue_head;         /* first query waiting for a worker */
+    daemon_query_t     *queue_tail;         /* last query waiting for a worker */
+} daemon_t;
+
+/* Structure describing one worker thread */
+typedef struct {
+    daemon_t           *daemon;
+    asfparse_ctx_t     *ctx;                /* parser context of this worker */
+    pthread_t           thread;
+} daemon_worker_t;
+
+/* Structure describing one accepted connection */
+typedef struct {
+    daemon_t           *daemon;
+    int                 fd;
+} daemon_connection_t;
+
+/*****************************************************************************
+* NAME:  handle_signal
+* DESCRIPTION: Stop the daemon on SIGINT or SIGTERM. shutdown() is
+*              async-signal-safe and wakes the blocked accept().
+* RETURNS: none
+******************************************************************************/
+static void
+handle_signal
+    (int    signal_number   /* [in] signal received */
+    )
+{
+    (void)signal_number;
+    stop_requested = 1;
+    if (listen_fd >= 0)
+    {
+        shutdown(listen_fd, SHUT_RDWR);
+    }
+}
+
+/*****************************************************************************
+* NAME:  now_ns
+* DESCRIPTION: Read the monotonic clock
+* RETURNS: nanoseconds since an arbitrary point
+******************************************************************************/
+static unsigned long long
+now_ns
+    (
+    )
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (unsigned long long)ts.tv_sec * 1000000000ull + (unsigned long long)ts.tv_nsec;
+}
+
+/*****************************************************************************
+* NAME:  count
+* DESCRIPTION: Add to a metrics counter shared between threads
+* RETURNS: none
+******************************************************************************/
+static void
+count
+    (unsigned long long    *counter     /* [in,out] counter */
+    ,unsigned long long     n           /* [in] amount to add */
+    )
+{
+    __atomic_add_fetch(counter, n, __ATOMIC_RELAXED);
+}
+
+/*****************************************************************************
+* NAME:  record_parse
+* DESCRIPTION: Count a parse in the latency histogram
+* RETURNS: none
+******************************************************************************/
+static void
+record_parse
+    (daemon_metrics_t  *metrics     /* [in,out] daemon counters */
+    ,unsigned long long elapsed_ns  /* [in] time the parse took */
+    ,asfparse_error_t   error       /* [in] result of the parse */
+    )
+{
+    int     i = 0;
+
+    while (i < NUM_LATENCY_BUCKETS && elapsed_ns > latency_bounds[i] * 1000)
+    {
+        i++;
+    }
+    count(&metrics->parse_buckets[i], 1);
+    count(&metrics->parse_ns, elapsed_ns);
+    if (error)
+    {
+        count(&metrics->errors, 1);
+    }
+}
+
+/*****************************************************************************
+* NAME:  write_counter
+* DESCRIPTION: Append one metric without labels in the Prometheus text format
+* RETURNS: none
+******************************************************************************/
+static void
+write_counter
+    (output_t              *out         /* [in,out] buffer receiving the metrics */
+    ,const char            *p_name      /* [in] metric name */
+    ,const char            *p_type      /* [in] "counter" or "gauge" */
+    ,const char            *p_help      /* [in] description */
+    ,unsigned long long     value       /* [in] value */
+    )
+{
+    output_printf(out, "# HELP %s %s\n# TYPE %s %s\n%s %llu\n", p_name, p_help, p_name, p_type, p_name, value);
+}
+
+/*****************************************************************************
+* NAME:  format_metrics
+* DESCRIPTION: Append the daemon's counters in the Prometheus text format
+* RETURNS: none
+******************************************************************************/
+static void
+format_metrics
+    (daemon_t          *daemon      /* [in,out] daemon state */
+    ,output_t          *out         /* [in,out] buffer receiving the metrics */
+    )
+{
+    daemon_metrics_t   *metrics = &daemon->metrics;
+    unsigned long long  hits = __atomic_load_n(&metrics->hits, __ATOMIC_RELAXED);
+    unsigned long long  misses = __atomic_load_n(&metrics->misses, __ATOMIC_RELAXED);
+    unsigned long long  cumulative = 0;
+    size_t              num_entries;
+    size_t              num_bytes;
+    int                 i;
+
+    write_counter(out, "asfparse_connections_total", "counter", "Connections accepted.",
+                  __atomic_load_n(&metrics->connections, __ATOMIC_RELAXED));
+    write_counter(out, "asfparse_requests_total", "counter", "Batches of file names answered.",
+                  __atomic_load_n(&metrics->requests, __ATOMIC_RELAXED));
+    write_counter(out, "asfparse_queries_total", "counter", "File names answered.",
+                  __atomic_load_n(&metrics->queries, __ATOMIC_RELAXED));
+    write_counter(out, "asfparse_cache_hits_total", "counter", "File names answered from the cache.", hits);
+    write_counter(out, "asfparse_cache_misses_total", "counter", "File names that had to be parsed.", misses);
+    output_printf(out, "# HELP asfparse_cache_hit_ratio Fraction of file names answered from the cache.\n"
+                       "# TYPE asfparse_cache_hit_ratio gauge\n"
+                       "asfparse_cache_hit_ratio %.6f\n", (hits + misses > 0) ? (double)hits / (double)(hits + misses) : 0.0);
+
+    lru_count(&daemon->lru, &num_entries, &num_bytes);
+    write_counter(out, "asfparse_cache_entries", "gauge", "Files held in the cache.", num_entries);
+    write_counter(out, "asfparse_cache_bytes", "gauge", "Bytes held in the cache.", num_bytes);
+    write_counter(out, "asfparse_parse_errors_total", "counter", "Parsed files that had an error.",
+                  __atomic_load_n(&metrics->errors, __ATOMIC_RELAXED));
+
+    output_printf(out, "# HELP asfparse_parse_duration_seconds Time taken to parse a file.\n"
+                       "# TYPE asfparse_parse_duration_seconds histogram\n");
+    for (i = 0; i <= NUM_LATENCY_BUCKETS; i++)
+    {
+        cumulative += __atomic_load_n(&metrics->parse_buckets[i], __ATOMIC_RELAXED);
+        if (i < NUM_LATENCY_BUCKETS)
+        {
+            output_printf(out, "asfparse_parse_duration_seconds_bucket{le=\"%g\"} %llu\n", (double)latency_bounds[i] / 1e6, cumulative);
+        }
+        else
+        {
+            output_printf(out, "asfparse_parse_duration_seconds_bucket{le=\"+Inf\"} %llu\n", cumulative);
+        }
+    }
+    output_printf(out, "asfparse_parse_duration_seconds_sum %.9f\n",
+                  (double)__atomic_load_n(&metrics->parse_ns, __ATOMIC_RELAXED) / 1e9);
+    output_printf(out, "asfparse_parse_duration_seconds_count %llu\n", cumulative);
+}
+
+/*****************************************************************************
+* NAME:  daemon_worker
+* DESCRIPTION: Worker thread body: parse queued files until the daemon stops
+*              and the queue is empty
+* RETURNS: NULL
+******************************************************************************/
+static void *
+daemon_worker
+    (void  *arg     /* [in] daemon_worker_t of this thread */
+    )
+{
+    daemon_worker_t    *worker = arg;
+    daemon_t           *daemon = worker->daemon;
+    daemon_query_t     *query;
+    unsigned long long  start;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&daemon->lock);
+        while (daemon->queue_head == NULL && !daemon->stopping)
+        {
+            pthread_cond_wait(&daemon->work_ready, &daemon->lock);
+        }
+        if (daemon->queue_head == NULL)
+        {
+            pthread_mutex_unlock(&daemon->lock);
+            break;
+        }
+        query = daemon->queue_head;
+        daemon->queue_head = query->next;
+        if (daemon->queue_head == NULL)
+        {
+            daemon->queue_tail = NULL;
+        }
+        pthread_mutex_unlock(&daemon->lock);
+
+        start = now_ns();
+        query->error = process_file(query->p_filename, daemon->params, worker->ctx, &query->out);
+        record_parse(&daemon->metrics, now_ns() - start, query->error);
+
+        /* the answer stays valid while the file keeps the key it had when
+           its name arrived */
+        if (query->have_key)
+        {
+            lru_insert(&daemon->lru, query->p_filename, &query->key, query->out.p_data, query->out.length, query->error);
+        }
+
+        pthread_mutex_lock(&daemon->lock);
+        (*query->p_pending)--;
+        pthread_cond_broadcast(&daemon->query_done);
+        pthread_mutex_unlock(&daemon->lock);
+    }
+
+    return NULL;
+}
+
+/*****************************************************************************
+* NAME:  answer_batch
+* DESCRIPTION: Have the workers parse the queries not answered from the LRU,
+*              wait for them and write every answer in order with one write
+* RETURNS: 0 on success, -1 if the connection failed
+******************************************************************************/
+static int
+answer_batch
+    (daemon_t          *daemon      /* [in,out] daemon state */
+    ,int                fd          /* [in] connection */
+    ,daemon_query_t    *queries     /* [in,out] queries of the batch */
+    ,int                num_queries /* [in] number of entries in queries */
+    ,output_t          *out         /* [in,out] buffer for the answers */
+    )
+{
+    int     pending = 0;
+    int     i;
+
+    pthread_mutex_lock(&daemon->lock);
+    for (i = 0; i < num_queries; i++)
+    {
+        if (queries[i].is_hit)
+        {
+            continue;
+        }
+        queries[i].p_pending = &pending;
+        queries[i].next = NULL;
+        if (daemon->queue_tail != NULL)
+        {
+            daemon->queue_tail->next = &queries[i];
+        }
+        else
+        {
+            daemon->queue_head = &queries[i];
+        }
+        daemon->queue_tail = &queries[i];
+        pending++;
+    }
+    if (pending > 0)
+    {
+        pthread_cond_broadcast(&daemon->work_ready);
+    }
+    while (pending > 0)
+    {
+        pthread_cond_wait(&daemon->query_done, &daemon->lock);
+    }
+    pthread_mutex_unlock(&daemon->lock);
+
+    output_reset(out);
+    for (i = 0; i < num_queries; i++)
+    {
+        output_write(out, queries[i].out.p_data, queries[i].out.length);
+    }
+    count(&daemon->metrics.requests, 1);
+    count(&daemon->metrics.queries, (unsigned long long)num_queries);
+
+    return output_flush(out, fd);
+}
+
+/*****************************************************************************
+* NAME:  answer_names
+* DESCRIPTION: Answer each line of a block of complete lines received, a file
+*              name, in batches of at most DAEMON_MAX_BATCH names. Every
+*              line is answered, so an empty name gets an error record, as
+*              the client waits for one answer per line it sent.
+* RETURNS: 0 on success, -1 if the connection failed
+******************************************************************************/
+static int
+answer_names
+    (daemon_t          *daemon      /* [in,out] daemon state */
+    ,int                fd          /* [in] connection */
+    ,char              *p_lines     /* [in,out] lines, each ending in '\n' */
+    ,size_t             length      /* [in] number of bytes in p_lines */
+    ,daemon_query_t    *queries     /* [in,out] DAEMON_MAX_BATCH queries */
+    ,output_t          *out         /* [in,out] buffer for the answers */
+    )
+{
+    daemon_query_t *query;
+    char           *p_end = p_lines + length;
+    char           *p_newline;
+    int             num_queries = 0;
+
+    while (p_lines < p_end)
+    {
+        p_newline = memchr(p_lines, '\n', (size_t)(p_end - p_lines));
+        *p_newline = '\0';
+        if (p_newline > p_lines && p_newline[-1] == '\r')
+        {
+            p_newline[-1] = '\0';
+        }
+
+        query = &queries[num_queries++];
+        query->p_filename = p_lines;
+        output_reset(&query->out);
+        query->have_key = (*p_lines != '\0' && header_cache_stat(p_lines, &query->key) == ASFPARSE_ERROR_OK);
+        query->is_hit = query->have_key
+                        && lru_lookup(&daemon->lru, p_lines, &query->key, &query->out, &query->error);
+        count(query->is_hit ? &daemon->metrics.hits : &daemon->metrics.misses, 1);
+        p_lines = p_newline + 1;
+
+        if (num_queries == DAEMON_MAX_BATCH || (p_lines == p_end && num_queries > 0))
+        {
+            if (answer_batch(daemon, fd, queries, num_queries, out) != 0)
+            {
+                return -1;
+            }
+            num_queries = 0;
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************
+* NAME:  find_header_end
+* DESCRIPTION: Look for the blank line that ends the headers of an HTTP
+*              request
+* RETURNS: non-zero if it was received
+******************************************************************************/
+static int
+find_header_end
+    (const char    *p_data      /* [in] bytes received */
+    ,size_t         length      /* [in] number of bytes in p_data */
+    )
+{
+    size_t  i;
+
+    for (i = 0; i + 1 < length; i++)
+    {
+        if (p_data[i] == '\n'
+            && (p_data[i + 1] == '\n' || (i + 2 < length && p_data[i + 1] == '\r' && p_data[i + 2] == '\n')))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************
+* NAME:  answer_http
+* DESCRIPTION: Answer an HTTP request for the metrics; the connection is
+*              closed afterwards
+* RETURNS: none
+******************************************************************************/
+static void
+answer_http
+    (daemon_t          *daemon      /* [in,out] daemon state */
+    ,int                fd          /* [in] connection */
+    ,char              *p_buffer    /* [in,out] DAEMON_MAX_LINE bytes holding the start of the request */
+    ,size_t             length      /* [in] number of bytes received so far */
+    )
+{
+    output_t    body;
+    output_t    response;
+    ssize_t     n;
+    size_t      path_length = strlen(DAEMON_METRICS_PATH);
+    char        next;
+
+    while (!find_header_end(p_buffer, length) && length < DAEMON_MAX_LINE)
+    {
+        n = read(fd, p_buffer + length, DAEMON_MAX_LINE - length);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return;
+        }
+        length += (size_t)n;
+    }
+
+    output_init(&body);
+    output_init(&response);
+    next = (length > HTTP_REQUEST_PREFIX_LENGTH + path_length) ? p_buffer[HTTP_REQUEST_PREFIX_LENGTH + path_length] : '\0';
+    if (length > HTTP_REQUEST_PREFIX_LENGTH + path_length
+        && memcmp(p_buffer + HTTP_REQUEST_PREFIX_LENGTH, DAEMON_METRICS_PATH, path_length) == 0
+        && (next == ' ' || next == '?' || next == '\r' || next == '\n'))
+    {
+        format_metrics(daemon, &body);
+        output_printf(&response, "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n");
+    }
+    else
+    {
+        output_printf(&body, "not found\n");
+        output_printf(&response, "HTTP/1.0 404 Not Found\r\nContent-Type: text/plain\r\n");
+    }
+    output_printf(&response, "Content-Length: %lu\r\nConnection: close\r\n\r\n", (unsigned long)body.length);
+    output_write(&response, body.p_data, body.length);
+    output_flush(&response, fd);
+    output_free(&response);
+    output_free(&body);
+}
+
+/*****************************************************************************
+* NAME:  serve_connection
+* DESCRIPTION: Connection thread body: answer the lines received on one
+*              connection until the client closes it
+* RETURNS: NULL
+******************************************************************************/
+static void *
+serve_connection
+    (void  *arg     /* [in] daemon_connection_t, freed here */
+    )
+{
+    daemon_connection_t    *connection = arg;
+    daemon_t               *daemon = connection->daemon;
+    daemon_query_t         *queries;
+    output_t                out;
+    char                   *p_buffer;
+    size_t                  length = 0;
+    size_t                  consumed;
+    ssize_t                 n;
+    int                     answered = 0;
+    int                     i;
+
+    output_init(&out);
+    queries = calloc(DAEMON_MAX_BATCH, sizeof(daemon_query_t));
+    p_buffer = malloc(DAEMON_MAX_LINE);
+
+    while (queries != NULL && p_buffer != NULL)
+    {
+        n = read(connection->fd, p_buffer + length, DAEMON_MAX_LINE - length);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            break;
+        }
+        length += (size_t)n;
+
+        /* a scrape starts with an HTTP request line instead of a name */
+        if (!answered && length >= HTTP_REQUEST_PREFIX_LENGTH
+            && memcmp(p_buffer, HTTP_REQUEST_PREFIX, HTTP_REQUEST_PREFIX_LENGTH) == 0)
+        {
+            answer_http(daemon, connection->fd, p_buffer, length);
+            break;
+        }
+
+        /* answer every complete line and keep the rest for the next read */
+        consumed = length;
+        while (consumed > 0 && p_buffer[consumed - 1] != '\n')
+        {
+            consumed--;
+        }
+        if (consumed == 0)
+        {
+            if (length == DAEMON_MAX_LINE)
+            {
+                break;
+            }
+            continue;
+        }
+        if (answer_names(daemon, connection->fd, p_buffer, consumed, queries, &out) != 0)
+        {
+            break;
+        }
+        answered = 1;
+        memmove(p_buffer, p_buffer + consumed, length - consumed);
+        length -= consumed;
+    }
+
+    close(connection->fd);
+    if (queries != NULL)
+    {
+        for (i = 0; i < DAEMON_MAX_BATCH; i++)
+        {
+            output_free(&queries[i].out);
+        }
+    }
+    free(queries);
+    free(p_buffer);
+    output_free(&out);
+    __atomic_sub_fetch(&daemon->num_connections, 1, __ATOMIC_RELAXED);
+    free(connection);
+
+    return NULL;
+}
+
+/*****************************************************************************
+* NAME:  fill_address
+* DESCRIPTION: Set up the address of a UNIX domain socket
+* RETURNS: asfparse_error_t; ASFPARSE_ERROR_INVALID_ARG if the name is too
+*          long
+******************************************************************************/
+static asfparse_error_t
+fill_address
+    (struct sockaddr_un    *address     /* [out] socket address */
+    ,const char            *p_path      /* [in] name of the socket */
+    )
+{
+    memset(address, 0, sizeof(struct sockaddr_un));
+    if (strlen(p_path) >= sizeof(address->sun_path))
+    {
+        return ASFPARSE_ERROR_INVALID_ARG;
+    }
+    address->sun_family = AF_UNIX;
+    strcpy(address->sun_path, p_path);
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  connect_socket
+* DESCRIPTION: Connect to a daemon's UNIX domain socket
+* RETURNS: connected descriptor, or -1
+******************************************************************************/
+static int
+connect_socket
+    (const char    *p_path      /* [in] name of the socket */
+    )
+{
+    struct sockaddr_un  address;
+    int                 fd;
+
+    if (fill_address(&address, p_path) != ASFPARSE_ERROR_OK)
+    {
+        return -1;
+    }
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (struct sockaddr *)&address, sizeof(struct sockaddr_un)) != 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+
+    return fd;
+}
+
+/*****************************************************************************
+* NAME:  open_socket
+* DESCRIPTION: Create the daemon's listening socket, replacing a socket file
+*              left behind by a daemon that is no longer running
+* RETURNS: listening descriptor, or -1
+******************************************************************************/
+static int
+open_socket
+    (const char    *p_path      /* [in] name of the socket */
+    )
+{
+    struct sockaddr_un  address;
+    struct stat         st;
+    int                 fd;
+
+    if (fill_address(&address, p_path) != ASFPARSE_ERROR_OK)
+    {
+        return -1;
+    }
+
+    /* never take over the socket of a daemon that still answers */
+    fd = connect_socket(p_path);
+    if (fd >= 0)
+    {
+        close(fd);
+        return -1;
+    }
+    if (lstat(p_path, &st) == 0 && S_ISSOCK(st.st_mode))
+    {
+        unlink(p_path);
+    }
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0
+        && (bind(fd, (struct sockaddr *)&address, sizeof(struct sockaddr_un)) != 0
+            || listen(fd, DAEMON_LISTEN_BACKLOG) != 0))
+    {
+        close(fd);
+        fd = -1;
+    }
+
+    return fd;
+}
+
+/*****************************************************************************
+* NAME:  run_daemon
+* DESCRIPTION: Listen on a UNIX domain socket until SIGINT or SIGTERM and
+*              answer each file name received with the file's JSON output
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+run_daemon
+    (const params_t    *params      /* [in] structure containing user-defined parameters */
+    )
+{
+    daemon_t                daemon;
+    daemon_worker_t         workers[MAX_NUM_THREADS];
+    daemon_connection_t    *connection;
+    struct sigaction        action;
+    sigset_t                signals;
+    pthread_attr_t          attr;
+    pthread_t               thread;
+    int                     num_workers;
+    int                     fd;
+    int                     i;
+
+    memset(&daemon, 0, sizeof(daemon_t));
+    daemon.params = params;
+    if (lru_init(&daemon.lru, (size_t)params->lru_entries) != ASFPARSE_ERROR_OK)
+    {
+        printf("Error starting daemon\n");
+        return ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
+    pthread_mutex_init(&daemon.lock, NULL);
+    pthread_cond_init(&daemon.work_ready, NULL);
+    pthread_cond_init(&daemon.query_done, NULL);
+
+    listen_fd = open_socket(params->p_daemon_socket);
+    if (listen_fd < 0)
+    {
+        printf("Error opening socket %s\n", params->p_daemon_socket);
+        lru_free(&daemon.lru);
+        return ASFPARSE_ERROR_OPEN_FILE;
+    }
+
+    /* a name of "-" must not read the daemon's own stdin */
+    fd = open("/dev/null", O_RDONLY);
+    if (fd >= 0)
+    {
+        dup2(fd, STDIN_FILENO);
+        close(fd);
+    }
+
+    /* clients that hang up must not kill the daemon, and only this thread
+       takes SIGINT and SIGTERM, so that they interrupt accept() */
+    memset(&action, 0, sizeof(struct sigaction));
+    action.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &action, NULL);
+    action.sa_handler = handle_signal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+    for (num_workers = 0; num_workers < params->num_threads; num_workers++)
+    {
+        workers[num_workers].daemon = &daemon;
+        workers[num_workers].ctx = process_create_context(params);
+        if (workers[num_workers].ctx == NULL
+            || pthread_create(&workers[num_workers].thread, NULL, daemon_worker, &workers[num_workers]) != 0)
+        {
+            asfparse_destroy(workers[num_workers].ctx);
+            break;
+        }
+    }
+    if (num_workers == 0)
+    {
+        printf("Error starting worker threads\n");
+        close(listen_fd);
+        listen_fd = -1;
+        unlink(params->p_daemon_socket);
+        lru_free(&daemon.lru);
+        return ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_sigmask(SIG_UNBLOCK, &signals, NULL);
+
+    while (!stop_requested)
+    {
+        fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0)
+        {
+            continue;
+        }
+        count(&daemon.metrics.connections, 1);
+
+        /* every connection has its own thread, so their number is bounded */
+        if (__atomic_add_fetch(&daemon.num_connections, 1, __ATOMIC_RELAXED) > DAEMON_MAX_CONNECTIONS)
+        {
+            __atomic_sub_fetch(&daemon.num_connections, 1, __ATOMIC_RELAXED);
+            close(fd);
+            continue;
+        }
+        connection = malloc(sizeof(daemon_connection_t));
+        if (connection != NULL)
+        {
+            connection->daemon = &daemon;
+            connection->fd = fd;
+            pthread_sigmask(SIG_BLOCK, &signals, NULL);
+            if (pthread_create(&thread, &attr, serve_connection, connection) != 0)
+            {
+                free(connection);
+                connection = NULL;
+            }
+            pthread_sigmask(SIG_UNBLOCK, &signals, NULL);
+        }
+        if (connection == NULL)
+        {
+            __atomic_sub_fetch(&daemon.num_connections, 1, __ATOMIC_RELAXED);
+            close(fd);
+        }
+    }
+
+    pthread_attr_destroy(&attr);
+    close(listen_fd);
+    listen_fd = -1;
+    unlink(params->p_daemon_socket);
+
+    pthread_mutex_lock(&daemon.lock);
+    daemon.stopping = 1;
+    pthread_cond_broadcast(&daemon.work_ready);
+    pthread_mutex_unlock(&daemon.lock);
+    for (i = 0; i < num_workers; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+        asfparse_destroy(workers[i].ctx);
+    }
+
+    /* connections still open end with the process and may still use the
+       LRU */
+    if (__atomic_load_n(&daemon.num_connections, __ATOMIC_RELAXED) == 0)
+    {
+        lru_free(&daemon.lru);
+    }
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  receive_answers
+* DESCRIPTION: Read answers from a daemon and write them to stdout until a
+*              given number of lines has arrived
+* RETURNS: asfparse_error_t; ASFPARSE_ERROR_OPEN_FILE if the connection
+*          ended early
+******************************************************************************/
+static asfparse_error_t
+receive_answers
+    (int                fd              /* [in] connection */
+    ,int                num_answers     /* [in] lines to wait for */
+    ,output_t          *buffer          /* [in,out] receive buffer, holding any partial line */
+    ,asfparse_error_t  *first_error     /* [in,out] first failure in input order */
+    )
+{
+    const char *p_line;
+    const char *p_error;
+    char       *p_newline;
+    size_t      consumed;
+    ssize_t     n;
+
+    while (num_answers > 0)
+    {
+        n = read(fd, output_reserve(buffer, RECEIVE_CHUNK_SIZE), RECEIVE_CHUNK_SIZE);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return ASFPARSE_ERROR_OPEN_FILE;
+        }
+        buffer->length += (size_t)n;
+
+        /* each answer is one line; note the error of the first that has one */
+        consumed = 0;
+        while (num_answers > 0
+               && (p_newline = memchr(buffer->p_data + consumed, '\n', buffer->length - consumed)) != NULL)
+        {
+            p_line = buffer->p_data + consumed;
+            *p_newline = '\0';
+            p_error = strstr(p_line, ERROR_MEMBER);
+            if (*first_error == ASFPARSE_ERROR_OK && p_error != NULL)
+            {
+                *first_error = (asfparse_error_t)atoi(p_error + strlen(ERROR_MEMBER));
+            }
+            *p_newline = '\n';
+            consumed = (size_t)(p_newline + 1 - buffer->p_data);
+            num_answers--;
+        }
+
+        if (write(STDOUT_FILENO, buffer->p_data, consumed) != (ssize_t)consumed)
+        {
+            return ASFPARSE_ERROR_WRITE_FILE;
+        }
+        memmove(buffer->p_data, buffer->p_data + consumed, buffer->length - consumed);
+        buffer->length -= consumed;
+    }
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  query_metrics
+* DESCRIPTION: Fetch a daemon's metrics and write them to stdout
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+query_metrics
+    (int                fd          /* [in] connection */
+    )
+{
+    asfparse_error_t    error = ASFPARSE_ERROR_OPEN_FILE;
+    output_t            response;
+    const char         *p_body;
+    ssize_t             n;
+
+    output_init(&response);
+    output_printf(&response, "GET %s HTTP/1.0\r\n\r\n", DAEMON_METRICS_PATH);
+    if (output_flush(&response, fd) == 0)
+    {
+        do
+        {
+            n = read(fd, output_reserve(&response, RECEIVE_CHUNK_SIZE), RECEIVE_CHUNK_SIZE);
+            response.length += (n > 0) ? (size_t)n : 0;
+        } while (n > 0 || (n < 0 && errno == EINTR));
+
+        output_write(&response, "", 1);
+        p_body = strstr(response.p_data, "\r\n\r\n");
+        if (p_body != NULL && strncmp(response.p_data, "HTTP/1.0 200", 12) == 0)
+        {
+            p_body += 4;
+            fwrite(p_body, 1, strlen(p_body), stdout);
+            error = ASFPARSE_ERROR_OK;
+        }
+    }
+    output_free(&response);
+
+    return error;
+}
+
+/*****************************************************************************
+* NAME:  run_query
+* DESCRIPTION: Send every input file name in params to a daemon and write its
+*              answers to stdout in input order, or, if no names were given,
+*              write the daemon's metrics
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+run_query
+    (const params_t    *params      /* [in] structure containing user-defined parameters */
+    )
+{
+    asfparse_error_t    first_error = ASFPARSE_ERROR_OK;
+    asfparse_error_t    error = ASFPARSE_ERROR_OK;
+    path_source_t       source;
+    output_t            request;
+    output_t            buffer;
+    const char         *p_path;
+    int                 num_sent;
+    int                 fd;
+
+    fd = connect_socket(params->p_query_socket);
+    if (fd < 0)
+    {
+        printf("Error connecting to %s\n", params->p_query_socket);
+        return ASFPARSE_ERROR_OPEN_FILE;
+    }
+
+    if (params->num_filenames == 0 && params->p_list_filename == NULL)
+    {
+        error = query_metrics(fd);
+        close(fd);
+        return error;
+    }
+
+    if (path_source_open(&source, params) != ASFPARSE_ERROR_OK)
+    {
+        printf("Error opening list file\n");
+        close(fd);
+        return ASFPARSE_ERROR_OPEN_FILE;
+    }
+
+    /* send a batch, then read its answers, so that neither side fills the
+       socket while the other is writing */
+    output_init(&request);
+    output_init(&buffer);
+    do
+    {
+        output_reset(&request);
+        num_sent = 0;
+        while (num_sent < DAEMON_MAX_BATCH && (p_path = path_source_next(&source)) != NULL)
+        {
+            /* a name is one line, so a name with a newline cannot be sent;
+               the daemon drops a trailing '\r', so neither can an empty name */
+            if (strchr(p_path, '\n') != NULL || strlen(p_path) >= DAEMON_MAX_LINE
+                || p_path[0] == '\0' || strcmp(p_path, "\r") == 0)
+            {
+                if (first_error == ASFPARSE_ERROR_OK)
+                {
+                    first_error = ASFPARSE_ERROR_INVALID_ARG;
+                }
+                continue;
+            }
+            output_printf(&request, "%s\n", p_path);
+            num_sent++;
+        }
+        if (num_sent > 0)
+        {
+            error = (output_flush(&request, fd) == 0) ? receive_answers(fd, num_sent, &buffer, &first_error)
+                                                      : ASFPARSE_ERROR_OPEN_FILE;
+        }
+    } while (num_sent > 0 && error == ASFPARSE_ERROR_OK);
+
+    if (error)
+    {
+        printf("Error reading answers from %s\n", params->p_query_socket);
+        first_error = error;
+    }
+    output_free(&request);
+    output_free(&buffer);
+    path_source_close(&source);
+    close(fd);
+
+    return first_error;
+}
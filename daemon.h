@@ -0,0 +1,43 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+/* Includes */
+#include "cli.h"
+
+/* Defines and constants */
+#define DAEMON_MAX_BATCH        (4096)          /* file names answered together, in one write */
+#define DAEMON_MAX_LINE         (65536)         /* longest request line accepted */
+#define DAEMON_MAX_CONNECTIONS  (1024)          /* clients served at once; more are closed at once */
+#define DAEMON_LISTEN_BACKLOG   (128)           /* connections waiting to be accepted */
+#define DAEMON_METRICS_PATH     "/metrics"      /* HTTP path that returns the metrics */
+
+/* Function prototypes */
+/*****************************************************************************
+* NAME:  run_daemon
+* DESCRIPTION: Listen on a UNIX domain socket until SIGINT or SIGTERM and
+*              answer each line received, a file name, with the file's JSON
+*              output. Results are kept in an LRU of files that is checked
+*              with one stat() per name; other files are parsed on a pool of
+*              worker threads. An HTTP GET of DAEMON_METRICS_PATH on the same
+*              socket returns counters in the Prometheus text format.
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+run_daemon
+    (const params_t    *params      /* [in] structure containing user-defined parameters */
+    );
+
+/*****************************************************************************
+* NAME:  run_query
+* DESCRIPTION: Send every input file name in params to a daemon and write its
+*              answers to stdout in input order, or, if no names were given,
+*              write the daemon's metrics
+* RETURNS: asfparse_error_t of the first file (in input order) that failed,
+*          or ASFPARSE_ERROR_OK
+******************************************************************************/
+asfparse_error_t
+run_query
+    (const params_t    *params      /* [in] structure containing user-defined parameters */
+    );
+
+#endif
@@ -1,202 +1,699 @@
 #include "display.h"
+#include "guid.h"
+
+/*****************************************************************************
+* NAME:  display_utf16_text
+* DESCRIPTION: Append a UTF-16LE string, up to its NUL terminator, to an
+*              output buffer as UTF-8
+* RETURNS: none
+******************************************************************************/
+static void
+display_utf16_text
+    (output_t      *out         /* [in,out] buffer receiving the formatted text */
+    ,const char    *p_data      /* [in] UTF-16LE code units */
+    ,size_t         num_bytes   /* [in] number of bytes in p_data */
+    )
+{
+    size_t  num_units = utf16le_length(p_data, num_bytes / 2);
+    char   *p_dest = output_reserve(out, num_units * UTF8_MAX_BYTES_PER_UTF16_UNIT);
+
+    out->length += utf16le_to_utf8(p_dest, p_data, num_units);
+}
+
+/*****************************************************************************
+* NAME:  display_byte_values
+* DESCRIPTION: Append each byte of an array as a signed decimal number
+*              followed by a space
+* RETURNS: none
+******************************************************************************/
+static void
+display_byte_values
+    (output_t      *out         /* [in,out] buffer receiving the formatted text */
+    ,const char    *p_data      /* [in] bytes */
+    ,size_t         length      /* [in] number of bytes in p_data */
+    )
+{
+    char   *p_start = output_reserve(out, length * 5);
+    char   *p_dest = p_start;
+    int     value;
+    size_t  i;
+
+    for (i = 0; i < length; i++)
+    {
+        value = (signed char)p_data[i];
+        if (value < 0)
+        {
+            *p_dest++ = '-';
+            value = -value;
+        }
+        if (value >= 100)
+        {
+            *p_dest++ = (char)('0' + value / 100);
+        }
+        if (value >= 10)
+        {
+            *p_dest++ = (char)('0' + value / 10 % 10);
+        }
+        *p_dest++ = (char)('0' + value % 10);
+        *p_dest++ = ' ';
+    }
+    out->length += (size_t)(p_dest - p_start);
+}
 
 /*****************************************************************************
 * NAME:  display_header_object
-* DESCRIPTION: Display header object information to command line
+* DESCRIPTION: Display header object information to an output
+*              buffer
 * RETURNS: none
 ******************************************************************************/
 void
 display_header_object
     (header_object_t   *header      /* [in] struct containing info about header object */
+    ,output_t          *out         /* [in,out] buffer receiving the formatted text */
     )
 {
-    printf("\nHEADER OBJECT\n");
-    printf("    Object size: %d bytes\n", header->object_size);
-    printf("    Number of header objects: %d\n", header->num_objects);
-    printf("\n--------------------------------------------------\n");
+    output_printf(out, "\nHEADER OBJECT\n");
+    output_printf(out, "    Object size: %lld bytes\n", header->object_size);
+    output_printf(out, "    Number of header objects: %lld\n", header->num_objects);
+    output_printf(out, "\n--------------------------------------------------\n");
 }
 
 /*****************************************************************************
 * NAME:  display_file_properties_object
-* DESCRIPTION: Display file properties object information to command line
+* DESCRIPTION: Display file properties object information to an output
+*              buffer
 * RETURNS: none
 ******************************************************************************/
 void
 display_file_properties_object
     (file_properties_object_t  *file_properties      /* [in] struct containing info about file properties object */
+    ,output_t                  *out                  /* [in,out] buffer receiving the formatted text */
     )
 {
-    printf("\nFILE PROPERTIES OBJECT\n");
-    printf("    Object size: %d bytes\n", file_properties->object_size);
-    printf("    File Size: %d bytes\n", file_properties->file_size);
-    printf("    Min Data Pkt Size: %d bytes\n", file_properties->min_data_packet_size);
-    printf("    Max Data Pkt Size: %d bytes\n", file_properties->max_data_packet_size);
-    printf("    Max Bitrate: %d bps\n", file_properties->max_bitrate);
-    printf("\n--------------------------------------------------\n");
+    output_printf(out, "\nFILE PROPERTIES OBJECT\n");
+    output_printf(out, "    Object size: %lld bytes\n", file_properties->object_size);
+    output_printf(out, "    File Size: %lld bytes\n", file_properties->file_size);
+    output_printf(out, "    Min Data Pkt Size: %lld bytes\n", file_properties->min_data_packet_size);
+    output_printf(out, "    Max Data Pkt Size: %lld bytes\n", file_properties->max_data_packet_size);
+    output_printf(out, "    Max Bitrate: %lld bps\n", file_properties->max_bitrate);
+    output_printf(out, "\n--------------------------------------------------\n");
 }
 
 /*****************************************************************************
 * NAME:  display_stream_properties_object
-* DESCRIPTION: Display stream properties object information to command line
+* DESCRIPTION: Display stream properties object information to an output
+*              buffer
 * RETURNS: none
 ******************************************************************************/
 void
 display_stream_properties_object
     (stream_properties_object_t    *stream_properties   /* [in] struct containing info about stream properties object */
+    ,output_t                      *out                 /* [in,out] buffer receiving the formatted text */
     )
 {
-    printf("\nSTREAM PROPERTIES OBJECT\n");
-    printf("    Object Size: %d bytes\n", stream_properties->object_size);
+    const guid_entry_t *entry;
+
+    output_printf(out, "\nSTREAM PROPERTIES OBJECT\n");
+    output_printf(out, "    Object Size: %lld bytes\n", stream_properties->object_size);
 
-    printf("    Stream type: ");
+    output_printf(out, "    Stream type: ");
     if (memcmp(stream_properties->stream_type, ASF_AUDIO_MEDIA_GUID, GUID_LENGTH_IN_BYTES) == 0)
     {
-        printf("Audio\n");
-        printf("    Audio Type Data Length: %d bytes\n", stream_properties->type_specific_data_length);
+        output_printf(out, "Audio\n");
+        output_printf(out, "    Audio Type Data Length: %lld bytes\n", stream_properties->type_specific_data_length);
     }
     else if (memcmp(stream_properties->stream_type, ASF_VIDEO_MEDIA_GUID, GUID_LENGTH_IN_BYTES) == 0)
     {
-        printf("Video\n");
-        printf("    Video Type Data Length: %d bytes\n", stream_properties->type_specific_data_length);
+        output_printf(out, "Video\n");
+        output_printf(out, "    Video Type Data Length: %lld bytes\n", stream_properties->type_specific_data_length);
     }
     else
     {
-        printf("?\n");
-        printf("    Type Specific Data Length: %d bytes\n", stream_properties->type_specific_data_length);
+        entry = guid_lookup(stream_properties->stream_type);
+        output_printf(out, "%s\n", (entry != NULL && entry->kind == GUID_KIND_STREAM_TYPE) ? entry->p_name : "?");
+        output_printf(out, "    Type Specific Data Length: %lld bytes\n", stream_properties->type_specific_data_length);
     }
-    printf("\n--------------------------------------------------\n");
+    output_printf(out, "\n--------------------------------------------------\n");
 }
 
 /*****************************************************************************
 * NAME:  display_header_extension_object
-* DESCRIPTION: Display header extension object information to command line
+* DESCRIPTION: Display header extension object information to an output
+*              buffer
 * RETURNS: none
 ******************************************************************************/
 void
 display_header_extension_object
     (header_extension_object_t *header_ext  /* [in] struct containing info about header extension object */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
     )
 {
-    printf("\nHEADER EXTENSION OBJECT\n");
-    printf("    Object size: %d bytes\n", header_ext->object_size);
-    printf("    Header extension data size: %d bytes\n", header_ext->data_size);
-    printf("\n--------------------------------------------------\n");
+    output_printf(out, "\nHEADER EXTENSION OBJECT\n");
+    output_printf(out, "    Object size: %lld bytes\n", header_ext->object_size);
+    output_printf(out, "    Header extension data size: %lld bytes\n", header_ext->data_size);
+    output_printf(out, "\n--------------------------------------------------\n");
 }
 
 /*****************************************************************************
 * NAME:  display_codec_list_object
-* DESCRIPTION: Display codec list object information to command line
+* DESCRIPTION: Display codec list object information to an output
+*              buffer
 * RETURNS: none
 ******************************************************************************/
 void
 display_codec_list_object
     (codec_list_object_t   *codec_list  /* [in] struct containing info about codec list object */
+    ,output_t              *out         /* [in,out] buffer receiving the formatted text */
     )
 {
-    int i, j;
+    int i;
 
-    printf("\nCODEC LIST OBJECT\n");
-    printf("    Object size: %d bytes\n", codec_list->object_size);
-    printf("    Number of codecs: %d\n\n", codec_list->codec_entry_count);
+    output_printf(out, "\nCODEC LIST OBJECT\n");
+    output_printf(out, "    Object size: %lld bytes\n", codec_list->object_size);
+    output_printf(out, "    Number of codecs: %lld\n\n", codec_list->codec_entry_count);
 
     /* print information about each codec entry */
     for (i = 0; i < codec_list->codec_entry_count; i++)
     {
-        printf("\tCODEC %d\n", i+1);
+        output_printf(out, "\tCODEC %d\n", i+1);
 
-        printf("\t    Name: ");
-        for (j = 0; j < codec_list->codec_entry[i].codec_name_length*2; j+=2)
-        {
-            printf("%c", codec_list->codec_entry[i].codec_name[j]);
-        }
-        printf("\n");
+        output_printf(out, "\t    Name: ");
+        display_utf16_text(out, codec_list->codec_entry[i].codec_name
+                          ,(size_t)codec_list->codec_entry[i].codec_name_length * 2);
+        output_printf(out, "\n");
 
-        printf("\t    Description: ");
-        for (j = 0; j < codec_list->codec_entry[i].codec_description_length*2; j+=2)
-        {
-            printf("%c", codec_list->codec_entry[i].codec_description[j]);
-        }
-        printf("\n");
+        output_printf(out, "\t    Description: ");
+        display_utf16_text(out, codec_list->codec_entry[i].codec_description
+                          ,(size_t)codec_list->codec_entry[i].codec_description_length * 2);
+        output_printf(out, "\n");
 
-        printf("\t    Information: ");
-        for (j = 0; j < codec_list->codec_entry[i].codec_information_length; j++)
-        {
-            printf("%c", codec_list->codec_entry[i].codec_information[j]);
-        }
-        printf("\n\n");
+        output_printf(out, "\t    Information: ");
+        output_write(out, codec_list->codec_entry[i].codec_information
+                    ,(size_t)codec_list->codec_entry[i].codec_information_length);
+        output_printf(out, "\n\n");
     }
-    printf("\n--------------------------------------------------\n");
+    output_printf(out, "\n--------------------------------------------------\n");
 }
 
 /*****************************************************************************
 * NAME:  display_extended_content_description_object
-* DESCRIPTION: Display extended content description object information to 
-*              command line
+* DESCRIPTION: Display extended content description object information to an
+*              output buffer
 * RETURNS: none
 ******************************************************************************/
 void
 display_extended_content_description_object
     (extended_content_description_object_t *ext_content_descr   /* [in] struct containing info about extended content description object */
+    ,output_t                              *out                 /* [in,out] buffer receiving the formatted text */
     )
 {
-    int i, j;
+    int i;
 
-    printf("\nEXTENDED CONTENT DESCRIPTION OBJECT\n");
-    printf("    Object size: %d bytes\n", ext_content_descr->object_size);
-    printf("    Number of content descriptors: %d\n\n", ext_content_descr->descriptor_count);
+    output_printf(out, "\nEXTENDED CONTENT DESCRIPTION OBJECT\n");
+    output_printf(out, "    Object size: %lld bytes\n", ext_content_descr->object_size);
+    output_printf(out, "    Number of content descriptors: %d\n\n", ext_content_descr->descriptor_count);
     
     for (i = 0; i < ext_content_descr->descriptor_count; i++)
     {
-        printf("\tCONTENT DESCRIPTOR %d\n", i+1);
-        printf("\t    ");
+        output_printf(out, "\tCONTENT DESCRIPTOR %d\n", i+1);
+        output_printf(out, "\t    ");
         
-        for (j = 0; j < ext_content_descr->descriptor[i].name_length; j+=2)
-        {
-            printf("%c", ext_content_descr->descriptor[i].name[j]);
-        }
-        printf(": ");
+        display_utf16_text(out, ext_content_descr->descriptor[i].name
+                          ,(size_t)ext_content_descr->descriptor[i].name_length);
+        output_printf(out, ": ");
 
         switch (ext_content_descr->descriptor[i].value_data_type)
         {
         case 0:	/* unicode string */
-            for (j=0; j < ext_content_descr->descriptor[i].value_length; j+=2)
-            {
-                printf("%c", ext_content_descr->descriptor[i].value[j]);
-            }
+            display_utf16_text(out, ext_content_descr->descriptor[i].value
+                              ,(size_t)ext_content_descr->descriptor[i].value_length);
             break;
         case 1:	/* byte array */
-            for (j = 0; j < ext_content_descr->descriptor[i].value_length; j++)
-            {
-                printf("%d ", ext_content_descr->descriptor[i].value[j]);
-            }
+            display_byte_values(out, ext_content_descr->descriptor[i].value
+                               ,(size_t)ext_content_descr->descriptor[i].value_length);
             break;
         case 2:	/* bool */
         case 3:	/* 32-bit word */
+            output_printf(out, "%llu", load_uint_le(ext_content_descr->descriptor[i].value
+                                                   ,(ext_content_descr->descriptor[i].value_length < 4)
+                                                    ? (size_t)ext_content_descr->descriptor[i].value_length : 4));
+            break;
         case 4:	/* 64-bit word */
-            printf("%lld", convert_char_bytes_to_int(ext_content_descr->descriptor[i].value, 4));
+            output_printf(out, "%llu", load_uint_le(ext_content_descr->descriptor[i].value
+                                                   ,(ext_content_descr->descriptor[i].value_length < 8)
+                                                    ? (size_t)ext_content_descr->descriptor[i].value_length : 8));
             break;
         case 5:	/* 16-bit word */
-            printf("%lld", convert_char_bytes_to_int(ext_content_descr->descriptor[i].value, 2));
+            output_printf(out, "%llu", load_uint_le(ext_content_descr->descriptor[i].value
+                                                   ,(ext_content_descr->descriptor[i].value_length < 2)
+                                                    ? (size_t)ext_content_descr->descriptor[i].value_length : 2));
             break;
         }
-        printf("\n\n");
+        output_printf(out, "\n\n");
     }
-    printf("\n--------------------------------------------------\n");
+    output_printf(out, "\n--------------------------------------------------\n");
 }
 
 /*****************************************************************************
 * NAME:  display_stream_bitrate_properties_object
-* DESCRIPTION: Display stream bitrate properties object information to 
-*              command line
+* DESCRIPTION: Display stream bitrate properties object information to an
+*              output buffer
 * RETURNS: none
 ******************************************************************************/
 void
 display_stream_bitrate_properties_object
     (stream_bitrate_properties_object_t    *stream_bitrate_properties   /* [in] struct containing info about stream bitrate properties object */
+    ,output_t                              *out                         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    const char *p_record;
+    int         i;
+
+    output_printf(out, "\nSTREAM BITRATE PROPERTIES OBJECT:\n");
+    output_printf(out, "    Object size: %lld bytes\n", stream_bitrate_properties->object_size);
+    output_printf(out, "    Number of records: %d\n", stream_bitrate_properties->bitrate_records_count);
+
+    /* print the average bitrate of each stream */
+    for (i = 0; i < stream_bitrate_properties->bitrate_records_count; i++)
+    {
+        p_record = stream_bitrate_properties->bitrate_records + (size_t)i * 6;
+        output_printf(out, "\tSTREAM %u: %u bps\n", load_uint16_le(p_record) & MAX_STREAM_NUMBER, load_uint32_le(p_record + 2));
+    }
+    output_printf(out, "\n--------------------------------------------------\n");
+}
+/*****************************************************************************
+* NAME:  display_data_object
+* DESCRIPTION: Display data object information and a summary of its data
+*              packets to an output buffer
+* RETURNS: none
+******************************************************************************/
+void
+display_data_object
+    (data_object_t         *data        /* [in] struct containing info about data object */
+    ,packet_summary_t      *summary     /* [in] summary of the data packets */
+    ,output_t              *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    int i;
+
+    output_printf(out, "\nDATA OBJECT\n");
+    output_printf(out, "    Object size: %lld bytes\n", data->object_size);
+    output_printf(out, "    Total data packets: %lld\n", data->total_data_packets);
+    output_printf(out, "    Packets parsed: %lld\n", summary->num_packets);
+    output_printf(out, "    Payloads: %lld\n", summary->num_payloads);
+    output_printf(out, "    Payload bytes: %lld\n", summary->payload_bytes);
+    output_printf(out, "    Send time: %u - %u ms\n\n", summary->first_send_time, summary->last_send_time);
+
+    /* print payload counts for each stream that has any */
+    for (i = 0; i <= MAX_STREAM_NUMBER; i++)
+    {
+        if (summary->stream[i].num_payloads == 0)
+        {
+            continue;
+        }
+        output_printf(out, "\tSTREAM %d\n", i);
+        output_printf(out, "\t    Payloads: %lld\n", summary->stream[i].num_payloads);
+        output_printf(out, "\t    Payload bytes: %lld\n", summary->stream[i].payload_bytes);
+        output_printf(out, "\t    Key frames: %lld\n\n", summary->stream[i].num_key_frames);
+    }
+    output_printf(out, "\n--------------------------------------------------\n");
+}
+
+/*****************************************************************************
+* NAME:  display_simple_index_object
+* DESCRIPTION: Display simple index object information to an output buffer
+* RETURNS: none
+******************************************************************************/
+void
+display_simple_index_object
+    (simple_index_object_t *simple_index    /* [in] struct containing info about simple index object */
+    ,output_t              *out             /* [in,out] buffer receiving the formatted text */
+    )
+{
+    output_printf(out, "\nSIMPLE INDEX OBJECT\n");
+    output_printf(out, "    Object size: %lld bytes\n", simple_index->object_size);
+    output_printf(out, "    Index entry time interval: %lld ms\n", simple_index->index_entry_time_interval / 10000);
+    output_printf(out, "    Max packet count: %lld\n", simple_index->max_packet_count);
+    output_printf(out, "    Number of index entries: %lld\n", simple_index->index_entries_count);
+    output_printf(out, "\n--------------------------------------------------\n");
+}
+
+/*****************************************************************************
+* NAME:  display_index_object
+* DESCRIPTION: Display index object information to an output buffer
+* RETURNS: none
+******************************************************************************/
+void
+display_index_object
+    (index_object_t    *index       /* [in] struct containing info about index object */
+    ,output_t          *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    output_printf(out, "\nINDEX OBJECT\n");
+    output_printf(out, "    Object size: %lld bytes\n", index->object_size);
+    output_printf(out, "    Index entry time interval: %lld ms\n", index->index_entry_time_interval);
+    output_printf(out, "    Number of index specifiers: %d\n", index->index_specifiers_count);
+    output_printf(out, "    Number of index blocks: %lld\n", index->index_blocks_count);
+    output_printf(out, "\n--------------------------------------------------\n");
+}
+
+/*****************************************************************************
+* NAME:  display_seek_position
+* DESCRIPTION: Display the result of an index lookup to an output buffer
+* RETURNS: none
+******************************************************************************/
+void
+display_seek_position
+    (long long              time        /* [in] requested presentation time (ms) */
+    ,const seek_table_t    *table       /* [in] seek table used for the lookup */
+    ,const seek_position_t *position    /* [in] position found */
+    ,output_t              *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    output_printf(out, "\nSEEK TO %lld ms\n", time);
+    if (table->stream_number != 0)
+    {
+        output_printf(out, "    Indexed stream: %d\n", table->stream_number);
+    }
+    output_printf(out, "    Index entry time: %lld ms\n", position->entry_time);
+    output_printf(out, "    Data packet: %lld\n", position->packet_number);
+    output_printf(out, "    File offset: %llu bytes\n", position->file_offset);
+    output_printf(out, "\n--------------------------------------------------\n");
+}
+
+/*****************************************************************************
+* NAME:  display_stream_analysis
+* DESCRIPTION: Display the bitrate, presentation time and key frame
+*              statistics of each stream to an output buffer
+* RETURNS: none
+******************************************************************************/
+void
+display_stream_analysis
+    (const stream_analysis_t   *analysis    /* [in] stream statistics */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    const stream_stats_t   *stats;
+    long long               mean_bitrate;
+    int                     i;
+
+    output_printf(out, "\nSTREAM ANALYSIS\n\n");
+
+    /* print statistics for each stream that has payloads */
+    for (i = 0; i <= MAX_STREAM_NUMBER; i++)
+    {
+        stats = &analysis->stream[i];
+        if (stats->num_payloads == 0)
+        {
+            continue;
+        }
+        mean_bitrate = stream_stats_mean_bitrate(stats);
+
+        output_printf(out, "\tSTREAM %d\n", i);
+        output_printf(out, "\t    Payload bytes: %lld\n", stats->payload_bytes);
+        output_printf(out, "\t    Send time: %u - %u ms\n", stats->first_send_time, stats->last_send_time);
+        output_printf(out, "\t    Bitrate: %lld bps (%lld - %lld bps per second)\n"
+                     ,mean_bitrate, stats->min_bitrate, stats->max_bitrate);
+        if (stats->declared_bitrate >= 0)
+        {
+            output_printf(out, "\t    Declared bitrate: %lld bps", stats->declared_bitrate);
+            if (stats->declared_bitrate > 0)
+            {
+                output_printf(out, " (observed %+.1f%%)"
+                             ,(double)(mean_bitrate - stats->declared_bitrate) * 100.0 / (double)stats->declared_bitrate);
+            }
+            output_printf(out, "\n");
+        }
+        output_printf(out, "\t    Media objects: %lld\n", stats->num_media_objects);
+        if (stats->num_deltas > 0)
+        {
+            output_printf(out, "\t    Presentation time delta: %.1f ms (max %lld ms, jitter %.1f ms)\n"
+                         ,(double)stats->delta_sum / (double)stats->num_deltas, stats->max_delta, stats->jitter);
+        }
+        output_printf(out, "\t    Gaps: %lld\n", stats->num_gaps);
+        output_printf(out, "\t    Backward steps: %lld\n", stats->num_backward_steps);
+        output_printf(out, "\t    Key frames: %lld\n", stats->num_key_frames);
+        if (stats->num_key_frame_intervals > 0)
+        {
+            output_printf(out, "\t    Key frame interval: %.1f ms (%lld - %lld ms)\n"
+                         ,(double)stats->key_frame_interval_sum / (double)stats->num_key_frame_intervals
+                         ,stats->min_key_frame_interval, stats->max_key_frame_interval);
+        }
+        output_printf(out, "\n");
+    }
+    output_printf(out, "\n--------------------------------------------------\n");
+}
+
+/*****************************************************************************
+* NAME:  display_extract_result
+* DESCRIPTION: Display what was written when extracting a stream to an
+*              output buffer
+* RETURNS: none
+******************************************************************************/
+void
+display_extract_result
+    (const extract_result_t    *result      /* [in] outcome of the extraction */
+    ,const char                *p_output    /* [in] name of the file written */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    const guid_entry_t *entry = (result->stream_type != NULL) ? guid_lookup(result->stream_type) : NULL;
+
+    output_printf(out, "\nEXTRACTED STREAM %d\n", result->stream_number);
+    output_printf(out, "    Stream type: %s\n", (entry != NULL && entry->kind == GUID_KIND_STREAM_TYPE) ? entry->p_name : "?");
+    output_printf(out, "    Output file: %s\n", p_output);
+    output_printf(out, "    Payloads: %lld\n", result->num_payloads);
+    output_printf(out, "    Media objects: %lld\n", result->num_media_objects);
+    output_printf(out, "    Incomplete media objects: %lld\n", result->num_incomplete);
+    output_printf(out, "    Dropped bytes: %lld\n", result->num_dropped_bytes);
+    output_printf(out, "    Bytes written: %lld\n", result->bytes_written);
+    output_printf(out, "    Writes: %lld\n", result->num_writes);
+    output_printf(out, "\n--------------------------------------------------\n");
+}
+
+/*****************************************************************************
+* NAME:  display_search_build_result
+* DESCRIPTION: Display what was indexed when building a search index to an
+*              output buffer
+* RETURNS: none
+******************************************************************************/
+void
+display_search_build_result
+    (const search_build_result_t   *result      /* [in] outcome of the build */
+    ,output_t                      *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    output_printf(out, "\nSEARCH INDEX\n");
+    output_printf(out, "    Files read: %lld\n", result->num_files);
+    output_printf(out, "    Files indexed: %lld\n", result->num_indexed);
+    output_printf(out, "    Files with errors: %lld\n", result->num_errors);
+    output_printf(out, "    Terms: %lld\n", result->num_terms);
+    output_printf(out, "    Postings: %lld\n", result->num_postings);
+    output_printf(out, "    Index size: %lld bytes\n", result->index_size);
+    output_printf(out, "\n--------------------------------------------------\n");
+}
+
+/*****************************************************************************
+* NAME:  display_search_matches
+* DESCRIPTION: Display the terms of a search index query and the names of
+*              the matching files to an output buffer
+* RETURNS: none
+******************************************************************************/
+void
+display_search_matches
+    (const search_index_t  *index       /* [in] index handle, or NULL if num_files is 0 */
+    ,char * const          *pp_terms    /* [in] query terms */
+    ,int                    num_terms   /* [in] number of entries in pp_terms */
+    ,const unsigned int    *p_files     /* [in] numbers of the matching files */
+    ,size_t                 num_files   /* [in] number of entries in p_files */
+    ,output_t              *out         /* [in,out] buffer receiving the formatted text */
     )
 {
-    printf("\nSTREAM BITRATE PROPERTIES OBJECT:\n");
-    printf("    Object size: %d bytes\n", stream_bitrate_properties->object_size);
-    printf("    Number of records: %d\n", stream_bitrate_properties->bitrate_records_count);
-    printf("\n--------------------------------------------------\n");
-}
\ No newline at end of file
+    size_t  i;
+    int     t;
+
+    output_printf(out, "\nSEARCH RESULTS\n    Terms:");
+    for (t = 0; t < num_terms; t++)
+    {
+        output_printf(out, " %s", pp_terms[t]);
+    }
+    output_printf(out, "\n    Files found: %lu\n", (unsigned long)num_files);
+    for (i = 0; i < num_files; i++)
+    {
+        output_printf(out, "        %s\n", search_index_file_name(index, p_files[i]));
+    }
+    output_printf(out, "\n--------------------------------------------------\n");
+}
+
+/*****************************************************************************
+* NAME:  display_instrument_totals
+* DESCRIPTION: Display the totals of the instrumentation probes as a table
+*              to an output buffer, with the time spent parsing, formatting
+*              and in I/O and the CPU time of the process beside the wall
+*              time, which together show whether a run is bound by I/O or by
+*              the CPU
+* RETURNS: none
+******************************************************************************/
+void
+display_instrument_totals
+    (const instrument_totals_t *totals      /* [in] totals of the run */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    const instrument_probe_total_t *probe;
+    const char                     *p_name;
+    long long                       parse_ns = 0;
+    long long                       format_ns = 0;
+    long long                       io_ns = 0;
+    int                             i;
+
+    output_printf(out, "\nSTATISTICS\n");
+    output_printf(out, "    Clock: %s\n", totals->p_clock);
+    output_printf(out, "    Threads: %d\n", totals->num_threads);
+    output_printf(out, "    Wall time: %.3f ms\n", totals->wall_ns / 1e6);
+    output_printf(out, "    CPU time: %.3f ms user, %.3f ms system (%.2f CPUs busy)\n"
+                 ,totals->user_ns / 1e6
+                 ,totals->system_ns / 1e6
+                 ,(totals->wall_ns > 0) ? (double)(totals->user_ns + totals->system_ns) / (double)totals->wall_ns : 0.0);
+    output_printf(out, "    Page faults: %lld major, %lld minor\n", totals->major_faults, totals->minor_faults);
+
+    output_printf(out, "\n    %-36s %12s %16s %14s %12s\n", "Probe", "Calls", "Bytes", "Time (ms)", "ns/call");
+    for (i = 0; i < NUM_INSTRUMENT_PROBES; i++)
+    {
+        probe = &totals->probes[i];
+        if (probe->count == 0)
+        {
+            continue;
+        }
+        p_name = instrument_probe_name((instrument_probe_t)i);
+        output_printf(out, "    %-36s %12lld %16lld %14.3f %12.0f\n"
+                     ,p_name
+                     ,probe->count
+                     ,probe->bytes
+                     ,probe->ns / 1e6
+                     ,(double)probe->ns / (double)probe->count);
+        if (strncmp(p_name, "parse.", 6) == 0)
+        {
+            parse_ns += probe->ns;
+        }
+        else if (strncmp(p_name, "format.", 7) == 0)
+        {
+            format_ns += probe->ns;
+        }
+        else
+        {
+            io_ns += probe->ns;
+        }
+    }
+
+    /* the times of all threads are added, so they may exceed the wall time */
+    output_printf(out, "\n    Parsing: %.3f ms\n", parse_ns / 1e6);
+    output_printf(out, "    Formatting: %.3f ms\n", format_ns / 1e6);
+    output_printf(out, "    I/O calls and waits: %.3f ms\n", io_ns / 1e6);
+    output_printf(out, "\n--------------------------------------------------\n");
+}
+
+/*****************************************************************************
+* NAME:  display_export_result
+* DESCRIPTION: Display what was written to an export file to an output
+*              buffer
+* RETURNS: none
+******************************************************************************/
+void
+display_export_result
+    (const export_result_t     *result      /* [in] outcome of the export */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    output_printf(out, "\nEXPORT\n");
+    output_printf(out, "    Files: %lld\n", result->num_files);
+    output_printf(out, "    Files with errors: %lld\n", result->num_errors);
+    output_printf(out, "    Streams: %lld\n", result->num_streams);
+    output_printf(out, "    Codecs: %lld\n", result->num_codecs);
+    output_printf(out, "    Row groups: %lld\n", result->num_row_groups);
+    output_printf(out, "    Export size: %lld bytes\n", result->export_size);
+    output_printf(out, "\n--------------------------------------------------\n");
+}
+
+/*****************************************************************************
+* NAME:  display_unknown_object
+* DESCRIPTION: Display the GUID and size of an object that was skipped
+*              because its type is not supported
+* RETURNS: none
+******************************************************************************/
+void
+display_unknown_object
+    (const char    *guid        /* [in] char buffer containing object's GUID */
+    ,long long      object_size /* [in] size of the object in bytes */
+    ,output_t      *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    const unsigned char *g = (const unsigned char *)guid;
+    const guid_entry_t  *entry = guid_lookup(guid);
+
+    /* GUIDs are stored with their first three fields little-endian */
+    output_printf(out, "\nUNSUPPORTED OBJECT (skipped)\n");
+    if (entry != NULL)
+    {
+        output_printf(out, "    Name: %s\n", entry->p_name);
+    }
+    output_printf(out, "    GUID: %02X%02X%02X%02X-%02X%02X-%02X%02X-%02X%02X-%02X%02X%02X%02X%02X%02X\n"
+                 ,g[3], g[2], g[1], g[0], g[5], g[4], g[7], g[6]
+                 ,g[8], g[9], g[10], g[11], g[12], g[13], g[14], g[15]);
+    output_printf(out, "    Object size: %lld bytes\n", object_size);
+    output_printf(out, "\n--------------------------------------------------\n");
+}
+
+/*****************************************************************************
+* NAME:  display_error
+* DESCRIPTION: Display a descriptive message for a parse error event
+* RETURNS: none
+******************************************************************************/
+void
+display_error
+    (const asfparse_event_t    *event       /* [in] ASFPARSE_EVENT_ERROR event */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    /* names of the objects in error messages, indexed by object_type_t */
+    static const char *const OBJECT_ERROR_NAMES[] =
+    {
+         "file"
+        ,"header object"
+        ,"file properties object"
+        ,"stream properties object"
+        ,"codec list object"
+        ,"header extension object"
+        ,"extended content description object"
+        ,"stream bitrate properties object"
+        ,"data object"
+        ,"simple index object"
+        ,"index object"
+    };
+
+    if (event->error == ASFPARSE_ERROR_OPEN_FILE)
+    {
+        output_printf(out, "Error opening input file\n");
+    }
+    else if (event->error == ASFPARSE_ERROR_WRITE_FILE)
+    {
+        output_printf(out, "Error writing output file\n");
+    }
+    else if (event->type == OBJECT_TYPE_NONE)
+    {
+        output_printf(out, "Error parsing file: %s\n"
+                     ,(event->error == ASFPARSE_ERROR_TRUNCATED_OBJECT) ? "truncated object" : "invalid object size");
+    }
+    else if (event->error == ASFPARSE_ERROR_OBJECT_NOT_FOUND)
+    {
+        output_printf(out, "Error parsing file: %s not found\n", OBJECT_ERROR_NAMES[event->type]);
+    }
+    else if (event->type == OBJECT_TYPE_DATA && event->packet_number >= 0)
+    {
+        output_printf(out, "Error parsing data packet %lld\n", event->packet_number);
+    }
+    else
+    {
+        output_printf(out, "Error parsing %s\n", OBJECT_ERROR_NAMES[event->type]);
+    }
+}
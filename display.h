@@ -5,78 +5,249 @@
 #include <stdio.h>
 #include <string.h>
 #include "util.h"
+#include "output.h"
+#include "packet.h"
+#include "index.h"
+#include "streamstats.h"
+#include "extract.h"
+#include "search.h"
+#include "export.h"
+#include "instrument.h"
+#include "asfparse.h"
+#include "utf16.h"
 
 /* Function prototypes */
 /*****************************************************************************
 * NAME:  display_header_object
-* DESCRIPTION: Display header object information to command line
+* DESCRIPTION: Display header object information to an output
+*              buffer
 * RETURNS: none
 ******************************************************************************/
 void
 display_header_object
     (header_object_t   *header      /* [in] struct containing info about header object */
+    ,output_t          *out         /* [in,out] buffer receiving the formatted text */
     );
 
 /*****************************************************************************
 * NAME:  display_file_properties_object
-* DESCRIPTION: Display file properties object information to command line
+* DESCRIPTION: Display file properties object information to an output
+*              buffer
 * RETURNS: none
 ******************************************************************************/
 void
 display_file_properties_object
     (file_properties_object_t  *file_properties      /* [in] struct containing info about file properties object */
+    ,output_t                  *out                  /* [in,out] buffer receiving the formatted text */
     );
 
 /*****************************************************************************
 * NAME:  display_stream_properties_object
-* DESCRIPTION: Display stream properties object information to command line
+* DESCRIPTION: Display stream properties object information to an output
+*              buffer
 * RETURNS: none
 ******************************************************************************/
 void
 display_stream_properties_object
     (stream_properties_object_t    *stream_properties   /* [in] struct containing info about stream properties object */
+    ,output_t                      *out                 /* [in,out] buffer receiving the formatted text */
     );
 
 /*****************************************************************************
 * NAME:  display_header_extension_object
-* DESCRIPTION: Display header extension object information to command line
+* DESCRIPTION: Display header extension object information to an output
+*              buffer
 * RETURNS: none
 ******************************************************************************/
 void
 display_header_extension_object
     (header_extension_object_t *header_ext  /* [in] struct containing info about header extension object */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
     );
 
 /*****************************************************************************
 * NAME:  display_codec_list_object
-* DESCRIPTION: Display codec list object information to command line
+* DESCRIPTION: Display codec list object information to an output
+*              buffer
 * RETURNS: none
 ******************************************************************************/
 void
 display_codec_list_object
     (codec_list_object_t   *codec_list  /* [in] struct containing info about codec list object */
+    ,output_t              *out         /* [in,out] buffer receiving the formatted text */
     );
 
 /*****************************************************************************
 * NAME:  display_extended_content_description_object
-* DESCRIPTION: Display extended content description object information to 
-*              command line
+* DESCRIPTION: Display extended content description object information to an
+*              output buffer
 * RETURNS: none
 ******************************************************************************/
 void
 display_extended_content_description_object
     (extended_content_description_object_t *ext_content_descr   /* [in] struct containing info about extended content description object */
+    ,output_t                              *out                 /* [in,out] buffer receiving the formatted text */
     );
 
 /*****************************************************************************
 * NAME:  display_stream_bitrate_properties_object
-* DESCRIPTION: Display stream bitrate properties object information to 
-*              command line
+* DESCRIPTION: Display stream bitrate properties object information to an
+*              output buffer
 * RETURNS: none
 ******************************************************************************/
 void
 display_stream_bitrate_properties_object
     (stream_bitrate_properties_object_t    *stream_bitrate_properties   /* [in] struct containing info about stream bitrate properties object */
+    ,output_t                              *out                         /* [in,out] buffer receiving the formatted text */
     );
 
-#endif
\ No newline at end of file
+/*****************************************************************************
+* NAME:  display_data_object
+* DESCRIPTION: Display data object information and a summary of its data
+*              packets to an output buffer
+* RETURNS: none
+******************************************************************************/
+void
+display_data_object
+    (data_object_t         *data        /* [in] struct containing info about data object */
+    ,packet_summary_t      *summary     /* [in] summary of the data packets */
+    ,output_t              *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  display_simple_index_object
+* DESCRIPTION: Display simple index object information to an output buffer
+* RETURNS: none
+******************************************************************************/
+void
+display_simple_index_object
+    (simple_index_object_t *simple_index    /* [in] struct containing info about simple index object */
+    ,output_t              *out             /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  display_index_object
+* DESCRIPTION: Display index object information to an output buffer
+* RETURNS: none
+******************************************************************************/
+void
+display_index_object
+    (index_object_t    *index       /* [in] struct containing info about index object */
+    ,output_t          *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  display_seek_position
+* DESCRIPTION: Display the result of an index lookup to an output buffer
+* RETURNS: none
+******************************************************************************/
+void
+display_seek_position
+    (long long              time        /* [in] requested presentation time (ms) */
+    ,const seek_table_t    *table       /* [in] seek table used for the lookup */
+    ,const seek_position_t *position    /* [in] position found */
+    ,output_t              *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  display_stream_analysis
+* DESCRIPTION: Display the bitrate, presentation time and key frame
+*              statistics of each stream to an output buffer
+* RETURNS: none
+******************************************************************************/
+void
+display_stream_analysis
+    (const stream_analysis_t   *analysis    /* [in] stream statistics */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  display_extract_result
+* DESCRIPTION: Display what was written when extracting a stream to an
+*              output buffer
+* RETURNS: none
+******************************************************************************/
+void
+display_extract_result
+    (const extract_result_t    *result      /* [in] outcome of the extraction */
+    ,const char                *p_output    /* [in] name of the file written */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  display_search_build_result
+* DESCRIPTION: Display what was indexed when building a search index to an
+*              output buffer
+* RETURNS: none
+******************************************************************************/
+void
+display_search_build_result
+    (const search_build_result_t   *result      /* [in] outcome of the build */
+    ,output_t                      *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  display_search_matches
+* DESCRIPTION: Display the terms of a search index query and the names of
+*              the matching files to an output buffer
+* RETURNS: none
+******************************************************************************/
+void
+display_search_matches
+    (const search_index_t  *index       /* [in] index handle, or NULL if num_files is 0 */
+    ,char * const          *pp_terms    /* [in] query terms */
+    ,int                    num_terms   /* [in] number of entries in pp_terms */
+    ,const unsigned int    *p_files     /* [in] numbers of the matching files */
+    ,size_t                 num_files   /* [in] number of entries in p_files */
+    ,output_t              *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  display_instrument_totals
+* DESCRIPTION: Display the totals of the instrumentation probes as a table
+*              to an output buffer
+* RETURNS: none
+******************************************************************************/
+void
+display_instrument_totals
+    (const instrument_totals_t *totals      /* [in] totals of the run */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  display_export_result
+* DESCRIPTION: Display what was written to an export file to an output
+*              buffer
+* RETURNS: none
+******************************************************************************/
+void
+display_export_result
+    (const export_result_t     *result      /* [in] outcome of the export */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  display_unknown_object
+* DESCRIPTION: Display the GUID and size of an object that was skipped
+*              because its type is not supported
+* RETURNS: none
+******************************************************************************/
+void
+display_unknown_object
+    (const char    *guid        /* [in] char buffer containing object's GUID */
+    ,long long      object_size /* [in] size of the object in bytes */
+    ,output_t      *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  display_error
+* DESCRIPTION: Display a descriptive message for a parse error event
+* RETURNS: none
+******************************************************************************/
+void
+display_error
+    (const asfparse_event_t    *event       /* [in] ASFPARSE_EVENT_ERROR event */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+#endif
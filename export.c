@@ -0,0 +1,949 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "asfparse.h"
+#include "batch.h"
+#include "guid.h"
+#include "display.h"
+#include "json.h"
+#include "utf16.h"
+#include "export.h"
+
+/* Defines and constants */
+#define EXPORT_MAGIC            "ASFTABLE"  /* first bytes of an export file */
+#define EXPORT_MAGIC_LENGTH     (8)
+#define EXPORT_VERSION          (1)
+#define CHUNK_ALIGN             (8)         /* every column chunk starts on this boundary */
+#define DICTIONARY_SLOTS        (2 * EXPORT_ROW_GROUP_ROWS)     /* hash slots of a row group dictionary, a power of two */
+#define COPY_BUFFER_SIZE        (1024 * 1024)   /* bytes copied at a time when the columns are joined */
+#define SPILL_BUFFER_SIZE       (64 * 1024)     /* stdio buffer of each column's temporary file */
+#define GUID_TEXT_LENGTH        (37)        /* a GUID in registry format and its NUL */
+#define FNV_OFFSET_BASIS        (0xcbf29ce484222325ull)
+#define FNV_PRIME               (0x100000001b3ull)
+#define STREAM_NUMBER_MASK      (0x7f)      /* stream properties flags: stream number */
+
+/* Enums and structs */
+/* Enum naming the tables of an export file */
+typedef enum {
+     TABLE_FILES = 0                /* one row per input file */
+    ,TABLE_STREAMS                  /* one row per Stream Properties Object */
+    ,TABLE_CODECS                   /* one row per Codec List entry */
+    ,NUM_TABLES
+} export_table_id_t;
+
+/* Enum naming the columns of an export file, table by table */
+typedef enum {
+     COLUMN_FILE_NAME = 0
+    ,COLUMN_FILE_ERROR
+    ,COLUMN_FILE_SIZE
+    ,COLUMN_FILE_CREATION_DATE
+    ,COLUMN_FILE_DATA_PACKETS_COUNT
+    ,COLUMN_FILE_PLAY_DURATION
+    ,COLUMN_FILE_SEND_DURATION
+    ,COLUMN_FILE_PREROLL
+    ,COLUMN_FILE_FLAGS
+    ,COLUMN_FILE_MIN_DATA_PACKET_SIZE
+    ,COLUMN_FILE_MAX_DATA_PACKET_SIZE
+    ,COLUMN_FILE_MAX_BITRATE
+    ,COLUMN_STREAM_FILE_ROW
+    ,COLUMN_STREAM_NUMBER
+    ,COLUMN_STREAM_TYPE
+    ,COLUMN_STREAM_ERR_CORRECTION_TYPE
+    ,COLUMN_STREAM_TIME_OFFSET
+    ,COLUMN_STREAM_FLAGS
+    ,COLUMN_STREAM_TYPE_SPECIFIC_DATA
+    ,COLUMN_STREAM_ERR_CORRECTION_DATA
+    ,COLUMN_CODEC_FILE_ROW
+    ,COLUMN_CODEC_TYPE
+    ,COLUMN_CODEC_NAME
+    ,COLUMN_CODEC_DESCRIPTION
+    ,COLUMN_CODEC_INFORMATION
+    ,NUM_COLUMNS
+} export_column_id_t;
+
+/* Structure describing a table: its columns are first_column up to, but not
+   including, end_column */
+typedef struct {
+    const char             *p_name;
+    export_column_id_t      first_column;
+    export_column_id_t      end_column;
+} export_table_def_t;
+
+/* Structure describing a column */
+typedef struct {
+    const char             *p_name;
+    export_column_type_t    type;
+} export_column_def_t;
+
+static const export_table_def_t EXPORT_TABLES[NUM_TABLES] = {
+     {"files",      COLUMN_FILE_NAME,       COLUMN_STREAM_FILE_ROW}
+    ,{"streams",    COLUMN_STREAM_FILE_ROW, COLUMN_CODEC_FILE_ROW}
+    ,{"codecs",     COLUMN_CODEC_FILE_ROW,  NUM_COLUMNS}
+};
+
+static const export_column_def_t EXPORT_COLUMNS[NUM_COLUMNS] = {
+     {"file",                       EXPORT_COLUMN_STRING}   /* input file name */
+    ,{"error",                      EXPORT_COLUMN_UINT32}   /* asfparse_error_t of the file */
+    ,{"file_size",                  EXPORT_COLUMN_INT64}
+    ,{"creation_date",              EXPORT_COLUMN_INT64}
+    ,{"data_packets_count",         EXPORT_COLUMN_INT64}
+    ,{"play_duration",              EXPORT_COLUMN_INT64}
+    ,{"send_duration",              EXPORT_COLUMN_INT64}
+    ,{"preroll",                    EXPORT_COLUMN_INT64}
+    ,{"flags",                      EXPORT_COLUMN_UINT32}
+    ,{"min_data_packet_size",       EXPORT_COLUMN_UINT32}
+    ,{"max_data_packet_size",       EXPORT_COLUMN_UINT32}
+    ,{"max_bitrate",                EXPORT_COLUMN_UINT32}
+    ,{"file_row",                   EXPORT_COLUMN_INT64}    /* row of the file in the files table */
+    ,{"stream_number",              EXPORT_COLUMN_UINT32}
+    ,{"stream_type",                EXPORT_COLUMN_STRING}   /* name of a known stream type, else the GUID */
+    ,{"err_correction_type",        EXPORT_COLUMN_STRING}   /* name of a known type, else the GUID */
+    ,{"time_offset",                EXPORT_COLUMN_INT64}
+    ,{"flags",                      EXPORT_COLUMN_UINT32}
+    ,{"type_specific_data",         EXPORT_COLUMN_STRING}   /* raw bytes */
+    ,{"err_correction_data",        EXPORT_COLUMN_STRING}   /* raw bytes */
+    ,{"file_row",                   EXPORT_COLUMN_INT64}    /* row of the file in the files table */
+    ,{"codec_type",                 EXPORT_COLUMN_UINT32}
+    ,{"codec_name",                 EXPORT_COLUMN_STRING}   /* UTF-8 */
+    ,{"codec_description",          EXPORT_COLUMN_STRING}   /* UTF-8 */
+    ,{"codec_information",          EXPORT_COLUMN_STRING}   /* raw bytes */
+};
+
+/* Structure describing the start of an export file. The file is laid out as
+   this header, the chunks of each column in turn, the table directory, the
+   column directory, the group table and the chunk table, all in the byte
+   order of the machine that wrote it. A row group of a table holds the
+   same rows in each of its columns, as one chunk per column starting on a
+   CHUNK_ALIGN boundary: an INT64 or UINT32 chunk is the values of its rows,
+   and a STRING chunk is the number of values in the row group's dictionary
+   (unsigned int), the end offset of each value in the value bytes (unsigned
+   int), the code of each row (unsigned int, an index into the dictionary)
+   and the value bytes. Since a column's chunks follow one another, the
+   whole column is read with one read of size bytes at offset. */
+typedef struct {
+    char                magic[EXPORT_MAGIC_LENGTH];
+    unsigned int        version;
+    unsigned int        table_size;         /* sizeof(export_table_entry_t), to reject another layout */
+    unsigned int        column_size;        /* sizeof(export_column_entry_t) */
+    unsigned int        num_tables;
+    unsigned int        num_columns;
+    unsigned int        row_group_rows;     /* EXPORT_ROW_GROUP_ROWS when written */
+    unsigned long long  tables_offset;      /* num_tables export_table_entry_t */
+    unsigned long long  columns_offset;     /* num_columns export_column_entry_t, table by table */
+    unsigned long long  groups_offset;      /* first row of each row group of each table, and the number of rows */
+    unsigned long long  chunks_offset;      /* file offset of each chunk of each column, and the column's end */
+    unsigned long long  file_size;
+} export_file_header_t;
+
+/* Structure describing one entry of the table directory. A row group may
+   hold fewer than row_group_rows rows when its strings are large. */
+typedef struct {
+    char                name[EXPORT_NAME_LENGTH];
+    unsigned long long  num_rows;
+    unsigned long long  num_groups;
+    unsigned long long  groups;             /* index of the table's first entry (num_groups + 1) in the group table */
+    unsigned int        first_column;       /* index of the table's first entry in the column directory */
+    unsigned int        num_columns;
+} export_table_entry_t;
+
+/* Structure describing one entry of the column directory */
+typedef struct {
+    char                name[EXPORT_NAME_LENGTH];
+    unsigned long long  offset;             /* file offset of the column's first chunk */
+    unsigned long long  size;               /* bytes in all of its chunks */
+    unsigned long long  chunks;             /* index of the column's first entry (num_groups + 1) in the chunk table */
+    unsigned int        table;              /* index of its table in the table directory */
+    unsigned int        type;               /* export_column_type_t */
+} export_column_entry_t;
+
+/* Structure describing a column while an export is written. Finished
+   chunks go to a temporary file that was removed as soon as it was opened,
+   so it disappears with the process. */
+typedef struct {
+    FILE               *p_spill;            /* chunks written so far */
+    unsigned long long  spill_size;         /* bytes in p_spill */
+    output_t            chunk_offsets;      /* unsigned long long offset in p_spill of each chunk */
+    output_t            values;             /* values of the row group, or the bytes of its dictionary values */
+    output_t            ends;               /* unsigned int end of each dictionary value in values */
+    output_t            codes;              /* unsigned int dictionary code of each row */
+    unsigned int       *p_slots;            /* dictionary hash table of codes plus one, 0 if empty */
+    unsigned int        num_values;         /* dictionary values */
+} export_column_t;
+
+/* Structure describing a table while an export is written */
+typedef struct {
+    unsigned long long  num_rows;
+    unsigned int        group_rows;         /* rows of the row group being collected */
+    output_t            group_starts;       /* unsigned long long first row of each written row group */
+} export_table_t;
+
+/* Structure describing an export being written */
+typedef struct {
+    export_column_t             columns[NUM_COLUMNS];
+    export_table_t              tables[NUM_TABLES];
+    file_properties_object_t    file_properties;    /* of the file being parsed, zero if none */
+    output_t                    text;               /* string being converted to UTF-8 */
+} exporter_t;
+
+/*****************************************************************************
+* NAME:  hash_bytes
+* DESCRIPTION: Hash a dictionary value (64-bit FNV-1a)
+* RETURNS: hash
+******************************************************************************/
+static unsigned long long
+hash_bytes
+    (const char    *p_data      /* [in] value bytes */
+    ,size_t         length      /* [in] number of bytes in p_data */
+    )
+{
+    unsigned long long  hash = FNV_OFFSET_BASIS;
+    size_t              i;
+
+    for (i = 0; i < length; i++)
+    {
+        hash = (hash ^ (unsigned char)p_data[i]) * FNV_PRIME;
+    }
+
+    return hash;
+}
+
+/*****************************************************************************
+* NAME:  add_int64
+* DESCRIPTION: Append a value to an INT64 column
+* RETURNS: none
+******************************************************************************/
+static void
+add_int64
+    (export_column_t   *column      /* [in,out] column being written */
+    ,long long          value       /* [in] value of the row */
+    )
+{
+    output_write(&column->values, (const char *)&value, sizeof(long long));
+}
+
+/*****************************************************************************
+* NAME:  add_uint32
+* DESCRIPTION: Append a value to a UINT32 column
+* RETURNS: none
+******************************************************************************/
+static void
+add_uint32
+    (export_column_t   *column      /* [in,out] column being written */
+    ,unsigned int       value       /* [in] value of the row */
+    )
+{
+    output_write(&column->values, (const char *)&value, sizeof(unsigned int));
+}
+
+/*****************************************************************************
+* NAME:  add_string
+* DESCRIPTION: Append a value to a STRING column, adding it to the row
+*              group's dictionary unless it is already there
+* RETURNS: none
+******************************************************************************/
+static void
+add_string
+    (export_column_t   *column      /* [in,out] column being written */
+    ,const char        *p_value     /* [in] value bytes */
+    ,size_t             length      /* [in] number of bytes in p_value */
+    )
+{
+    const unsigned int *p_ends = (const unsigned int *)column->ends.p_data;
+    size_t              slot = (size_t)hash_bytes(p_value, length) & (DICTIONARY_SLOTS - 1);
+    unsigned int        code;
+    unsigned int        start;
+
+    /* a row group has at most EXPORT_ROW_GROUP_ROWS values, so the table
+       never fills */
+    while (column->p_slots[slot] != 0)
+    {
+        code = column->p_slots[slot] - 1;
+        start = (code > 0) ? p_ends[code - 1] : 0;
+        if (p_ends[code] - start == length && (length == 0 || memcmp(column->values.p_data + start, p_value, length) == 0))
+        {
+            output_write(&column->codes, (const char *)&code, sizeof(unsigned int));
+            return;
+        }
+        slot = (slot + 1) & (DICTIONARY_SLOTS - 1);
+    }
+
+    code = column->num_values++;
+    column->p_slots[slot] = code + 1;
+    if (length > 0)
+    {
+        output_write(&column->values, p_value, length);
+    }
+    start = (unsigned int)column->values.length;
+    output_write(&column->ends, (const char *)&start, sizeof(unsigned int));
+    output_write(&column->codes, (const char *)&code, sizeof(unsigned int));
+}
+
+/*****************************************************************************
+* NAME:  add_utf16_string
+* DESCRIPTION: Append a UTF-16LE string, up to any NUL terminator, to a
+*              STRING column as UTF-8
+* RETURNS: none
+******************************************************************************/
+static void
+add_utf16_string
+    (exporter_t        *exporter    /* [in,out] export being written */
+    ,export_column_t   *column      /* [in,out] column being written */
+    ,const char        *p_data      /* [in] UTF-16LE bytes */
+    ,size_t             num_units   /* [in] number of code units in p_data */
+    )
+{
+    size_t  length;
+
+    num_units = utf16le_length(p_data, num_units);
+    output_reset(&exporter->text);
+    length = utf16le_to_utf8(output_reserve(&exporter->text, num_units * UTF8_MAX_BYTES_PER_UTF16_UNIT + 1), p_data, num_units);
+    add_string(column, exporter->text.p_data, length);
+}
+
+/*****************************************************************************
+* NAME:  add_guid
+* DESCRIPTION: Append a GUID to a STRING column: its name if the registry
+*              knows it as the given kind, otherwise its registry format
+* RETURNS: none
+******************************************************************************/
+static void
+add_guid
+    (export_column_t   *column      /* [in,out] column being written */
+    ,const char        *guid        /* [in] char buffer containing the GUID */
+    ,guid_kind_t        kind        /* [in] what the GUID identifies */
+    )
+{
+    const unsigned char    *g = (const unsigned char *)guid;
+    const guid_entry_t     *entry = guid_lookup(guid);
+    char                    text[GUID_TEXT_LENGTH];
+
+    if (entry != NULL && entry->kind == kind)
+    {
+        add_string(column, entry->p_name, strlen(entry->p_name));
+        return;
+    }
+
+    /* GUIDs are stored with their first three fields little-endian */
+    sprintf(text, "%02X%02X%02X%02X-%02X%02X-%02X%02X-%02X%02X-%02X%02X%02X%02X%02X%02X"
+           ,g[3], g[2], g[1], g[0], g[5], g[4], g[7], g[6]
+           ,g[8], g[9], g[10], g[11], g[12], g[13], g[14], g[15]);
+    add_string(column, text, strlen(text));
+}
+
+/*****************************************************************************
+* NAME:  write_chunk
+* DESCRIPTION: Write the values a column holds for the row group being
+*              collected to its temporary file as one chunk, and empty them
+* RETURNS: none
+******************************************************************************/
+static void
+write_chunk
+    (export_column_t       *column      /* [in,out] column being written */
+    ,export_column_type_t   type        /* [in] how the column stores its values */
+    )
+{
+    static const char   zeros[CHUNK_ALIGN] = {0};
+    unsigned long long  size = 0;
+    size_t              padding;
+
+    output_write(&column->chunk_offsets, (const char *)&column->spill_size, sizeof(unsigned long long));
+    if (type == EXPORT_COLUMN_STRING)
+    {
+        fwrite(&column->num_values, sizeof(unsigned int), 1, column->p_spill);
+        fwrite(column->ends.p_data, 1, column->ends.length, column->p_spill);
+        fwrite(column->codes.p_data, 1, column->codes.length, column->p_spill);
+        size = sizeof(unsigned int) + column->ends.length + column->codes.length;
+        memset(column->p_slots, 0, DICTIONARY_SLOTS * sizeof(unsigned int));
+        column->num_values = 0;
+        output_reset(&column->ends);
+        output_reset(&column->codes);
+    }
+    if (column->values.length > 0)
+    {
+        fwrite(column->values.p_data, 1, column->values.length, column->p_spill);
+        size += column->values.length;
+    }
+    output_reset(&column->values);
+
+    padding = (size_t)((CHUNK_ALIGN - size % CHUNK_ALIGN) % CHUNK_ALIGN);
+    fwrite(zeros, 1, padding, column->p_spill);
+    column->spill_size += size + padding;
+}
+
+/*****************************************************************************
+* NAME:  write_row_group
+* DESCRIPTION: Write the row group being collected for a table, one chunk
+*              per column
+* RETURNS: none
+******************************************************************************/
+static void
+write_row_group
+    (exporter_t        *exporter    /* [in,out] export being written */
+    ,export_table_id_t  table_id    /* [in] table of the row group */
+    )
+{
+    export_table_t     *table = &exporter->tables[table_id];
+    unsigned long long  first_row = table->num_rows - table->group_rows;
+    int                 i;
+
+    output_write(&table->group_starts, (const char *)&first_row, sizeof(unsigned long long));
+    for (i = EXPORT_TABLES[table_id].first_column; i < (int)EXPORT_TABLES[table_id].end_column; i++)
+    {
+        write_chunk(&exporter->columns[i], EXPORT_COLUMNS[i].type);
+    }
+    table->group_rows = 0;
+}
+
+/*****************************************************************************
+* NAME:  end_row
+* DESCRIPTION: Finish a row whose value has been added to each column of its
+*              table, writing the row group once it is full or its strings
+*              are large
+* RETURNS: none
+******************************************************************************/
+static void
+end_row
+    (exporter_t        *exporter    /* [in,out] export being written */
+    ,export_table_id_t  table_id    /* [in] table of the row */
+    )
+{
+    export_table_t *table = &exporter->tables[table_id];
+    int             is_full = 0;
+    int             i;
+
+    table->num_rows++;
+    table->group_rows++;
+    for (i = EXPORT_TABLES[table_id].first_column; i < (int)EXPORT_TABLES[table_id].end_column; i++)
+    {
+        if (exporter->columns[i].values.length >= EXPORT_MAX_GROUP_BYTES)
+        {
+            is_full = 1;
+        }
+    }
+    if (is_full || table->group_rows == EXPORT_ROW_GROUP_ROWS)
+    {
+        write_row_group(exporter, table_id);
+    }
+}
+
+/*****************************************************************************
+* NAME:  export_stream
+* DESCRIPTION: Add a row for a Stream Properties Object to the streams table
+* RETURNS: none
+******************************************************************************/
+static void
+export_stream
+    (exporter_t                        *exporter            /* [in,out] export being written */
+    ,const stream_properties_object_t  *stream_properties   /* [in] struct containing info about stream properties object */
+    )
+{
+    export_column_t    *columns = exporter->columns;
+
+    add_int64(&columns[COLUMN_STREAM_FILE_ROW], (long long)exporter->tables[TABLE_FILES].num_rows);
+    add_uint32(&columns[COLUMN_STREAM_NUMBER], (unsigned int)(stream_properties->flags & STREAM_NUMBER_MASK));
+    add_guid(&columns[COLUMN_STREAM_TYPE], stream_properties->stream_type, GUID_KIND_STREAM_TYPE);
+    add_guid(&columns[COLUMN_STREAM_ERR_CORRECTION_TYPE], stream_properties->err_correction_type, GUID_KIND_ERROR_CORRECTION);
+    add_int64(&columns[COLUMN_STREAM_TIME_OFFSET], stream_properties->time_offset);
+    add_uint32(&columns[COLUMN_STREAM_FLAGS], (unsigned int)stream_properties->flags);
+    add_string(&columns[COLUMN_STREAM_TYPE_SPECIFIC_DATA], stream_properties->type_specific_data
+              ,(size_t)stream_properties->type_specific_data_length);
+    add_string(&columns[COLUMN_STREAM_ERR_CORRECTION_DATA], stream_properties->err_correction_data
+              ,(size_t)stream_properties->err_correction_data_length);
+    end_row(exporter, TABLE_STREAMS);
+}
+
+/*****************************************************************************
+* NAME:  export_codecs
+* DESCRIPTION: Add a row for each entry of a Codec List Object to the codecs
+*              table
+* RETURNS: none
+******************************************************************************/
+static void
+export_codecs
+    (exporter_t                    *exporter    /* [in,out] export being written */
+    ,const codec_list_object_t     *codec_list  /* [in] struct containing info about codec list object */
+    )
+{
+    export_column_t        *columns = exporter->columns;
+    const codec_entry_t    *entry;
+    long long               i;
+
+    for (i = 0; i < codec_list->codec_entry_count; i++)
+    {
+        entry = &codec_list->codec_entry[i];
+        add_int64(&columns[COLUMN_CODEC_FILE_ROW], (long long)exporter->tables[TABLE_FILES].num_rows);
+        add_uint32(&columns[COLUMN_CODEC_TYPE], (unsigned int)entry->codec_type);
+        add_utf16_string(exporter, &columns[COLUMN_CODEC_NAME], entry->codec_name, (size_t)entry->codec_name_length);
+        add_utf16_string(exporter, &columns[COLUMN_CODEC_DESCRIPTION], entry->codec_description
+                        ,(size_t)entry->codec_description_length);
+        add_string(&columns[COLUMN_CODEC_INFORMATION], entry->codec_information, (size_t)entry->codec_information_length);
+        end_row(exporter, TABLE_CODECS);
+    }
+}
+
+/*****************************************************************************
+* NAME:  export_file
+* DESCRIPTION: Add the row of a parsed file to the files table
+* RETURNS: none
+******************************************************************************/
+static void
+export_file
+    (exporter_t        *exporter    /* [in,out] export being written */
+    ,const char        *p_filename  /* [in] name of the file */
+    ,asfparse_error_t   error       /* [in] result of parsing it */
+    )
+{
+    export_column_t                *columns = exporter->columns;
+    const file_properties_object_t *file_properties = &exporter->file_properties;
+
+    add_string(&columns[COLUMN_FILE_NAME], p_filename, strlen(p_filename));
+    add_uint32(&columns[COLUMN_FILE_ERROR], (unsigned int)error);
+    add_int64(&columns[COLUMN_FILE_SIZE], file_properties->file_size);
+    add_int64(&columns[COLUMN_FILE_CREATION_DATE], file_properties->creation_date);
+    add_int64(&columns[COLUMN_FILE_DATA_PACKETS_COUNT], file_properties->data_packets_count);
+    add_int64(&columns[COLUMN_FILE_PLAY_DURATION], file_properties->play_duration);
+    add_int64(&columns[COLUMN_FILE_SEND_DURATION], file_properties->send_duration);
+    add_int64(&columns[COLUMN_FILE_PREROLL], file_properties->preroll);
+    add_uint32(&columns[COLUMN_FILE_FLAGS], (unsigned int)file_properties->flags);
+    add_uint32(&columns[COLUMN_FILE_MIN_DATA_PACKET_SIZE], (unsigned int)file_properties->min_data_packet_size);
+    add_uint32(&columns[COLUMN_FILE_MAX_DATA_PACKET_SIZE], (unsigned int)file_properties->max_data_packet_size);
+    add_uint32(&columns[COLUMN_FILE_MAX_BITRATE], (unsigned int)file_properties->max_bitrate);
+    end_row(exporter, TABLE_FILES);
+}
+
+/*****************************************************************************
+* NAME:  export_event
+* DESCRIPTION: Callback receiving the parse events of a file being exported
+* RETURNS: 0 to continue parsing
+******************************************************************************/
+static int
+export_event
+    (void                      *p_user      /* [in] exporter_t */
+    ,const asfparse_event_t    *event       /* [in] parse event */
+    )
+{
+    exporter_t     *exporter = p_user;
+
+    if (event->kind == ASFPARSE_EVENT_OBJECT)
+    {
+        switch (event->type)
+        {
+        case OBJECT_TYPE_FILE_PROPERTIES:
+            exporter->file_properties = *(const file_properties_object_t *)event->object;
+            break;
+        case OBJECT_TYPE_STREAM_PROPERTIES:
+            export_stream(exporter, event->object);
+            break;
+        case OBJECT_TYPE_CODEC_LIST:
+            export_codecs(exporter, event->object);
+            break;
+        default:
+            break;
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************
+* NAME:  init_exporter
+* DESCRIPTION: Prepare an export, opening the temporary file of each column
+*              next to the export file
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+init_exporter
+    (exporter_t        *exporter    /* [out] export being written */
+    ,const char        *p_filename  /* [in] name of export file */
+    )
+{
+    export_column_t    *column;
+    char               *p_spill_filename;
+    int                 i;
+
+    memset(exporter, 0, sizeof(exporter_t));
+    output_init(&exporter->text);
+    for (i = 0; i < NUM_TABLES; i++)
+    {
+        output_init(&exporter->tables[i].group_starts);
+    }
+    for (i = 0; i < NUM_COLUMNS; i++)
+    {
+        column = &exporter->columns[i];
+        output_init(&column->chunk_offsets);
+        output_init(&column->values);
+        output_init(&column->ends);
+        output_init(&column->codes);
+    }
+
+    p_spill_filename = malloc(strlen(p_filename) + 48);
+    if (p_spill_filename == NULL)
+    {
+        return ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
+    for (i = 0; i < NUM_COLUMNS; i++)
+    {
+        column = &exporter->columns[i];
+        if (EXPORT_COLUMNS[i].type == EXPORT_COLUMN_STRING)
+        {
+            column->p_slots = calloc(DICTIONARY_SLOTS, sizeof(unsigned int));
+            if (column->p_slots == NULL)
+            {
+                free(p_spill_filename);
+                return ASFPARSE_ERROR_OUT_OF_MEMORY;
+            }
+        }
+
+        /* the name is only needed to create the file */
+        sprintf(p_spill_filename, "%s.%ld.%d.tmp", p_filename, (long)getpid(), i);
+        column->p_spill = fopen(p_spill_filename, "w+b");
+        if (column->p_spill == NULL)
+        {
+            free(p_spill_filename);
+            return ASFPARSE_ERROR_OPEN_FILE;
+        }
+        unlink(p_spill_filename);
+        setvbuf(column->p_spill, NULL, _IOFBF, SPILL_BUFFER_SIZE);
+    }
+    free(p_spill_filename);
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  free_exporter
+* DESCRIPTION: Release everything held by an export being written
+* RETURNS: none
+******************************************************************************/
+static void
+free_exporter
+    (exporter_t        *exporter    /* [in,out] export being written */
+    )
+{
+    export_column_t    *column;
+    int                 i;
+
+    for (i = 0; i < NUM_COLUMNS; i++)
+    {
+        column = &exporter->columns[i];
+        if (column->p_spill != NULL)
+        {
+            fclose(column->p_spill);
+        }
+        free(column->p_slots);
+        output_free(&column->chunk_offsets);
+        output_free(&column->values);
+        output_free(&column->ends);
+        output_free(&column->codes);
+    }
+    for (i = 0; i < NUM_TABLES; i++)
+    {
+        output_free(&exporter->tables[i].group_starts);
+    }
+    output_free(&exporter->text);
+}
+
+/*****************************************************************************
+* NAME:  copy_spill
+* DESCRIPTION: Append the chunks of a column from its temporary file to the
+*              export file
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+copy_spill
+    (export_column_t   *column      /* [in,out] column written */
+    ,FILE              *p_file      /* [in] export file being written */
+    ,char              *p_buffer    /* [in] COPY_BUFFER_SIZE bytes of scratch space */
+    )
+{
+    unsigned long long  remaining = column->spill_size;
+    size_t              num_bytes;
+
+    if (fflush(column->p_spill) != 0 || ferror(column->p_spill) || fseek(column->p_spill, 0, SEEK_SET) != 0)
+    {
+        return ASFPARSE_ERROR_WRITE_FILE;
+    }
+    while (remaining > 0)
+    {
+        num_bytes = (remaining < COPY_BUFFER_SIZE) ? (size_t)remaining : COPY_BUFFER_SIZE;
+        if (fread(p_buffer, 1, num_bytes, column->p_spill) != num_bytes)
+        {
+            return ASFPARSE_ERROR_WRITE_FILE;
+        }
+        fwrite(p_buffer, 1, num_bytes, p_file);
+        remaining -= num_bytes;
+    }
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  write_export
+* DESCRIPTION: Write the last row group of each table, join the columns in a
+*              temporary file after the header and follow them with the
+*              directories, then rename it over the export file
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+write_export
+    (exporter_t        *exporter    /* [in,out] export being written */
+    ,const char        *p_filename  /* [in] name of export file */
+    ,export_result_t   *result      /* [out] row groups and bytes written */
+    )
+{
+    asfparse_error_t            error = ASFPARSE_ERROR_OK;
+    export_file_header_t        header;
+    export_table_entry_t        table_entry;
+    export_column_entry_t       column_entry;
+    export_column_t            *column;
+    export_table_t             *table;
+    FILE                       *p_file;
+    char                       *p_tmp_filename;
+    char                       *p_buffer;
+    unsigned long long          offsets[NUM_COLUMNS];
+    unsigned long long          num_groups[NUM_TABLES];
+    unsigned long long          num_entries = 0;
+    unsigned long long          offset;
+    const unsigned long long   *p_chunk_offsets;
+    int                         i;
+    int                         t;
+    size_t                      j;
+
+    for (t = 0; t < NUM_TABLES; t++)
+    {
+        if (exporter->tables[t].group_rows > 0)
+        {
+            write_row_group(exporter, (export_table_id_t)t);
+        }
+        num_groups[t] = exporter->tables[t].group_starts.length / sizeof(unsigned long long);
+        result->num_row_groups += (long long)num_groups[t];
+    }
+
+    /* lay out the sections */
+    memset(&header, 0, sizeof(export_file_header_t));
+    memcpy(header.magic, EXPORT_MAGIC, EXPORT_MAGIC_LENGTH);
+    header.version = EXPORT_VERSION;
+    header.table_size = sizeof(export_table_entry_t);
+    header.column_size = sizeof(export_column_entry_t);
+    header.num_tables = NUM_TABLES;
+    header.num_columns = NUM_COLUMNS;
+    header.row_group_rows = EXPORT_ROW_GROUP_ROWS;
+    offset = sizeof(export_file_header_t);
+    for (i = 0; i < NUM_COLUMNS; i++)
+    {
+        offsets[i] = offset;
+        offset += exporter->columns[i].spill_size;
+    }
+    header.tables_offset = offset;
+    header.columns_offset = header.tables_offset + NUM_TABLES * sizeof(export_table_entry_t);
+    header.groups_offset = header.columns_offset + NUM_COLUMNS * sizeof(export_column_entry_t);
+    for (t = 0; t < NUM_TABLES; t++)
+    {
+        num_entries += num_groups[t] + 1;
+    }
+    header.chunks_offset = header.groups_offset + num_entries * sizeof(unsigned long long);
+    num_entries = 0;
+    for (t = 0; t < NUM_TABLES; t++)
+    {
+        num_entries += (num_groups[t] + 1) * (EXPORT_TABLES[t].end_column - EXPORT_TABLES[t].first_column);
+    }
+    header.file_size = header.chunks_offset + num_entries * sizeof(unsigned long long);
+
+    p_tmp_filename = malloc(strlen(p_filename) + 32);
+    p_buffer = malloc(COPY_BUFFER_SIZE);
+    if (p_tmp_filename == NULL || p_buffer == NULL)
+    {
+        free(p_tmp_filename);
+        free(p_buffer);
+        return ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
+    sprintf(p_tmp_filename, "%s.%ld.tmp", p_filename, (long)getpid());
+    p_file = fopen(p_tmp_filename, "wb");
+    if (p_file == NULL)
+    {
+        free(p_tmp_filename);
+        free(p_buffer);
+        return ASFPARSE_ERROR_OPEN_FILE;
+    }
+
+    fwrite(&header, sizeof(export_file_header_t), 1, p_file);
+    for (i = 0; i < NUM_COLUMNS && error == ASFPARSE_ERROR_OK; i++)
+    {
+        error = copy_spill(&exporter->columns[i], p_file, p_buffer);
+    }
+
+    /* directories */
+    num_entries = 0;
+    for (t = 0; t < NUM_TABLES; t++)
+    {
+        memset(&table_entry, 0, sizeof(export_table_entry_t));
+        strncpy(table_entry.name, EXPORT_TABLES[t].p_name, EXPORT_NAME_LENGTH - 1);
+        table_entry.num_rows = exporter->tables[t].num_rows;
+        table_entry.num_groups = num_groups[t];
+        table_entry.groups = num_entries;
+        table_entry.first_column = EXPORT_TABLES[t].first_column;
+        table_entry.num_columns = EXPORT_TABLES[t].end_column - EXPORT_TABLES[t].first_column;
+        fwrite(&table_entry, sizeof(export_table_entry_t), 1, p_file);
+        num_entries += num_groups[t] + 1;
+    }
+    num_entries = 0;
+    for (t = 0; t < NUM_TABLES; t++)
+    {
+        for (i = EXPORT_TABLES[t].first_column; i < (int)EXPORT_TABLES[t].end_column; i++)
+        {
+            memset(&column_entry, 0, sizeof(export_column_entry_t));
+            strncpy(column_entry.name, EXPORT_COLUMNS[i].p_name, EXPORT_NAME_LENGTH - 1);
+            column_entry.offset = offsets[i];
+            column_entry.size = exporter->columns[i].spill_size;
+            column_entry.chunks = num_entries;
+            column_entry.table = (unsigned int)t;
+            column_entry.type = EXPORT_COLUMNS[i].type;
+            fwrite(&column_entry, sizeof(export_column_entry_t), 1, p_file);
+            num_entries += num_groups[t] + 1;
+        }
+    }
+
+    /* the entry after a table's last row group, or a column's last chunk,
+       marks where it ends */
+    for (t = 0; t < NUM_TABLES; t++)
+    {
+        table = &exporter->tables[t];
+        if (num_groups[t] > 0)
+        {
+            fwrite(table->group_starts.p_data, sizeof(unsigned long long), (size_t)num_groups[t], p_file);
+        }
+        fwrite(&table->num_rows, sizeof(unsigned long long), 1, p_file);
+    }
+    for (i = 0; i < NUM_COLUMNS; i++)
+    {
+        column = &exporter->columns[i];
+        p_chunk_offsets = (const unsigned long long *)column->chunk_offsets.p_data;
+        for (j = 0; j < column->chunk_offsets.length / sizeof(unsigned long long); j++)
+        {
+            offset = offsets[i] + p_chunk_offsets[j];
+            fwrite(&offset, sizeof(unsigned long long), 1, p_file);
+        }
+        offset = offsets[i] + column->spill_size;
+        fwrite(&offset, sizeof(unsigned long long), 1, p_file);
+    }
+
+    if (ferror(p_file) || fflush(p_file) != 0 || fsync(fileno(p_file)) != 0)
+    {
+        error = ASFPARSE_ERROR_WRITE_FILE;
+    }
+    if (fclose(p_file) != 0 && error == ASFPARSE_ERROR_OK)
+    {
+        error = ASFPARSE_ERROR_WRITE_FILE;
+    }
+    if (error == ASFPARSE_ERROR_OK && rename(p_tmp_filename, p_filename) != 0)
+    {
+        error = ASFPARSE_ERROR_WRITE_FILE;
+    }
+    if (error)
+    {
+        unlink(p_tmp_filename);
+    }
+    result->export_size = (long long)header.file_size;
+
+    free(p_tmp_filename);
+    free(p_buffer);
+
+    return error;
+}
+
+/*****************************************************************************
+* NAME:  export_tables
+* DESCRIPTION: Export the File Properties, Stream Properties and Codec List
+*              Objects of every input file and append a summary to an output
+*              buffer
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+export_tables
+    (const params_t    *params      /* [in] structure containing user-defined parameters */
+    ,output_t          *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    asfparse_error_t    first_error = ASFPARSE_ERROR_OK;
+    asfparse_error_t    file_error;
+    asfparse_error_t    error;
+    export_result_t     result;
+    exporter_t          exporter;
+    asfparse_options_t  options;
+    asfparse_ctx_t     *ctx;
+    path_source_t       source;
+    const char         *p_path;
+
+    memset(&result, 0, sizeof(export_result_t));
+
+    /* reading each header stops once the three objects are found */
+    memset(&options, 0, sizeof(asfparse_options_t));
+    options.object_mask = OBJECT_MASK(OBJECT_TYPE_FILE_PROPERTIES)
+                        | OBJECT_MASK(OBJECT_TYPE_STREAM_PROPERTIES)
+                        | OBJECT_MASK(OBJECT_TYPE_CODEC_LIST);
+    ctx = asfparse_create(&options);
+    error = init_exporter(&exporter, params->p_export_filename);
+    if (error == ASFPARSE_ERROR_OK && ctx == NULL)
+    {
+        error = ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
+    else if (error == ASFPARSE_ERROR_OK && path_source_open(&source, params) != ASFPARSE_ERROR_OK)
+    {
+        error = ASFPARSE_ERROR_OPEN_FILE;
+    }
+    else if (error == ASFPARSE_ERROR_OK)
+    {
+        while ((p_path = path_source_next(&source)) != NULL)
+        {
+            memset(&exporter.file_properties, 0, sizeof(file_properties_object_t));
+            file_error = asfparse_parse_file(ctx, p_path, export_event, &exporter);
+            export_file(&exporter, p_path, file_error);
+            if (file_error)
+            {
+                result.num_errors++;
+                if (first_error == ASFPARSE_ERROR_OK)
+                {
+                    first_error = file_error;
+                }
+            }
+        }
+        path_source_close(&source);
+
+        error = write_export(&exporter, params->p_export_filename, &result);
+    }
+    asfparse_destroy(ctx);
+
+    result.num_files = (long long)exporter.tables[TABLE_FILES].num_rows;
+    result.num_streams = (long long)exporter.tables[TABLE_STREAMS].num_rows;
+    result.num_codecs = (long long)exporter.tables[TABLE_CODECS].num_rows;
+    free_exporter(&exporter);
+
+    /* files that could not be parsed keep their row, with their error; only
+       a failure to write the export is reported as such */
+    if (params->output_format == OUTPUT_FORMAT_JSON)
+    {
+        output_write(out, "{\"export\":", 10);
+        json_write_string(out, params->p_export_filename, strlen(params->p_export_filename));
+        output_write(out, ",\"tables\":", 10);
+        json_export_result(&result, out);
+        if (error)
+        {
+            output_printf(out, ",\"error\":{\"code\":%d,\"message\":\"%s\"}", error, asfparse_error_string(error));
+        }
+        output_write(out, "}\n", 2);
+    }
+    else
+    {
+        output_printf(out, "WRITING EXPORT FILE:\n    %s\n", params->p_export_filename);
+        output_printf(out, "\n--------------------------------------------------\n");
+        if (error)
+        {
+            output_printf(out, "Error writing export file: %s\n", asfparse_error_string(error));
+        }
+        display_export_result(&result, out);
+    }
+
+    return error ? error : first_error;
+}
@@ -0,0 +1,53 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+/* Includes */
+#include "util.h"
+#include "cli.h"
+#include "output.h"
+
+/* Defines and constants */
+#define EXPORT_ROW_GROUP_ROWS   (65536)             /* most rows in a row group */
+#define EXPORT_MAX_GROUP_BYTES  (16 * 1024 * 1024)  /* string bytes held in one column before its row group is written */
+#define EXPORT_NAME_LENGTH      (32)                /* bytes for a table or column name, NUL-padded */
+
+/* Enums and structs */
+/* Enum describing how the values of a column are stored */
+typedef enum {
+     EXPORT_COLUMN_INT64 = 1        /* one 64-bit signed value per row */
+    ,EXPORT_COLUMN_UINT32           /* one 32-bit unsigned value per row */
+    ,EXPORT_COLUMN_STRING           /* one dictionary code per row into the row group's dictionary */
+} export_column_type_t;
+
+/* Structure describing the outcome of an export */
+typedef struct {
+    long long       num_files;              /* rows of the files table */
+    long long       num_errors;             /* files that could not be parsed */
+    long long       num_streams;            /* rows of the streams table */
+    long long       num_codecs;             /* rows of the codecs table */
+    long long       num_row_groups;         /* row groups of all three tables */
+    long long       export_size;            /* bytes in the export file */
+} export_result_t;
+
+/* Function prototypes */
+/*****************************************************************************
+* NAME:  export_tables
+* DESCRIPTION: Parse the File Properties, Stream Properties and Codec List
+*              Objects of every input file named in params into three tables
+*              of a column-oriented file named in params, and append a summary
+*              to an output buffer. Rows are collected in row groups of at most
+*              EXPORT_ROW_GROUP_ROWS, each written to the column it belongs to
+*              as soon as it is full, so memory does not grow with the number
+*              of files; the columns are then joined one after another so
+*              that each can be loaded with one read. The file is written to a
+*              temporary file that then replaces the old one.
+* RETURNS: asfparse_error_t; writing the export failing takes precedence over
+*          the first file (in input order) that could not be parsed
+******************************************************************************/
+asfparse_error_t
+export_tables
+    (const params_t    *params      /* [in] structure containing user-defined parameters */
+    ,output_t          *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+#endif
@@ -0,0 +1,426 @@
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include "cursor.h"
+#include "packet.h"
+#include "asfparse.h"
+#include "display.h"
+#include "json.h"
+#include "extract.h"
+
+/* Defines and constants */
+#define STREAM_NUMBER_MASK      (0x7f)  /* stream properties flags: stream number */
+#define MIN_REPLICATED_LENGTH   (8)     /* media object size and presentation time */
+
+/* Enums and structs */
+/* Structure describing what is kept while the packets of a file arrive.
+   Payload data is never copied: each iovec points into the mapped input
+   file, and runs that are adjacent in the file share one iovec. */
+typedef struct {
+    const params_t     *params;             /* user-defined parameters */
+    int                 fd;                 /* output file, or -1 until the stream is found */
+    struct iovec        iov[EXTRACT_MAX_IOVECS];
+    int                 num_iov;            /* entries of iov waiting to be written */
+    long long           object_number;      /* media object being reassembled, or -1 */
+    unsigned int        object_size;        /* its size from the replicated data, or 0 if unknown */
+    unsigned int        object_offset;      /* bytes of it written so far */
+    int                 object_broken;      /* non-zero once a fragment of it was lost */
+    asfparse_error_t    error;              /* first error found while handling events */
+    asfparse_event_t    error_event;        /* the error to report, if kind is ASFPARSE_EVENT_ERROR */
+    extract_result_t    result;
+} extract_state_t;
+
+/*****************************************************************************
+* NAME:  flush_iovecs
+* DESCRIPTION: Write every gathered payload run with as few writev() calls
+*              as the kernel allows
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+flush_iovecs
+    (extract_state_t   *state       /* [in,out] extraction state */
+    )
+{
+    struct iovec   *iov = state->iov;
+    int             num_iov = state->num_iov;
+    ssize_t         num_written;
+
+    state->num_iov = 0;
+    while (num_iov > 0)
+    {
+        num_written = writev(state->fd, iov, num_iov);
+        if (num_written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (num_written < 0)
+        {
+            return ASFPARSE_ERROR_WRITE_FILE;
+        }
+        state->result.num_writes++;
+        state->result.bytes_written += num_written;
+
+        /* step over what was written, resuming within a run if the write
+           was short */
+        while (num_iov > 0 && (size_t)num_written >= iov->iov_len)
+        {
+            num_written -= (ssize_t)iov->iov_len;
+            iov++;
+            num_iov--;
+        }
+        if (num_iov > 0)
+        {
+            iov->iov_base = (char *)iov->iov_base + num_written;
+            iov->iov_len -= (size_t)num_written;
+        }
+    }
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  queue_bytes
+* DESCRIPTION: Add a run of the input file to the data to be written,
+*              extending the last run if the two are adjacent
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+queue_bytes
+    (extract_state_t   *state       /* [in,out] extraction state */
+    ,const char        *p_data      /* [in] first byte of the run */
+    ,size_t             length      /* [in] number of bytes in the run */
+    )
+{
+    asfparse_error_t    error;
+    struct iovec       *last;
+
+    if (length == 0)
+    {
+        return ASFPARSE_ERROR_OK;
+    }
+    if (state->num_iov > 0)
+    {
+        last = &state->iov[state->num_iov - 1];
+        if ((const char *)last->iov_base + last->iov_len == p_data)
+        {
+            last->iov_len += length;
+            return ASFPARSE_ERROR_OK;
+        }
+    }
+
+    if (state->num_iov == EXTRACT_MAX_IOVECS)
+    {
+        error = flush_iovecs(state);
+        if (error)
+        {
+            return error;
+        }
+    }
+    state->iov[state->num_iov].iov_base = (void *)p_data;
+    state->iov[state->num_iov].iov_len = length;
+    state->num_iov++;
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  end_media_object
+* DESCRIPTION: Count the media object being reassembled as incomplete if
+*              fewer bytes than its size arrived
+* RETURNS: none
+******************************************************************************/
+static void
+end_media_object
+    (extract_state_t   *state       /* [in,out] extraction state */
+    )
+{
+    if (state->object_number >= 0
+        && (state->object_broken || state->object_offset < state->object_size))
+    {
+        state->result.num_incomplete++;
+    }
+    state->object_number = -1;
+}
+
+/*****************************************************************************
+* NAME:  extract_payload
+* DESCRIPTION: Queue the media object data of one payload of the stream
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+extract_payload
+    (extract_state_t   *state       /* [in,out] extraction state */
+    ,const payload_t   *payload     /* [in] payload of the extracted stream */
+    )
+{
+    asfparse_error_t    error = ASFPARSE_ERROR_OK;
+    cursor_t            cur;
+    const char         *p_sub_payload;
+    unsigned int        length;
+
+    state->result.num_payloads++;
+
+    /* each sub-payload of a compressed payload is a whole media object */
+    if (payload->is_compressed)
+    {
+        end_media_object(state);
+        cursor_init(&cur, payload->payload_data, payload->payload_data_length);
+        while (error == ASFPARSE_ERROR_OK && cursor_remaining(&cur) > 0)
+        {
+            length = cursor_read_uint8(&cur);
+            p_sub_payload = cursor_read_bytes(&cur, length);
+            if (p_sub_payload == NULL)
+            {
+                state->result.num_incomplete++;
+                break;
+            }
+            state->result.num_media_objects++;
+            error = queue_bytes(state, p_sub_payload, length);
+        }
+        return error;
+    }
+
+    /* a fragment at offset 0 starts a media object; any other must carry
+       on from where the previous fragment of the same object ended */
+    if (payload->offset_into_media_object == 0)
+    {
+        end_media_object(state);
+        state->object_number = payload->media_object_number;
+        state->object_size = (payload->replicated_data_length >= MIN_REPLICATED_LENGTH)
+                             ? load_uint32_le(payload->replicated_data) : 0;
+        state->object_offset = 0;
+        state->object_broken = 0;
+        state->result.num_media_objects++;
+    }
+    else if (state->object_number != (long long)payload->media_object_number
+             || state->object_broken
+             || payload->offset_into_media_object != state->object_offset)
+    {
+        if (state->object_number == (long long)payload->media_object_number)
+        {
+            state->object_broken = 1;
+        }
+        state->result.num_dropped_bytes += payload->payload_data_length;
+        return ASFPARSE_ERROR_OK;
+    }
+
+    state->object_offset += payload->payload_data_length;
+
+    return queue_bytes(state, payload->payload_data, payload->payload_data_length);
+}
+
+/*****************************************************************************
+* NAME:  record_error
+* DESCRIPTION: Remember the first error of the extraction
+* RETURNS: non-zero, to stop parsing
+******************************************************************************/
+static int
+record_error
+    (extract_state_t   *state       /* [in,out] extraction state */
+    ,object_type_t      type        /* [in] object being processed */
+    ,asfparse_error_t   error       /* [in] error */
+    )
+{
+    if (state->error_event.kind != ASFPARSE_EVENT_ERROR)
+    {
+        memset(&state->error_event, 0, sizeof(asfparse_event_t));
+        state->error_event.kind = ASFPARSE_EVENT_ERROR;
+        state->error_event.type = type;
+        state->error_event.error = error;
+        state->error_event.packet_number = -1;
+    }
+    if (state->error == ASFPARSE_ERROR_OK)
+    {
+        state->error = error;
+    }
+
+    return 1;
+}
+
+/*****************************************************************************
+* NAME:  extract_event
+* DESCRIPTION: Handle one parse event, implementing asfparse_callback_t
+* RETURNS: non-zero to stop parsing
+******************************************************************************/
+static int
+extract_event
+    (void                      *p_user      /* [in] extraction state */
+    ,const asfparse_event_t    *event       /* [in] event */
+    )
+{
+    extract_state_t                    *state = p_user;
+    const stream_properties_object_t   *stream_properties;
+    const data_packet_t                *packet;
+    const char                         *p_output = state->params->p_extract_filename;
+    asfparse_error_t                    error;
+    int                                 i;
+
+    switch (event->kind)
+    {
+    case ASFPARSE_EVENT_OBJECT:
+        if (event->type == OBJECT_TYPE_STREAM_PROPERTIES)
+        {
+            stream_properties = event->object;
+            if ((stream_properties->flags & STREAM_NUMBER_MASK) == state->result.stream_number)
+            {
+                state->result.stream_type = stream_properties->stream_type;
+            }
+        }
+        else if (event->type == OBJECT_TYPE_DATA)
+        {
+            /* the whole header has been read, so the stream is known to
+               exist before the output file is created */
+            if (state->result.stream_type == NULL)
+            {
+                return record_error(state, OBJECT_TYPE_STREAM_PROPERTIES, ASFPARSE_ERROR_OBJECT_NOT_FOUND);
+            }
+            state->fd = (strcmp(p_output, EXTRACT_STDOUT_FILENAME) == 0)
+                        ? STDOUT_FILENO : open(p_output, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+            if (state->fd < 0)
+            {
+                return record_error(state, OBJECT_TYPE_NONE, ASFPARSE_ERROR_WRITE_FILE);
+            }
+        }
+        break;
+    case ASFPARSE_EVENT_DATA_PACKET:
+        packet = event->object;
+        for (i = 0; i < packet->num_payloads; i++)
+        {
+            if (packet->payload[i].stream_number != state->result.stream_number)
+            {
+                continue;
+            }
+            error = extract_payload(state, &packet->payload[i]);
+            if (error)
+            {
+                return record_error(state, OBJECT_TYPE_NONE, error);
+            }
+        }
+        break;
+    case ASFPARSE_EVENT_ERROR:
+        state->error_event = *event;
+        if (state->error == ASFPARSE_ERROR_OK)
+        {
+            state->error = event->error;
+        }
+        break;
+    case ASFPARSE_EVENT_UNKNOWN_OBJECT:
+    case ASFPARSE_EVENT_DATA_END:
+    case ASFPARSE_EVENT_PACKET_SUMMARY:
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************
+* NAME:  extract_stream
+* DESCRIPTION: Write the media objects of one stream of an ASF file to the
+*              output file named in params, and append a summary to an
+*              output buffer
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+extract_stream
+    (const char        *p_filename  /* [in] name of ASF file to read */
+    ,const params_t    *params      /* [in] structure containing user-defined parameters */
+    ,output_t          *out         /* [in,out] buffer receiving the summary */
+    )
+{
+    asfparse_error_t    error;
+    asfparse_options_t  options;
+    asfparse_ctx_t     *ctx;
+    mapped_file_t       file;
+    extract_state_t     state;
+    int                 is_mapped = 0;
+    int                 is_json = (params->output_format == OUTPUT_FORMAT_JSON);
+
+    memset(&state, 0, sizeof(extract_state_t));
+    state.params = params;
+    state.fd = -1;
+    state.object_number = -1;
+    state.result.stream_number = params->extract_stream;
+
+    /* the payloads and the stream type are pointers into the file, so it
+       stays mapped until the summary has been written */
+    error = map_file(p_filename, &file);
+    if (error)
+    {
+        record_error(&state, OBJECT_TYPE_NONE, error);
+    }
+    else
+    {
+        is_mapped = 1;
+        memset(&options, 0, sizeof(asfparse_options_t));
+        options.object_mask = OBJECT_MASK(OBJECT_TYPE_STREAM_PROPERTIES);
+        options.parse_packets = 1;
+        ctx = asfparse_create(&options);
+        if (ctx == NULL)
+        {
+            record_error(&state, OBJECT_TYPE_NONE, ASFPARSE_ERROR_OUT_OF_MEMORY);
+        }
+        else
+        {
+            error = asfparse_parse_buffer(ctx, file.p_data, file.size, extract_event, &state);
+            if (error && state.error == ASFPARSE_ERROR_OK)
+            {
+                state.error = error;
+            }
+            asfparse_destroy(ctx);
+        }
+
+        /* what was gathered before an error in a later packet is still
+           written */
+        end_media_object(&state);
+        if (state.fd >= 0)
+        {
+            error = flush_iovecs(&state);
+            if (error)
+            {
+                record_error(&state, OBJECT_TYPE_NONE, error);
+            }
+            if (state.fd != STDOUT_FILENO && close(state.fd) != 0)
+            {
+                record_error(&state, OBJECT_TYPE_NONE, ASFPARSE_ERROR_WRITE_FILE);
+            }
+        }
+    }
+
+    if (is_json)
+    {
+        output_write(out, "{\"file\":", 8);
+        json_write_string(out, p_filename, strlen(p_filename));
+        output_write(out, ",\"extract\":", 11);
+        json_extract_result(&state.result, params->p_extract_filename, out);
+        if (state.error_event.kind == ASFPARSE_EVENT_ERROR)
+        {
+            output_write(out, ",\"error\":", 9);
+            json_error(&state.error_event, out);
+        }
+        output_write(out, "}\n", 2);
+    }
+    else
+    {
+        output_printf(out, "EXTRACTING STREAM %d FROM ASF FILE:\n    %s\n", state.result.stream_number, p_filename);
+        output_printf(out, "\n--------------------------------------------------\n");
+        if (state.error_event.kind == ASFPARSE_EVENT_ERROR)
+        {
+            display_error(&state.error_event, out);
+        }
+        if (state.fd >= 0)
+        {
+            display_extract_result(&state.result, params->p_extract_filename, out);
+        }
+    }
+
+    if (is_mapped)
+    {
+        unmap_file(&file);
+    }
+
+    return state.error;
+}
@@ -0,0 +1,41 @@
+#ifndef EXTRACT_H
+#define EXTRACT_H
+
+/* Includes */
+#include "util.h"
+#include "cli.h"
+#include "output.h"
+
+/* Defines and constants */
+#define EXTRACT_MAX_IOVECS      (1024)  /* payload runs gathered per writev(), the Linux IOV_MAX */
+#define EXTRACT_STDOUT_FILENAME "-"     /* output file name that writes the stream to stdout */
+
+/* Enums and structs */
+/* Structure describing the outcome of extracting one stream */
+typedef struct {
+    int             stream_number;
+    const char     *stream_type;            /* stream type GUID, pointing into the input file */
+    long long       num_payloads;           /* payloads of the stream written */
+    long long       num_media_objects;      /* media objects started */
+    long long       num_incomplete;         /* media objects missing a fragment */
+    long long       num_dropped_bytes;      /* bytes of fragments whose media object start was lost */
+    long long       bytes_written;
+    long long       num_writes;             /* writev() calls */
+} extract_result_t;
+
+/* Function prototypes */
+/*****************************************************************************
+* NAME:  extract_stream
+* DESCRIPTION: Write the media objects of one stream of an ASF file, in file
+*              order and without their payload headers, to the output file
+*              named in params, and append a summary to an output buffer
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+extract_stream
+    (const char        *p_filename  /* [in] name of ASF file to read */
+    ,const params_t    *params      /* [in] structure containing user-defined parameters */
+    ,output_t          *out         /* [in,out] buffer receiving the summary */
+    );
+
+#endif
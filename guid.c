@@ -0,0 +1,178 @@
+#include "guid.h"
+
+/* Defines and constants */
+#define GUID_TABLE_BITS     (7)
+#define GUID_TABLE_SIZE     (1 << GUID_TABLE_BITS)      /* more than twice NUM_GUIDS, so probes stay short */
+#define GUID_HASH_MULTIPLIER    (0x9e3779b97f4a7c15ULL) /* 2^64 divided by the golden ratio */
+
+/* Enums and structs */
+/* Structure describing a slot of the open-addressed lookup table. The GUID
+   is held as two 64-bit words so a probe is two integer compares. */
+typedef struct {
+    unsigned long long      low;        /* first 8 bytes of the GUID */
+    unsigned long long      high;       /* last 8 bytes of the GUID */
+    const guid_entry_t     *entry;      /* NULL if the slot is empty */
+} guid_slot_t;
+
+/* GUIDs defined in Section 10 of the ASF Specification */
+const guid_entry_t GUID_REGISTRY[NUM_GUIDS] =
+{
+    /* Top-level objects, Section 10.1 */
+     { { 0x30, 0x26, 0xb2, 0x75, 0x8e, 0x66, 0xcf, 0x11, 0xa6, 0xd9, 0x00, 0xaa, 0x00, 0x62, 0xce, 0x6c }, GUID_KIND_OBJECT,           OBJECT_TYPE_HEADER,                             "header" }
+    ,{ { 0x36, 0x26, 0xb2, 0x75, 0x8e, 0x66, 0xcf, 0x11, 0xa6, 0xd9, 0x00, 0xaa, 0x00, 0x62, 0xce, 0x6c }, GUID_KIND_OBJECT,           OBJECT_TYPE_DATA,                               "data" }
+    ,{ { 0x90, 0x08, 0x00, 0x33, 0xb1, 0xe5, 0xcf, 0x11, 0x89, 0xf4, 0x00, 0xa0, 0xc9, 0x03, 0x49, 0xcb }, GUID_KIND_OBJECT,           OBJECT_TYPE_SIMPLE_INDEX,                       "simple_index" }
+    ,{ { 0xd3, 0x29, 0xe2, 0xd6, 0xda, 0x35, 0xd1, 0x11, 0x90, 0x34, 0x00, 0xa0, 0xc9, 0x03, 0x49, 0xbe }, GUID_KIND_OBJECT,           OBJECT_TYPE_INDEX,                              "index" }
+    ,{ { 0xf8, 0x03, 0xb1, 0xfe, 0xad, 0x12, 0x64, 0x4c, 0x84, 0x0f, 0x2a, 0x1d, 0x2f, 0x7a, 0xd4, 0x8c }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "media_object_index" }
+    ,{ { 0xd0, 0x3f, 0xb7, 0x3c, 0x4a, 0x0c, 0x03, 0x48, 0x95, 0x3d, 0xed, 0xf7, 0xb6, 0x22, 0x8f, 0x0c }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "timecode_index" }
+
+    /* Header Object objects, Section 10.2 */
+    ,{ { 0xa1, 0xdc, 0xab, 0x8c, 0x47, 0xa9, 0xcf, 0x11, 0x8e, 0xe4, 0x00, 0xc0, 0x0c, 0x20, 0x53, 0x65 }, GUID_KIND_OBJECT,           OBJECT_TYPE_FILE_PROPERTIES,                    "file_properties" }
+    ,{ { 0x91, 0x07, 0xdc, 0xb7, 0xb7, 0xa9, 0xcf, 0x11, 0x8e, 0xe6, 0x00, 0xc0, 0x0c, 0x20, 0x53, 0x65 }, GUID_KIND_OBJECT,           OBJECT_TYPE_STREAM_PROPERTIES,                  "stream_properties" }
+    ,{ { 0xb5, 0x03, 0xbf, 0x5f, 0x2e, 0xa9, 0xcf, 0x11, 0x8e, 0xe3, 0x00, 0xc0, 0x0c, 0x20, 0x53, 0x65 }, GUID_KIND_OBJECT,           OBJECT_TYPE_HEADER_EXTENSION,                   "header_extension" }
+    ,{ { 0x40, 0x52, 0xd1, 0x86, 0x1d, 0x31, 0xd0, 0x11, 0xa3, 0xa4, 0x00, 0xa0, 0xc9, 0x03, 0x48, 0xf6 }, GUID_KIND_OBJECT,           OBJECT_TYPE_CODEC_LIST,                         "codec_list" }
+    ,{ { 0x30, 0x1a, 0xfb, 0x1e, 0x62, 0x0b, 0xd0, 0x11, 0xa3, 0x9b, 0x00, 0xa0, 0xc9, 0x03, 0x48, 0xf6 }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "script_command" }
+    ,{ { 0x01, 0xcd, 0x87, 0xf4, 0x51, 0xa9, 0xcf, 0x11, 0x8e, 0xe6, 0x00, 0xc0, 0x0c, 0x20, 0x53, 0x65 }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "marker" }
+    ,{ { 0xdc, 0x29, 0xe2, 0xd6, 0xda, 0x35, 0xd1, 0x11, 0x90, 0x34, 0x00, 0xa0, 0xc9, 0x03, 0x49, 0xbe }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "bitrate_mutual_exclusion" }
+    ,{ { 0x35, 0x26, 0xb2, 0x75, 0x8e, 0x66, 0xcf, 0x11, 0xa6, 0xd9, 0x00, 0xaa, 0x00, 0x62, 0xce, 0x6c }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "error_correction" }
+    ,{ { 0x33, 0x26, 0xb2, 0x75, 0x8e, 0x66, 0xcf, 0x11, 0xa6, 0xd9, 0x00, 0xaa, 0x00, 0x62, 0xce, 0x6c }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "content_description" }
+    ,{ { 0x40, 0xa4, 0xd0, 0xd2, 0x07, 0xe3, 0xd2, 0x11, 0x97, 0xf0, 0x00, 0xa0, 0xc9, 0x5e, 0xa8, 0x50 }, GUID_KIND_OBJECT,           OBJECT_TYPE_EXTENDED_CONTENT_DESCRIPTION,       "extended_content_description" }
+    ,{ { 0xfa, 0xb3, 0x11, 0x22, 0x23, 0xbd, 0xd2, 0x11, 0xb4, 0xb7, 0x00, 0xa0, 0xc9, 0x55, 0xfc, 0x6e }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "content_branding" }
+    ,{ { 0xce, 0x75, 0xf8, 0x7b, 0x8d, 0x46, 0xd1, 0x11, 0x8d, 0x82, 0x00, 0x60, 0x97, 0xc9, 0xa2, 0xb2 }, GUID_KIND_OBJECT,           OBJECT_TYPE_STREAM_BITRATE_PROPERTIES,          "stream_bitrate_properties" }
+    ,{ { 0xfb, 0xb3, 0x11, 0x22, 0x23, 0xbd, 0xd2, 0x11, 0xb4, 0xb7, 0x00, 0xa0, 0xc9, 0x55, 0xfc, 0x6e }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "content_encryption" }
+    ,{ { 0x14, 0xe6, 0x8a, 0x29, 0x22, 0x26, 0x17, 0x4c, 0xb9, 0x35, 0xda, 0xe0, 0x7e, 0xe9, 0x28, 0x9c }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "extended_content_encryption" }
+    ,{ { 0xfc, 0xb3, 0x11, 0x22, 0x23, 0xbd, 0xd2, 0x11, 0xb4, 0xb7, 0x00, 0xa0, 0xc9, 0x55, 0xfc, 0x6e }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "digital_signature" }
+    ,{ { 0x74, 0xd4, 0x06, 0x18, 0xdf, 0xca, 0x09, 0x45, 0xa4, 0xba, 0x9a, 0xab, 0xcb, 0x96, 0xaa, 0xe8 }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "padding" }
+
+    /* Header Extension Object objects, Section 10.3 */
+    ,{ { 0xcb, 0xa5, 0xe6, 0x14, 0x72, 0xc6, 0x32, 0x43, 0x83, 0x99, 0xa9, 0x69, 0x52, 0x06, 0x5b, 0x5a }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "extended_stream_properties" }
+    ,{ { 0xcf, 0x49, 0x86, 0xa0, 0x75, 0x47, 0x70, 0x46, 0x8a, 0x16, 0x6e, 0x35, 0x35, 0x75, 0x66, 0xcd }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "advanced_mutual_exclusion" }
+    ,{ { 0x40, 0x5a, 0x46, 0xd1, 0x79, 0x5a, 0x38, 0x43, 0xb7, 0x1b, 0xe3, 0x6b, 0x8f, 0xd6, 0xc2, 0x49 }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "group_mutual_exclusion" }
+    ,{ { 0x5b, 0xd1, 0xfe, 0xd4, 0xd3, 0x88, 0x4f, 0x45, 0x81, 0xf0, 0xed, 0x5c, 0x45, 0x99, 0x9e, 0x24 }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "stream_prioritization" }
+    ,{ { 0xe6, 0x09, 0x96, 0xa6, 0x7b, 0x51, 0xd2, 0x11, 0xb6, 0xaf, 0x00, 0xc0, 0x4f, 0xd9, 0x08, 0xe9 }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "bandwidth_sharing" }
+    ,{ { 0xa9, 0x46, 0x43, 0x7c, 0xe0, 0xef, 0xfc, 0x4b, 0xb2, 0x29, 0x39, 0x3e, 0xde, 0x41, 0x5c, 0x85 }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "language_list" }
+    ,{ { 0xea, 0xcb, 0xf8, 0xc5, 0xaf, 0x5b, 0x77, 0x48, 0x84, 0x67, 0xaa, 0x8c, 0x44, 0xfa, 0x4c, 0xca }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "metadata" }
+    ,{ { 0x94, 0x1c, 0x23, 0x44, 0x98, 0x94, 0xd1, 0x49, 0xa1, 0x41, 0x1d, 0x13, 0x4e, 0x45, 0x70, 0x54 }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "metadata_library" }
+    ,{ { 0xdf, 0x29, 0xe2, 0xd6, 0xda, 0x35, 0xd1, 0x11, 0x90, 0x34, 0x00, 0xa0, 0xc9, 0x03, 0x49, 0xbe }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "index_parameters" }
+    ,{ { 0xad, 0x3b, 0x20, 0x6b, 0x11, 0x3f, 0xe4, 0x48, 0xac, 0xa8, 0xd7, 0x61, 0x3d, 0xe2, 0xcf, 0xa7 }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "media_object_index_parameters" }
+    ,{ { 0x6d, 0x49, 0x5e, 0xf5, 0x97, 0x97, 0x5d, 0x4b, 0x8c, 0x8b, 0x60, 0x4d, 0xfe, 0x9b, 0xfb, 0x24 }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "timecode_index_parameters" }
+    ,{ { 0x5d, 0x8b, 0xf1, 0x26, 0x84, 0x45, 0xec, 0x47, 0x9f, 0x5f, 0x0e, 0x65, 0x1f, 0x04, 0x52, 0xc9 }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "compatibility" }
+    ,{ { 0x33, 0x85, 0x05, 0x43, 0x81, 0x69, 0xe6, 0x49, 0x9b, 0x74, 0xad, 0x12, 0xcb, 0x86, 0xd5, 0x8c }, GUID_KIND_OBJECT,           OBJECT_TYPE_NONE,                               "advanced_content_encryption" }
+
+    /* Stream types, Section 10.4 */
+    ,{ { 0x40, 0x9e, 0x69, 0xf8, 0x4d, 0x5b, 0xcf, 0x11, 0xa8, 0xfd, 0x00, 0x80, 0x5f, 0x5c, 0x44, 0x2b }, GUID_KIND_STREAM_TYPE,      OBJECT_TYPE_NONE,                               "audio" }
+    ,{ { 0xc0, 0xef, 0x19, 0xbc, 0x4d, 0x5b, 0xcf, 0x11, 0xa8, 0xfd, 0x00, 0x80, 0x5f, 0x5c, 0x44, 0x2b }, GUID_KIND_STREAM_TYPE,      OBJECT_TYPE_NONE,                               "video" }
+    ,{ { 0xc0, 0xcf, 0xda, 0x59, 0xe6, 0x59, 0xd0, 0x11, 0xa3, 0xac, 0x00, 0xa0, 0xc9, 0x03, 0x48, 0xf6 }, GUID_KIND_STREAM_TYPE,      OBJECT_TYPE_NONE,                               "command" }
+    ,{ { 0x00, 0xe1, 0x1b, 0xb6, 0x4e, 0x5b, 0xcf, 0x11, 0xa8, 0xfd, 0x00, 0x80, 0x5f, 0x5c, 0x44, 0x2b }, GUID_KIND_STREAM_TYPE,      OBJECT_TYPE_NONE,                               "jfif" }
+    ,{ { 0xe0, 0x7d, 0x90, 0x35, 0x15, 0xe4, 0xcf, 0x11, 0xa9, 0x17, 0x00, 0x80, 0x5f, 0x5c, 0x44, 0x2b }, GUID_KIND_STREAM_TYPE,      OBJECT_TYPE_NONE,                               "degradable_jpeg" }
+    ,{ { 0x2c, 0x22, 0xbd, 0x91, 0x1c, 0xf2, 0x7a, 0x49, 0x8b, 0x6d, 0x5a, 0xa8, 0x6b, 0xfc, 0x01, 0x85 }, GUID_KIND_STREAM_TYPE,      OBJECT_TYPE_NONE,                               "file_transfer" }
+    ,{ { 0xe2, 0x65, 0xfb, 0x3a, 0xef, 0x47, 0xf2, 0x40, 0xac, 0x2c, 0x70, 0xa9, 0x0d, 0x71, 0xd3, 0x43 }, GUID_KIND_STREAM_TYPE,      OBJECT_TYPE_NONE,                               "binary" }
+
+    /* Error correction types, Section 10.5 */
+    ,{ { 0x00, 0x57, 0xfb, 0x20, 0x55, 0x5b, 0xcf, 0x11, 0xa8, 0xfd, 0x00, 0x80, 0x5f, 0x5c, 0x44, 0x2b }, GUID_KIND_ERROR_CORRECTION, OBJECT_TYPE_NONE,                               "no_error_correction" }
+    ,{ { 0x50, 0xcd, 0xc3, 0xbf, 0x8f, 0x61, 0xcf, 0x11, 0x8b, 0xb2, 0x00, 0xaa, 0x00, 0xb4, 0xe2, 0x20 }, GUID_KIND_ERROR_CORRECTION, OBJECT_TYPE_NONE,                               "audio_spread" }
+
+    /* Reserved field values, Sections 10.3 and 10.6 */
+    ,{ { 0x11, 0xd2, 0xd3, 0xab, 0xba, 0xa9, 0xcf, 0x11, 0x8e, 0xe6, 0x00, 0xc0, 0x0c, 0x20, 0x53, 0x65 }, GUID_KIND_RESERVED,         OBJECT_TYPE_NONE,                               "reserved_1" }
+    ,{ { 0x41, 0x52, 0xd1, 0x86, 0x1d, 0x31, 0xd0, 0x11, 0xa3, 0xa4, 0x00, 0xa0, 0xc9, 0x03, 0x48, 0xf6 }, GUID_KIND_RESERVED,         OBJECT_TYPE_NONE,                               "reserved_2" }
+};
+
+/* Lookup table, filled from GUID_REGISTRY before main() runs and only read
+   afterwards, so it is safe to share between threads */
+static guid_slot_t guid_table[GUID_TABLE_SIZE];
+
+/*****************************************************************************
+* NAME:  guid_hash
+* DESCRIPTION: Work out the first lookup table slot to probe for a GUID
+* RETURNS: slot index
+******************************************************************************/
+static inline unsigned int
+guid_hash
+    (unsigned long long     low     /* [in] first 8 bytes of the GUID */
+    ,unsigned long long     high    /* [in] last 8 bytes of the GUID */
+    )
+{
+    /* many GUIDs share their last 8 bytes and differ only in the first 4,
+       so both halves are mixed before taking the top bits */
+    return (unsigned int)(((low ^ (high >> 1)) * GUID_HASH_MULTIPLIER) >> (64 - GUID_TABLE_BITS));
+}
+
+/*****************************************************************************
+* NAME:  guid_table_init
+* DESCRIPTION: Fill the lookup table from GUID_REGISTRY, using linear probing
+*              on collisions. Runs once when the program or library loads.
+* RETURNS: none
+******************************************************************************/
+static void __attribute__((constructor))
+guid_table_init
+    (
+    )
+{
+    unsigned long long  low;
+    unsigned long long  high;
+    unsigned int        slot;
+    int                 i;
+
+    for (i = 0; i < NUM_GUIDS; i++)
+    {
+        low = load_uint64_le(GUID_REGISTRY[i].guid);
+        high = load_uint64_le(GUID_REGISTRY[i].guid + 8);
+        slot = guid_hash(low, high);
+        while (guid_table[slot].entry != NULL)
+        {
+            slot = (slot + 1) & (GUID_TABLE_SIZE - 1);
+        }
+        guid_table[slot].low = low;
+        guid_table[slot].high = high;
+        guid_table[slot].entry = &GUID_REGISTRY[i];
+    }
+}
+
+/*****************************************************************************
+* NAME:  guid_lookup
+* DESCRIPTION: Find a GUID in the registry with a hash table lookup of two
+*              64-bit compares
+* RETURNS: registry entry, or NULL if the GUID is not in the ASF
+*          Specification
+******************************************************************************/
+const guid_entry_t *
+guid_lookup
+    (const char    *guid        /* [in] char buffer containing the GUID */
+    )
+{
+    unsigned long long  low = load_uint64_le(guid);
+    unsigned long long  high = load_uint64_le(guid + 8);
+    unsigned int        slot = guid_hash(low, high);
+
+    while (guid_table[slot].entry != NULL)
+    {
+        if (guid_table[slot].low == low && guid_table[slot].high == high)
+        {
+            return guid_table[slot].entry;
+        }
+        slot = (slot + 1) & (GUID_TABLE_SIZE - 1);
+    }
+
+    return NULL;
+}
+
+/*****************************************************************************
+* NAME: get_object_type
+* DESCRIPTION: Get ASF object type from its GUID (Globally Unique Identifier)
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+get_object_type
+    (const char    *guid        /* [in] char buffer containing object's GUID */
+    ,object_type_t *obj_type    /* [out] object type */
+    )
+{
+    const guid_entry_t *entry = guid_lookup(guid);
+
+    if (entry == NULL || entry->object_type == OBJECT_TYPE_NONE)
+    {
+        return ASFPARSE_ERROR_UNSUPPORTED_OBJECT_TYPE;
+    }
+
+    *obj_type = entry->object_type;
+    return ASFPARSE_ERROR_OK;
+}
@@ -0,0 +1,181 @@
+#ifndef GUID_H
+#define GUID_H
+
+/* Includes */
+#include "util.h"
+
+/* Defines and constants */
+/* Bytes of each registry GUID, under the names of Section 10 of the ASF
+   Specification */
+#define ASF_HEADER_OBJECT_GUID                           (GUID_REGISTRY[GUID_HEADER_OBJECT].guid)
+#define ASF_DATA_OBJECT_GUID                             (GUID_REGISTRY[GUID_DATA_OBJECT].guid)
+#define ASF_SIMPLE_INDEX_OBJECT_GUID                     (GUID_REGISTRY[GUID_SIMPLE_INDEX_OBJECT].guid)
+#define ASF_INDEX_OBJECT_GUID                            (GUID_REGISTRY[GUID_INDEX_OBJECT].guid)
+#define ASF_MEDIA_OBJECT_INDEX_OBJECT_GUID               (GUID_REGISTRY[GUID_MEDIA_OBJECT_INDEX_OBJECT].guid)
+#define ASF_TIMECODE_INDEX_OBJECT_GUID                   (GUID_REGISTRY[GUID_TIMECODE_INDEX_OBJECT].guid)
+#define ASF_FILE_PROPERTIES_OBJECT_GUID                  (GUID_REGISTRY[GUID_FILE_PROPERTIES_OBJECT].guid)
+#define ASF_STREAM_PROPERTIES_OBJECT_GUID                (GUID_REGISTRY[GUID_STREAM_PROPERTIES_OBJECT].guid)
+#define ASF_HEADER_EXTENSION_OBJECT_GUID                 (GUID_REGISTRY[GUID_HEADER_EXTENSION_OBJECT].guid)
+#define ASF_CODEC_LIST_OBJECT_GUID                       (GUID_REGISTRY[GUID_CODEC_LIST_OBJECT].guid)
+#define ASF_SCRIPT_COMMAND_OBJECT_GUID                   (GUID_REGISTRY[GUID_SCRIPT_COMMAND_OBJECT].guid)
+#define ASF_MARKER_OBJECT_GUID                           (GUID_REGISTRY[GUID_MARKER_OBJECT].guid)
+#define ASF_BITRATE_MUTUAL_EXCLUSION_OBJECT_GUID         (GUID_REGISTRY[GUID_BITRATE_MUTUAL_EXCLUSION_OBJECT].guid)
+#define ASF_ERROR_CORRECTION_OBJECT_GUID                 (GUID_REGISTRY[GUID_ERROR_CORRECTION_OBJECT].guid)
+#define ASF_CONTENT_DESCRIPTION_OBJECT_GUID              (GUID_REGISTRY[GUID_CONTENT_DESCRIPTION_OBJECT].guid)
+#define ASF_EXTENDED_CONTENT_DESCRIPTION_OBJECT_GUID     (GUID_REGISTRY[GUID_EXTENDED_CONTENT_DESCRIPTION_OBJECT].guid)
+#define ASF_CONTENT_BRANDING_OBJECT_GUID                 (GUID_REGISTRY[GUID_CONTENT_BRANDING_OBJECT].guid)
+#define ASF_STREAM_BITRATE_PROPERTIES_OBJECT_GUID        (GUID_REGISTRY[GUID_STREAM_BITRATE_PROPERTIES_OBJECT].guid)
+#define ASF_CONTENT_ENCRYPTION_OBJECT_GUID               (GUID_REGISTRY[GUID_CONTENT_ENCRYPTION_OBJECT].guid)
+#define ASF_EXTENDED_CONTENT_ENCRYPTION_OBJECT_GUID      (GUID_REGISTRY[GUID_EXTENDED_CONTENT_ENCRYPTION_OBJECT].guid)
+#define ASF_DIGITAL_SIGNATURE_OBJECT_GUID                (GUID_REGISTRY[GUID_DIGITAL_SIGNATURE_OBJECT].guid)
+#define ASF_PADDING_OBJECT_GUID                          (GUID_REGISTRY[GUID_PADDING_OBJECT].guid)
+#define ASF_EXTENDED_STREAM_PROPERTIES_OBJECT_GUID       (GUID_REGISTRY[GUID_EXTENDED_STREAM_PROPERTIES_OBJECT].guid)
+#define ASF_ADVANCED_MUTUAL_EXCLUSION_OBJECT_GUID        (GUID_REGISTRY[GUID_ADVANCED_MUTUAL_EXCLUSION_OBJECT].guid)
+#define ASF_GROUP_MUTUAL_EXCLUSION_OBJECT_GUID           (GUID_REGISTRY[GUID_GROUP_MUTUAL_EXCLUSION_OBJECT].guid)
+#define ASF_STREAM_PRIORITIZATION_OBJECT_GUID            (GUID_REGISTRY[GUID_STREAM_PRIORITIZATION_OBJECT].guid)
+#define ASF_BANDWIDTH_SHARING_OBJECT_GUID                (GUID_REGISTRY[GUID_BANDWIDTH_SHARING_OBJECT].guid)
+#define ASF_LANGUAGE_LIST_OBJECT_GUID                    (GUID_REGISTRY[GUID_LANGUAGE_LIST_OBJECT].guid)
+#define ASF_METADATA_OBJECT_GUID                         (GUID_REGISTRY[GUID_METADATA_OBJECT].guid)
+#define ASF_METADATA_LIBRARY_OBJECT_GUID                 (GUID_REGISTRY[GUID_METADATA_LIBRARY_OBJECT].guid)
+#define ASF_INDEX_PARAMETERS_OBJECT_GUID                 (GUID_REGISTRY[GUID_INDEX_PARAMETERS_OBJECT].guid)
+#define ASF_MEDIA_OBJECT_INDEX_PARAMETERS_OBJECT_GUID    (GUID_REGISTRY[GUID_MEDIA_OBJECT_INDEX_PARAMETERS_OBJECT].guid)
+#define ASF_TIMECODE_INDEX_PARAMETERS_OBJECT_GUID        (GUID_REGISTRY[GUID_TIMECODE_INDEX_PARAMETERS_OBJECT].guid)
+#define ASF_COMPATIBILITY_OBJECT_GUID                    (GUID_REGISTRY[GUID_COMPATIBILITY_OBJECT].guid)
+#define ASF_ADVANCED_CONTENT_ENCRYPTION_OBJECT_GUID      (GUID_REGISTRY[GUID_ADVANCED_CONTENT_ENCRYPTION_OBJECT].guid)
+#define ASF_AUDIO_MEDIA_GUID                             (GUID_REGISTRY[GUID_AUDIO_MEDIA].guid)
+#define ASF_VIDEO_MEDIA_GUID                             (GUID_REGISTRY[GUID_VIDEO_MEDIA].guid)
+#define ASF_COMMAND_MEDIA_GUID                           (GUID_REGISTRY[GUID_COMMAND_MEDIA].guid)
+#define ASF_JFIF_MEDIA_GUID                              (GUID_REGISTRY[GUID_JFIF_MEDIA].guid)
+#define ASF_DEGRADABLE_JPEG_MEDIA_GUID                   (GUID_REGISTRY[GUID_DEGRADABLE_JPEG_MEDIA].guid)
+#define ASF_FILE_TRANSFER_MEDIA_GUID                     (GUID_REGISTRY[GUID_FILE_TRANSFER_MEDIA].guid)
+#define ASF_BINARY_MEDIA_GUID                            (GUID_REGISTRY[GUID_BINARY_MEDIA].guid)
+#define ASF_NO_ERROR_CORRECTION_GUID                     (GUID_REGISTRY[GUID_NO_ERROR_CORRECTION].guid)
+#define ASF_AUDIO_SPREAD_GUID                            (GUID_REGISTRY[GUID_AUDIO_SPREAD].guid)
+#define ASF_RESERVED_1_GUID                              (GUID_REGISTRY[GUID_RESERVED_1].guid)
+#define ASF_RESERVED_2_GUID                              (GUID_REGISTRY[GUID_RESERVED_2].guid)
+
+/* Enums and structs */
+/* Enum describing what a GUID identifies */
+typedef enum {
+     GUID_KIND_OBJECT = 0           /* an ASF object */
+    ,GUID_KIND_STREAM_TYPE          /* the stream type of a Stream Properties Object */
+    ,GUID_KIND_ERROR_CORRECTION     /* the error correction type of a Stream Properties Object */
+    ,GUID_KIND_RESERVED             /* the value of a reserved GUID field */
+} guid_kind_t;
+
+/* Enum naming each entry of GUID_REGISTRY, in the order of Section 10 of
+   the ASF Specification */
+typedef enum {
+    /* Top-level objects, Section 10.1 */
+     GUID_HEADER_OBJECT = 0
+    ,GUID_DATA_OBJECT
+    ,GUID_SIMPLE_INDEX_OBJECT
+    ,GUID_INDEX_OBJECT
+    ,GUID_MEDIA_OBJECT_INDEX_OBJECT
+    ,GUID_TIMECODE_INDEX_OBJECT
+
+    /* Header Object objects, Section 10.2 */
+    ,GUID_FILE_PROPERTIES_OBJECT
+    ,GUID_STREAM_PROPERTIES_OBJECT
+    ,GUID_HEADER_EXTENSION_OBJECT
+    ,GUID_CODEC_LIST_OBJECT
+    ,GUID_SCRIPT_COMMAND_OBJECT
+    ,GUID_MARKER_OBJECT
+    ,GUID_BITRATE_MUTUAL_EXCLUSION_OBJECT
+    ,GUID_ERROR_CORRECTION_OBJECT
+    ,GUID_CONTENT_DESCRIPTION_OBJECT
+    ,GUID_EXTENDED_CONTENT_DESCRIPTION_OBJECT
+    ,GUID_CONTENT_BRANDING_OBJECT
+    ,GUID_STREAM_BITRATE_PROPERTIES_OBJECT
+    ,GUID_CONTENT_ENCRYPTION_OBJECT
+    ,GUID_EXTENDED_CONTENT_ENCRYPTION_OBJECT
+    ,GUID_DIGITAL_SIGNATURE_OBJECT
+    ,GUID_PADDING_OBJECT
+
+    /* Header Extension Object objects, Section 10.3 */
+    ,GUID_EXTENDED_STREAM_PROPERTIES_OBJECT
+    ,GUID_ADVANCED_MUTUAL_EXCLUSION_OBJECT
+    ,GUID_GROUP_MUTUAL_EXCLUSION_OBJECT
+    ,GUID_STREAM_PRIORITIZATION_OBJECT
+    ,GUID_BANDWIDTH_SHARING_OBJECT
+    ,GUID_LANGUAGE_LIST_OBJECT
+    ,GUID_METADATA_OBJECT
+    ,GUID_METADATA_LIBRARY_OBJECT
+    ,GUID_INDEX_PARAMETERS_OBJECT
+    ,GUID_MEDIA_OBJECT_INDEX_PARAMETERS_OBJECT
+    ,GUID_TIMECODE_INDEX_PARAMETERS_OBJECT
+    ,GUID_COMPATIBILITY_OBJECT
+    ,GUID_ADVANCED_CONTENT_ENCRYPTION_OBJECT
+
+    /* Stream types, Section 10.4 */
+    ,GUID_AUDIO_MEDIA
+    ,GUID_VIDEO_MEDIA
+    ,GUID_COMMAND_MEDIA
+    ,GUID_JFIF_MEDIA
+    ,GUID_DEGRADABLE_JPEG_MEDIA
+    ,GUID_FILE_TRANSFER_MEDIA
+    ,GUID_BINARY_MEDIA
+
+    /* Error correction types, Section 10.5 */
+    ,GUID_NO_ERROR_CORRECTION
+    ,GUID_AUDIO_SPREAD
+
+    /* Reserved field values, Sections 10.3 and 10.6 */
+    ,GUID_RESERVED_1
+    ,GUID_RESERVED_2
+    ,NUM_GUIDS
+} guid_id_t;
+
+/* Structure describing a GUID of the ASF Specification */
+typedef struct {
+    char            guid[GUID_LENGTH_IN_BYTES];     /* as stored in a file, first three fields little-endian */
+    guid_kind_t     kind;
+    object_type_t   object_type;    /* selects the object's parser; OBJECT_TYPE_NONE if the object is skipped */
+    const char     *p_name;         /* short name, as used in JSON output */
+} guid_entry_t;
+
+/* Every GUID defined by the ASF Specification, indexed by guid_id_t */
+extern const guid_entry_t GUID_REGISTRY[NUM_GUIDS];
+
+/* Function prototypes */
+/*****************************************************************************
+* NAME:  guid_equal
+* DESCRIPTION: Compare two GUIDs as two 64-bit words, for checks against one
+*              expected GUID that need no registry lookup
+* RETURNS: non-zero if the GUIDs are the same
+******************************************************************************/
+static inline int
+guid_equal
+    (const char    *guid_a      /* [in] first GUID */
+    ,const char    *guid_b      /* [in] second GUID */
+    )
+{
+    return load_uint64_le(guid_a) == load_uint64_le(guid_b)
+           && load_uint64_le(guid_a + 8) == load_uint64_le(guid_b + 8);
+}
+
+/*****************************************************************************
+* NAME:  guid_lookup
+* DESCRIPTION: Find a GUID in the registry with a hash table lookup of two
+*              64-bit compares
+* RETURNS: registry entry, or NULL if the GUID is not in the ASF
+*          Specification
+******************************************************************************/
+const guid_entry_t *
+guid_lookup
+    (const char    *guid        /* [in] char buffer containing the GUID */
+    );
+
+/*****************************************************************************
+* NAME:  get_object_type
+* DESCRIPTION: Get ASF object type from its GUID (Globally Unique Identifier)
+* RETURNS: asfparse_error_t; ASFPARSE_ERROR_UNSUPPORTED_OBJECT_TYPE for GUIDs
+*          of objects that are not parsed
+******************************************************************************/
+asfparse_error_t
+get_object_type
+    (const char    *guid        /* [in] char buffer containing object's GUID */
+    ,object_type_t *obj_type    /* [out] object type */
+    );
+
+#endif
@@ -0,0 +1,219 @@
+#include <stdlib.h>
+#include "cursor.h"
+#include "index.h"
+
+/*****************************************************************************
+* NAME:  seek_table_from_simple_index
+* DESCRIPTION: Build a seek table from a parsed Simple Index Object
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+seek_table_from_simple_index
+    (seek_table_t                  *table           /* [out] seek table */
+    ,const simple_index_object_t   *simple_index    /* [in] struct containing info about simple index object */
+    ,const data_object_t           *data            /* [in] struct containing info about data object */
+    ,unsigned int                   packet_size     /* [in] fixed data packet size */
+    )
+{
+    cursor_t    cur;
+    long long   i;
+
+    memset(table, 0, sizeof(seek_table_t));
+    if (simple_index->index_entry_time_interval <= 0
+        || simple_index->index_entries_count <= 0
+        || packet_size == 0)
+    {
+        return ASFPARSE_ERROR_INVALID_ASF_FILE;
+    }
+
+    table->packet_numbers = malloc((size_t)simple_index->index_entries_count * sizeof(unsigned int));
+    if (table->packet_numbers == NULL)
+    {
+        return ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
+
+    /* keep the packet number of each entry; the packet count is not needed
+       to find where to start reading */
+    cursor_init(&cur, simple_index->index_entries, (size_t)simple_index->index_entries_count * 6);
+    for (i = 0; i < simple_index->index_entries_count; i++)
+    {
+        table->packet_numbers[i] = cursor_read_uint32(&cur);
+        cursor_skip(&cur, 2);
+    }
+
+    table->time_interval = simple_index->index_entry_time_interval;
+    table->num_entries = simple_index->index_entries_count;
+    table->packets_offset = data->packets_offset;
+    table->packet_size = packet_size;
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  seek_table_from_index
+* DESCRIPTION: Build a seek table from one index specifier of a parsed Index
+*              Object, flattening its index blocks into a single array
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+seek_table_from_index
+    (seek_table_t              *table           /* [out] seek table */
+    ,const index_object_t      *index           /* [in] struct containing info about index object */
+    ,int                        specifier       /* [in] index of the index specifier to use */
+    ,const data_object_t       *data            /* [in] struct containing info about data object */
+    ,unsigned int               packet_size     /* [in] fixed data packet size */
+    )
+{
+    cursor_t            cur;
+    cursor_t            spec_cur;
+    unsigned long long  block_position;
+    unsigned long long *p_grown;
+    unsigned int        offset;
+    long long           num_block_entries;
+    long long           capacity = 0;
+    size_t              entry_size = (size_t)index->index_specifiers_count * 4;
+    int                 block;
+    long long           i;
+
+    memset(table, 0, sizeof(seek_table_t));
+    if (index->index_entry_time_interval <= 0
+        || specifier < 0
+        || specifier >= index->index_specifiers_count
+        || packet_size == 0)
+    {
+        return ASFPARSE_ERROR_INVALID_ASF_FILE;
+    }
+
+    cursor_init(&spec_cur, index->index_specifiers + (size_t)specifier * 4, 4);
+    table->stream_number = (int)cursor_read_uint16(&spec_cur);
+
+    /* each block holds an entry count, one base position per specifier and
+       then one offset per specifier for every entry */
+    cursor_init(&cur, index->index_blocks, index->index_blocks_size);
+    for (block = 0; block < index->index_blocks_count; block++)
+    {
+        num_block_entries = cursor_read_uint32(&cur);
+        cursor_skip(&cur, (size_t)specifier * 8);
+        block_position = cursor_read_uint64(&cur);
+        cursor_skip(&cur, (size_t)(index->index_specifiers_count - specifier - 1) * 8);
+
+        if (cur.overrun || (size_t)num_block_entries > cursor_remaining(&cur) / entry_size)
+        {
+            seek_table_free(table);
+            return ASFPARSE_ERROR_TRUNCATED_OBJECT;
+        }
+
+        if (table->num_entries + num_block_entries > capacity)
+        {
+            capacity = (table->num_entries + num_block_entries) * 2;
+            p_grown = realloc(table->packet_offsets, (size_t)capacity * sizeof(unsigned long long));
+            if (p_grown == NULL)
+            {
+                seek_table_free(table);
+                return ASFPARSE_ERROR_OUT_OF_MEMORY;
+            }
+            table->packet_offsets = p_grown;
+        }
+
+        for (i = 0; i < num_block_entries; i++)
+        {
+            spec_cur = cur;
+            cursor_skip(&spec_cur, (size_t)specifier * 4);
+            offset = cursor_read_uint32(&spec_cur);
+            cursor_skip(&cur, entry_size);
+
+            table->packet_offsets[table->num_entries++] =
+                (offset == INVALID_INDEX_OFFSET) ? (unsigned long long)-1
+                                                 : block_position + offset;
+        }
+    }
+
+    if (table->num_entries == 0)
+    {
+        seek_table_free(table);
+        return ASFPARSE_ERROR_INVALID_ASF_FILE;
+    }
+
+    /* convert the interval from milliseconds to 100-nanosecond units */
+    table->time_interval = (long long)index->index_entry_time_interval * 10000;
+    table->packets_offset = data->packets_offset;
+    table->packet_size = packet_size;
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  seek_table_lookup
+* DESCRIPTION: Find the data packet to start reading from to present the
+*              given time, i.e. the last index entry at or before it
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+seek_table_lookup
+    (const seek_table_t    *table       /* [in] seek table */
+    ,long long              time        /* [in] presentation time (ms) */
+    ,seek_position_t       *position    /* [out] position of the data packet */
+    )
+{
+    long long           entry;
+    unsigned long long  offset;
+
+    if (time < 0 || time > SEEK_MAX_TIME || table->num_entries == 0)
+    {
+        return ASFPARSE_ERROR_INVALID_ARG;
+    }
+
+    /* entries are evenly spaced, so the entry index is a single division */
+    entry = (time * 10000) / table->time_interval;
+    if (entry < 0)
+    {
+        entry = 0;
+    }
+    else if (entry >= table->num_entries)
+    {
+        entry = table->num_entries - 1;
+    }
+
+    if (table->packet_numbers != NULL)
+    {
+        position->packet_number = table->packet_numbers[entry];
+        offset = (unsigned long long)position->packet_number * table->packet_size;
+    }
+    else
+    {
+        /* step back over entries an Index Object marks as invalid */
+        while (entry > 0 && table->packet_offsets[entry] == (unsigned long long)-1)
+        {
+            entry--;
+        }
+        offset = table->packet_offsets[entry];
+        if (offset == (unsigned long long)-1)
+        {
+            return ASFPARSE_ERROR_INVALID_ASF_FILE;
+        }
+        position->packet_number = (long long)(offset / table->packet_size);
+        offset = (unsigned long long)position->packet_number * table->packet_size;
+    }
+
+    position->entry_time = entry * table->time_interval / 10000;
+    position->file_offset = table->packets_offset + offset;
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  seek_table_free
+* DESCRIPTION: Release the memory held by a seek table
+* RETURNS: none
+******************************************************************************/
+void
+seek_table_free
+    (seek_table_t  *table       /* [in,out] seek table */
+    )
+{
+    free(table->packet_numbers);
+    free(table->packet_offsets);
+    table->packet_numbers = NULL;
+    table->packet_offsets = NULL;
+    table->num_entries = 0;
+}
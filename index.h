@@ -0,0 +1,89 @@
+#ifndef INDEX_H
+#define INDEX_H
+
+/* Includes */
+#include <limits.h>
+#include "util.h"
+
+/* Defines and constants */
+#define INVALID_INDEX_OFFSET    (0xffffffffu)   /* index object entry with no valid offset */
+#define SEEK_MAX_TIME           (LLONG_MAX / 10000) /* latest presentation time (ms) a lookup converts to 100-nanosecond units */
+
+/* Enums and structs */
+/* Structure describing a time-to-position lookup table built from a Simple
+   Index Object or from one index specifier of an Index Object. Index entries
+   are spaced at a fixed time interval, so the entry for a presentation time
+   is found by a single division; the table holds exactly one packed array,
+   4 bytes per entry for a simple index and 8 bytes per entry for an index
+   object. */
+typedef struct {
+    long long           time_interval;      /* 100-nanosecond units between entries */
+    long long           num_entries;
+    unsigned int       *packet_numbers;     /* per entry, from a Simple Index Object, or NULL */
+    unsigned long long *packet_offsets;     /* per entry, byte offset from the first data packet, or NULL */
+    size_t              packets_offset;     /* file offset of the first data packet */
+    unsigned int        packet_size;        /* fixed data packet size */
+    int                 stream_number;      /* stream indexed by an Index Object, 0 for a simple index */
+} seek_table_t;
+
+/* Structure describing the result of a seek table lookup */
+typedef struct {
+    long long           entry_time;         /* presentation time of the index entry used (ms) */
+    long long           packet_number;      /* data packet to start reading from */
+    unsigned long long  file_offset;        /* byte offset of that data packet in the file */
+} seek_position_t;
+
+/* Function prototypes */
+/*****************************************************************************
+* NAME:  seek_table_from_simple_index
+* DESCRIPTION: Build a seek table from a parsed Simple Index Object
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+seek_table_from_simple_index
+    (seek_table_t                  *table           /* [out] seek table */
+    ,const simple_index_object_t   *simple_index    /* [in] struct containing info about simple index object */
+    ,const data_object_t           *data            /* [in] struct containing info about data object */
+    ,unsigned int                   packet_size     /* [in] fixed data packet size */
+    );
+
+/*****************************************************************************
+* NAME:  seek_table_from_index
+* DESCRIPTION: Build a seek table from one index specifier of a parsed Index
+*              Object, flattening its index blocks into a single array
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+seek_table_from_index
+    (seek_table_t              *table           /* [out] seek table */
+    ,const index_object_t      *index           /* [in] struct containing info about index object */
+    ,int                        specifier       /* [in] index of the index specifier to use */
+    ,const data_object_t       *data            /* [in] struct containing info about data object */
+    ,unsigned int               packet_size     /* [in] fixed data packet size */
+    );
+
+/*****************************************************************************
+* NAME:  seek_table_lookup
+* DESCRIPTION: Find the data packet to start reading from to present the
+*              given time, i.e. the last index entry at or before it
+* RETURNS: asfparse_error_t; ASFPARSE_ERROR_INVALID_ARG for a time outside
+*          0 to SEEK_MAX_TIME
+******************************************************************************/
+asfparse_error_t
+seek_table_lookup
+    (const seek_table_t    *table       /* [in] seek table */
+    ,long long              time        /* [in] presentation time (ms) */
+    ,seek_position_t       *position    /* [out] position of the data packet */
+    );
+
+/*****************************************************************************
+* NAME:  seek_table_free
+* DESCRIPTION: Release the memory held by a seek table
+* RETURNS: none
+******************************************************************************/
+void
+seek_table_free
+    (seek_table_t  *table       /* [in,out] seek table */
+    );
+
+#endif
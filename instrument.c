@@ -0,0 +1,248 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define INSTRUMENT_HAVE_TSC
+#endif
+
+#include "instrument.h"
+
+/* Defines and constants */
+#define NS_PER_SECOND   (1000000000ll)
+
+/* Enums and structs */
+/* Structure describing the totals one thread has gathered. Blocks are kept
+   until the process exits, so the totals of threads that have finished are
+   still summed. */
+typedef struct instrument_block_s {
+    struct instrument_block_s  *p_next;     /* block of the thread that registered before */
+    long long                   count[NUM_INSTRUMENT_PROBES];
+    long long                   bytes[NUM_INSTRUMENT_PROBES];
+    instrument_ticks_t          ticks[NUM_INSTRUMENT_PROBES];
+} instrument_block_t;
+
+static pthread_mutex_t                      block_lock = PTHREAD_MUTEX_INITIALIZER;
+static instrument_block_t                  *first_block = NULL;    /* blocks of every thread */
+static _Thread_local instrument_block_t    *thread_block = NULL;   /* block of the calling thread */
+static long long                            start_ns = 0;           /* CLOCK_MONOTONIC at instrument_start */
+static instrument_ticks_t                   start_ticks = 0;        /* clock the probes use at instrument_start */
+static struct rusage                        start_usage;            /* resources used before instrument_start */
+
+/* Names of the probes, indexed by instrument_probe_t */
+static const char *const PROBE_NAMES[NUM_INSTRUMENT_PROBES] =
+{
+     "parse.unknown"
+    ,"parse.header"
+    ,"parse.file_properties"
+    ,"parse.stream_properties"
+    ,"parse.codec_list"
+    ,"parse.header_extension"
+    ,"parse.extended_content_description"
+    ,"parse.stream_bitrate_properties"
+    ,"parse.data"
+    ,"parse.simple_index"
+    ,"parse.index"
+    ,"parse.data_packet"
+    ,"format.text"
+    ,"format.json"
+    ,"io.open"
+    ,"io.mmap"
+    ,"io.read"
+    ,"io.uring"
+    ,"io.wait"
+};
+
+/*****************************************************************************
+* NAME:  monotonic_ns
+* DESCRIPTION: Read CLOCK_MONOTONIC
+* RETURNS: time in nanoseconds
+******************************************************************************/
+static long long
+monotonic_ns
+    (
+    )
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (long long)ts.tv_sec * NS_PER_SECOND + ts.tv_nsec;
+}
+
+/*****************************************************************************
+* NAME:  timeval_ns
+* DESCRIPTION: Convert a time reported by getrusage
+* RETURNS: time in nanoseconds
+******************************************************************************/
+static long long
+timeval_ns
+    (const struct timeval  *tv          /* [in] time to convert */
+    )
+{
+    return (long long)tv->tv_sec * NS_PER_SECOND + (long long)tv->tv_usec * 1000;
+}
+
+/*****************************************************************************
+* NAME:  register_thread
+* DESCRIPTION: Give the calling thread a block of totals the first time it
+*              hits a probe
+* RETURNS: the thread's block, or NULL if memory is exhausted
+******************************************************************************/
+static instrument_block_t *
+register_thread
+    (
+    )
+{
+    instrument_block_t *block = calloc(1, sizeof(instrument_block_t));
+
+    if (block != NULL)
+    {
+        pthread_mutex_lock(&block_lock);
+        block->p_next = first_block;
+        first_block = block;
+        pthread_mutex_unlock(&block_lock);
+        thread_block = block;
+    }
+
+    return block;
+}
+
+/*****************************************************************************
+* NAME:  instrument_start
+* DESCRIPTION: Note the time the measured run starts
+* RETURNS: none
+******************************************************************************/
+void
+instrument_start
+    (
+    )
+{
+    if (getrusage(RUSAGE_SELF, &start_usage) != 0)
+    {
+        memset(&start_usage, 0, sizeof(start_usage));
+    }
+    start_ns = monotonic_ns();
+    start_ticks = instrument_now();
+}
+
+/*****************************************************************************
+* NAME:  instrument_now
+* DESCRIPTION: Read the clock the probes use
+* RETURNS: timestamp
+******************************************************************************/
+instrument_ticks_t
+instrument_now
+    (
+    )
+{
+#if defined(INSTRUMENT_HAVE_TSC)
+    return (instrument_ticks_t)__rdtsc();
+#else
+    return (instrument_ticks_t)monotonic_ns();
+#endif
+}
+
+/*****************************************************************************
+* NAME:  instrument_add
+* DESCRIPTION: Add one call to a probe's totals for the calling thread
+* RETURNS: none
+******************************************************************************/
+void
+instrument_add
+    (instrument_probe_t     probe       /* [in] probe hit */
+    ,long long              bytes       /* [in] bytes handled by the call */
+    ,instrument_ticks_t     ticks       /* [in] clock ticks spent in it */
+    )
+{
+    instrument_block_t *block = thread_block;
+
+    if (block == NULL && (block = register_thread()) == NULL)
+    {
+        return;
+    }
+    block->count[probe]++;
+    block->bytes[probe] += bytes;
+    block->ticks[probe] += ticks;
+}
+
+/*****************************************************************************
+* NAME:  instrument_totals
+* DESCRIPTION: Sum the totals of every thread, converting clock ticks to
+*              nanoseconds with the rate the clock ran at since
+*              instrument_start
+* RETURNS: none
+******************************************************************************/
+void
+instrument_totals
+    (instrument_totals_t   *totals      /* [out] totals of the run so far */
+    )
+{
+    const instrument_block_t   *block;
+    instrument_ticks_t          ticks[NUM_INSTRUMENT_PROBES];
+    instrument_ticks_t          elapsed_ticks = instrument_now() - start_ticks;
+    struct rusage               usage;
+    double                      ns_per_tick = 1.0;
+    int                         i;
+
+    memset(totals, 0, sizeof(instrument_totals_t));
+    memset(ticks, 0, sizeof(ticks));
+    totals->wall_ns = monotonic_ns() - start_ns;
+#if defined(INSTRUMENT_HAVE_TSC)
+    totals->p_clock = "tsc";
+    if (elapsed_ticks > 0)
+    {
+        ns_per_tick = (double)totals->wall_ns / (double)elapsed_ticks;
+    }
+#else
+    totals->p_clock = "clock_gettime";
+    (void)elapsed_ticks;
+#endif
+
+    pthread_mutex_lock(&block_lock);
+    for (block = first_block; block != NULL; block = block->p_next)
+    {
+        totals->num_threads++;
+        for (i = 0; i < NUM_INSTRUMENT_PROBES; i++)
+        {
+            totals->probes[i].count += block->count[i];
+            totals->probes[i].bytes += block->bytes[i];
+            ticks[i] += block->ticks[i];
+        }
+    }
+    pthread_mutex_unlock(&block_lock);
+
+    for (i = 0; i < NUM_INSTRUMENT_PROBES; i++)
+    {
+        totals->probes[i].ns = (long long)((double)ticks[i] * ns_per_tick);
+    }
+
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+        totals->user_ns = timeval_ns(&usage.ru_utime) - timeval_ns(&start_usage.ru_utime);
+        totals->system_ns = timeval_ns(&usage.ru_stime) - timeval_ns(&start_usage.ru_stime);
+        totals->major_faults = usage.ru_majflt - start_usage.ru_majflt;
+        totals->minor_faults = usage.ru_minflt - start_usage.ru_minflt;
+    }
+}
+
+/*****************************************************************************
+* NAME:  instrument_probe_name
+* DESCRIPTION: Get the name of a probe
+* RETURNS: constant NUL-terminated string
+******************************************************************************/
+const char *
+instrument_probe_name
+    (instrument_probe_t     probe       /* [in] probe */
+    )
+{
+    if ((int)probe < 0 || probe >= NUM_INSTRUMENT_PROBES)
+    {
+        return PROBE_NAMES[0];
+    }
+
+    return PROBE_NAMES[probe];
+}
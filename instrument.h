@@ -0,0 +1,124 @@
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+/* Includes */
+#include "util.h"
+
+/* Defines and constants */
+/* Probes are only compiled in when ASFPARSE_INSTRUMENT is defined
+   (make INSTRUMENT=1); otherwise every macro below compiles to nothing.
+   INSTRUMENT_DECLARE must be the last declaration of its block. */
+#if defined(ASFPARSE_INSTRUMENT)
+#define INSTRUMENT_DECLARE(start)               instrument_ticks_t start = 0
+#define INSTRUMENT_START(start)                 ((start) = instrument_now())
+#define INSTRUMENT_STOP(probe, start, bytes)    instrument_add((probe), (long long)(bytes), instrument_now() - (start))
+#define INSTRUMENT_COUNT(probe, bytes)          instrument_add((probe), (long long)(bytes), 0)
+#else
+#define INSTRUMENT_DECLARE(start)
+#define INSTRUMENT_START(start)                 ((void)0)
+#define INSTRUMENT_STOP(probe, start, bytes)    ((void)0)
+#define INSTRUMENT_COUNT(probe, bytes)          ((void)0)
+#endif
+
+#define INSTRUMENT_PARSE(type)  ((instrument_probe_t)(type))   /* probe timing the parser of an object_type_t */
+
+/* Enums and structs */
+/* Enum naming what is counted and timed. The parser of each object type
+   has the probe numbered by its object_type_t, which INSTRUMENT_PARSE
+   gives; the other probes follow. */
+typedef enum {
+     INSTRUMENT_PARSE_DATA_PACKET = NUM_OBJECT_TYPES    /* parse_data_packet(); bytes are packet sizes */
+    ,INSTRUMENT_FORMAT_TEXT                             /* formatting a parse event as text */
+    ,INSTRUMENT_FORMAT_JSON                             /* formatting a parse event as JSON */
+    ,INSTRUMENT_IO_OPEN                                 /* open() of an input file */
+    ,INSTRUMENT_IO_MMAP                                 /* mmap() of an input file; bytes mapped */
+    ,INSTRUMENT_IO_READ                                 /* read() or pread() of an input file; bytes read */
+    ,INSTRUMENT_IO_URING                                /* read of an input file completed by io_uring; bytes read */
+    ,INSTRUMENT_IO_WAIT                                 /* waiting for a header read to complete */
+    ,NUM_INSTRUMENT_PROBES
+} instrument_probe_t;
+
+/* Timestamp in the units of the clock the probes use */
+typedef unsigned long long instrument_ticks_t;
+
+/* Structure describing the totals of one probe */
+typedef struct {
+    long long       count;                  /* calls */
+    long long       bytes;                  /* bytes handled by them */
+    long long       ns;                     /* time spent in them, 0 for counters */
+} instrument_probe_total_t;
+
+/* Structure describing the totals of every probe over all threads, and
+   what the whole process used since instrument_start */
+typedef struct {
+    const char                 *p_clock;        /* "tsc" or "clock_gettime" */
+    int                         num_threads;    /* threads that hit a probe */
+    long long                   wall_ns;
+    long long                   user_ns;        /* CPU time of all threads */
+    long long                   system_ns;
+    long long                   major_faults;   /* page faults that read from disk, including mapped input */
+    long long                   minor_faults;
+    instrument_probe_total_t    probes[NUM_INSTRUMENT_PROBES];
+} instrument_totals_t;
+
+/* Function prototypes */
+/*****************************************************************************
+* NAME:  instrument_start
+* DESCRIPTION: Note the time and resources used when the measured run
+*              starts, against which the TSC is calibrated and CPU time and
+*              page faults are counted
+* RETURNS: none
+******************************************************************************/
+void
+instrument_start
+    (
+    );
+
+/*****************************************************************************
+* NAME:  instrument_now
+* DESCRIPTION: Read the clock the probes use: the TSC on x86, otherwise
+*              CLOCK_MONOTONIC in nanoseconds
+* RETURNS: timestamp
+******************************************************************************/
+instrument_ticks_t
+instrument_now
+    (
+    );
+
+/*****************************************************************************
+* NAME:  instrument_add
+* DESCRIPTION: Add one call to a probe's totals for the calling thread,
+*              which keeps its own totals so that threads never share a
+*              counter
+* RETURNS: none
+******************************************************************************/
+void
+instrument_add
+    (instrument_probe_t     probe       /* [in] probe hit */
+    ,long long              bytes       /* [in] bytes handled by the call */
+    ,instrument_ticks_t     ticks       /* [in] clock ticks spent in it */
+    );
+
+/*****************************************************************************
+* NAME:  instrument_totals
+* DESCRIPTION: Sum the totals of every thread that hit a probe. Threads that
+*              may still hit a probe should have finished first.
+* RETURNS: none
+******************************************************************************/
+void
+instrument_totals
+    (instrument_totals_t   *totals      /* [out] totals of the run so far */
+    );
+
+/*****************************************************************************
+* NAME:  instrument_probe_name
+* DESCRIPTION: Get the name of a probe, such as "parse.file_properties" or
+*              "io.read"
+* RETURNS: constant NUL-terminated string
+******************************************************************************/
+const char *
+instrument_probe_name
+    (instrument_probe_t     probe       /* [in] probe */
+    );
+
+#endif
@@ -0,0 +1,853 @@
+#include "json.h"
+#include "guid.h"
+#include "utf16.h"
+
+/* Defines and constants */
+#define JSON_MAX_ESCAPE_LENGTH      (6)     /* longest escape sequence, \uXXXX */
+#define STREAM_NUMBER_MASK          (0x7f)  /* stream properties flags: stream number */
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+/*****************************************************************************
+* NAME:  json_escape
+* DESCRIPTION: Write the JSON escape sequence for a character that cannot
+*              appear literally in a JSON string
+* RETURNS: pointer to the byte after the escape sequence
+******************************************************************************/
+static char *
+json_escape
+    (char          *p_dest      /* [out] space for up to JSON_MAX_ESCAPE_LENGTH bytes */
+    ,unsigned int   ch          /* [in] character or UTF-16 code unit */
+    )
+{
+    *p_dest++ = '\\';
+    switch (ch)
+    {
+    case '"':
+    case '\\':
+        *p_dest++ = (char)ch;
+        break;
+    case '\n':
+        *p_dest++ = 'n';
+        break;
+    case '\r':
+        *p_dest++ = 'r';
+        break;
+    case '\t':
+        *p_dest++ = 't';
+        break;
+    default:
+        *p_dest++ = 'u';
+        *p_dest++ = HEX_DIGITS[(ch >> 12) & 0x0f];
+        *p_dest++ = HEX_DIGITS[(ch >> 8) & 0x0f];
+        *p_dest++ = HEX_DIGITS[(ch >> 4) & 0x0f];
+        *p_dest++ = HEX_DIGITS[ch & 0x0f];
+        break;
+    }
+
+    return p_dest;
+}
+
+/*****************************************************************************
+* NAME:  json_write_string
+* DESCRIPTION: Append a quoted JSON string holding bytes that are already
+*              UTF-8 (or ASCII)
+* RETURNS: none
+******************************************************************************/
+void
+json_write_string
+    (output_t      *out         /* [in,out] buffer receiving the formatted text */
+    ,const char    *p_data      /* [in] string bytes */
+    ,size_t         length      /* [in] number of bytes in p_data */
+    )
+{
+    const unsigned char    *p_src = (const unsigned char *)p_data;
+    char                   *p_start;
+    char                   *p_dest;
+    size_t                  i;
+
+    /* reserve for the worst case so the loop needs no bounds checks */
+    p_start = output_reserve(out, length * JSON_MAX_ESCAPE_LENGTH + 2);
+    p_dest = p_start;
+
+    *p_dest++ = '"';
+    for (i = 0; i < length; i++)
+    {
+        if (p_src[i] < 0x20 || p_src[i] == '"' || p_src[i] == '\\')
+        {
+            p_dest = json_escape(p_dest, p_src[i]);
+        }
+        else
+        {
+            *p_dest++ = (char)p_src[i];
+        }
+    }
+    *p_dest++ = '"';
+
+    out->length += (size_t)(p_dest - p_start);
+}
+
+/*****************************************************************************
+* NAME:  json_needs_escape
+* DESCRIPTION: Check whether UTF-8 text contains a character that must be
+*              escaped in a JSON string
+* RETURNS: non-zero if any byte must be escaped
+******************************************************************************/
+static int
+json_needs_escape
+    (const char    *p_data      /* [in] UTF-8 bytes */
+    ,size_t         length      /* [in] number of bytes in p_data */
+    )
+{
+    const unsigned char    *p = (const unsigned char *)p_data;
+    size_t                  i;
+
+    for (i = 0; i < length; i++)
+    {
+        if (p[i] < 0x20 || p[i] == '"' || p[i] == '\\')
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************
+* NAME:  json_write_utf16_string
+* DESCRIPTION: Append a quoted JSON string holding a UTF-16LE string,
+*              transcoded to UTF-8
+* RETURNS: none
+******************************************************************************/
+void
+json_write_utf16_string
+    (output_t      *out         /* [in,out] buffer receiving the formatted text */
+    ,const char    *p_data      /* [in] UTF-16LE code units */
+    ,size_t         num_bytes   /* [in] number of bytes in p_data */
+    )
+{
+    size_t          num_units = utf16le_length(p_data, num_bytes / 2);
+    char           *p_start;
+    char           *p_dest;
+    size_t          length;
+    size_t          i;
+    size_t          j;
+    unsigned int    unit;
+
+    /* reserve for the worst case, every code unit escaped */
+    p_start = output_reserve(out, num_units * JSON_MAX_ESCAPE_LENGTH + 2);
+    p_dest = p_start;
+    *p_dest++ = '"';
+
+    /* transcode in one pass; most strings need no escaping */
+    length = utf16le_to_utf8(p_dest, p_data, num_units);
+    if (!json_needs_escape(p_dest, length))
+    {
+        p_dest += length;
+    }
+    else
+    {
+        /* transcode again between the characters that need escaping, all of
+           which are ASCII, so no surrogate pair is split */
+        for (i = 0, j = 0; j < num_units; j++)
+        {
+            unit = (unsigned char)p_data[2 * j] | ((unsigned int)(unsigned char)p_data[2 * j + 1] << 8);
+            if (unit < 0x20 || unit == '"' || unit == '\\')
+            {
+                p_dest += utf16le_to_utf8(p_dest, p_data + 2 * i, j - i);
+                p_dest = json_escape(p_dest, unit);
+                i = j + 1;
+            }
+        }
+        p_dest += utf16le_to_utf8(p_dest, p_data + 2 * i, num_units - i);
+    }
+    *p_dest++ = '"';
+
+    out->length += (size_t)(p_dest - p_start);
+}
+
+/*****************************************************************************
+* NAME:  json_write_hex
+* DESCRIPTION: Append a quoted JSON string holding binary data as hex digits
+* RETURNS: none
+******************************************************************************/
+static void
+json_write_hex
+    (output_t      *out         /* [in,out] buffer receiving the formatted text */
+    ,const char    *p_data      /* [in] binary data */
+    ,size_t         length      /* [in] number of bytes in p_data */
+    )
+{
+    const unsigned char    *p_src = (const unsigned char *)p_data;
+    char                   *p_dest;
+    size_t                  i;
+
+    p_dest = output_reserve(out, length * 2 + 2);
+
+    *p_dest++ = '"';
+    for (i = 0; i < length; i++)
+    {
+        *p_dest++ = HEX_DIGITS[p_src[i] >> 4];
+        *p_dest++ = HEX_DIGITS[p_src[i] & 0x0f];
+    }
+    *p_dest++ = '"';
+
+    out->length += length * 2 + 2;
+}
+
+/*****************************************************************************
+* NAME:  json_write_guid
+* DESCRIPTION: Append a quoted JSON string holding a GUID in its usual
+*              registry format
+* RETURNS: none
+******************************************************************************/
+static void
+json_write_guid
+    (output_t      *out         /* [in,out] buffer receiving the formatted text */
+    ,const char    *guid        /* [in] char buffer containing the GUID */
+    )
+{
+    const unsigned char *g = (const unsigned char *)guid;
+
+    /* GUIDs are stored with their first three fields little-endian */
+    output_printf(out, "\"%02X%02X%02X%02X-%02X%02X-%02X%02X-%02X%02X-%02X%02X%02X%02X%02X%02X\""
+                 ,g[3], g[2], g[1], g[0], g[5], g[4], g[7], g[6]
+                 ,g[8], g[9], g[10], g[11], g[12], g[13], g[14], g[15]);
+}
+
+/*****************************************************************************
+* NAME:  json_begin_object
+* DESCRIPTION: Open a JSON object with the members common to every ASF
+*              object
+* RETURNS: none
+******************************************************************************/
+static void
+json_begin_object
+    (object_type_t  type        /* [in] object type */
+    ,long long      offset      /* [in] file offset of the object */
+    ,long long      object_size /* [in] size of the object in bytes */
+    ,output_t      *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    output_printf(out, "{\"type\":\"%s\",\"offset\":%lld,\"object_size\":%lld"
+                 ,get_object_name(type), offset, object_size);
+}
+
+/*****************************************************************************
+* NAME:  json_header_object
+* DESCRIPTION: Append header object information as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_header_object
+    (const header_object_t *header      /* [in] struct containing info about header object */
+    ,long long              offset      /* [in] file offset of the object */
+    ,output_t              *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    json_begin_object(OBJECT_TYPE_HEADER, offset, header->object_size, out);
+    output_printf(out, ",\"num_objects\":%lld}", header->num_objects);
+}
+
+/*****************************************************************************
+* NAME:  json_file_properties_object
+* DESCRIPTION: Append file properties object information as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_file_properties_object
+    (const file_properties_object_t    *file_properties     /* [in] struct containing info about file properties object */
+    ,long long                          offset              /* [in] file offset of the object */
+    ,output_t                          *out                 /* [in,out] buffer receiving the formatted text */
+    )
+{
+    json_begin_object(OBJECT_TYPE_FILE_PROPERTIES, offset, file_properties->object_size, out);
+    output_printf(out, ",\"file_size\":%lld,\"creation_date\":%lld,\"data_packets_count\":%lld"
+                       ",\"play_duration\":%lld,\"send_duration\":%lld,\"preroll\":%lld,\"flags\":%lld"
+                       ",\"min_data_packet_size\":%lld,\"max_data_packet_size\":%lld,\"max_bitrate\":%lld}"
+                 ,file_properties->file_size
+                 ,file_properties->creation_date
+                 ,file_properties->data_packets_count
+                 ,file_properties->play_duration
+                 ,file_properties->send_duration
+                 ,file_properties->preroll
+                 ,file_properties->flags
+                 ,file_properties->min_data_packet_size
+                 ,file_properties->max_data_packet_size
+                 ,file_properties->max_bitrate);
+}
+
+/*****************************************************************************
+* NAME:  json_stream_properties_object
+* DESCRIPTION: Append stream properties object information as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_stream_properties_object
+    (const stream_properties_object_t  *stream_properties   /* [in] struct containing info about stream properties object */
+    ,long long                          offset              /* [in] file offset of the object */
+    ,output_t                          *out                 /* [in,out] buffer receiving the formatted text */
+    )
+{
+    const guid_entry_t *entry = guid_lookup(stream_properties->stream_type);
+
+    json_begin_object(OBJECT_TYPE_STREAM_PROPERTIES, offset, stream_properties->object_size, out);
+
+    /* stream types of the ASF Specification are written by name */
+    output_printf(out, ",\"stream_type\":");
+    if (entry != NULL && entry->kind == GUID_KIND_STREAM_TYPE)
+    {
+        output_printf(out, "\"%s\"", entry->p_name);
+    }
+    else
+    {
+        json_write_guid(out, stream_properties->stream_type);
+    }
+
+    output_printf(out, ",\"stream_number\":%d,\"time_offset\":%lld,\"flags\":%d"
+                       ",\"type_specific_data_length\":%lld,\"err_correction_data_length\":%lld}"
+                 ,stream_properties->flags & STREAM_NUMBER_MASK
+                 ,stream_properties->time_offset
+                 ,stream_properties->flags
+                 ,stream_properties->type_specific_data_length
+                 ,stream_properties->err_correction_data_length);
+}
+
+/*****************************************************************************
+* NAME:  json_header_extension_object
+* DESCRIPTION: Append header extension object information as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_header_extension_object
+    (const header_extension_object_t   *header_ext  /* [in] struct containing info about header extension object */
+    ,long long                          offset      /* [in] file offset of the object */
+    ,output_t                          *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    json_begin_object(OBJECT_TYPE_HEADER_EXTENSION, offset, header_ext->object_size, out);
+    output_printf(out, ",\"data_size\":%lld}", header_ext->data_size);
+}
+
+/*****************************************************************************
+* NAME:  json_codec_list_object
+* DESCRIPTION: Append codec list object information as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_codec_list_object
+    (const codec_list_object_t *codec_list  /* [in] struct containing info about codec list object */
+    ,long long                  offset      /* [in] file offset of the object */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    const codec_entry_t    *entry;
+    int                     i;
+
+    json_begin_object(OBJECT_TYPE_CODEC_LIST, offset, codec_list->object_size, out);
+    output_printf(out, ",\"codecs\":[");
+
+    /* codec names and descriptions are counted in UTF-16 characters */
+    for (i = 0; i < codec_list->codec_entry_count; i++)
+    {
+        entry = &codec_list->codec_entry[i];
+
+        output_printf(out, "%s{\"codec_type\":%d,\"name\":", (i > 0) ? "," : "", entry->codec_type);
+        json_write_utf16_string(out, entry->codec_name, (size_t)entry->codec_name_length * 2);
+        output_write(out, ",\"description\":", 15);
+        json_write_utf16_string(out, entry->codec_description, (size_t)entry->codec_description_length * 2);
+        output_write(out, ",\"information\":", 15);
+        json_write_hex(out, entry->codec_information, (size_t)entry->codec_information_length);
+        output_write(out, "}", 1);
+    }
+
+    output_write(out, "]}", 2);
+}
+
+/*****************************************************************************
+* NAME:  json_extended_content_description_object
+* DESCRIPTION: Append extended content description object information as a
+*              JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_extended_content_description_object
+    (const extended_content_description_object_t   *ext_content_descr   /* [in] struct containing info about extended content description object */
+    ,long long                                      offset              /* [in] file offset of the object */
+    ,output_t                                      *out                 /* [in,out] buffer receiving the formatted text */
+    )
+{
+    const content_descriptor_t *descriptor;
+    int                         i;
+
+    json_begin_object(OBJECT_TYPE_EXTENDED_CONTENT_DESCRIPTION, offset, ext_content_descr->object_size, out);
+    output_printf(out, ",\"descriptors\":[");
+
+    for (i = 0; i < ext_content_descr->descriptor_count; i++)
+    {
+        descriptor = &ext_content_descr->descriptor[i];
+
+        output_write(out, (i > 0) ? ",{\"name\":" : "{\"name\":", (i > 0) ? 9 : 8);
+        json_write_utf16_string(out, descriptor->name, (size_t)descriptor->name_length);
+        output_printf(out, ",\"value_type\":%d,\"value\":", descriptor->value_data_type);
+
+        /* numeric values are little-endian and bounded by the value length */
+        switch (descriptor->value_data_type)
+        {
+        case 0:	/* unicode string */
+            json_write_utf16_string(out, descriptor->value, (size_t)descriptor->value_length);
+            break;
+        case 2:	/* bool */
+            output_printf(out, "%s", load_uint_le(descriptor->value
+                                                 ,(descriptor->value_length < 4)
+                                                  ? (size_t)descriptor->value_length : 4) ? "true" : "false");
+            break;
+        case 3:	/* 32-bit word */
+            output_printf(out, "%llu", load_uint_le(descriptor->value
+                                                   ,(descriptor->value_length < 4)
+                                                    ? (size_t)descriptor->value_length : 4));
+            break;
+        case 4:	/* 64-bit word */
+            output_printf(out, "%llu", load_uint_le(descriptor->value
+                                                   ,(descriptor->value_length < 8)
+                                                    ? (size_t)descriptor->value_length : 8));
+            break;
+        case 5:	/* 16-bit word */
+            output_printf(out, "%llu", load_uint_le(descriptor->value
+                                                   ,(descriptor->value_length < 2)
+                                                    ? (size_t)descriptor->value_length : 2));
+            break;
+        case 1:	/* byte array */
+        default:
+            json_write_hex(out, descriptor->value, (size_t)descriptor->value_length);
+            break;
+        }
+        output_write(out, "}", 1);
+    }
+
+    output_write(out, "]}", 2);
+}
+
+/*****************************************************************************
+* NAME:  json_stream_bitrate_properties_object
+* DESCRIPTION: Append stream bitrate properties object information as a JSON
+*              object
+* RETURNS: none
+******************************************************************************/
+void
+json_stream_bitrate_properties_object
+    (const stream_bitrate_properties_object_t  *stream_bitrate_properties   /* [in] struct containing info about stream bitrate properties object */
+    ,long long                                  offset                      /* [in] file offset of the object */
+    ,output_t                                  *out                         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    const char *p_record;
+    int         i;
+
+    json_begin_object(OBJECT_TYPE_STREAM_BITRATE_PROPERTIES, offset, stream_bitrate_properties->object_size, out);
+    output_printf(out, ",\"bitrate_records_count\":%d,\"bitrate_records\":[", stream_bitrate_properties->bitrate_records_count);
+    for (i = 0; i < stream_bitrate_properties->bitrate_records_count; i++)
+    {
+        p_record = stream_bitrate_properties->bitrate_records + (size_t)i * 6;
+        output_printf(out, "%s{\"stream_number\":%u,\"average_bitrate\":%u}"
+                     ,(i > 0) ? "," : ""
+                     ,load_uint16_le(p_record) & STREAM_NUMBER_MASK
+                     ,load_uint32_le(p_record + 2));
+    }
+    output_write(out, "]}", 2);
+}
+
+/*****************************************************************************
+* NAME:  json_data_object
+* DESCRIPTION: Append data object information and a summary of its data
+*              packets as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_data_object
+    (const data_object_t       *data        /* [in] struct containing info about data object */
+    ,const packet_summary_t    *summary     /* [in] summary of the data packets */
+    ,long long                  offset      /* [in] file offset of the object */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    const char *p_separator = "";
+    int         i;
+
+    json_begin_object(OBJECT_TYPE_DATA, offset, data->object_size, out);
+    output_printf(out, ",\"total_data_packets\":%lld,\"packets_parsed\":%lld,\"payloads\":%lld"
+                       ",\"payload_bytes\":%lld,\"first_send_time\":%u,\"last_send_time\":%u,\"streams\":["
+                 ,data->total_data_packets
+                 ,summary->num_packets
+                 ,summary->num_payloads
+                 ,summary->payload_bytes
+                 ,summary->first_send_time
+                 ,summary->last_send_time);
+
+    /* list payload counts for each stream that has any */
+    for (i = 0; i <= MAX_STREAM_NUMBER; i++)
+    {
+        if (summary->stream[i].num_payloads == 0)
+        {
+            continue;
+        }
+        output_printf(out, "%s{\"stream_number\":%d,\"payloads\":%lld,\"payload_bytes\":%lld,\"key_frames\":%lld}"
+                     ,p_separator
+                     ,i
+                     ,summary->stream[i].num_payloads
+                     ,summary->stream[i].payload_bytes
+                     ,summary->stream[i].num_key_frames);
+        p_separator = ",";
+    }
+
+    output_write(out, "]}", 2);
+}
+
+/*****************************************************************************
+* NAME:  json_simple_index_object
+* DESCRIPTION: Append simple index object information as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_simple_index_object
+    (const simple_index_object_t   *simple_index    /* [in] struct containing info about simple index object */
+    ,long long                      offset          /* [in] file offset of the object */
+    ,output_t                      *out             /* [in,out] buffer receiving the formatted text */
+    )
+{
+    json_begin_object(OBJECT_TYPE_SIMPLE_INDEX, offset, simple_index->object_size, out);
+    output_printf(out, ",\"index_entry_time_interval\":%lld,\"max_packet_count\":%lld,\"index_entries_count\":%lld}"
+                 ,simple_index->index_entry_time_interval / 10000
+                 ,simple_index->max_packet_count
+                 ,simple_index->index_entries_count);
+}
+
+/*****************************************************************************
+* NAME:  json_index_object
+* DESCRIPTION: Append index object information as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_index_object
+    (const index_object_t  *index       /* [in] struct containing info about index object */
+    ,long long              offset      /* [in] file offset of the object */
+    ,output_t              *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    json_begin_object(OBJECT_TYPE_INDEX, offset, index->object_size, out);
+    output_printf(out, ",\"index_entry_time_interval\":%lld,\"index_specifiers_count\":%d,\"index_blocks_count\":%lld}"
+                 ,index->index_entry_time_interval
+                 ,index->index_specifiers_count
+                 ,index->index_blocks_count);
+}
+
+/*****************************************************************************
+* NAME:  json_unknown_object
+* DESCRIPTION: Append the GUID and size of a skipped object as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_unknown_object
+    (const char    *guid        /* [in] char buffer containing object's GUID */
+    ,long long      offset      /* [in] file offset of the object */
+    ,long long      object_size /* [in] size of the object in bytes */
+    ,output_t      *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    const guid_entry_t *entry = guid_lookup(guid);
+
+    json_begin_object(OBJECT_TYPE_NONE, offset, object_size, out);
+    output_printf(out, ",\"guid\":");
+    json_write_guid(out, guid);
+    if (entry != NULL)
+    {
+        output_printf(out, ",\"name\":\"%s\"", entry->p_name);
+    }
+    output_write(out, "}", 1);
+}
+
+/*****************************************************************************
+* NAME:  json_seek_position
+* DESCRIPTION: Append the result of an index lookup as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_seek_position
+    (long long              time        /* [in] requested presentation time (ms) */
+    ,const seek_table_t    *table       /* [in] seek table used for the lookup */
+    ,const seek_position_t *position    /* [in] position found */
+    ,output_t              *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    output_printf(out, "{\"time\":%lld,\"stream_number\":%d,\"entry_time\":%lld,\"packet_number\":%lld,\"file_offset\":%llu}"
+                 ,time
+                 ,table->stream_number
+                 ,position->entry_time
+                 ,position->packet_number
+                 ,position->file_offset);
+}
+
+/*****************************************************************************
+* NAME:  json_stream_analysis
+* DESCRIPTION: Append the bitrate, presentation time and key frame
+*              statistics of each stream as a JSON array
+* RETURNS: none
+******************************************************************************/
+void
+json_stream_analysis
+    (const stream_analysis_t   *analysis    /* [in] stream statistics */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    const stream_stats_t   *stats;
+    const char             *p_separator = "";
+    int                     i;
+
+    output_write(out, "[", 1);
+
+    /* list statistics for each stream that has payloads; means that are
+       undefined, such as the key frame interval of a stream with a single
+       key frame, are written as null */
+    for (i = 0; i <= MAX_STREAM_NUMBER; i++)
+    {
+        stats = &analysis->stream[i];
+        if (stats->num_payloads == 0)
+        {
+            continue;
+        }
+        output_printf(out, "%s{\"stream_number\":%d,\"payload_bytes\":%lld,\"first_send_time\":%u,\"last_send_time\":%u"
+                           ",\"mean_bitrate\":%lld,\"min_bitrate\":%lld,\"max_bitrate\":%lld"
+                     ,p_separator
+                     ,i
+                     ,stats->payload_bytes
+                     ,stats->first_send_time
+                     ,stats->last_send_time
+                     ,stream_stats_mean_bitrate(stats)
+                     ,stats->min_bitrate
+                     ,stats->max_bitrate);
+        if (stats->declared_bitrate >= 0)
+        {
+            output_printf(out, ",\"declared_bitrate\":%lld", stats->declared_bitrate);
+        }
+        else
+        {
+            output_printf(out, ",\"declared_bitrate\":null");
+        }
+        output_printf(out, ",\"media_objects\":%lld", stats->num_media_objects);
+        if (stats->num_deltas > 0)
+        {
+            output_printf(out, ",\"mean_delta\":%.3f,\"max_delta\":%lld,\"jitter\":%.3f"
+                         ,(double)stats->delta_sum / (double)stats->num_deltas
+                         ,stats->max_delta
+                         ,stats->jitter);
+        }
+        else
+        {
+            output_printf(out, ",\"mean_delta\":null,\"max_delta\":null,\"jitter\":null");
+        }
+        output_printf(out, ",\"gaps\":%lld,\"backward_steps\":%lld,\"key_frames\":%lld"
+                     ,stats->num_gaps
+                     ,stats->num_backward_steps
+                     ,stats->num_key_frames);
+        if (stats->num_key_frame_intervals > 0)
+        {
+            output_printf(out, ",\"mean_key_frame_interval\":%.3f,\"min_key_frame_interval\":%lld,\"max_key_frame_interval\":%lld}"
+                         ,(double)stats->key_frame_interval_sum / (double)stats->num_key_frame_intervals
+                         ,stats->min_key_frame_interval
+                         ,stats->max_key_frame_interval);
+        }
+        else
+        {
+            output_printf(out, ",\"mean_key_frame_interval\":null,\"min_key_frame_interval\":null,\"max_key_frame_interval\":null}");
+        }
+        p_separator = ",";
+    }
+
+    output_write(out, "]", 1);
+}
+
+/*****************************************************************************
+* NAME:  json_extract_result
+* DESCRIPTION: Append what was written when extracting a stream as a JSON
+*              object
+* RETURNS: none
+******************************************************************************/
+void
+json_extract_result
+    (const extract_result_t    *result      /* [in] outcome of the extraction */
+    ,const char                *p_output    /* [in] name of the file written */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    const guid_entry_t *entry = (result->stream_type != NULL) ? guid_lookup(result->stream_type) : NULL;
+
+    output_printf(out, "{\"stream_number\":%d,\"stream_type\":", result->stream_number);
+    if (entry != NULL && entry->kind == GUID_KIND_STREAM_TYPE)
+    {
+        json_write_string(out, entry->p_name, strlen(entry->p_name));
+    }
+    else
+    {
+        output_write(out, "null", 4);
+    }
+    output_write(out, ",\"output_file\":", 15);
+    json_write_string(out, p_output, strlen(p_output));
+    output_printf(out, ",\"payloads\":%lld,\"media_objects\":%lld,\"incomplete_media_objects\":%lld"
+                       ",\"dropped_bytes\":%lld,\"bytes_written\":%lld,\"writes\":%lld}"
+                 ,result->num_payloads
+                 ,result->num_media_objects
+                 ,result->num_incomplete
+                 ,result->num_dropped_bytes
+                 ,result->bytes_written
+                 ,result->num_writes);
+}
+
+/*****************************************************************************
+* NAME:  json_search_build_result
+* DESCRIPTION: Append what was indexed when building a search index as a
+*              JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_search_build_result
+    (const search_build_result_t   *result      /* [in] outcome of the build */
+    ,output_t                      *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    output_printf(out, "{\"files\":%lld,\"indexed_files\":%lld,\"errors\":%lld,\"terms\":%lld"
+                       ",\"postings\":%lld,\"index_size\":%lld}"
+                 ,result->num_files
+                 ,result->num_indexed
+                 ,result->num_errors
+                 ,result->num_terms
+                 ,result->num_postings
+                 ,result->index_size);
+}
+
+/*****************************************************************************
+* NAME:  json_search_matches
+* DESCRIPTION: Append the terms of a search index query and the names of the
+*              matching files as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_search_matches
+    (const search_index_t  *index       /* [in] index handle, or NULL if num_files is 0 */
+    ,char * const          *pp_terms    /* [in] query terms */
+    ,int                    num_terms   /* [in] number of entries in pp_terms */
+    ,const unsigned int    *p_files     /* [in] numbers of the matching files */
+    ,size_t                 num_files   /* [in] number of entries in p_files */
+    ,output_t              *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    const char *p_name;
+    size_t      i;
+    int         t;
+
+    output_write(out, "{\"terms\":[", 10);
+    for (t = 0; t < num_terms; t++)
+    {
+        if (t > 0)
+        {
+            output_write(out, ",", 1);
+        }
+        json_write_string(out, pp_terms[t], strlen(pp_terms[t]));
+    }
+    output_printf(out, "],\"count\":%lu,\"files\":[", (unsigned long)num_files);
+    for (i = 0; i < num_files; i++)
+    {
+        if (i > 0)
+        {
+            output_write(out, ",", 1);
+        }
+        p_name = search_index_file_name(index, p_files[i]);
+        json_write_string(out, p_name, strlen(p_name));
+    }
+    output_write(out, "]}", 2);
+}
+
+/*****************************************************************************
+* NAME:  json_instrument_totals
+* DESCRIPTION: Append the totals of the instrumentation probes as a JSON
+*              object on its own line, with a member per probe that was hit
+* RETURNS: none
+******************************************************************************/
+void
+json_instrument_totals
+    (const instrument_totals_t *totals      /* [in] totals of the run */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    const instrument_probe_total_t *probe;
+    int                             num_written = 0;
+    int                             i;
+
+    output_printf(out, "{\"stats\":{\"clock\":\"%s\",\"threads\":%d,\"wall_ns\":%lld,\"user_ns\":%lld"
+                       ",\"system_ns\":%lld,\"major_faults\":%lld,\"minor_faults\":%lld,\"probes\":{"
+                 ,totals->p_clock
+                 ,totals->num_threads
+                 ,totals->wall_ns
+                 ,totals->user_ns
+                 ,totals->system_ns
+                 ,totals->major_faults
+                 ,totals->minor_faults);
+    for (i = 0; i < NUM_INSTRUMENT_PROBES; i++)
+    {
+        probe = &totals->probes[i];
+        if (probe->count == 0)
+        {
+            continue;
+        }
+        output_printf(out, "%s\"%s\":{\"calls\":%lld,\"bytes\":%lld,\"ns\":%lld}"
+                     ,(num_written++ > 0) ? "," : ""
+                     ,instrument_probe_name((instrument_probe_t)i)
+                     ,probe->count
+                     ,probe->bytes
+                     ,probe->ns);
+    }
+    output_write(out, "}}}\n", 4);
+}
+
+/*****************************************************************************
+* NAME:  json_export_result
+* DESCRIPTION: Append what was written to an export file as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_export_result
+    (const export_result_t     *result      /* [in] outcome of the export */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    output_printf(out, "{\"files\":%lld,\"errors\":%lld,\"streams\":%lld,\"codecs\":%lld"
+                       ",\"row_groups\":%lld,\"export_size\":%lld}"
+                 ,result->num_files
+                 ,result->num_errors
+                 ,result->num_streams
+                 ,result->num_codecs
+                 ,result->num_row_groups
+                 ,result->export_size);
+}
+
+/*****************************************************************************
+* NAME:  json_error
+* DESCRIPTION: Append a parse error event as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_error
+    (const asfparse_event_t    *event       /* [in] ASFPARSE_EVENT_ERROR event */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    output_printf(out, "{\"code\":%d,\"message\":\"%s\",\"type\":\"%s\",\"offset\":%lld"
+                 ,(int)event->error
+                 ,asfparse_error_string(event->error)
+                 ,get_object_name(event->type)
+                 ,event->offset);
+    if (event->packet_number >= 0)
+    {
+        output_printf(out, ",\"packet_number\":%lld", event->packet_number);
+    }
+    output_write(out, "}", 1);
+}
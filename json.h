@@ -0,0 +1,282 @@
+#ifndef JSON_H
+#define JSON_H
+
+/* Includes */
+#include <stddef.h>
+#include "util.h"
+#include "output.h"
+#include "packet.h"
+#include "index.h"
+#include "streamstats.h"
+#include "extract.h"
+#include "search.h"
+#include "export.h"
+#include "instrument.h"
+#include "asfparse.h"
+
+/* Function prototypes */
+/*****************************************************************************
+* NAME:  json_write_string
+* DESCRIPTION: Append a quoted JSON string holding bytes that are already
+*              UTF-8 (or ASCII), escaping quotes, backslashes and control
+*              characters
+* RETURNS: none
+******************************************************************************/
+void
+json_write_string
+    (output_t      *out         /* [in,out] buffer receiving the formatted text */
+    ,const char    *p_data      /* [in] string bytes */
+    ,size_t         length      /* [in] number of bytes in p_data */
+    );
+
+/*****************************************************************************
+* NAME:  json_write_utf16_string
+* DESCRIPTION: Append a quoted JSON string holding a UTF-16LE string, which
+*              ends at its NUL terminator or after num_bytes bytes, as UTF-8
+* RETURNS: none
+******************************************************************************/
+void
+json_write_utf16_string
+    (output_t      *out         /* [in,out] buffer receiving the formatted text */
+    ,const char    *p_data      /* [in] UTF-16LE code units */
+    ,size_t         num_bytes   /* [in] number of bytes in p_data */
+    );
+
+/*****************************************************************************
+* NAME:  json_header_object
+* DESCRIPTION: Append header object information as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_header_object
+    (const header_object_t *header      /* [in] struct containing info about header object */
+    ,long long              offset      /* [in] file offset of the object */
+    ,output_t              *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  json_file_properties_object
+* DESCRIPTION: Append file properties object information as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_file_properties_object
+    (const file_properties_object_t    *file_properties     /* [in] struct containing info about file properties object */
+    ,long long                          offset              /* [in] file offset of the object */
+    ,output_t                          *out                 /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  json_stream_properties_object
+* DESCRIPTION: Append stream properties object information as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_stream_properties_object
+    (const stream_properties_object_t  *stream_properties   /* [in] struct containing info about stream properties object */
+    ,long long                          offset              /* [in] file offset of the object */
+    ,output_t                          *out                 /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  json_header_extension_object
+* DESCRIPTION: Append header extension object information as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_header_extension_object
+    (const header_extension_object_t   *header_ext  /* [in] struct containing info about header extension object */
+    ,long long                          offset      /* [in] file offset of the object */
+    ,output_t                          *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  json_codec_list_object
+* DESCRIPTION: Append codec list object information as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_codec_list_object
+    (const codec_list_object_t *codec_list  /* [in] struct containing info about codec list object */
+    ,long long                  offset      /* [in] file offset of the object */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  json_extended_content_description_object
+* DESCRIPTION: Append extended content description object information as a
+*              JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_extended_content_description_object
+    (const extended_content_description_object_t   *ext_content_descr   /* [in] struct containing info about extended content description object */
+    ,long long                                      offset              /* [in] file offset of the object */
+    ,output_t                                      *out                 /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  json_stream_bitrate_properties_object
+* DESCRIPTION: Append stream bitrate properties object information as a JSON
+*              object
+* RETURNS: none
+******************************************************************************/
+void
+json_stream_bitrate_properties_object
+    (const stream_bitrate_properties_object_t  *stream_bitrate_properties   /* [in] struct containing info about stream bitrate properties object */
+    ,long long                                  offset                      /* [in] file offset of the object */
+    ,output_t                                  *out                         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  json_data_object
+* DESCRIPTION: Append data object information and a summary of its data
+*              packets as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_data_object
+    (const data_object_t       *data        /* [in] struct containing info about data object */
+    ,const packet_summary_t    *summary     /* [in] summary of the data packets */
+    ,long long                  offset      /* [in] file offset of the object */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  json_simple_index_object
+* DESCRIPTION: Append simple index object information as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_simple_index_object
+    (const simple_index_object_t   *simple_index    /* [in] struct containing info about simple index object */
+    ,long long                      offset          /* [in] file offset of the object */
+    ,output_t                      *out             /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  json_index_object
+* DESCRIPTION: Append index object information as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_index_object
+    (const index_object_t  *index       /* [in] struct containing info about index object */
+    ,long long              offset      /* [in] file offset of the object */
+    ,output_t              *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  json_unknown_object
+* DESCRIPTION: Append the GUID and size of a skipped object as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_unknown_object
+    (const char    *guid        /* [in] char buffer containing object's GUID */
+    ,long long      offset      /* [in] file offset of the object */
+    ,long long      object_size /* [in] size of the object in bytes */
+    ,output_t      *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  json_seek_position
+* DESCRIPTION: Append the result of an index lookup as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_seek_position
+    (long long              time        /* [in] requested presentation time (ms) */
+    ,const seek_table_t    *table       /* [in] seek table used for the lookup */
+    ,const seek_position_t *position    /* [in] position found */
+    ,output_t              *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  json_stream_analysis
+* DESCRIPTION: Append the bitrate, presentation time and key frame
+*              statistics of each stream as a JSON array
+* RETURNS: none
+******************************************************************************/
+void
+json_stream_analysis
+    (const stream_analysis_t   *analysis    /* [in] stream statistics */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  json_extract_result
+* DESCRIPTION: Append what was written when extracting a stream as a JSON
+*              object
+* RETURNS: none
+******************************************************************************/
+void
+json_extract_result
+    (const extract_result_t    *result      /* [in] outcome of the extraction */
+    ,const char                *p_output    /* [in] name of the file written */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  json_search_build_result
+* DESCRIPTION: Append what was indexed when building a search index as a
+*              JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_search_build_result
+    (const search_build_result_t   *result      /* [in] outcome of the build */
+    ,output_t                      *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  json_search_matches
+* DESCRIPTION: Append the terms of a search index query and the names of the
+*              matching files as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_search_matches
+    (const search_index_t  *index       /* [in] index handle, or NULL if num_files is 0 */
+    ,char * const          *pp_terms    /* [in] query terms */
+    ,int                    num_terms   /* [in] number of entries in pp_terms */
+    ,const unsigned int    *p_files     /* [in] numbers of the matching files */
+    ,size_t                 num_files   /* [in] number of entries in p_files */
+    ,output_t              *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  json_instrument_totals
+* DESCRIPTION: Append the totals of the instrumentation probes as a JSON
+*              object on its own line
+* RETURNS: none
+******************************************************************************/
+void
+json_instrument_totals
+    (const instrument_totals_t *totals      /* [in] totals of the run */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  json_export_result
+* DESCRIPTION: Append what was written to an export file as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_export_result
+    (const export_result_t     *result      /* [in] outcome of the export */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  json_error
+* DESCRIPTION: Append a parse error event as a JSON object
+* RETURNS: none
+******************************************************************************/
+void
+json_error
+    (const asfparse_event_t    *event       /* [in] ASFPARSE_EVENT_ERROR event */
+    ,output_t                  *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+#endif
@@ -0,0 +1,274 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "lru.h"
+
+/* Defines and constants */
+#define FNV_OFFSET_BASIS        (0xcbf29ce484222325ull)
+#define FNV_PRIME               (0x100000001b3ull)
+
+/*****************************************************************************
+* NAME:  hash_name
+* DESCRIPTION: Hash a file name (64-bit FNV-1a)
+* RETURNS: hash value
+******************************************************************************/
+static unsigned long long
+hash_name
+    (const char    *p_filename  /* [in] NUL-terminated file name */
+    )
+{
+    unsigned long long  h = FNV_OFFSET_BASIS;
+
+    while (*p_filename != '\0')
+    {
+        h = (h ^ (unsigned char)*p_filename++) * FNV_PRIME;
+    }
+
+    return h;
+}
+
+/*****************************************************************************
+* NAME:  find_entry
+* DESCRIPTION: Find the bucket link that points to the entry of a file name
+* RETURNS: the link, which points to NULL if the name is not in the map
+******************************************************************************/
+static lru_entry_t **
+find_entry
+    (lru_t                 *lru         /* [in] map */
+    ,const char            *p_filename  /* [in] file name */
+    ,unsigned long long     hash        /* [in] hash of p_filename */
+    )
+{
+    lru_entry_t   **link = &lru->buckets[hash & (lru->num_buckets - 1)];
+
+    while (*link != NULL && ((*link)->hash != hash || strcmp((*link)->p_filename, p_filename) != 0))
+    {
+        link = &(*link)->hash_next;
+    }
+
+    return link;
+}
+
+/*****************************************************************************
+* NAME:  unlink_entry
+* DESCRIPTION: Take an entry out of the recency list
+* RETURNS: none
+******************************************************************************/
+static void
+unlink_entry
+    (lru_entry_t   *entry       /* [in,out] entry in the list */
+    )
+{
+    entry->older->newer = entry->newer;
+    entry->newer->older = entry->older;
+}
+
+/*****************************************************************************
+* NAME:  push_newest
+* DESCRIPTION: Put an entry at the most recently used end of the list
+* RETURNS: none
+******************************************************************************/
+static void
+push_newest
+    (lru_t         *lru         /* [in,out] map */
+    ,lru_entry_t   *entry       /* [in,out] entry not in the list */
+    )
+{
+    entry->older = lru->list.older;
+    entry->newer = &lru->list;
+    lru->list.older->newer = entry;
+    lru->list.older = entry;
+}
+
+/*****************************************************************************
+* NAME:  remove_entry
+* DESCRIPTION: Take an entry out of the map and free it
+* RETURNS: none
+******************************************************************************/
+static void
+remove_entry
+    (lru_t         *lru         /* [in,out] map */
+    ,lru_entry_t  **link        /* [in,out] bucket link pointing to the entry */
+    )
+{
+    lru_entry_t    *entry = *link;
+
+    *link = entry->hash_next;
+    unlink_entry(entry);
+    lru->num_entries--;
+    lru->num_bytes -= sizeof(lru_entry_t) + strlen(entry->p_filename) + 1 + entry->output_length;
+    free(entry);
+}
+
+/*****************************************************************************
+* NAME:  lru_init
+* DESCRIPTION: Create an empty map
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+lru_init
+    (lru_t         *lru             /* [out] map */
+    ,size_t         max_entries     /* [in] files to remember, at least 1 */
+    )
+{
+    memset(lru, 0, sizeof(lru_t));
+
+    /* chains average at most one entry when the map is full */
+    lru->num_buckets = 1;
+    while (lru->num_buckets < max_entries)
+    {
+        lru->num_buckets *= 2;
+    }
+    lru->buckets = calloc(lru->num_buckets, sizeof(lru_entry_t *));
+    if (lru->buckets == NULL)
+    {
+        return ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
+    lru->max_entries = max_entries;
+    lru->list.newer = &lru->list;
+    lru->list.older = &lru->list;
+    pthread_mutex_init(&lru->lock, NULL);
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  lru_free
+* DESCRIPTION: Release a map and all of its entries
+* RETURNS: none
+******************************************************************************/
+void
+lru_free
+    (lru_t         *lru             /* [in,out] map */
+    )
+{
+    lru_entry_t    *entry;
+    lru_entry_t    *next;
+
+    if (lru->buckets == NULL)
+    {
+        return;
+    }
+    for (entry = lru->list.newer; entry != &lru->list; entry = next)
+    {
+        next = entry->newer;
+        free(entry);
+    }
+    free(lru->buckets);
+    pthread_mutex_destroy(&lru->lock);
+    memset(lru, 0, sizeof(lru_t));
+}
+
+/*****************************************************************************
+* NAME:  lru_lookup
+* DESCRIPTION: Append the stored output of a file to an output buffer if the
+*              file still has the key it had when it was parsed
+* RETURNS: non-zero if the file was found unchanged
+******************************************************************************/
+int
+lru_lookup
+    (lru_t                     *lru         /* [in,out] map */
+    ,const char                *p_filename  /* [in] file name */
+    ,const header_cache_key_t  *key         /* [in] current key of the file */
+    ,output_t                  *out         /* [in,out] buffer receiving the output */
+    ,asfparse_error_t          *error       /* [out] result of parsing the file */
+    )
+{
+    lru_entry_t    *entry;
+    int             found = 0;
+
+    pthread_mutex_lock(&lru->lock);
+    entry = *find_entry(lru, p_filename, hash_name(p_filename));
+    if (entry != NULL && memcmp(&entry->key, key, sizeof(header_cache_key_t)) == 0)
+    {
+        unlink_entry(entry);
+        push_newest(lru, entry);
+        output_write(out, entry->p_output, entry->output_length);
+        *error = entry->error;
+        found = 1;
+    }
+    pthread_mutex_unlock(&lru->lock);
+
+    return found;
+}
+
+/*****************************************************************************
+* NAME:  lru_insert
+* DESCRIPTION: Store the output of a file, replacing any older result for
+*              the same name and dropping the least recently used file if
+*              the map is full
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+lru_insert
+    (lru_t                     *lru             /* [in,out] map */
+    ,const char                *p_filename      /* [in] file name */
+    ,const header_cache_key_t  *key             /* [in] key of the file when it was parsed */
+    ,const char                *p_output        /* [in] formatted output */
+    ,size_t                     output_length   /* [in] number of bytes in p_output */
+    ,asfparse_error_t           error           /* [in] result of parsing the file */
+    )
+{
+    lru_entry_t       **link;
+    lru_entry_t        *entry;
+    size_t              name_length = strlen(p_filename) + 1;
+    size_t              size = sizeof(lru_entry_t) + name_length + output_length;
+
+    /* build the entry outside the lock */
+    entry = malloc(size);
+    if (entry == NULL)
+    {
+        return ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
+    memset(entry, 0, sizeof(lru_entry_t));
+    entry->hash = hash_name(p_filename);
+    entry->key = *key;
+    entry->error = error;
+    entry->p_filename = (char *)(entry + 1);
+    entry->p_output = (char *)(entry + 1) + name_length;
+    entry->output_length = output_length;
+    memcpy((char *)(entry + 1), p_filename, name_length);
+    memcpy((char *)(entry + 1) + name_length, p_output, output_length);
+
+    pthread_mutex_lock(&lru->lock);
+
+    /* two workers may have parsed the same file; the later result wins */
+    link = find_entry(lru, p_filename, entry->hash);
+    if (*link != NULL)
+    {
+        remove_entry(lru, link);
+    }
+    else if (lru->num_entries == lru->max_entries)
+    {
+        remove_entry(lru, find_entry(lru, lru->list.newer->p_filename, lru->list.newer->hash));
+        link = find_entry(lru, p_filename, entry->hash);
+    }
+
+    entry->hash_next = *link;
+    *link = entry;
+    push_newest(lru, entry);
+    lru->num_entries++;
+    lru->num_bytes += size;
+
+    pthread_mutex_unlock(&lru->lock);
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  lru_count
+* DESCRIPTION: Get the number of files and bytes held
+* RETURNS: none
+******************************************************************************/
+void
+lru_count
+    (lru_t         *lru             /* [in,out] map */
+    ,size_t        *num_entries     /* [out] files held */
+    ,size_t        *num_bytes       /* [out] bytes held */
+    )
+{
+    pthread_mutex_lock(&lru->lock);
+    *num_entries = lru->num_entries;
+    *num_bytes = lru->num_bytes;
+    pthread_mutex_unlock(&lru->lock);
+}
@@ -0,0 +1,110 @@
+#ifndef LRU_H
+#define LRU_H
+
+/* Includes */
+#include <pthread.h>
+#include <stddef.h>
+#include "util.h"
+#include "cache.h"
+#include "output.h"
+
+/* Defines and constants */
+#define LRU_DEFAULT_ENTRIES     (65536)     /* files remembered by default */
+#define LRU_MAX_ENTRIES         (1 << 26)   /* largest number of files remembered */
+
+/* Enums and structs */
+/* Structure describing the formatted result of one file. The name and the
+   output are held in the same allocation as the entry. */
+typedef struct lru_entry_s {
+    struct lru_entry_s *hash_next;      /* next entry in the same bucket */
+    struct lru_entry_s *newer;          /* next more recently used entry */
+    struct lru_entry_s *older;          /* next less recently used entry */
+    unsigned long long  hash;           /* hash of the file name */
+    header_cache_key_t  key;            /* identity of the file when it was parsed */
+    asfparse_error_t    error;          /* result of parsing it */
+    const char         *p_filename;     /* NUL-terminated file name */
+    const char         *p_output;       /* formatted output */
+    size_t              output_length;  /* number of bytes in p_output */
+} lru_entry_t;
+
+/* Structure describing a bounded map from file names to formatted results
+   that drops the least recently used file when full. Every function takes
+   the lock, so the map can be shared between threads. */
+typedef struct {
+    pthread_mutex_t     lock;
+    lru_entry_t       **buckets;        /* hash chains, num_buckets entries */
+    size_t              num_buckets;    /* power of two, at least max_entries */
+    size_t              num_entries;
+    size_t              max_entries;
+    size_t              num_bytes;      /* bytes held by entries */
+    lru_entry_t         list;           /* sentinel: list.older is the newest entry, list.newer the oldest */
+} lru_t;
+
+/* Function prototypes */
+/*****************************************************************************
+* NAME:  lru_init
+* DESCRIPTION: Create an empty map
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+lru_init
+    (lru_t         *lru             /* [out] map */
+    ,size_t         max_entries     /* [in] files to remember, at least 1 */
+    );
+
+/*****************************************************************************
+* NAME:  lru_free
+* DESCRIPTION: Release a map and all of its entries
+* RETURNS: none
+******************************************************************************/
+void
+lru_free
+    (lru_t         *lru             /* [in,out] map */
+    );
+
+/*****************************************************************************
+* NAME:  lru_lookup
+* DESCRIPTION: Append the stored output of a file to an output buffer if the
+*              file still has the key it had when it was parsed, and make it
+*              the most recently used
+* RETURNS: non-zero if the file was found unchanged
+******************************************************************************/
+int
+lru_lookup
+    (lru_t                     *lru         /* [in,out] map */
+    ,const char                *p_filename  /* [in] file name */
+    ,const header_cache_key_t  *key         /* [in] current key of the file */
+    ,output_t                  *out         /* [in,out] buffer receiving the output */
+    ,asfparse_error_t          *error       /* [out] result of parsing the file */
+    );
+
+/*****************************************************************************
+* NAME:  lru_insert
+* DESCRIPTION: Store the output of a file, replacing any older result for
+*              the same name and dropping the least recently used file if
+*              the map is full
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+lru_insert
+    (lru_t                     *lru             /* [in,out] map */
+    ,const char                *p_filename      /* [in] file name */
+    ,const header_cache_key_t  *key             /* [in] key of the file when it was parsed */
+    ,const char                *p_output        /* [in] formatted output */
+    ,size_t                     output_length   /* [in] number of bytes in p_output */
+    ,asfparse_error_t           error           /* [in] result of parsing the file */
+    );
+
+/*****************************************************************************
+* NAME:  lru_count
+* DESCRIPTION: Get the number of files and bytes held
+* RETURNS: none
+******************************************************************************/
+void
+lru_count
+    (lru_t         *lru             /* [in,out] map */
+    ,size_t        *num_entries     /* [out] files held */
+    ,size_t        *num_bytes       /* [out] bytes held */
+    );
+
+#endif
@@ -1,9 +1,20 @@
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
-#include "util.h"
-#include "parse.h"
+#include "cli.h"
+#include "output.h"
+#include "process.h"
+#include "batch.h"
+#include "extract.h"
+#include "cache.h"
+#include "daemon.h"
+#include "watch.h"
+#include "search.h"
+#include "export.h"
+#include "instrument.h"
 #include "display.h"
+#include "json.h"
 
 /*****************************************************************************
 * NAME: main 
@@ -16,32 +27,16 @@ main
     )
 {
     asfparse_error_t    error;
-    char                object_id[GUID_LENGTH_IN_BYTES];
-    int                 i;
     params_t            params;
-    object_type_t       object_type = OBJECT_TYPE_NONE;
-
-    /* declare structs needed for parsing ASF file */
-    header_object_t                         header;
-    file_properties_object_t                file_properties;
-    stream_properties_object_t              stream_properties;
-    header_extension_object_t               header_extension;
-    codec_list_object_t                     codec_list;
-    extended_content_description_object_t   ext_content_descr;
-    stream_bitrate_properties_object_t      stream_bitrate_properties;
-
-    /* initialize structs */
-    memset(&header, 0, sizeof(header_object_t));
-    memset(&file_properties, 0, sizeof(file_properties_object_t));
-    memset(&stream_properties, 0, sizeof(stream_properties_object_t));
-    memset(&header_extension, 0, sizeof(header_extension_object_t));
-    memset(&codec_list, 0, sizeof(codec_list_object_t));
-    memset(&ext_content_descr, 0, sizeof(extended_content_description_object_t));
-    memset(&stream_bitrate_properties, 0, sizeof(stream_bitrate_properties_object_t));
+    output_t            out;
+    instrument_totals_t totals;
+    asfparse_ctx_t     *ctx;
+    int                 summary_fd;
+    long long           num_kept;
+    long long           num_dropped;
 
     /* initialize user-specified parameters */
-    params.p_file = NULL;
-    params.p_filename = NULL;
+    memset(&params, 0, sizeof(params_t));
 
     /* parse command-line arguments */
     error = parse_command_line(argc, argv, &params);
@@ -49,142 +44,132 @@ main
     {
         return error;
     }
+    if (params.stats)
+    {
+        instrument_start();
+    }
 
-    /* display banner information */
-    display_banner();
-
-    /* print ASF file name to command line */
-    printf("PARSING ASF FILE:\n    %s\n", params.p_filename);
-    printf("\n--------------------------------------------------\n");
+    /* a stream extracted to stdout leaves stdout for the stream alone */
+    summary_fd = STDOUT_FILENO;
+    if (params.p_extract_filename != NULL && strcmp(params.p_extract_filename, EXTRACT_STDOUT_FILENAME) == 0)
+    {
+        summary_fd = STDERR_FILENO;
+    }
 
-    /* open ASF file */
-    params.p_file = fopen(params.p_filename, "rb");
-    if (params.p_file == NULL)
+    /* display banner information; JSON output holds nothing but JSON.
+       Each file's output is then written with write(), so flush stdio first. */
+    if (params.output_format == OUTPUT_FORMAT_TEXT && summary_fd == STDOUT_FILENO)
     {
-        printf("Error opening input file\n");
-        return ASFPARSE_ERROR_OPEN_FILE;
+        display_banner();
+        fflush(stdout);
     }
 
-    /* parse and display header object in ASF file */
-    error = parse_header_object(&header, params.p_file);
-    if (error)
+    if (params.compact_cache)
     {
-        printf("Error parsing header object\n");
-        fclose(params.p_file);
+        error = header_cache_compact(params.p_cache_filename, &num_kept, &num_dropped);
+        output_init(&out);
+        if (params.output_format == OUTPUT_FORMAT_JSON)
+        {
+            output_write(&out, "{\"cache\":", 9);
+            json_write_string(&out, params.p_cache_filename, strlen(params.p_cache_filename));
+            output_printf(&out, ",\"kept\":%lld,\"dropped\":%lld", num_kept, num_dropped);
+            if (error)
+            {
+                output_printf(&out, ",\"error\":{\"code\":%d,\"message\":\"%s\"}", error, asfparse_error_string(error));
+            }
+            output_write(&out, "}\n", 2);
+        }
+        else
+        {
+            output_printf(&out, "COMPACTING CACHE FILE:\n    %s\n", params.p_cache_filename);
+            output_printf(&out, "\n--------------------------------------------------\n");
+            if (error)
+            {
+                output_printf(&out, "Error compacting cache file: %s\n", asfparse_error_string(error));
+            }
+            else
+            {
+                output_printf(&out, "    Entries kept: %lld\n    Entries dropped: %lld\n", num_kept, num_dropped);
+            }
+        }
+        output_flush(&out, STDOUT_FILENO);
+        output_free(&out);
         return error;
     }
-    else
+
+    if (params.p_daemon_socket != NULL)
     {
-        display_header_object(&header);
+        return run_daemon(&params);
     }
-    
-    /* parse and display subsequent objects in ASF file */
-    for (i = 0; i < header.num_objects; i++)
+    if (params.p_query_socket != NULL)
     {
-        /* read object id from file to get object type */
-        fread(object_id, 1, GUID_LENGTH_IN_BYTES, params.p_file);
-        error = get_object_type(object_id, &object_type);
+        return run_query(&params);
+    }
+    if (params.watch)
+    {
+        return run_watch(&params);
+    }
+
+    if (params.p_search_filename != NULL)
+    {
+        output_init(&out);
+        error = params.search_query ? query_search_index(&params, &out) : build_search_index(&params, &out);
+        output_flush(&out, STDOUT_FILENO);
+        output_free(&out);
+    }
+    else if (params.p_export_filename != NULL)
+    {
+        output_init(&out);
+        error = export_tables(&params, &out);
+        output_flush(&out, STDOUT_FILENO);
+        output_free(&out);
+    }
+    else if (params.extract_stream != 0)
+    {
+        output_init(&out);
+        error = extract_stream(params.pp_filenames[0], &params, &out);
+        output_flush(&out, summary_fd);
+        output_free(&out);
+    }
+    else if (params.num_filenames == 1 && params.p_list_filename == NULL && params.p_cache_filename == NULL)
+    {
+        /* a single file is parsed on this thread, which shares its data
+           packets out between the worker threads; anything more, or
+           anything checked against the header cache, goes through the
+           batch code */
+        params.packet_threads = params.num_threads;
+        ctx = process_create_context(&params);
+        if (ctx == NULL)
+        {
+            return ASFPARSE_ERROR_OUT_OF_MEMORY;
+        }
+        output_init(&out);
+        error = process_file(params.pp_filenames[0], &params, ctx, &out);
+        output_flush(&out, STDOUT_FILENO);
+        output_free(&out);
+        asfparse_destroy(ctx);
+    }
+    else
+    {
+        error = run_batch(&params);
+    }
 
-        /* parse and display specific object based on its type
-           print descriptive message and close file if an error occurs */
-        if (error)
+    /* statistics go to stderr, leaving stdout to the output they describe */
+    if (params.stats)
+    {
+        instrument_totals(&totals);
+        output_init(&out);
+        if (params.output_format == OUTPUT_FORMAT_JSON)
         {
-            printf("Error parsing file: unsupported object\n");
-            fclose(params.p_file);
-            return error;
+            json_instrument_totals(&totals, &out);
         }
         else
         {
-            switch (object_type)
-            {
-            case OBJECT_TYPE_FILE_PROPERTIES:
-                error = parse_file_properties_object(&file_properties, params.p_file);
-                if (error)
-                {
-                    printf("Error parsing file properties object\n");
-                    fclose(params.p_file);
-                    return error;
-                }
-                else
-                {
-                    display_file_properties_object(&file_properties);
-                }
-                break;
-            case OBJECT_TYPE_STREAM_PROPERTIES:
-                error = parse_stream_properties_object(&stream_properties, params.p_file);
-                if (error)
-                {
-                    printf("Error parsing stream properties object\n");
-                    fclose(params.p_file);
-                    return error;
-                }
-                else
-                {
-                    display_stream_properties_object(&stream_properties);
-                }
-                break;
-            case OBJECT_TYPE_HEADER_EXTENSION:
-                error = parse_header_extension_object(&header_extension, params.p_file);
-                if (error)
-                {
-                    printf("Error parsing header extension object\n");
-                    fclose(params.p_file);
-                    return error;
-                }
-                else
-                {
-                    display_header_extension_object(&header_extension);
-                }
-                break;
-            case OBJECT_TYPE_CODEC_LIST:
-                error = parse_codec_list_object(&codec_list, params.p_file);
-                if (error)
-                {
-                    printf("Error parsing codec list object\n");
-                    fclose(params.p_file);
-                    return error;
-                }
-                else
-                {
-                    display_codec_list_object(&codec_list);
-                }
-                break;
-            case OBJECT_TYPE_EXTENDED_CONTENT_DESCRIPTION:
-                error = parse_extended_content_description_object(&ext_content_descr, params.p_file);
-                if (error)
-                {
-                    printf("Error parsing extended content description object\n");
-                    fclose(params.p_file);
-                    return error;
-                }
-                else
-                {
-                    display_extended_content_description_object(&ext_content_descr);
-                }
-                break;
-            case OBJECT_TYPE_STREAM_BITRATE_PROPERTIES:
-                error = parse_stream_bitrate_properties_object(&stream_bitrate_properties, params.p_file);
-                if (error)
-                {
-                    printf("Error parsing stream bitrate properties object\n");
-                    fclose(params.p_file);
-                    return error;
-                }
-                else
-                {
-                    display_stream_bitrate_properties_object(&stream_bitrate_properties);
-                }
-                break;
-            case OBJECT_TYPE_NONE:
-            case OBJECT_TYPE_HEADER:
-            default:
-                break;
-            }
+            display_instrument_totals(&totals, &out);
         }
+        output_flush(&out, STDERR_FILENO);
+        output_free(&out);
     }
 
-    /* ensure file is closed after parsing */
-    fclose(params.p_file);
-
-    return ASFPARSE_ERROR_OK;
-}
\ No newline at end of file
+    return error;
+}
@@ -0,0 +1,181 @@
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "output.h"
+
+/*****************************************************************************
+* NAME:  output_reserve
+* DESCRIPTION: Make room for at least num_bytes more bytes in the buffer
+* RETURNS: pointer to the first spare byte (aborts if memory is exhausted)
+******************************************************************************/
+char *
+output_reserve
+    (output_t      *out         /* [in,out] output buffer */
+    ,size_t         num_bytes   /* [in] number of bytes about to be appended */
+    )
+{
+    size_t  capacity;
+    char   *p_grown;
+
+    if (out->length + num_bytes <= out->capacity)
+    {
+        return out->p_data + out->length;
+    }
+
+    capacity = (out->capacity == 0) ? 4096 : out->capacity;
+    while (capacity < out->length + num_bytes)
+    {
+        capacity *= 2;
+    }
+
+    p_grown = realloc(out->p_data, capacity);
+    if (p_grown == NULL)
+    {
+        fprintf(stderr, "asfparse: out of memory\n");
+        abort();
+    }
+
+    out->p_data = p_grown;
+    out->capacity = capacity;
+
+    return out->p_data + out->length;
+}
+
+/*****************************************************************************
+* NAME:  output_init
+* DESCRIPTION: Initialize an empty output buffer
+* RETURNS: none
+******************************************************************************/
+void
+output_init
+    (output_t      *out         /* [out] output buffer */
+    )
+{
+    out->p_data = NULL;
+    out->length = 0;
+    out->capacity = 0;
+}
+
+/*****************************************************************************
+* NAME:  output_reset
+* DESCRIPTION: Discard buffered text but keep the allocation for reuse
+* RETURNS: none
+******************************************************************************/
+void
+output_reset
+    (output_t      *out         /* [in,out] output buffer */
+    )
+{
+    out->length = 0;
+}
+
+/*****************************************************************************
+* NAME:  output_free
+* DESCRIPTION: Release the memory held by an output buffer
+* RETURNS: none
+******************************************************************************/
+void
+output_free
+    (output_t      *out         /* [in,out] output buffer */
+    )
+{
+    free(out->p_data);
+    output_init(out);
+}
+
+/*****************************************************************************
+* NAME:  output_write
+* DESCRIPTION: Append raw bytes to an output buffer
+* RETURNS: none
+******************************************************************************/
+void
+output_write
+    (output_t      *out         /* [in,out] output buffer */
+    ,const char    *p_data      /* [in] bytes to append */
+    ,size_t         length      /* [in] number of bytes to append */
+    )
+{
+    memcpy(output_reserve(out, length), p_data, length);
+    out->length += length;
+}
+
+/*****************************************************************************
+* NAME:  output_printf
+* DESCRIPTION: Append printf-style formatted text to an output buffer
+* RETURNS: none
+******************************************************************************/
+void
+output_printf
+    (output_t      *out         /* [in,out] output buffer */
+    ,const char    *p_format    /* [in] printf-style format string */
+    ,...
+    )
+{
+    va_list     args;
+    int         length;
+
+    /* format directly into the spare capacity, growing once if needed */
+    va_start(args, p_format);
+    length = vsnprintf(out->p_data + out->length
+                      ,out->capacity - out->length
+                      ,p_format
+                      ,args);
+    va_end(args);
+
+    if (length < 0)
+    {
+        return;
+    }
+
+    if ((size_t)length >= out->capacity - out->length)
+    {
+        output_reserve(out, (size_t)length + 1);
+
+        va_start(args, p_format);
+        vsnprintf(out->p_data + out->length
+                 ,out->capacity - out->length
+                 ,p_format
+                 ,args);
+        va_end(args);
+    }
+
+    out->length += (size_t)length;
+}
+
+/*****************************************************************************
+* NAME:  output_flush
+* DESCRIPTION: Write the buffered text to a file descriptor, normally with a
+*              single write() call, and empty the buffer
+* RETURNS: 0 on success, -1 if the write failed
+******************************************************************************/
+int
+output_flush
+    (output_t      *out         /* [in,out] output buffer */
+    ,int            fd          /* [in] file descriptor to write to */
+    )
+{
+    size_t      written = 0;
+    ssize_t     result;
+
+    /* pipes and sockets may accept less than everything at once */
+    while (written < out->length)
+    {
+        result = write(fd, out->p_data + written, out->length - written);
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        written += (size_t)result;
+    }
+
+    out->length = 0;
+
+    return 0;
+}
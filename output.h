@@ -0,0 +1,97 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+/* Includes */
+#include <stddef.h>
+
+/* Enums and structs */
+/* Structure describing a growable text buffer that display functions write
+   into, so that each file's output can be produced on any thread and
+   emitted in one piece */
+typedef struct {
+    char           *p_data;         /* buffered text (not NUL-terminated) */
+    size_t          length;         /* number of bytes in use */
+    size_t          capacity;       /* number of bytes allocated */
+} output_t;
+
+/* Function prototypes */
+/*****************************************************************************
+* NAME:  output_init
+* DESCRIPTION: Initialize an empty output buffer
+* RETURNS: none
+******************************************************************************/
+void
+output_init
+    (output_t      *out         /* [out] output buffer */
+    );
+
+/*****************************************************************************
+* NAME:  output_reset
+* DESCRIPTION: Discard buffered text but keep the allocation for reuse
+* RETURNS: none
+******************************************************************************/
+void
+output_reset
+    (output_t      *out         /* [in,out] output buffer */
+    );
+
+/*****************************************************************************
+* NAME:  output_free
+* DESCRIPTION: Release the memory held by an output buffer
+* RETURNS: none
+******************************************************************************/
+void
+output_free
+    (output_t      *out         /* [in,out] output buffer */
+    );
+
+/*****************************************************************************
+* NAME:  output_reserve
+* DESCRIPTION: Make room for at least num_bytes more bytes in the buffer. The
+*              caller may fill the returned space and then add the number of
+*              bytes it used to out->length.
+* RETURNS: pointer to the first spare byte (aborts if memory is exhausted)
+******************************************************************************/
+char *
+output_reserve
+    (output_t      *out         /* [in,out] output buffer */
+    ,size_t         num_bytes   /* [in] number of bytes about to be appended */
+    );
+
+/*****************************************************************************
+* NAME:  output_write
+* DESCRIPTION: Append raw bytes to an output buffer
+* RETURNS: none
+******************************************************************************/
+void
+output_write
+    (output_t      *out         /* [in,out] output buffer */
+    ,const char    *p_data      /* [in] bytes to append */
+    ,size_t         length      /* [in] number of bytes to append */
+    );
+
+/*****************************************************************************
+* NAME:  output_printf
+* DESCRIPTION: Append printf-style formatted text to an output buffer
+* RETURNS: none
+******************************************************************************/
+void
+output_printf
+    (output_t      *out         /* [in,out] output buffer */
+    ,const char    *p_format    /* [in] printf-style format string */
+    ,...
+    ) __attribute__((format(printf, 2, 3)));
+
+/*****************************************************************************
+* NAME:  output_flush
+* DESCRIPTION: Write the buffered text to a file descriptor, normally with a
+*              single write() call, and empty the buffer
+* RETURNS: 0 on success, -1 if the write failed
+******************************************************************************/
+int
+output_flush
+    (output_t      *out         /* [in,out] output buffer */
+    ,int            fd          /* [in] file descriptor to write to */
+    );
+
+#endif
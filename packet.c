@@ -0,0 +1,341 @@
+#include "packet.h"
+#include "instrument.h"
+
+/* Defines and constants */
+#define ERR_CORRECTION_PRESENT          (0x80)  /* error correction flags: error correction data present */
+#define ERR_CORRECTION_LENGTH_TYPE      (0x60)  /* error correction flags: length type, must be 00 */
+#define ERR_CORRECTION_DATA_LENGTH      (0x0f)  /* error correction flags: data length */
+#define MULTIPLE_PAYLOADS_PRESENT       (0x01)  /* length type flags: multiple payloads present */
+#define NUM_PAYLOADS_MASK               (0x3f)  /* payload flags: number of payloads */
+#define BROADCAST_FLAG                  (0x01)  /* file properties flags: data packets count is invalid */
+#define COMPRESSED_REPLICATED_LENGTH    (1)     /* replicated data length signalling compressed payloads */
+
+/*****************************************************************************
+* NAME:  read_length_type_value
+* DESCRIPTION: Read a field whose width is given by a 2-bit length type:
+*              00 = not present, 01 = BYTE, 10 = WORD, 11 = DWORD
+* RETURNS: unsigned int (0 if the field is not present)
+******************************************************************************/
+static inline unsigned int
+read_length_type_value
+    (cursor_t  *cur             /* [in,out] cursor */
+    ,int        length_type     /* [in] 2-bit length type */
+    )
+{
+    switch (length_type & 0x03)
+    {
+    case 1:
+        return cursor_read_uint8(cur);
+    case 2:
+        return cursor_read_uint16(cur);
+    case 3:
+        return cursor_read_uint32(cur);
+    default:
+        return 0;
+    }
+}
+
+/*****************************************************************************
+* NAME:  parse_data_packet
+* DESCRIPTION: Parse a single data packet according to Section 5.2 of the ASF
+*              Specification
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+parse_data_packet
+    (data_packet_t *packet      /* [out] struct containing info about data packet */
+    ,cursor_t      *cur         /* [in,out] cursor positioned at the start of the packet */
+    ,unsigned int   packet_size /* [in] fixed packet size, or 0 if packets vary in size */
+    )
+{
+    size_t          packet_start = cur->pos;
+    size_t          payloads_end;
+    int             flags;
+    int             payload_length_type = 0;
+    int             i;
+    payload_t      *payload;
+
+    /* parse error correction data (Section 5.2.1) if present */
+    flags = (int)cursor_read_uint8(cur);
+    packet->err_correction_flags = 0;
+    packet->err_correction_data_length = 0;
+    if (flags & ERR_CORRECTION_PRESENT)
+    {
+        if (flags & ERR_CORRECTION_LENGTH_TYPE)
+        {
+            return ASFPARSE_ERROR_INVALID_ASF_FILE;
+        }
+        packet->err_correction_flags = flags;
+        packet->err_correction_data_length = flags & ERR_CORRECTION_DATA_LENGTH;
+        cursor_skip(cur, packet->err_correction_data_length);
+
+        flags = (int)cursor_read_uint8(cur);
+    }
+
+    /* parse payload parsing information (Section 5.2.2) */
+    packet->length_type_flags = flags;
+    packet->property_flags = (int)cursor_read_uint8(cur);
+    packet->packet_length = read_length_type_value(cur, flags >> 5);
+    packet->sequence = read_length_type_value(cur, flags >> 1);
+    packet->padding_length = read_length_type_value(cur, flags >> 3);
+    packet->send_time = cursor_read_uint32(cur);
+    packet->duration = cursor_read_uint16(cur);
+
+    if (cur->overrun)
+    {
+        return ASFPARSE_ERROR_TRUNCATED_OBJECT;
+    }
+
+    /* a packet length that is not present means the packet fills its slot */
+    if (packet->packet_length == 0)
+    {
+        packet->packet_length = (packet_size != 0) ? packet_size
+                                                   : (unsigned int)(cur->size - packet_start);
+    }
+    if (packet->packet_length > cur->size - packet_start
+        || packet->packet_length < cur->pos - packet_start
+        || packet->padding_length > packet->packet_length - (cur->pos - packet_start))
+    {
+        return ASFPARSE_ERROR_INVALID_ASF_FILE;
+    }
+    payloads_end = packet_start + packet->packet_length - packet->padding_length;
+
+    /* parse payload flags if the packet carries multiple payloads */
+    if (flags & MULTIPLE_PAYLOADS_PRESENT)
+    {
+        flags = (int)cursor_read_uint8(cur);
+        packet->num_payloads = flags & NUM_PAYLOADS_MASK;
+        payload_length_type = flags >> 6;
+    }
+    else
+    {
+        packet->num_payloads = 1;
+    }
+
+    /* parse each payload (Section 5.2.3) */
+    for (i = 0; i < packet->num_payloads; i++)
+    {
+        payload = &packet->payload[i];
+
+        flags = (int)cursor_read_uint8(cur);
+        payload->stream_number = flags & MAX_STREAM_NUMBER;
+        payload->is_key_frame = (flags & 0x80) != 0;
+        payload->media_object_number = read_length_type_value(cur, packet->property_flags >> 4);
+        payload->offset_into_media_object = read_length_type_value(cur, packet->property_flags >> 2);
+        payload->replicated_data_length = read_length_type_value(cur, packet->property_flags);
+        payload->replicated_data = cursor_read_bytes(cur, payload->replicated_data_length);
+        payload->is_compressed = (payload->replicated_data_length == COMPRESSED_REPLICATED_LENGTH);
+
+        /* a single payload extends to the padding */
+        if (packet->length_type_flags & MULTIPLE_PAYLOADS_PRESENT)
+        {
+            payload->payload_data_length = read_length_type_value(cur, payload_length_type);
+        }
+        else if (cur->pos <= payloads_end)
+        {
+            payload->payload_data_length = (unsigned int)(payloads_end - cur->pos);
+        }
+        else
+        {
+            return ASFPARSE_ERROR_INVALID_ASF_FILE;
+        }
+        payload->payload_data = cursor_read_bytes(cur, payload->payload_data_length);
+
+        if (cur->overrun || cur->pos > payloads_end)
+        {
+            return ASFPARSE_ERROR_INVALID_ASF_FILE;
+        }
+    }
+
+    /* leave the cursor after the padding */
+    cursor_seek(cur, packet_start + packet->packet_length);
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  packet_layout
+* DESCRIPTION: Work out the size and number of the data packets in a Data
+*              Object
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+packet_layout
+    (const data_object_t               *data                /* [in] struct containing info about data object */
+    ,const file_properties_object_t    *file_properties     /* [in] struct containing info about file properties object */
+    ,unsigned int                      *packet_size         /* [out] fixed packet size, or 0 if packets vary in size */
+    ,long long                         *num_packets         /* [out] number of packets to decode */
+    )
+{
+    long long   count;
+
+    /* ASF files use fixed-size packets; the packet length field is only
+       needed when the minimum and maximum sizes differ */
+    if (file_properties->min_data_packet_size == file_properties->max_data_packet_size)
+    {
+        if (file_properties->min_data_packet_size <= 0)
+        {
+            return ASFPARSE_ERROR_INVALID_ASF_FILE;
+        }
+        *packet_size = (unsigned int)file_properties->min_data_packet_size;
+        count = (long long)(data->packets_size / *packet_size);
+    }
+    else
+    {
+        *packet_size = 0;
+        count = (long long)data->packets_size;
+    }
+
+    /* the declared count is meaningless while a broadcast is being written */
+    if (!(file_properties->flags & BROADCAST_FLAG)
+        && data->total_data_packets > 0
+        && data->total_data_packets < count)
+    {
+        count = data->total_data_packets;
+    }
+    *num_packets = count;
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  packet_iterator_init
+* DESCRIPTION: Prepare to walk the data packets of a Data Object
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+packet_iterator_init
+    (packet_iterator_t                 *it                  /* [out] packet iterator */
+    ,const char                        *p_file_data         /* [in] first byte of the mapped ASF file */
+    ,const data_object_t               *data                /* [in] struct containing info about data object */
+    ,const file_properties_object_t    *file_properties     /* [in] struct containing info about file properties object */
+    )
+{
+    cursor_init(&it->cur, p_file_data + data->packets_offset, data->packets_size);
+    it->packet_index = 0;
+
+    return packet_layout(data, file_properties, &it->packet_size, &it->num_packets);
+}
+
+/*****************************************************************************
+* NAME:  packet_iterator_next
+* DESCRIPTION: Decode the next data packet
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+packet_iterator_next
+    (packet_iterator_t *it      /* [in,out] packet iterator */
+    ,data_packet_t     *packet  /* [out] struct containing info about data packet */
+    )
+{
+    asfparse_error_t    error;
+    cursor_t            packet_cur;
+    size_t              packet_start = it->cur.pos;
+    INSTRUMENT_DECLARE(start);
+
+    if (packet_iterator_done(it))
+    {
+        return ASFPARSE_ERROR_OK;
+    }
+
+    /* restrict the packet parser to a single packet */
+    if (it->packet_size != 0)
+    {
+        if (cursor_remaining(&it->cur) < it->packet_size)
+        {
+            return ASFPARSE_ERROR_TRUNCATED_OBJECT;
+        }
+        cursor_init(&packet_cur, it->cur.p_base + packet_start, it->packet_size);
+    }
+    else
+    {
+        cursor_init(&packet_cur, it->cur.p_base + packet_start, cursor_remaining(&it->cur));
+    }
+
+    INSTRUMENT_START(start);
+    error = parse_data_packet(packet, &packet_cur, it->packet_size);
+    INSTRUMENT_STOP(INSTRUMENT_PARSE_DATA_PACKET, start, (it->packet_size != 0) ? it->packet_size : packet->packet_length);
+    if (error)
+    {
+        return error;
+    }
+
+    cursor_seek(&it->cur, packet_start + ((it->packet_size != 0) ? it->packet_size : packet->packet_length));
+    it->packet_index++;
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  packet_summary_add
+* DESCRIPTION: Accumulate the payload counts of one data packet
+* RETURNS: none
+******************************************************************************/
+void
+packet_summary_add
+    (packet_summary_t      *summary     /* [in,out] running packet summary */
+    ,const data_packet_t   *packet      /* [in] decoded data packet */
+    )
+{
+    const payload_t            *payload;
+    stream_packet_counts_t     *counts;
+    int                         i;
+
+    if (summary->num_packets == 0)
+    {
+        summary->first_send_time = packet->send_time;
+    }
+    summary->last_send_time = packet->send_time;
+    summary->num_packets++;
+
+    for (i = 0; i < packet->num_payloads; i++)
+    {
+        payload = &packet->payload[i];
+        counts = &summary->stream[payload->stream_number];
+
+        counts->num_payloads++;
+        counts->payload_bytes += payload->payload_data_length;
+        if (payload->is_key_frame
+            && (payload->is_compressed || payload->offset_into_media_object == 0))
+        {
+            counts->num_key_frames++;
+        }
+        summary->num_payloads++;
+        summary->payload_bytes += payload->payload_data_length;
+    }
+}
+
+/*****************************************************************************
+* NAME:  packet_summary_merge
+* DESCRIPTION: Add the payload counts of a partial summary, covering packets
+*              that follow those already counted, to a running summary
+* RETURNS: none
+******************************************************************************/
+void
+packet_summary_merge
+    (packet_summary_t          *summary     /* [in,out] running packet summary */
+    ,const packet_summary_t    *partial     /* [in] summary of later packets */
+    )
+{
+    int     i;
+
+    if (partial->num_packets == 0)
+    {
+        return;
+    }
+    if (summary->num_packets == 0)
+    {
+        summary->first_send_time = partial->first_send_time;
+    }
+    summary->last_send_time = partial->last_send_time;
+    summary->num_packets += partial->num_packets;
+    summary->num_payloads += partial->num_payloads;
+    summary->payload_bytes += partial->payload_bytes;
+
+    for (i = 0; i <= MAX_STREAM_NUMBER; i++)
+    {
+        summary->stream[i].num_payloads += partial->stream[i].num_payloads;
+        summary->stream[i].payload_bytes += partial->stream[i].payload_bytes;
+        summary->stream[i].num_key_frames += partial->stream[i].num_key_frames;
+    }
+}
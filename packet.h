@@ -0,0 +1,163 @@
+#ifndef PACKET_H
+#define PACKET_H
+
+/* Includes */
+#include "util.h"
+#include "cursor.h"
+
+/* Defines and constants */
+#define MAX_NUM_PAYLOADS        (64)    /* number of payloads field in a packet is 6 bits wide */
+#define MAX_STREAM_NUMBER       (127)   /* stream number field is 7 bits wide */
+
+/* Enums and structs */
+/* Structure describing one payload of a data packet, defined in Section
+   5.2.3 of the ASF Specification. Pointer members refer into the mapped
+   input file. For compressed payloads (replicated data length of 1) the
+   offset into media object holds the presentation time, and payload data
+   is a sequence of sub-payloads each prefixed with a one-byte length. */
+typedef struct {
+    int             stream_number;
+    int             is_key_frame;
+    int             is_compressed;
+    unsigned int    media_object_number;
+    unsigned int    offset_into_media_object;
+    unsigned int    replicated_data_length;
+    const char     *replicated_data;
+    unsigned int    payload_data_length;
+    const char     *payload_data;
+} payload_t;
+
+/* Structure describing a data packet, defined in Section 5.2 of the ASF
+   Specification */
+typedef struct {
+    int             err_correction_flags;       /* 0 if no error correction data is present */
+    int             err_correction_data_length;
+    int             length_type_flags;
+    int             property_flags;
+    unsigned int    packet_length;
+    unsigned int    sequence;
+    unsigned int    padding_length;
+    unsigned int    send_time;                  /* milliseconds */
+    unsigned int    duration;                   /* milliseconds */
+    int             num_payloads;
+    payload_t       payload[MAX_NUM_PAYLOADS];
+} data_packet_t;
+
+/* Structure describing a position within the data packets of a Data
+   Object. Packets are decoded in place; no memory is allocated per packet. */
+typedef struct {
+    cursor_t        cur;                /* cursor over the data packets only */
+    unsigned int    packet_size;        /* fixed packet size, or 0 if packets vary in size */
+    long long       packet_index;       /* number of packets returned so far */
+    long long       num_packets;        /* number of packets to return */
+} packet_iterator_t;
+
+/* Structures describing payload counts gathered while walking the data
+   packets, in total and per stream number */
+typedef struct {
+    long long       num_payloads;
+    long long       payload_bytes;
+    long long       num_key_frames;     /* key frame media objects started */
+} stream_packet_counts_t;
+
+typedef struct {
+    long long               num_packets;
+    long long               num_payloads;
+    long long               payload_bytes;
+    unsigned int            first_send_time;    /* milliseconds */
+    unsigned int            last_send_time;     /* milliseconds */
+    stream_packet_counts_t  stream[MAX_STREAM_NUMBER + 1];
+} packet_summary_t;
+
+/* Function prototypes */
+/*****************************************************************************
+* NAME:  parse_data_packet
+* DESCRIPTION: Parse a single data packet according to Section 5.2 of the ASF
+*              Specification. The cursor must cover exactly one packet of
+*              packet_size bytes, or everything that remains in the Data
+*              Object if packet_size is 0.
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+parse_data_packet
+    (data_packet_t *packet      /* [out] struct containing info about data packet */
+    ,cursor_t      *cur         /* [in,out] cursor positioned at the start of the packet */
+    ,unsigned int   packet_size /* [in] fixed packet size, or 0 if packets vary in size */
+    );
+
+/*****************************************************************************
+* NAME:  packet_layout
+* DESCRIPTION: Work out the size and number of the data packets in a Data
+*              Object from the File Properties Object
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+packet_layout
+    (const data_object_t               *data                /* [in] struct containing info about data object */
+    ,const file_properties_object_t    *file_properties     /* [in] struct containing info about file properties object */
+    ,unsigned int                      *packet_size         /* [out] fixed packet size, or 0 if packets vary in size */
+    ,long long                         *num_packets         /* [out] number of packets to decode */
+    );
+
+/*****************************************************************************
+* NAME:  packet_iterator_init
+* DESCRIPTION: Prepare to walk the data packets of a Data Object
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+packet_iterator_init
+    (packet_iterator_t                 *it                  /* [out] packet iterator */
+    ,const char                        *p_file_data         /* [in] first byte of the mapped ASF file */
+    ,const data_object_t               *data                /* [in] struct containing info about data object */
+    ,const file_properties_object_t    *file_properties     /* [in] struct containing info about file properties object */
+    );
+
+/*****************************************************************************
+* NAME:  packet_iterator_next
+* DESCRIPTION: Decode the next data packet
+* RETURNS: asfparse_error_t; ASFPARSE_ERROR_OK with no packet consumed once
+*          packet_iterator_done() is true
+******************************************************************************/
+asfparse_error_t
+packet_iterator_next
+    (packet_iterator_t *it      /* [in,out] packet iterator */
+    ,data_packet_t     *packet  /* [out] struct containing info about data packet */
+    );
+
+/*****************************************************************************
+* NAME:  packet_iterator_done
+* DESCRIPTION: Check whether every data packet has been returned
+* RETURNS: non-zero if no packets remain
+******************************************************************************/
+static inline int
+packet_iterator_done
+    (const packet_iterator_t   *it  /* [in] packet iterator */
+    )
+{
+    return it->packet_index >= it->num_packets || cursor_remaining(&it->cur) == 0;
+}
+
+/*****************************************************************************
+* NAME:  packet_summary_add
+* DESCRIPTION: Accumulate the payload counts of one data packet
+* RETURNS: none
+******************************************************************************/
+void
+packet_summary_add
+    (packet_summary_t      *summary     /* [in,out] running packet summary */
+    ,const data_packet_t   *packet      /* [in] decoded data packet */
+    );
+
+/*****************************************************************************
+* NAME:  packet_summary_merge
+* DESCRIPTION: Add the payload counts of a partial summary, covering packets
+*              that follow those already counted, to a running summary
+* RETURNS: none
+******************************************************************************/
+void
+packet_summary_merge
+    (packet_summary_t          *summary     /* [in,out] running packet summary */
+    ,const packet_summary_t    *partial     /* [in] summary of later packets */
+    );
+
+#endif
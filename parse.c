@@ -1,4 +1,5 @@
 #include "parse.h"
+#include "guid.h"
 
 /*****************************************************************************
 * NAME:  parse_header_object
@@ -9,34 +10,33 @@
 asfparse_error_t
 parse_header_object
     (header_object_t   *header      /* [out] struct containing info about header object */
-    ,FILE              *fin         /* [in] file pointer to ASF file */
+    ,cursor_t          *cur         /* [in,out] cursor over the ASF file */
     )
 {
-    char                buffer[MAX_BYTES_TO_READ];
-    asfparse_error_t    error;
-    object_type_t       object_type;
+    const char         *guid;
 
     /* parse object id (16 bytes) */
-    fread(buffer, 1, GUID_LENGTH_IN_BYTES, fin);
-    error = get_object_type(buffer, &object_type);
+    guid = cursor_read_bytes(cur, GUID_LENGTH_IN_BYTES);
+    if (guid == NULL)
+    {
+        return ASFPARSE_ERROR_TRUNCATED_OBJECT;
+    }
 
-    if (object_type != OBJECT_TYPE_HEADER)
+    if (!guid_equal(guid, ASF_HEADER_OBJECT_GUID))
     {
         return ASFPARSE_ERROR_INVALID_ASF_FILE;
     }
 
     /* parse object size (8 bytes) */
-    fread(buffer, 1, 8, fin);
-    header->object_size = convert_char_bytes_to_int(buffer, 8);
+    header->object_size = cursor_read_uint64(cur);
 
     /* parse number of header objects (4 bytes) */
-    fread(buffer, 1, 4, fin);
-    header->num_objects = convert_char_bytes_to_int(buffer, 4);
+    header->num_objects = cursor_read_uint32(cur);
 
     /* parse and discard reserved fields (2 bytes) */
-    fread(buffer, 1, 2, fin);
+    cursor_skip(cur, 2);
 
-    return ASFPARSE_ERROR_OK;
+    return cur->overrun ? ASFPARSE_ERROR_TRUNCATED_OBJECT : ASFPARSE_ERROR_OK;
 }
 
 /*****************************************************************************
@@ -48,59 +48,46 @@ parse_header_object
 asfparse_error_t
 parse_file_properties_object
     (file_properties_object_t  *file_properties     /* [out] struct containing info about file properties object */
-    ,FILE                      *fin                 /* [in] file pointer to ASF file */
+    ,cursor_t                  *cur                 /* [in,out] cursor over the ASF file */
     )
 {
-    char    buffer[MAX_BYTES_TO_READ];
-
     /* parse object size (8 bytes) */
-    fread(buffer, 1, 8, fin);
-    file_properties->object_size = convert_char_bytes_to_int(buffer, 8);
+    file_properties->object_size = cursor_read_uint64(cur);
 
     /* parse and discard file id (16 bytes) */
-    fread(buffer, 1, 16, fin);
+    cursor_skip(cur, 16);
 
     /* parse file size (8 bytes) */
-    fread(buffer, 1, 8, fin);
-    file_properties->file_size = convert_char_bytes_to_int(buffer, 8);
+    file_properties->file_size = cursor_read_uint64(cur);
 
     /* parse creation_date (8 bytes) */
-    fread(buffer, 1, 8, fin);
-    file_properties->creation_date = convert_char_bytes_to_int(buffer, 8); 
+    file_properties->creation_date = cursor_read_uint64(cur);
 
     /* parse data packets count (8 bytes) */
-    fread(buffer, 1, 8, fin);
-    file_properties->data_packets_count = convert_char_bytes_to_int(buffer, 8); 
+    file_properties->data_packets_count = cursor_read_uint64(cur);
 
     /* parse play duration (8 bytes) */
-    fread(buffer, 1, 8, fin);
-    file_properties->play_duration = convert_char_bytes_to_int(buffer, 8); 
+    file_properties->play_duration = cursor_read_uint64(cur);
 
     /* parse send duration (8 bytes) */
-    fread(buffer, 1, 8, fin);
-    file_properties->send_duration = convert_char_bytes_to_int(buffer, 8);
+    file_properties->send_duration = cursor_read_uint64(cur);
 
     /* parse preroll (8 bytes) */
-    fread(buffer, 1, 8, fin);
-    file_properties->preroll = convert_char_bytes_to_int(buffer, 8); 
+    file_properties->preroll = cursor_read_uint64(cur);
 
     /* parse flags (4 bytes) */
-    fread(buffer, 1, 4, fin);
-    file_properties->flags = convert_char_bytes_to_int(buffer, 4);
+    file_properties->flags = cursor_read_uint32(cur);
 
     /* parse min data packet size (4 bytes) */
-    fread(buffer, 1, 4, fin);
-    file_properties->min_data_packet_size = convert_char_bytes_to_int(buffer, 4);
+    file_properties->min_data_packet_size = cursor_read_uint32(cur);
 
     /* parse max data packet size (4 bytes) */
-    fread(buffer, 1, 4, fin);
-    file_properties->max_data_packet_size = convert_char_bytes_to_int(buffer, 4);
+    file_properties->max_data_packet_size = cursor_read_uint32(cur);
 
     /* parse max bitrate (4 bytes) */
-    fread(buffer, 1, 4, fin);
-    file_properties->max_bitrate = convert_char_bytes_to_int(buffer, 4);
+    file_properties->max_bitrate = cursor_read_uint32(cur);
 
-    return ASFPARSE_ERROR_OK;
+    return cur->overrun ? ASFPARSE_ERROR_TRUNCATED_OBJECT : ASFPARSE_ERROR_OK;
 }
 
 /*****************************************************************************
@@ -112,53 +99,42 @@ parse_file_properties_object
 asfparse_error_t
 parse_stream_properties_object
     (stream_properties_object_t    *stream_properties   /* [out] struct containing info about stream properties object */
-    ,FILE                          *fin                 /* [in] file pointer to ASF file */
+    ,cursor_t                      *cur                 /* [in,out] cursor over the ASF file */
     )
 {
-    char    buffer[MAX_BYTES_TO_READ];
-
     /* parse object size (8 bytes) */
-    fread(buffer, 1, 8, fin);
-    stream_properties->object_size = convert_char_bytes_to_int(buffer, 8);
+    stream_properties->object_size = cursor_read_uint64(cur);
 
     /* parse stream type (16 bytes) */
-    fread(stream_properties->stream_type, 1, 16, fin);
+    stream_properties->stream_type = cursor_read_bytes(cur, GUID_LENGTH_IN_BYTES);
 
     /* parse error correction type (16 bytes) */
-    fread(stream_properties->err_correction_type, 1, 16, fin);
+    stream_properties->err_correction_type = cursor_read_bytes(cur, GUID_LENGTH_IN_BYTES);
 
     /* parse time offset (8 bytes) */
-    fread(buffer, 1, 8, fin);
-    stream_properties->time_offset = convert_char_bytes_to_int(buffer, 8);
+    stream_properties->time_offset = cursor_read_uint64(cur);
 
     /* parse type specific data length (4 bytes) */
-    fread(buffer, 1, 4, fin);
-    stream_properties->type_specific_data_length = convert_char_bytes_to_int(buffer, 4);
+    stream_properties->type_specific_data_length = cursor_read_uint32(cur);
 
     /* parse error correction data length (4 bytes) */
-    fread(buffer, 1, 4, fin);
-    stream_properties->err_correction_data_length = convert_char_bytes_to_int(buffer, 4);
+    stream_properties->err_correction_data_length = cursor_read_uint32(cur);
 
     /* parse flags (2 bytes) */
-    fread(buffer, 1, 2, fin);
-    stream_properties->flags = convert_char_bytes_to_int(buffer, 2);
+    stream_properties->flags = cursor_read_uint16(cur);
 
     /* parse and discard reserved field (4 bytes) */
-    fread(buffer, 1, 4, fin);
+    cursor_skip(cur, 4);
 
     /* parse type-specific data */
-    fread(stream_properties->type_specific_data
-         ,1
-         ,stream_properties->type_specific_data_length
-         ,fin);
+    stream_properties->type_specific_data =
+        cursor_read_bytes(cur, stream_properties->type_specific_data_length);
 
     /* parse error correction data */
-    fread(stream_properties->err_correction_data
-         ,1
-         ,stream_properties->err_correction_data_length
-         ,fin);
+    stream_properties->err_correction_data =
+        cursor_read_bytes(cur, stream_properties->err_correction_data_length);
 
-    return ASFPARSE_ERROR_OK;
+    return cur->overrun ? ASFPARSE_ERROR_TRUNCATED_OBJECT : ASFPARSE_ERROR_OK;
 }
 
 /*****************************************************************************
@@ -170,29 +146,25 @@ parse_stream_properties_object
 asfparse_error_t
 parse_header_extension_object
     (header_extension_object_t *header_ext  /* [out] struct containing info about header extension object */
-    ,FILE                      *fin         /* [in] file pointer to ASF file */
+    ,cursor_t                  *cur         /* [in,out] cursor over the ASF file */
     )
 {
-    char    buffer[MAX_BYTES_TO_READ];
-
     /* parse object size (8 bytes) */
-    fread(buffer, 1, 8, fin);
-    header_ext->object_size = convert_char_bytes_to_int(buffer, 8);
+    header_ext->object_size = cursor_read_uint64(cur);
 
     /* parse and discard reserved field 1 (16 bytes) */
-    fread(buffer, 1, 16, fin);
+    cursor_skip(cur, 16);
 
     /* parse and discard reserved field 2 (2 bytes) */
-    fread(buffer, 1, 2, fin);
+    cursor_skip(cur, 2);
 
     /* parse data size (4 bytes) */
-    fread(buffer, 1, 4, fin);
-    header_ext->data_size = convert_char_bytes_to_int(buffer, 4);
+    header_ext->data_size = cursor_read_uint32(cur);
 
     /* parse data */
-    fread(header_ext->data, 1, header_ext->data_size, fin);
+    header_ext->data = cursor_read_bytes(cur, header_ext->data_size);
 
-    return ASFPARSE_ERROR_OK;
+    return cur->overrun ? ASFPARSE_ERROR_TRUNCATED_OBJECT : ASFPARSE_ERROR_OK;
 }
 
 /*****************************************************************************
@@ -204,61 +176,60 @@ parse_header_extension_object
 asfparse_error_t
 parse_codec_list_object
     (codec_list_object_t   *codec_list  /* [out] struct containing info about codec list object */
-    ,FILE                  *fin         /* [in] file pointer to ASF file */
+    ,cursor_t              *cur         /* [in,out] cursor over the ASF file */
+    ,arena_t               *arena       /* [in,out] arena holding the codec entries */
     )
 {
-    int     i;
-    char    buffer[MAX_BYTES_TO_READ];
+    int             i;
+    codec_entry_t  *entry;
 
     /* parse object size (8 bytes) */
-    fread(buffer, 1, 8, fin);
-    codec_list->object_size = convert_char_bytes_to_int(buffer, 8);
+    codec_list->object_size = cursor_read_uint64(cur);
 
     /* parse and discard reserved fields (16 bytes) */
-    fread(buffer, 1, 16, fin);
+    cursor_skip(cur, 16);
+
+    /* parse codec entries count (4 bytes); every entry takes at least
+       8 bytes, which bounds the allocation by the size of the file */
+    codec_list->codec_entry_count = cursor_read_uint32(cur);
+    if (cur->overrun
+        || (size_t)codec_list->codec_entry_count > cursor_remaining(cur) / 8)
+    {
+        return ASFPARSE_ERROR_TRUNCATED_OBJECT;
+    }
 
-    /* parse codec entries count (4 bytes) */
-    fread(buffer, 1, 4, fin);
-    codec_list->codec_entry_count = convert_char_bytes_to_int(buffer, 4);
+    codec_list->codec_entry = arena_alloc(arena, (size_t)codec_list->codec_entry_count * sizeof(codec_entry_t));
+    if (codec_list->codec_entry == NULL && codec_list->codec_entry_count > 0)
+    {
+        return ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
 
     /* parse each codec entry */
     for (i = 0; i < codec_list->codec_entry_count; i++)
     {
+        entry = &codec_list->codec_entry[i];
+
         /* parse codec entry type (2 bytes) */
-        fread(buffer, 1, 2, fin);
-        codec_list->codec_entry[i].codec_type = convert_char_bytes_to_int(buffer, 2);
-
-        /* parse codec name length (2 bytes) */
-        fread(buffer, 1, 2, fin);
-        codec_list->codec_entry[i].codec_name_length = convert_char_bytes_to_int(buffer, 2);
-
-        /* parse codec name */
-        fread(codec_list->codec_entry[i].codec_name
-             ,1
-             ,codec_list->codec_entry[i].codec_name_length * 2
-             ,fin);
-
-        /* parse codec description length (2 bytes) */
-        fread(buffer, 1, 2, fin);
-        codec_list->codec_entry[i].codec_description_length = convert_char_bytes_to_int(buffer, 2);
-
-        /* parse codec description */
-        fread(codec_list->codec_entry[i].codec_description
-             ,1
-             ,codec_list->codec_entry[i].codec_description_length * 2
-             ,fin);
-
-        /* parse codec information length (2 bytes) */
-        fread(buffer, 1, 2, fin);
-        codec_list->codec_entry[i].codec_information_length = convert_char_bytes_to_int(buffer, 2);
-
-        /* parse codec information */
-        fread(codec_list->codec_entry[i].codec_information
-             ,1
-             ,codec_list->codec_entry[i].codec_information_length
-             ,fin);
+        entry->codec_type = cursor_read_uint16(cur);
+
+        /* parse codec name length (2 bytes) and name */
+        entry->codec_name_length = cursor_read_uint16(cur);
+        entry->codec_name = cursor_read_bytes(cur, (size_t)entry->codec_name_length * 2);
+
+        /* parse codec description length (2 bytes) and description */
+        entry->codec_description_length = cursor_read_uint16(cur);
+        entry->codec_description = cursor_read_bytes(cur, (size_t)entry->codec_description_length * 2);
+
+        /* parse codec information length (2 bytes) and information */
+        entry->codec_information_length = cursor_read_uint16(cur);
+        entry->codec_information = cursor_read_bytes(cur, entry->codec_information_length);
+
+        if (cur->overrun)
+        {
+            return ASFPARSE_ERROR_TRUNCATED_OBJECT;
+        }
     }
-    
+
     return ASFPARSE_ERROR_OK;
 }
 
@@ -271,48 +242,53 @@ parse_codec_list_object
 asfparse_error_t
 parse_extended_content_description_object
     (extended_content_description_object_t *ext_content_descr   /* [out] struct containing info about extended content description object */
-    ,FILE                                  *fin                 /* [in] file pointer to ASF file */
+    ,cursor_t                              *cur                 /* [in,out] cursor over the ASF file */
+    ,arena_t                               *arena               /* [in,out] arena holding the content descriptors */
     )
 {
-    int     i;
-    char    buffer[MAX_BYTES_TO_READ];
+    int                     i;
+    content_descriptor_t   *descriptor;
 
     /* parse object size (8 bytes) */
-    fread(buffer, 1, 8, fin);
-    ext_content_descr->object_size = convert_char_bytes_to_int(buffer, 8);
+    ext_content_descr->object_size = cursor_read_uint64(cur);
+
+    /* parse content descriptors count (2 bytes); every descriptor takes at
+       least 6 bytes */
+    ext_content_descr->descriptor_count = cursor_read_uint16(cur);
+    if (cur->overrun
+        || (size_t)ext_content_descr->descriptor_count > cursor_remaining(cur) / 6)
+    {
+        return ASFPARSE_ERROR_TRUNCATED_OBJECT;
+    }
 
-    /* parse content descriptors count (2 bytes) */
-    fread(buffer, 1, 2, fin);
-    ext_content_descr->descriptor_count = convert_char_bytes_to_int(buffer, 2);
+    ext_content_descr->descriptor = arena_alloc(arena, (size_t)ext_content_descr->descriptor_count * sizeof(content_descriptor_t));
+    if (ext_content_descr->descriptor == NULL && ext_content_descr->descriptor_count > 0)
+    {
+        return ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
 
     /* parse each content descriptor */
     for (i = 0; i < ext_content_descr->descriptor_count; i++)
     {
-        /* parse descriptor name length (2 bytes) */
-        fread(buffer, 1, 2, fin);
-        ext_content_descr->descriptor[i].name_length = convert_char_bytes_to_int(buffer, 2);
+        descriptor = &ext_content_descr->descriptor[i];
 
-        /* parse descriptor name */
-        fread(ext_content_descr->descriptor[i].name
-             ,1
-             ,ext_content_descr->descriptor[i].name_length
-             ,fin);
+        /* parse descriptor name length (2 bytes) and name */
+        descriptor->name_length = cursor_read_uint16(cur);
+        descriptor->name = cursor_read_bytes(cur, descriptor->name_length);
 
         /* parse descriptor value data type (2 bytes) */
-        fread(buffer, 1, 2, fin);
-        ext_content_descr->descriptor[i].value_data_type = convert_char_bytes_to_int(buffer, 2);
-
-        /* parse descriptor value length (2 bytes) */
-        fread(buffer, 1, 2, fin);
-        ext_content_descr->descriptor[i].value_length = convert_char_bytes_to_int(buffer, 2);
-
-        /* parse descriptor value */
-        fread(ext_content_descr->descriptor[i].value
-             ,1
-             ,ext_content_descr->descriptor[i].value_length
-             ,fin);
+        descriptor->value_data_type = cursor_read_uint16(cur);
+
+        /* parse descriptor value length (2 bytes) and value */
+        descriptor->value_length = cursor_read_uint16(cur);
+        descriptor->value = cursor_read_bytes(cur, descriptor->value_length);
+
+        if (cur->overrun)
+        {
+            return ASFPARSE_ERROR_TRUNCATED_OBJECT;
+        }
     }
-    
+
     return ASFPARSE_ERROR_OK;
 }
 
@@ -325,25 +301,143 @@ parse_extended_content_description_object
 asfparse_error_t
 parse_stream_bitrate_properties_object
     (stream_bitrate_properties_object_t    *stream_bitrate_properties   /* [out] struct containing info about stream bitrate properties object */
-    ,FILE                                  *fin                         /* [in] file pointer to ASF file */
+    ,cursor_t                              *cur                         /* [in,out] cursor over the ASF file */
     )
 {
-    int     i;
-    char    buffer[MAX_BYTES_TO_READ];
-
     /* parse object size (8 bytes) */
-    fread(buffer, 1, 8, fin);
-    stream_bitrate_properties->object_size = convert_char_bytes_to_int(buffer, 8);
+    stream_bitrate_properties->object_size = cursor_read_uint64(cur);
 
     /* parse bitrate records count (2 bytes) */
-    fread(buffer, 1, 2, fin);
-    stream_bitrate_properties->bitrate_records_count = convert_char_bytes_to_int(buffer, 2);
+    stream_bitrate_properties->bitrate_records_count = cursor_read_uint16(cur);
+
+    /* keep bitrate records (6 bytes each) in place */
+    stream_bitrate_properties->bitrate_records = cursor_read_bytes(cur, (size_t)stream_bitrate_properties->bitrate_records_count * 6);
+
+    return cur->overrun ? ASFPARSE_ERROR_TRUNCATED_OBJECT : ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  parse_data_object
+* DESCRIPTION: Parse data object information from ASF file according to
+*              Section 5.1 of the ASF Specification, leaving the cursor at
+*              the first data packet
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+parse_data_object
+    (data_object_t *data        /* [out] struct containing info about data object */
+    ,cursor_t      *cur         /* [in,out] cursor over the ASF file */
+    )
+{
+    size_t  object_start = cur->pos - GUID_LENGTH_IN_BYTES;
+    size_t  object_end;
+
+    /* parse object size (8 bytes) */
+    data->object_size = cursor_read_uint64(cur);
+
+    /* parse and discard file id (16 bytes) */
+    cursor_skip(cur, 16);
+
+    /* parse total data packets (8 bytes) */
+    data->total_data_packets = cursor_read_uint64(cur);
 
-    /* parse and discard bitrate records */
-    for (i = 0; i < stream_bitrate_properties->bitrate_records_count; i++)
+    /* parse and discard reserved field (2 bytes) */
+    cursor_skip(cur, 2);
+
+    if (cur->overrun)
+    {
+        return ASFPARSE_ERROR_TRUNCATED_OBJECT;
+    }
+
+    /* the packets run to the end of the object; a recording that is still
+       being written may declare a size beyond the end of the file */
+    object_end = object_start + (size_t)data->object_size;
+    if (data->object_size < 50 || object_end > cur->size)
     {
-        fread(buffer, 1, 6, fin);
+        object_end = cur->size;
     }
+    data->packets_offset = cur->pos;
+    data->packets_size = object_end - cur->pos;
 
     return ASFPARSE_ERROR_OK;
-}
\ No newline at end of file
+}
+
+/*****************************************************************************
+* NAME:  parse_simple_index_object
+* DESCRIPTION: Parse simple index object information from ASF file according
+*              to Section 6.1 of the ASF Specification
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+parse_simple_index_object
+    (simple_index_object_t *simple_index    /* [out] struct containing info about simple index object */
+    ,cursor_t              *cur             /* [in,out] cursor over the ASF file */
+    )
+{
+    /* parse object size (8 bytes) */
+    simple_index->object_size = cursor_read_uint64(cur);
+
+    /* parse and discard file id (16 bytes) */
+    cursor_skip(cur, 16);
+
+    /* parse index entry time interval (8 bytes) */
+    simple_index->index_entry_time_interval = cursor_read_uint64(cur);
+
+    /* parse maximum packet count (4 bytes) */
+    simple_index->max_packet_count = cursor_read_uint32(cur);
+
+    /* parse index entries count (4 bytes) */
+    simple_index->index_entries_count = cursor_read_uint32(cur);
+
+    /* parse index entries (6 bytes each) */
+    simple_index->index_entries = cursor_read_bytes(cur, (size_t)simple_index->index_entries_count * 6);
+
+    return cur->overrun ? ASFPARSE_ERROR_TRUNCATED_OBJECT : ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  parse_index_object
+* DESCRIPTION: Parse index object information from ASF file according to
+*              Section 6.2 of the ASF Specification
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+parse_index_object
+    (index_object_t    *index       /* [out] struct containing info about index object */
+    ,cursor_t          *cur         /* [in,out] cursor over the ASF file */
+    )
+{
+    size_t  object_start = cur->pos - GUID_LENGTH_IN_BYTES;
+    size_t  object_end;
+
+    /* parse object size (8 bytes) */
+    index->object_size = cursor_read_uint64(cur);
+
+    /* parse index entry time interval (4 bytes) */
+    index->index_entry_time_interval = cursor_read_uint32(cur);
+
+    /* parse index specifiers count (2 bytes) */
+    index->index_specifiers_count = cursor_read_uint16(cur);
+
+    /* parse index blocks count (4 bytes) */
+    index->index_blocks_count = cursor_read_uint32(cur);
+
+    /* parse index specifiers (4 bytes each) */
+    index->index_specifiers = cursor_read_bytes(cur, (size_t)index->index_specifiers_count * 4);
+
+    if (cur->overrun)
+    {
+        return ASFPARSE_ERROR_TRUNCATED_OBJECT;
+    }
+
+    /* the index blocks fill the rest of the object */
+    object_end = object_start + (size_t)index->object_size;
+    if (object_end < cur->pos || object_end > cur->size)
+    {
+        return ASFPARSE_ERROR_TRUNCATED_OBJECT;
+    }
+    index->index_blocks_size = object_end - cur->pos;
+    index->index_blocks = cursor_read_bytes(cur, index->index_blocks_size);
+
+    return ASFPARSE_ERROR_OK;
+}
@@ -2,8 +2,9 @@
 #define PARSE_H
 
 /* Includes */
-#include <stdio.h>
 #include "util.h"
+#include "cursor.h"
+#include "arena.h"
 
 /* Function prototypes */
 /*****************************************************************************
@@ -15,7 +16,7 @@
 asfparse_error_t
 parse_header_object
     (header_object_t   *header      /* [out] struct containing info about header object */
-    ,FILE              *fin         /* [in] file pointer to ASF file */
+    ,cursor_t          *cur         /* [in,out] cursor over the ASF file */
     );
 
 /*****************************************************************************
@@ -27,7 +28,7 @@ parse_header_object
 asfparse_error_t
 parse_file_properties_object
     (file_properties_object_t  *file_properties     /* [out] struct containing info about file properties object */
-    ,FILE                      *fin                 /* [in] file pointer to ASF file */
+    ,cursor_t                  *cur                 /* [in,out] cursor over the ASF file */
     );
 
 /*****************************************************************************
@@ -39,7 +40,7 @@ parse_file_properties_object
 asfparse_error_t
 parse_stream_properties_object
     (stream_properties_object_t    *stream_properties   /* [out] struct containing info about stream properties object */
-    ,FILE                          *fin                 /* [in] file pointer to ASF file */
+    ,cursor_t                      *cur                 /* [in,out] cursor over the ASF file */
     );
 
 /*****************************************************************************
@@ -51,7 +52,7 @@ parse_stream_properties_object
 asfparse_error_t
 parse_header_extension_object
     (header_extension_object_t *header_ext  /* [out] struct containing info about header extension object */
-    ,FILE                      *fin         /* [in] file pointer to ASF file */
+    ,cursor_t                  *cur         /* [in,out] cursor over the ASF file */
     );
 
 /*****************************************************************************
@@ -63,7 +64,8 @@ parse_header_extension_object
 asfparse_error_t
 parse_codec_list_object
     (codec_list_object_t   *codec_list  /* [out] struct containing info about codec list object */
-    ,FILE                  *fin         /* [in] file pointer to ASF file */
+    ,cursor_t              *cur         /* [in,out] cursor over the ASF file */
+    ,arena_t               *arena       /* [in,out] arena holding the codec entries */
     );
 
 /*****************************************************************************
@@ -75,7 +77,8 @@ parse_codec_list_object
 asfparse_error_t
 parse_extended_content_description_object
     (extended_content_description_object_t *ext_content_descr   /* [out] struct containing info about extended content description object */
-    ,FILE                                  *fin                 /* [in] file pointer to ASF file */
+    ,cursor_t                              *cur                 /* [in,out] cursor over the ASF file */
+    ,arena_t                               *arena               /* [in,out] arena holding the content descriptors */
     );
 
 /*****************************************************************************
@@ -87,7 +90,44 @@ parse_extended_content_description_object
 asfparse_error_t
 parse_stream_bitrate_properties_object
     (stream_bitrate_properties_object_t    *stream_bitrate_properties   /* [out] struct containing info about stream bitrate properties object */
-    ,FILE                                  *fin                         /* [in] file pointer to ASF file */
+    ,cursor_t                              *cur                         /* [in,out] cursor over the ASF file */
+    );
+
+/*****************************************************************************
+* NAME:  parse_data_object
+* DESCRIPTION: Parse data object information from ASF file according to
+*              Section 5.1 of the ASF Specification, leaving the cursor at
+*              the first data packet
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+parse_data_object
+    (data_object_t *data        /* [out] struct containing info about data object */
+    ,cursor_t      *cur         /* [in,out] cursor over the ASF file */
+    );
+
+/*****************************************************************************
+* NAME:  parse_simple_index_object
+* DESCRIPTION: Parse simple index object information from ASF file according
+*              to Section 6.1 of the ASF Specification
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+parse_simple_index_object
+    (simple_index_object_t *simple_index    /* [out] struct containing info about simple index object */
+    ,cursor_t              *cur             /* [in,out] cursor over the ASF file */
+    );
+
+/*****************************************************************************
+* NAME:  parse_index_object
+* DESCRIPTION: Parse index object information from ASF file according to
+*              Section 6.2 of the ASF Specification
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+parse_index_object
+    (index_object_t    *index       /* [out] struct containing info about index object */
+    ,cursor_t          *cur         /* [in,out] cursor over the ASF file */
     );
 
 #endif
\ No newline at end of file
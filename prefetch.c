@@ -0,0 +1,837 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+#if defined(__linux__) && defined(__NR_io_uring_setup) && !defined(PREFETCH_NO_IO_URING)
+#define PREFETCH_HAVE_IO_URING
+#include <sched.h>
+#include <sys/mman.h>
+#include <linux/io_uring.h>
+#endif
+
+#include "cursor.h"
+#include "prefetch.h"
+#include "instrument.h"
+
+/* Defines and constants */
+#define URING_MAX_RETRIES       (1000)  /* io_uring_enter calls that may fail with EAGAIN or EBUSY in a row */
+
+/* Enums and structs */
+/* Enum describing where a request is in its sequence of I/O operations */
+typedef enum {
+     REQUEST_FREE = 0           /* not in use */
+    ,REQUEST_QUEUED             /* waiting for a reader thread */
+    ,REQUEST_OPEN               /* opening the file */
+    ,REQUEST_READ_FIRST         /* reading the first PREFETCH_FIRST_READ_SIZE bytes */
+    ,REQUEST_READ_REST          /* reading the rest of the Header Object */
+    ,REQUEST_COMPLETE           /* waiting for prefetch_wait */
+} request_stage_t;
+
+/* Structure describing one file in flight */
+typedef struct {
+    const char         *p_filename;     /* name of file to read */
+    void               *p_tag;          /* caller's pointer */
+    request_stage_t     stage;
+    int                 fd;             /* open file, or -1 */
+    char               *p_data;         /* bytes read so far */
+    size_t              size;           /* number of bytes in p_data */
+    size_t              wanted;         /* number of bytes the whole Header Object takes, once known */
+    asfparse_error_t    error;
+} prefetch_request_t;
+
+/* Structure describing a FIFO of request indices */
+typedef struct {
+    unsigned int   *items;
+    unsigned int    head;               /* index of the oldest item */
+    unsigned int    count;              /* number of items queued */
+    unsigned int    capacity;
+} request_queue_t;
+
+#if defined(PREFETCH_HAVE_IO_URING)
+/* Structure describing an io_uring instance set up with raw system calls */
+typedef struct {
+    int                     fd;
+    unsigned int           *sq_tail;
+    unsigned int           *sq_mask;
+    unsigned int           *sq_array;
+    unsigned int           *cq_head;
+    unsigned int           *cq_tail;
+    unsigned int           *cq_mask;
+    struct io_uring_sqe    *sqes;
+    struct io_uring_cqe    *cqes;
+    void                   *p_sq_ring;
+    size_t                  sq_ring_size;
+    void                   *p_cq_ring;      /* same as p_sq_ring with IORING_FEAT_SINGLE_MMAP */
+    size_t                  cq_ring_size;
+    size_t                  sqes_size;
+    unsigned int            num_pending;    /* entries queued since the last io_uring_enter */
+} uring_t;
+#endif
+
+/* Structure describing an I/O engine */
+struct prefetch_s {
+    prefetch_request_t *requests;       /* one entry per file that may be in flight */
+    unsigned int        depth;          /* number of entries in requests */
+    request_queue_t     free;           /* requests not in use */
+    request_queue_t     queued;         /* requests waiting for a reader thread */
+    request_queue_t     done;           /* requests waiting for prefetch_wait */
+    int                 use_uring;      /* non-zero if ring is set up */
+#if defined(PREFETCH_HAVE_IO_URING)
+    uring_t             ring;
+#endif
+    pthread_t           threads[PREFETCH_MAX_THREADS];
+    int                 num_threads;
+    int                 stopping;       /* non-zero once the threads should exit */
+    pthread_mutex_t     lock;
+    pthread_cond_t      work_ready;     /* signalled when a request is queued */
+    pthread_cond_t      request_done;   /* signalled when a request completes */
+};
+
+/*****************************************************************************
+* NAME:  queue_push
+* DESCRIPTION: Append a request index to a FIFO
+* RETURNS: none
+******************************************************************************/
+static void
+queue_push
+    (request_queue_t   *queue       /* [in,out] FIFO with room for the item */
+    ,unsigned int       item        /* [in] request index */
+    )
+{
+    queue->items[(queue->head + queue->count) % queue->capacity] = item;
+    queue->count++;
+}
+
+/*****************************************************************************
+* NAME:  queue_pop
+* DESCRIPTION: Remove the oldest request index from a non-empty FIFO
+* RETURNS: request index
+******************************************************************************/
+static unsigned int
+queue_pop
+    (request_queue_t   *queue       /* [in,out] FIFO */
+    )
+{
+    unsigned int    item = queue->items[queue->head];
+
+    queue->head = (queue->head + 1) % queue->capacity;
+    queue->count--;
+
+    return item;
+}
+
+/*****************************************************************************
+* NAME:  header_read_size
+* DESCRIPTION: Work out how many bytes to read for the whole Header Object
+*              from the start of a file
+* RETURNS: asfparse_error_t; ASFPARSE_ERROR_OUT_OF_MEMORY if the Header
+*          Object is larger than PREFETCH_MAX_HEADER_SIZE
+******************************************************************************/
+static asfparse_error_t
+header_read_size
+    (const char    *p_data      /* [in] first bytes of the file */
+    ,size_t         size        /* [in] number of bytes in p_data */
+    ,size_t        *wanted      /* [out] number of bytes to read, at least size */
+    )
+{
+    cursor_t    cur;
+    long long   object_size;
+
+    *wanted = size;
+    cursor_init(&cur, p_data, size);
+    cursor_skip(&cur, GUID_LENGTH_IN_BYTES);
+    object_size = cursor_read_uint64(&cur);
+    if (cur.overrun || object_size <= (long long)size)
+    {
+        return ASFPARSE_ERROR_OK;
+    }
+
+    /* reading only part of a larger header would report a valid file as
+       truncated, so it is left to the caller to map the file instead; a
+       damaged size field is reported there as well */
+    if (object_size > PREFETCH_MAX_HEADER_SIZE)
+    {
+        return ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
+    *wanted = (size_t)object_size;
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  grow_request
+* DESCRIPTION: Make room in a request's buffer for the rest of the header
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+grow_request
+    (prefetch_request_t    *req     /* [in,out] request */
+    ,size_t                 size    /* [in] number of bytes needed */
+    )
+{
+    char   *p_data = realloc(req->p_data, size);
+
+    if (p_data == NULL)
+    {
+        return ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
+    req->p_data = p_data;
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  read_at
+* DESCRIPTION: Read up to size bytes at an offset, retrying short reads
+* RETURNS: number of bytes read, or -1 on error
+******************************************************************************/
+static ssize_t
+read_at
+    (int            fd          /* [in] open file */
+    ,char          *p_dest      /* [out] bytes read */
+    ,size_t         size        /* [in] number of bytes wanted */
+    ,off_t          offset      /* [in] file offset of the first byte */
+    )
+{
+    size_t  total = 0;
+    ssize_t n;
+    INSTRUMENT_DECLARE(start);
+
+    while (total < size)
+    {
+        INSTRUMENT_START(start);
+        n = pread(fd, p_dest + total, size - total, offset + (off_t)total);
+        INSTRUMENT_STOP(INSTRUMENT_IO_READ, start, (n > 0) ? n : 0);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n < 0)
+        {
+            return -1;
+        }
+        if (n == 0)
+        {
+            break;
+        }
+        total += (size_t)n;
+    }
+
+    return (ssize_t)total;
+}
+
+/*****************************************************************************
+* NAME:  read_header_sync
+* DESCRIPTION: Open a file and read its Header Object with blocking calls
+* RETURNS: none
+******************************************************************************/
+static void
+read_header_sync
+    (prefetch_request_t    *req     /* [in,out] request */
+    )
+{
+    ssize_t n;
+    size_t  wanted;
+    int     fd;
+    INSTRUMENT_DECLARE(start);
+
+    req->error = ASFPARSE_ERROR_OPEN_FILE;
+    INSTRUMENT_START(start);
+    fd = open(req->p_filename, O_RDONLY);
+    INSTRUMENT_STOP(INSTRUMENT_IO_OPEN, start, 0);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    n = read_at(fd, req->p_data, PREFETCH_FIRST_READ_SIZE, 0);
+    if (n >= 0)
+    {
+        req->size = (size_t)n;
+        req->error = header_read_size(req->p_data, req->size, &wanted);
+        if (req->error == ASFPARSE_ERROR_OK && req->size == PREFETCH_FIRST_READ_SIZE && wanted > req->size)
+        {
+            req->error = grow_request(req, wanted);
+            if (req->error == ASFPARSE_ERROR_OK)
+            {
+                n = read_at(fd, req->p_data + req->size, wanted - req->size, (off_t)req->size);
+                req->error = (n < 0) ? ASFPARSE_ERROR_OPEN_FILE : ASFPARSE_ERROR_OK;
+                req->size += (n > 0) ? (size_t)n : 0;
+            }
+        }
+    }
+
+    close(fd);
+}
+
+/*****************************************************************************
+* NAME:  prefetch_thread
+* DESCRIPTION: Reader thread body: read queued headers until the engine is
+*              destroyed
+* RETURNS: NULL
+******************************************************************************/
+static void *
+prefetch_thread
+    (void  *arg     /* [in] prefetch_t engine */
+    )
+{
+    prefetch_t         *engine = arg;
+    prefetch_request_t *req;
+
+    pthread_mutex_lock(&engine->lock);
+    for (;;)
+    {
+        while (engine->queued.count == 0 && !engine->stopping)
+        {
+            pthread_cond_wait(&engine->work_ready, &engine->lock);
+        }
+        if (engine->queued.count == 0)
+        {
+            break;
+        }
+        req = &engine->requests[queue_pop(&engine->queued)];
+        pthread_mutex_unlock(&engine->lock);
+
+        read_header_sync(req);
+
+        pthread_mutex_lock(&engine->lock);
+        req->stage = REQUEST_COMPLETE;
+        queue_push(&engine->done, (unsigned int)(req - engine->requests));
+        pthread_cond_signal(&engine->request_done);
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    return NULL;
+}
+
+#if defined(PREFETCH_HAVE_IO_URING)
+/*****************************************************************************
+* NAME:  uring_init
+* DESCRIPTION: Set up an io_uring instance and map its rings
+* RETURNS: 0 on success, -1 if io_uring is unavailable
+******************************************************************************/
+static int
+uring_init
+    (uring_t       *ring        /* [out] io_uring instance */
+    ,unsigned int   entries     /* [in] minimum number of submission entries */
+    )
+{
+    struct io_uring_params  p;
+    char                   *p_sq;
+    char                   *p_cq;
+
+    memset(ring, 0, sizeof(uring_t));
+    memset(&p, 0, sizeof(struct io_uring_params));
+    ring->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (ring->fd < 0)
+    {
+        return -1;
+    }
+
+    ring->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+    ring->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (ring->cq_ring_size > ring->sq_ring_size)
+        {
+            ring->sq_ring_size = ring->cq_ring_size;
+        }
+        ring->cq_ring_size = ring->sq_ring_size;
+    }
+
+    ring->p_sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                           ring->fd, IORING_OFF_SQ_RING);
+    if (ring->p_sq_ring == MAP_FAILED)
+    {
+        close(ring->fd);
+        return -1;
+    }
+    ring->p_cq_ring = ring->p_sq_ring;
+    if (!(p.features & IORING_FEAT_SINGLE_MMAP))
+    {
+        ring->p_cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                               ring->fd, IORING_OFF_CQ_RING);
+        if (ring->p_cq_ring == MAP_FAILED)
+        {
+            munmap(ring->p_sq_ring, ring->sq_ring_size);
+            close(ring->fd);
+            return -1;
+        }
+    }
+
+    ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED)
+    {
+        if (ring->p_cq_ring != ring->p_sq_ring)
+        {
+            munmap(ring->p_cq_ring, ring->cq_ring_size);
+        }
+        munmap(ring->p_sq_ring, ring->sq_ring_size);
+        close(ring->fd);
+        return -1;
+    }
+
+    p_sq = ring->p_sq_ring;
+    p_cq = ring->p_cq_ring;
+    ring->sq_tail = (unsigned int *)(p_sq + p.sq_off.tail);
+    ring->sq_mask = (unsigned int *)(p_sq + p.sq_off.ring_mask);
+    ring->sq_array = (unsigned int *)(p_sq + p.sq_off.array);
+    ring->cq_head = (unsigned int *)(p_cq + p.cq_off.head);
+    ring->cq_tail = (unsigned int *)(p_cq + p.cq_off.tail);
+    ring->cq_mask = (unsigned int *)(p_cq + p.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(p_cq + p.cq_off.cqes);
+
+    return 0;
+}
+
+/*****************************************************************************
+* NAME:  uring_free
+* DESCRIPTION: Unmap the rings of an io_uring instance and close it
+* RETURNS: none
+******************************************************************************/
+static void
+uring_free
+    (uring_t       *ring        /* [in,out] io_uring instance */
+    )
+{
+    munmap(ring->sqes, ring->sqes_size);
+    if (ring->p_cq_ring != ring->p_sq_ring)
+    {
+        munmap(ring->p_cq_ring, ring->cq_ring_size);
+    }
+    munmap(ring->p_sq_ring, ring->sq_ring_size);
+    close(ring->fd);
+}
+
+/*****************************************************************************
+* NAME:  uring_queue
+* DESCRIPTION: Add an open or read to the submission ring. Each request has
+*              at most one operation in flight, so the ring cannot overflow.
+* RETURNS: none
+******************************************************************************/
+static void
+uring_queue
+    (uring_t           *ring        /* [in,out] io_uring instance */
+    ,unsigned char      opcode      /* [in] IORING_OP_OPENAT or IORING_OP_READ */
+    ,int                fd          /* [in] file to read, or AT_FDCWD to open */
+    ,const void        *p_addr      /* [in] file name to open or buffer to read into */
+    ,unsigned int       length      /* [in] number of bytes to read */
+    ,unsigned long long offset      /* [in] file offset to read from */
+    ,unsigned int       index       /* [in] request index returned in the completion */
+    )
+{
+    struct io_uring_sqe    *sqe;
+    unsigned int            tail = *ring->sq_tail;
+    unsigned int            slot = tail & *ring->sq_mask;
+
+    sqe = &ring->sqes[slot];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = (unsigned long long)(size_t)p_addr;
+    sqe->len = length;
+    sqe->off = offset;
+    sqe->user_data = index;
+    if (opcode == IORING_OP_OPENAT)
+    {
+        sqe->open_flags = O_RDONLY;
+    }
+    ring->sq_array[slot] = slot;
+
+    /* publish the entry before the kernel can see the new tail */
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->num_pending++;
+}
+
+/*****************************************************************************
+* NAME:  uring_complete
+* DESCRIPTION: Advance a request after one of its operations completed,
+*              queueing its next operation if it has one
+* RETURNS: none
+******************************************************************************/
+static void
+uring_complete
+    (prefetch_t    *engine      /* [in,out] I/O engine */
+    ,unsigned int   index       /* [in] request index */
+    ,int            result      /* [in] completion result: fd, bytes read or -errno */
+    )
+{
+    prefetch_request_t *req = &engine->requests[index];
+    size_t              target;
+
+    if (result < 0)
+    {
+        req->error = ASFPARSE_ERROR_OPEN_FILE;
+    }
+    else if (req->stage == REQUEST_OPEN)
+    {
+        /* operations run asynchronously, so they are counted, not timed */
+        INSTRUMENT_COUNT(INSTRUMENT_IO_OPEN, 0);
+        req->fd = result;
+        req->stage = REQUEST_READ_FIRST;
+        uring_queue(&engine->ring, IORING_OP_READ, req->fd, req->p_data, PREFETCH_FIRST_READ_SIZE, 0, index);
+        return;
+    }
+    else
+    {
+        INSTRUMENT_COUNT(INSTRUMENT_IO_URING, result);
+        req->size += (size_t)result;
+
+        /* continue a short read from where it stopped until the end of the
+           file, as read_at does */
+        target = (req->stage == REQUEST_READ_FIRST) ? PREFETCH_FIRST_READ_SIZE : req->wanted;
+        if (result > 0 && req->size < target)
+        {
+            uring_queue(&engine->ring, IORING_OP_READ, req->fd, req->p_data + req->size,
+                        (unsigned int)(target - req->size), req->size, index);
+            return;
+        }
+
+        if (req->stage == REQUEST_READ_FIRST)
+        {
+            req->error = header_read_size(req->p_data, req->size, &req->wanted);
+            if (req->error == ASFPARSE_ERROR_OK && req->size == PREFETCH_FIRST_READ_SIZE && req->wanted > req->size)
+            {
+                req->error = grow_request(req, req->wanted);
+                if (req->error == ASFPARSE_ERROR_OK)
+                {
+                    req->stage = REQUEST_READ_REST;
+                    uring_queue(&engine->ring, IORING_OP_READ, req->fd, req->p_data + req->size,
+                                (unsigned int)(req->wanted - req->size), req->size, index);
+                    return;
+                }
+            }
+        }
+    }
+
+    if (req->fd >= 0)
+    {
+        close(req->fd);
+        req->fd = -1;
+    }
+    req->stage = REQUEST_COMPLETE;
+    queue_push(&engine->done, index);
+}
+
+/*****************************************************************************
+* NAME:  uring_reap
+* DESCRIPTION: Handle every completion available in the completion queue
+* RETURNS: number of completions handled
+******************************************************************************/
+static unsigned int
+uring_reap
+    (prefetch_t    *engine      /* [in,out] I/O engine */
+    )
+{
+    uring_t            *ring = &engine->ring;
+    struct io_uring_cqe *cqe;
+    unsigned int        head;
+    unsigned int        tail;
+    unsigned int        num_reaped;
+
+    head = *ring->cq_head;
+    tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail)
+    {
+        cqe = &ring->cqes[head & *ring->cq_mask];
+        uring_complete(engine, (unsigned int)cqe->user_data, cqe->res);
+        head++;
+    }
+    num_reaped = head - *ring->cq_head;
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+    return num_reaped;
+}
+
+/*****************************************************************************
+* NAME:  uring_run
+* DESCRIPTION: Submit the queued operations, wait for at least one to
+*              complete and handle every completion available
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+uring_run
+    (prefetch_t    *engine      /* [in,out] I/O engine */
+    )
+{
+    uring_t    *ring = &engine->ring;
+    long        n;
+    int         num_retries = 0;
+
+    for (;;)
+    {
+        n = syscall(__NR_io_uring_enter, ring->fd, ring->num_pending, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+        if (n >= 0)
+        {
+            break;
+        }
+        if (errno == EINTR)
+        {
+            continue;
+        }
+
+        /* the kernel is short of resources or its completion queue is
+           full: make room by handling the completions already posted, and
+           try again while it keeps failing for that reason */
+        if ((errno != EAGAIN && errno != EBUSY) || ++num_retries > URING_MAX_RETRIES)
+        {
+            return ASFPARSE_ERROR_OPEN_FILE;
+        }
+        if (uring_reap(engine) > 0)
+        {
+            return ASFPARSE_ERROR_OK;
+        }
+        sched_yield();
+    }
+    ring->num_pending -= (unsigned int)n;
+
+    (void)uring_reap(engine);
+
+    return ASFPARSE_ERROR_OK;
+}
+#endif
+
+/*****************************************************************************
+* NAME:  prefetch_create
+* DESCRIPTION: Create an I/O engine for header reads
+* RETURNS: new engine, or NULL if memory is exhausted
+******************************************************************************/
+prefetch_t *
+prefetch_create
+    (unsigned int   queue_depth     /* [in] maximum number of files in flight */
+    )
+{
+    prefetch_t     *engine;
+    unsigned int    i;
+    int             num_threads;
+
+    if (queue_depth == 0)
+    {
+        return NULL;
+    }
+
+    engine = calloc(1, sizeof(prefetch_t));
+    if (engine == NULL)
+    {
+        return NULL;
+    }
+    engine->depth = queue_depth;
+    engine->requests = calloc(queue_depth, sizeof(prefetch_request_t));
+    engine->free.items = calloc(queue_depth, sizeof(unsigned int));
+    engine->queued.items = calloc(queue_depth, sizeof(unsigned int));
+    engine->done.items = calloc(queue_depth, sizeof(unsigned int));
+    if (engine->requests == NULL || engine->free.items == NULL
+        || engine->queued.items == NULL || engine->done.items == NULL)
+    {
+        free(engine->requests);
+        free(engine->free.items);
+        free(engine->queued.items);
+        free(engine->done.items);
+        free(engine);
+        return NULL;
+    }
+    engine->free.capacity = queue_depth;
+    engine->queued.capacity = queue_depth;
+    engine->done.capacity = queue_depth;
+    for (i = 0; i < queue_depth; i++)
+    {
+        engine->requests[i].fd = -1;
+        queue_push(&engine->free, i);
+    }
+    pthread_mutex_init(&engine->lock, NULL);
+    pthread_cond_init(&engine->work_ready, NULL);
+    pthread_cond_init(&engine->request_done, NULL);
+
+#if defined(PREFETCH_HAVE_IO_URING)
+    /* a single thread drives every request through the ring */
+    if (uring_init(&engine->ring, queue_depth) == 0)
+    {
+        engine->use_uring = 1;
+        return engine;
+    }
+#endif
+
+    /* otherwise the queue depth comes from blocking reader threads */
+    num_threads = (queue_depth < PREFETCH_MAX_THREADS) ? (int)queue_depth : PREFETCH_MAX_THREADS;
+    for (engine->num_threads = 0; engine->num_threads < num_threads; engine->num_threads++)
+    {
+        if (pthread_create(&engine->threads[engine->num_threads], NULL, prefetch_thread, engine) != 0)
+        {
+            break;
+        }
+    }
+    if (engine->num_threads == 0)
+    {
+        prefetch_destroy(engine);
+        return NULL;
+    }
+
+    return engine;
+}
+
+/*****************************************************************************
+* NAME:  prefetch_destroy
+* DESCRIPTION: Release an I/O engine
+* RETURNS: none
+******************************************************************************/
+void
+prefetch_destroy
+    (prefetch_t    *engine      /* [in] I/O engine */
+    )
+{
+    unsigned int    i;
+
+    if (engine == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    engine->stopping = 1;
+    pthread_cond_broadcast(&engine->work_ready);
+    pthread_mutex_unlock(&engine->lock);
+    while (engine->num_threads > 0)
+    {
+        pthread_join(engine->threads[--engine->num_threads], NULL);
+    }
+
+#if defined(PREFETCH_HAVE_IO_URING)
+    if (engine->use_uring)
+    {
+        uring_free(&engine->ring);
+    }
+#endif
+
+    for (i = 0; i < engine->depth; i++)
+    {
+        free(engine->requests[i].p_data);
+    }
+    free(engine->requests);
+    free(engine->free.items);
+    free(engine->queued.items);
+    free(engine->done.items);
+    pthread_cond_destroy(&engine->request_done);
+    pthread_cond_destroy(&engine->work_ready);
+    pthread_mutex_destroy(&engine->lock);
+    free(engine);
+}
+
+/*****************************************************************************
+* NAME:  prefetch_submit
+* DESCRIPTION: Start reading the Header Object of a file
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+prefetch_submit
+    (prefetch_t    *engine      /* [in,out] I/O engine */
+    ,const char    *p_filename  /* [in] name of file to read */
+    ,void          *p_tag       /* [in] pointer returned with the result */
+    )
+{
+    prefetch_request_t *req;
+    unsigned int        index;
+
+    /* only the submitting thread takes and returns free requests */
+    if (engine == NULL || p_filename == NULL || engine->free.count == 0)
+    {
+        return ASFPARSE_ERROR_INVALID_ARG;
+    }
+    index = engine->free.items[engine->free.head];
+    req = &engine->requests[index];
+    req->p_data = malloc(PREFETCH_FIRST_READ_SIZE);
+    if (req->p_data == NULL)
+    {
+        return ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
+    (void)queue_pop(&engine->free);
+
+    req->p_filename = p_filename;
+    req->p_tag = p_tag;
+    req->fd = -1;
+    req->size = 0;
+    req->error = ASFPARSE_ERROR_OK;
+
+#if defined(PREFETCH_HAVE_IO_URING)
+    if (engine->use_uring)
+    {
+        req->stage = REQUEST_OPEN;
+        uring_queue(&engine->ring, IORING_OP_OPENAT, AT_FDCWD, p_filename, 0, 0, index);
+        return ASFPARSE_ERROR_OK;
+    }
+#endif
+
+    pthread_mutex_lock(&engine->lock);
+    req->stage = REQUEST_QUEUED;
+    queue_push(&engine->queued, index);
+    pthread_cond_signal(&engine->work_ready);
+    pthread_mutex_unlock(&engine->lock);
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  prefetch_wait
+* DESCRIPTION: Wait for any submitted file to finish
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+prefetch_wait
+    (prefetch_t        *engine      /* [in,out] I/O engine */
+    ,prefetch_result_t *result      /* [out] finished file */
+    )
+{
+    prefetch_request_t *req;
+    unsigned int        index;
+    INSTRUMENT_DECLARE(start);
+
+    if (engine == NULL || result == NULL || engine->free.count == engine->depth)
+    {
+        return ASFPARSE_ERROR_INVALID_ARG;
+    }
+    INSTRUMENT_START(start);
+
+#if defined(PREFETCH_HAVE_IO_URING)
+    if (engine->use_uring)
+    {
+        asfparse_error_t    error;
+
+        while (engine->done.count == 0)
+        {
+            error = uring_run(engine);
+            if (error)
+            {
+                return error;
+            }
+        }
+    }
+#endif
+
+    pthread_mutex_lock(&engine->lock);
+    while (engine->done.count == 0)
+    {
+        pthread_cond_wait(&engine->request_done, &engine->lock);
+    }
+    index = queue_pop(&engine->done);
+    pthread_mutex_unlock(&engine->lock);
+    INSTRUMENT_STOP(INSTRUMENT_IO_WAIT, start, 0);
+
+    /* hand the buffer over to the caller */
+    req = &engine->requests[index];
+    result->p_tag = req->p_tag;
+    result->error = req->error;
+    result->p_data = req->p_data;
+    result->size = req->size;
+    req->p_data = NULL;
+    req->stage = REQUEST_FREE;
+    queue_push(&engine->free, index);
+
+    return ASFPARSE_ERROR_OK;
+}
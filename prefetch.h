@@ -0,0 +1,80 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+/* Includes */
+#include <stddef.h>
+#include "util.h"
+
+/* Defines and constants */
+#define PREFETCH_FIRST_READ_SIZE    (4096)              /* bytes read before the header size is known */
+#define PREFETCH_MAX_HEADER_SIZE    (16 * 1024 * 1024)  /* largest Header Object read; a larger one fails the read */
+#define PREFETCH_MAX_THREADS        (64)                /* reader threads when io_uring is unavailable */
+
+/* Enums and structs */
+/* Structure describing a finished header read. p_data belongs to the
+   caller, who must release it with free(). */
+typedef struct {
+    void               *p_tag;      /* caller's pointer given to prefetch_submit */
+    asfparse_error_t    error;      /* ASFPARSE_ERROR_OK, or why the file could not be read */
+    char               *p_data;     /* bytes read from the start of the file, or NULL */
+    size_t              size;       /* number of bytes in p_data */
+} prefetch_result_t;
+
+/* Opaque I/O engine that keeps many header reads in flight, using io_uring
+   where the kernel supports it and a pool of threads calling pread()
+   otherwise */
+typedef struct prefetch_s prefetch_t;
+
+/* Function prototypes */
+/*****************************************************************************
+* NAME:  prefetch_create
+* DESCRIPTION: Create an I/O engine for header reads
+* RETURNS: new engine, or NULL if memory is exhausted
+******************************************************************************/
+prefetch_t *
+prefetch_create
+    (unsigned int   queue_depth     /* [in] maximum number of files in flight */
+    );
+
+/*****************************************************************************
+* NAME:  prefetch_destroy
+* DESCRIPTION: Release an I/O engine. Every submitted file must have been
+*              returned by prefetch_wait.
+* RETURNS: none
+******************************************************************************/
+void
+prefetch_destroy
+    (prefetch_t    *engine      /* [in] I/O engine */
+    );
+
+/*****************************************************************************
+* NAME:  prefetch_submit
+* DESCRIPTION: Start reading the Header Object of a file: the first
+*              PREFETCH_FIRST_READ_SIZE bytes, then, if the header is larger,
+*              one more read for the rest of it. A Header Object larger than
+*              PREFETCH_MAX_HEADER_SIZE is not read, and its result has the
+*              error ASFPARSE_ERROR_OUT_OF_MEMORY. p_filename must stay
+*              valid until the result is returned by prefetch_wait.
+* RETURNS: asfparse_error_t; ASFPARSE_ERROR_INVALID_ARG if queue_depth files
+*          are already in flight
+******************************************************************************/
+asfparse_error_t
+prefetch_submit
+    (prefetch_t    *engine      /* [in,out] I/O engine */
+    ,const char    *p_filename  /* [in] name of file to read */
+    ,void          *p_tag       /* [in] pointer returned with the result */
+    );
+
+/*****************************************************************************
+* NAME:  prefetch_wait
+* DESCRIPTION: Wait for any submitted file to finish, in completion order
+* RETURNS: asfparse_error_t; ASFPARSE_ERROR_INVALID_ARG if nothing is in
+*          flight
+******************************************************************************/
+asfparse_error_t
+prefetch_wait
+    (prefetch_t        *engine      /* [in,out] I/O engine */
+    ,prefetch_result_t *result      /* [out] finished file */
+    );
+
+#endif
@@ -0,0 +1,571 @@
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "util.h"
+#include "packet.h"
+#include "index.h"
+#include "streamstats.h"
+#include "display.h"
+#include "json.h"
+#include "instrument.h"
+#include "process.h"
+
+/* Defines and constants */
+#define STDIN_FILENAME          "-"             /* file name that reads the ASF stream from stdin */
+#define PUSH_CHUNK_SIZE         (64 * 1024)     /* bytes read from a stream at a time */
+
+/* Structure describing what the CLI keeps while a file's events arrive */
+typedef struct {
+    const params_t             *params;             /* user-defined parameters */
+    output_t                   *out;                /* buffer receiving the formatted text */
+    unsigned int                display_mask;       /* OBJECT_MASK bits of the objects to display */
+    file_properties_object_t    file_properties;    /* copy of the file properties object */
+    data_object_t               data;               /* copy of the data object */
+    long long                   data_offset;        /* file offset of the data object */
+    packet_summary_t            summary;            /* payload counts of the data packets */
+    stream_analysis_t           analysis;           /* per-stream statistics, if params->analyze */
+    int                         have_packets;       /* non-zero once the packet walk has ended */
+    seek_table_t                table;              /* seek table built from the first index */
+    int                         have_table;         /* non-zero once table is valid */
+    asfparse_error_t            error;              /* first error found while handling events */
+    int                         num_elements;       /* JSON objects written to the objects array */
+    asfparse_event_t            error_event;        /* JSON: the error to report, if kind is ASFPARSE_EVENT_ERROR */
+} display_state_t;
+
+/*****************************************************************************
+* NAME:  record_error
+* DESCRIPTION: Remember the first error of a file for the JSON output, which
+*              reports it after all objects
+* RETURNS: none
+******************************************************************************/
+static void
+record_error
+    (display_state_t   *state       /* [in,out] display state */
+    ,object_type_t      type        /* [in] object being processed */
+    ,asfparse_error_t   error       /* [in] error */
+    ,long long          offset      /* [in] file offset of the object */
+    ,long long          packet_number   /* [in] number of the bad data packet, or -1 */
+    )
+{
+    if (state->error_event.kind == ASFPARSE_EVENT_ERROR)
+    {
+        return;
+    }
+
+    memset(&state->error_event, 0, sizeof(asfparse_event_t));
+    state->error_event.kind = ASFPARSE_EVENT_ERROR;
+    state->error_event.type = type;
+    state->error_event.error = error;
+    state->error_event.offset = offset;
+    state->error_event.packet_number = packet_number;
+}
+
+/*****************************************************************************
+* NAME:  build_seek_table
+* DESCRIPTION: Build the seek table from the first index object reported.
+*              Index entries only map to packet numbers and offsets when the
+*              data packets are of a fixed size, so no table is built for a
+*              file whose packets vary in size.
+* RETURNS: none
+******************************************************************************/
+static void
+build_seek_table
+    (display_state_t           *state       /* [in,out] display state */
+    ,const asfparse_event_t    *event       /* [in] simple index or index object event */
+    )
+{
+    unsigned int    packet_size = (unsigned int)state->file_properties.min_data_packet_size;
+
+    if (state->have_table || state->params->seek_time < 0
+        || state->file_properties.min_data_packet_size != state->file_properties.max_data_packet_size)
+    {
+        return;
+    }
+
+    if (event->type == OBJECT_TYPE_SIMPLE_INDEX)
+    {
+        state->error = seek_table_from_simple_index(&state->table, event->object, &state->data, packet_size);
+    }
+    else
+    {
+        state->error = seek_table_from_index(&state->table, event->object, 0, &state->data, packet_size);
+    }
+    state->have_table = (state->error == ASFPARSE_ERROR_OK);
+    if (!state->have_table)
+    {
+        record_error(state, event->type, state->error, event->offset, -1);
+    }
+}
+
+/*****************************************************************************
+* NAME:  track_event
+* DESCRIPTION: Keep what later events and the seek lookup need, whatever the
+*              output format
+* RETURNS: non-zero if the event should be displayed
+******************************************************************************/
+static int
+track_event
+    (display_state_t           *state       /* [in,out] display state */
+    ,const asfparse_event_t    *event       /* [in] event */
+    )
+{
+    switch (event->kind)
+    {
+    case ASFPARSE_EVENT_OBJECT:
+        if (event->type == OBJECT_TYPE_FILE_PROPERTIES)
+        {
+            state->file_properties = *(const file_properties_object_t *)event->object;
+        }
+        else if (event->type == OBJECT_TYPE_DATA)
+        {
+            state->data = *(const data_object_t *)event->object;
+            state->data_offset = event->offset;
+        }
+        else if (event->type == OBJECT_TYPE_STREAM_BITRATE_PROPERTIES && state->params->analyze)
+        {
+            stream_analysis_add_bitrates(&state->analysis, event->object);
+        }
+        else if (event->type == OBJECT_TYPE_SIMPLE_INDEX || event->type == OBJECT_TYPE_INDEX)
+        {
+            build_seek_table(state, event);
+        }
+
+        /* the data object is displayed with its packet summary */
+        return event->type != OBJECT_TYPE_DATA
+               && (state->display_mask & OBJECT_MASK(event->type)) != 0;
+    case ASFPARSE_EVENT_UNKNOWN_OBJECT:
+        return state->params->object_mask == 0;
+    case ASFPARSE_EVENT_DATA_PACKET:
+        packet_summary_add(&state->summary, event->object);
+        if (state->params->analyze)
+        {
+            stream_analysis_add_packet(&state->analysis, event->object);
+        }
+        return 0;
+    case ASFPARSE_EVENT_PACKET_SUMMARY:
+        state->summary = *(const packet_summary_t *)event->object;
+        return 0;
+    case ASFPARSE_EVENT_ERROR:
+        record_error(state, event->type, event->error, event->offset, event->packet_number);
+        return 1;
+    case ASFPARSE_EVENT_DATA_END:
+        state->have_packets = 1;
+        return 1;
+    default:
+        return 1;
+    }
+}
+
+/*****************************************************************************
+* NAME:  display_event
+* DESCRIPTION: Format one parse event as text, implementing
+*              asfparse_callback_t
+* RETURNS: non-zero to stop parsing
+******************************************************************************/
+static int
+display_event
+    (void                      *p_user      /* [in] display state */
+    ,const asfparse_event_t    *event       /* [in] event */
+    )
+{
+    display_state_t    *state = p_user;
+    output_t           *out = state->out;
+    INSTRUMENT_DECLARE(start);
+
+    if (!track_event(state, event))
+    {
+        return state->error != ASFPARSE_ERROR_OK;
+    }
+
+    INSTRUMENT_START(start);
+    switch (event->kind)
+    {
+    case ASFPARSE_EVENT_OBJECT:
+        switch (event->type)
+        {
+        case OBJECT_TYPE_HEADER:
+            display_header_object((header_object_t *)event->object, out);
+            break;
+        case OBJECT_TYPE_FILE_PROPERTIES:
+            display_file_properties_object(&state->file_properties, out);
+            break;
+        case OBJECT_TYPE_STREAM_PROPERTIES:
+            display_stream_properties_object((stream_properties_object_t *)event->object, out);
+            break;
+        case OBJECT_TYPE_HEADER_EXTENSION:
+            display_header_extension_object((header_extension_object_t *)event->object, out);
+            break;
+        case OBJECT_TYPE_CODEC_LIST:
+            display_codec_list_object((codec_list_object_t *)event->object, out);
+            break;
+        case OBJECT_TYPE_EXTENDED_CONTENT_DESCRIPTION:
+            display_extended_content_description_object((extended_content_description_object_t *)event->object, out);
+            break;
+        case OBJECT_TYPE_STREAM_BITRATE_PROPERTIES:
+            display_stream_bitrate_properties_object((stream_bitrate_properties_object_t *)event->object, out);
+            break;
+        case OBJECT_TYPE_SIMPLE_INDEX:
+            display_simple_index_object((simple_index_object_t *)event->object, out);
+            break;
+        case OBJECT_TYPE_INDEX:
+            display_index_object((index_object_t *)event->object, out);
+            break;
+        case OBJECT_TYPE_NONE:
+        case OBJECT_TYPE_DATA:
+        default:
+            break;
+        }
+        break;
+    case ASFPARSE_EVENT_UNKNOWN_OBJECT:
+        display_unknown_object(event->guid, event->object_size, out);
+        break;
+    case ASFPARSE_EVENT_DATA_END:
+        display_data_object(&state->data, &state->summary, out);
+        break;
+    case ASFPARSE_EVENT_ERROR:
+        display_error(event, out);
+        break;
+    case ASFPARSE_EVENT_DATA_PACKET:
+    case ASFPARSE_EVENT_PACKET_SUMMARY:
+    default:
+        break;
+    }
+    INSTRUMENT_STOP(INSTRUMENT_FORMAT_TEXT, start, 0);
+
+    /* stop at the first index that cannot be turned into a seek table */
+    return state->error != ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  display_json_event
+* DESCRIPTION: Format one parse event as an element of the JSON objects
+*              array, implementing asfparse_callback_t
+* RETURNS: non-zero to stop parsing
+******************************************************************************/
+static int
+display_json_event
+    (void                      *p_user      /* [in] display state */
+    ,const asfparse_event_t    *event       /* [in] event */
+    )
+{
+    display_state_t    *state = p_user;
+    output_t           *out = state->out;
+    INSTRUMENT_DECLARE(start);
+
+    /* errors are reported after the objects array */
+    if (!track_event(state, event) || event->kind == ASFPARSE_EVENT_ERROR)
+    {
+        return state->error != ASFPARSE_ERROR_OK;
+    }
+
+    INSTRUMENT_START(start);
+    if (state->num_elements++ > 0)
+    {
+        output_write(out, ",", 1);
+    }
+
+    switch (event->kind)
+    {
+    case ASFPARSE_EVENT_OBJECT:
+        switch (event->type)
+        {
+        case OBJECT_TYPE_HEADER:
+            json_header_object(event->object, event->offset, out);
+            break;
+        case OBJECT_TYPE_FILE_PROPERTIES:
+            json_file_properties_object(event->object, event->offset, out);
+            break;
+        case OBJECT_TYPE_STREAM_PROPERTIES:
+            json_stream_properties_object(event->object, event->offset, out);
+            break;
+        case OBJECT_TYPE_HEADER_EXTENSION:
+            json_header_extension_object(event->object, event->offset, out);
+            break;
+        case OBJECT_TYPE_CODEC_LIST:
+            json_codec_list_object(event->object, event->offset, out);
+            break;
+        case OBJECT_TYPE_EXTENDED_CONTENT_DESCRIPTION:
+            json_extended_content_description_object(event->object, event->offset, out);
+            break;
+        case OBJECT_TYPE_STREAM_BITRATE_PROPERTIES:
+            json_stream_bitrate_properties_object(event->object, event->offset, out);
+            break;
+        case OBJECT_TYPE_SIMPLE_INDEX:
+            json_simple_index_object(event->object, event->offset, out);
+            break;
+        case OBJECT_TYPE_INDEX:
+            json_index_object(event->object, event->offset, out);
+            break;
+        case OBJECT_TYPE_NONE:
+        case OBJECT_TYPE_DATA:
+        default:
+            break;
+        }
+        break;
+    case ASFPARSE_EVENT_UNKNOWN_OBJECT:
+        json_unknown_object(event->guid, event->offset, event->object_size, out);
+        break;
+    case ASFPARSE_EVENT_DATA_END:
+        json_data_object(&state->data, &state->summary, state->data_offset, out);
+        break;
+    case ASFPARSE_EVENT_DATA_PACKET:
+    case ASFPARSE_EVENT_PACKET_SUMMARY:
+    case ASFPARSE_EVENT_ERROR:
+    default:
+        break;
+    }
+    INSTRUMENT_STOP(INSTRUMENT_FORMAT_JSON, start, 0);
+
+    return state->error != ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  push_stream
+* DESCRIPTION: Read an ASF stream from a file descriptor in chunks and push
+*              it through the parser, stopping once nothing more is needed
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+push_stream
+    (asfparse_ctx_t        *ctx         /* [in,out] parser context */
+    ,int                    fd          /* [in] descriptor to read the stream from */
+    ,asfparse_callback_t    callback    /* [in] function receiving parse events */
+    ,void                  *p_user      /* [in] pointer passed through to the callback */
+    )
+{
+    asfparse_error_t    error;
+    asfparse_error_t    end_error;
+    char                buffer[PUSH_CHUNK_SIZE];
+    ssize_t             num_read;
+    INSTRUMENT_DECLARE(start);
+
+    error = asfparse_push_begin(ctx, callback, p_user);
+    while (error == ASFPARSE_ERROR_OK && !asfparse_push_done(ctx))
+    {
+        INSTRUMENT_START(start);
+        num_read = read(fd, buffer, sizeof(buffer));
+        INSTRUMENT_STOP(INSTRUMENT_IO_READ, start, (num_read > 0) ? num_read : 0);
+        if (num_read < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (num_read < 0)
+        {
+            error = ASFPARSE_ERROR_OPEN_FILE;
+            break;
+        }
+        if (num_read == 0)
+        {
+            break;
+        }
+        error = asfparse_push_feed(ctx, buffer, (size_t)num_read);
+    }
+
+    end_error = asfparse_push_end(ctx);
+
+    return (error != ASFPARSE_ERROR_OK) ? error : end_error;
+}
+
+/*****************************************************************************
+* NAME:  process_input
+* DESCRIPTION: Parse every object in an ASF file held in memory, or read
+*              from the named file or stdin, and append the formatted results,
+*              including any error message, to an output buffer
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+process_input
+    (const char        *p_filename  /* [in] name of ASF file to parse */
+    ,const char        *p_data      /* [in] file contents, or NULL to read the file */
+    ,size_t             size        /* [in] number of bytes in p_data */
+    ,const params_t    *params      /* [in] structure containing user-defined parameters */
+    ,asfparse_ctx_t    *ctx         /* [in,out] parser context created with process_create_context */
+    ,output_t          *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    asfparse_error_t    error;
+    seek_position_t     position;
+    display_state_t     state;
+    int                 is_json = (params->output_format == OUTPUT_FORMAT_JSON);
+
+    memset(&state, 0, sizeof(display_state_t));
+    state.params = params;
+    state.out = out;
+    state.display_mask = params->object_mask ? params->object_mask : ~0u;
+    stream_analysis_init(&state.analysis);
+
+    /* print ASF file name */
+    if (is_json)
+    {
+        output_write(out, "{\"file\":", 8);
+        json_write_string(out, p_filename, strlen(p_filename));
+        output_write(out, ",\"objects\":[", 12);
+    }
+    else
+    {
+        output_printf(out, "PARSING ASF FILE:\n    %s\n", p_filename);
+        output_printf(out, "\n--------------------------------------------------\n");
+    }
+
+    if (p_data != NULL)
+    {
+        error = asfparse_parse_buffer(ctx, p_data, size, is_json ? display_json_event : display_event, &state);
+    }
+    else if (strcmp(p_filename, STDIN_FILENAME) == 0)
+    {
+        error = push_stream(ctx, STDIN_FILENO, is_json ? display_json_event : display_event, &state);
+    }
+    else
+    {
+        error = asfparse_parse_file(ctx, p_filename, is_json ? display_json_event : display_event, &state);
+    }
+    if (error == ASFPARSE_ERROR_OK)
+    {
+        error = state.error;
+    }
+    if (is_json)
+    {
+        output_write(out, "]", 1);
+    }
+
+    /* report the statistics of the packets walked, even if the walk
+       stopped at a bad packet */
+    if (params->analyze && state.have_packets)
+    {
+        stream_analysis_finish(&state.analysis);
+        if (is_json)
+        {
+            output_write(out, ",\"analysis\":", 12);
+            json_stream_analysis(&state.analysis, out);
+        }
+        else
+        {
+            display_stream_analysis(&state.analysis, out);
+        }
+    }
+
+    /* answer the seek request from the index */
+    if (error == ASFPARSE_ERROR_OK && params->seek_time >= 0)
+    {
+        if (!state.have_table)
+        {
+            error = ASFPARSE_ERROR_OBJECT_NOT_FOUND;
+            record_error(&state, OBJECT_TYPE_INDEX, error, 0, -1);
+            if (!is_json)
+            {
+                output_printf(out, "Error seeking: file has no index%s\n"
+                             ,(state.file_properties.min_data_packet_size != state.file_properties.max_data_packet_size)
+                                 ? " usable with variable-size data packets" : "");
+            }
+        }
+        else
+        {
+            error = seek_table_lookup(&state.table, params->seek_time, &position);
+            if (error != ASFPARSE_ERROR_OK)
+            {
+                record_error(&state, OBJECT_TYPE_INDEX, error, 0, -1);
+                if (!is_json)
+                {
+                    output_printf(out, "Error seeking to %lld ms\n", params->seek_time);
+                }
+            }
+            else if (is_json)
+            {
+                output_write(out, ",\"seek\":", 8);
+                json_seek_position(params->seek_time, &state.table, &position, out);
+            }
+            else
+            {
+                display_seek_position(params->seek_time, &state.table, &position, out);
+            }
+        }
+    }
+
+    if (is_json)
+    {
+        if (state.error_event.kind == ASFPARSE_EVENT_ERROR)
+        {
+            output_write(out, ",\"error\":", 9);
+            json_error(&state.error_event, out);
+        }
+        output_write(out, "}\n", 2);
+    }
+
+    seek_table_free(&state.table);
+
+    return error;
+}
+
+/*****************************************************************************
+* NAME:  process_file
+* DESCRIPTION: Parse every object in an ASF file, or in a stream read from
+*              stdin if the name is "-", and append the formatted results,
+*              including any error message, to an output buffer
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+process_file
+    (const char        *p_filename  /* [in] name of ASF file to parse */
+    ,const params_t    *params      /* [in] structure containing user-defined parameters */
+    ,asfparse_ctx_t    *ctx         /* [in,out] parser context created with process_create_context */
+    ,output_t          *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    return process_input(p_filename, NULL, 0, params, ctx, out);
+}
+
+/*****************************************************************************
+* NAME:  process_buffer
+* DESCRIPTION: Parse every object in the start of an ASF file that was
+*              already read into memory and append the formatted results to
+*              an output buffer
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+process_buffer
+    (const char        *p_filename  /* [in] name of the ASF file, for display */
+    ,const char        *p_data      /* [in] bytes read from the start of the file */
+    ,size_t             size        /* [in] number of bytes in p_data */
+    ,const params_t    *params      /* [in] structure containing user-defined parameters */
+    ,asfparse_ctx_t    *ctx         /* [in,out] parser context created with process_create_context */
+    ,output_t          *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    return process_input(p_filename, (p_data != NULL) ? p_data : "", size, params, ctx, out);
+}
+
+/*****************************************************************************
+* NAME:  process_create_context
+* DESCRIPTION: Create a parser context configured from the user-defined
+*              parameters
+* RETURNS: new context, or NULL if memory is exhausted
+******************************************************************************/
+asfparse_ctx_t *
+process_create_context
+    (const params_t    *params      /* [in] structure containing user-defined parameters */
+    )
+{
+    asfparse_options_t  options;
+
+    memset(&options, 0, sizeof(asfparse_options_t));
+    options.object_mask = params->object_mask;
+    options.parse_packets = params->parse_packets;
+    options.parse_index = params->parse_index;
+
+    /* the analysis needs every packet in order, and the declared bitrates */
+    if (params->analyze)
+    {
+        options.packet_threads = 0;
+        if (options.object_mask != 0)
+        {
+            options.object_mask |= OBJECT_MASK(OBJECT_TYPE_STREAM_BITRATE_PROPERTIES);
+        }
+    }
+    else
+    {
+        options.packet_threads = params->packet_threads;
+    }
+
+    return asfparse_create(&options);
+}
@@ -0,0 +1,55 @@
+#ifndef PROCESS_H
+#define PROCESS_H
+
+/* Includes */
+#include "cli.h"
+#include "output.h"
+#include "asfparse.h"
+
+/* Function prototypes */
+/*****************************************************************************
+* NAME:  process_file
+* DESCRIPTION: Parse every object in an ASF file, or in a stream read from
+*              stdin if the name is "-", and append the formatted results,
+*              including any error message, to an output buffer.
+*              All parsing state is held in ctx, so this may run concurrently
+*              on several threads with distinct contexts and output buffers.
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+process_file
+    (const char        *p_filename  /* [in] name of ASF file to parse */
+    ,const params_t    *params      /* [in] structure containing user-defined parameters */
+    ,asfparse_ctx_t    *ctx         /* [in,out] parser context created with process_create_context */
+    ,output_t          *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  process_buffer
+* DESCRIPTION: Parse every object in the start of an ASF file that was
+*              already read into memory, such as just its Header Object, and
+*              append the formatted results to an output buffer
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+process_buffer
+    (const char        *p_filename  /* [in] name of the ASF file, for display */
+    ,const char        *p_data      /* [in] bytes read from the start of the file */
+    ,size_t             size        /* [in] number of bytes in p_data */
+    ,const params_t    *params      /* [in] structure containing user-defined parameters */
+    ,asfparse_ctx_t    *ctx         /* [in,out] parser context created with process_create_context */
+    ,output_t          *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  process_create_context
+* DESCRIPTION: Create a parser context configured from the user-defined
+*              parameters
+* RETURNS: new context, or NULL if memory is exhausted
+******************************************************************************/
+asfparse_ctx_t *
+process_create_context
+    (const params_t    *params      /* [in] structure containing user-defined parameters */
+    );
+
+#endif
@@ -0,0 +1,352 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cursor.h"
+#include "scan.h"
+#include "instrument.h"
+
+/* Enums and structs */
+/* Structure describing the chunks of packets a worker has not yet taken.
+   The owner takes chunks from the front and a thief takes half of what is
+   left from the back, each while holding the lock. */
+typedef struct {
+    pthread_mutex_t     lock;
+    long long           next_chunk;         /* first chunk not yet taken */
+    long long           end_chunk;          /* chunk after the last one not yet taken */
+} scan_queue_t;
+
+struct scan_job_s;
+
+/* Structure describing one worker and its partial results */
+typedef struct {
+    struct scan_job_s  *job;                /* packets being scanned */
+    int                 index;              /* position in job->workers */
+    scan_queue_t        queue;              /* chunks still to be decoded */
+    packet_summary_t    summary;            /* payload counts of the packets this worker decoded */
+    long long           first_packet;       /* lowest packet number decoded, or -1 */
+    long long           last_packet;        /* highest packet number decoded, or -1 */
+    unsigned int        first_send_time;    /* send time of first_packet (ms) */
+    unsigned int        last_send_time;     /* send time of last_packet (ms) */
+    asfparse_error_t    error;              /* first packet this worker could not decode */
+} scan_worker_t;
+
+/* Structure describing the packets shared out between the workers */
+typedef struct scan_job_s {
+    const char         *p_packets;          /* first byte of the first data packet */
+    unsigned int        packet_size;        /* fixed packet size */
+    long long           num_packets;        /* number of packets to decode */
+    scan_worker_t      *workers;            /* one entry per worker */
+    int                 num_workers;        /* number of entries in workers */
+} scan_job_t;
+
+/*****************************************************************************
+* NAME:  scan_serial
+* DESCRIPTION: Decode the data packets one after the other on the calling
+*              thread
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+scan_serial
+    (packet_summary_t                  *summary             /* [out] payload counts of the decoded packets */
+    ,const char                        *p_file_data         /* [in] first byte of the mapped ASF file */
+    ,const data_object_t               *data                /* [in] struct containing info about data object */
+    ,const file_properties_object_t    *file_properties     /* [in] struct containing info about file properties object */
+    ,size_t                            *bad_offset          /* [out] offset in p_file_data of the packet that failed */
+    )
+{
+    asfparse_error_t    error;
+    data_packet_t       packet;
+    packet_iterator_t   it;
+
+    memset(summary, 0, sizeof(packet_summary_t));
+    *bad_offset = data->packets_offset;
+
+    error = packet_iterator_init(&it, p_file_data, data, file_properties);
+    while (error == ASFPARSE_ERROR_OK && !packet_iterator_done(&it))
+    {
+        *bad_offset = data->packets_offset + it.cur.pos;
+        error = packet_iterator_next(&it, &packet);
+        if (error == ASFPARSE_ERROR_OK)
+        {
+            packet_summary_add(summary, &packet);
+        }
+    }
+
+    return error;
+}
+
+/*****************************************************************************
+* NAME:  take_chunk
+* DESCRIPTION: Take the next chunk of a worker's own queue, or, once that is
+*              empty, steal the back half of another worker's queue
+* RETURNS: chunk number, or -1 if no chunks are left anywhere
+******************************************************************************/
+static long long
+take_chunk
+    (scan_worker_t     *worker      /* [in,out] worker looking for work */
+    )
+{
+    scan_job_t     *job = worker->job;
+    scan_queue_t   *victim;
+    long long       chunk = -1;
+    long long       end_chunk;
+    int             i;
+
+    pthread_mutex_lock(&worker->queue.lock);
+    if (worker->queue.next_chunk < worker->queue.end_chunk)
+    {
+        chunk = worker->queue.next_chunk++;
+    }
+    pthread_mutex_unlock(&worker->queue.lock);
+    if (chunk >= 0)
+    {
+        return chunk;
+    }
+
+    /* start with the next worker so thieves spread over their victims */
+    for (i = 1; i < job->num_workers; i++)
+    {
+        victim = &job->workers[(worker->index + i) % job->num_workers].queue;
+
+        pthread_mutex_lock(&victim->lock);
+        end_chunk = victim->end_chunk;
+        if (victim->next_chunk < end_chunk)
+        {
+            victim->end_chunk -= (end_chunk - victim->next_chunk + 1) / 2;
+            chunk = victim->end_chunk;
+        }
+        pthread_mutex_unlock(&victim->lock);
+
+        if (chunk >= 0)
+        {
+            /* keep the rest of the stolen range so it can be stolen in turn */
+            pthread_mutex_lock(&worker->queue.lock);
+            worker->queue.next_chunk = chunk + 1;
+            worker->queue.end_chunk = end_chunk;
+            pthread_mutex_unlock(&worker->queue.lock);
+            return chunk;
+        }
+    }
+
+    return -1;
+}
+
+/*****************************************************************************
+* NAME:  abandon_chunks
+* DESCRIPTION: Empty every worker's queue so that all workers stop after the
+*              chunk they are decoding
+* RETURNS: none
+******************************************************************************/
+static void
+abandon_chunks
+    (scan_job_t    *job         /* [in,out] packets being scanned */
+    )
+{
+    int     i;
+
+    for (i = 0; i < job->num_workers; i++)
+    {
+        pthread_mutex_lock(&job->workers[i].queue.lock);
+        job->workers[i].queue.end_chunk = job->workers[i].queue.next_chunk;
+        pthread_mutex_unlock(&job->workers[i].queue.lock);
+    }
+}
+
+/*****************************************************************************
+* NAME:  decode_chunk
+* DESCRIPTION: Decode the packets of one chunk into a worker's partial
+*              summary
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+decode_chunk
+    (scan_worker_t     *worker      /* [in,out] worker decoding the chunk */
+    ,long long          chunk       /* [in] chunk number */
+    )
+{
+    scan_job_t         *job = worker->job;
+    asfparse_error_t    error;
+    data_packet_t       packet;
+    cursor_t            cur;
+    long long           i = chunk * SCAN_CHUNK_PACKETS;
+    long long           end = i + SCAN_CHUNK_PACKETS;
+    INSTRUMENT_DECLARE(start);
+
+    if (end > job->num_packets)
+    {
+        end = job->num_packets;
+    }
+
+    for (; i < end; i++)
+    {
+        cursor_init(&cur, job->p_packets + (size_t)i * job->packet_size, job->packet_size);
+        INSTRUMENT_START(start);
+        error = parse_data_packet(&packet, &cur, job->packet_size);
+        INSTRUMENT_STOP(INSTRUMENT_PARSE_DATA_PACKET, start, job->packet_size);
+        if (error)
+        {
+            return error;
+        }
+        packet_summary_add(&worker->summary, &packet);
+
+        /* chunks are not decoded in order, so remember which packets
+           bound the send times */
+        if (worker->first_packet < 0 || i < worker->first_packet)
+        {
+            worker->first_packet = i;
+            worker->first_send_time = packet.send_time;
+        }
+        if (i > worker->last_packet)
+        {
+            worker->last_packet = i;
+            worker->last_send_time = packet.send_time;
+        }
+    }
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  scan_worker
+* DESCRIPTION: Decode chunks until none are left, implementing the pthread
+*              start routine
+* RETURNS: NULL
+******************************************************************************/
+static void *
+scan_worker
+    (void  *p_arg       /* [in,out] scan_worker_t of this thread */
+    )
+{
+    scan_worker_t  *worker = p_arg;
+    long long       chunk;
+
+    while ((chunk = take_chunk(worker)) >= 0)
+    {
+        worker->error = decode_chunk(worker, chunk);
+        if (worker->error)
+        {
+            abandon_chunks(worker->job);
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+/*****************************************************************************
+* NAME:  packet_scan
+* DESCRIPTION: Decode every data packet of a Data Object and gather their
+*              payload counts, sharing fixed-size packets out between
+*              threads
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+packet_scan
+    (packet_summary_t                  *summary             /* [out] payload counts of the decoded packets */
+    ,const char                        *p_file_data         /* [in] first byte of the mapped ASF file */
+    ,const data_object_t               *data                /* [in] struct containing info about data object */
+    ,const file_properties_object_t    *file_properties     /* [in] struct containing info about file properties object */
+    ,int                                num_threads         /* [in] maximum number of threads to decode with */
+    ,size_t                            *bad_offset          /* [out] offset in p_file_data of the packet that failed */
+    )
+{
+    asfparse_error_t    error;
+    scan_job_t          job;
+    scan_worker_t      *worker;
+    pthread_t           threads[SCAN_MAX_THREADS];
+    int                 started[SCAN_MAX_THREADS];
+    long long           num_chunks;
+    long long           first_packet = -1;
+    long long           last_packet = -1;
+    unsigned int        first_send_time = 0;
+    unsigned int        last_send_time = 0;
+    int                 i;
+
+    memset(&job, 0, sizeof(scan_job_t));
+    error = packet_layout(data, file_properties, &job.packet_size, &job.num_packets);
+
+    /* variable-size packets can only be found by decoding the ones before */
+    if (error || job.packet_size == 0 || num_threads < 2 || job.num_packets < SCAN_MIN_PACKETS)
+    {
+        return scan_serial(summary, p_file_data, data, file_properties, bad_offset);
+    }
+
+    num_chunks = (job.num_packets + SCAN_CHUNK_PACKETS - 1) / SCAN_CHUNK_PACKETS;
+    job.num_workers = (num_threads < SCAN_MAX_THREADS) ? num_threads : SCAN_MAX_THREADS;
+    if (job.num_workers > num_chunks)
+    {
+        job.num_workers = (int)num_chunks;
+    }
+    job.p_packets = p_file_data + data->packets_offset;
+    job.workers = calloc((size_t)job.num_workers, sizeof(scan_worker_t));
+    if (job.workers == NULL)
+    {
+        return scan_serial(summary, p_file_data, data, file_properties, bad_offset);
+    }
+
+    /* give each worker an equal run of chunks to start with */
+    for (i = 0; i < job.num_workers; i++)
+    {
+        worker = &job.workers[i];
+        worker->job = &job;
+        worker->index = i;
+        worker->first_packet = -1;
+        worker->last_packet = -1;
+        worker->queue.next_chunk = num_chunks * i / job.num_workers;
+        worker->queue.end_chunk = num_chunks * (i + 1) / job.num_workers;
+        pthread_mutex_init(&worker->queue.lock, NULL);
+    }
+
+    /* the calling thread is the first worker; the chunks of any thread that
+       fails to start are stolen by the others */
+    for (i = 1; i < job.num_workers; i++)
+    {
+        started[i] = (pthread_create(&threads[i], NULL, scan_worker, &job.workers[i]) == 0);
+    }
+    scan_worker(&job.workers[0]);
+    for (i = 1; i < job.num_workers; i++)
+    {
+        if (started[i])
+        {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    /* merge the partial summaries, taking the send times from the packets
+       that really came first and last */
+    memset(summary, 0, sizeof(packet_summary_t));
+    for (i = 0; i < job.num_workers; i++)
+    {
+        worker = &job.workers[i];
+        if (worker->error)
+        {
+            error = worker->error;
+        }
+        packet_summary_merge(summary, &worker->summary);
+        if (worker->first_packet >= 0 && (first_packet < 0 || worker->first_packet < first_packet))
+        {
+            first_packet = worker->first_packet;
+            first_send_time = worker->first_send_time;
+        }
+        if (worker->last_packet > last_packet)
+        {
+            last_packet = worker->last_packet;
+            last_send_time = worker->last_send_time;
+        }
+        pthread_mutex_destroy(&worker->queue.lock);
+    }
+    summary->first_send_time = first_send_time;
+    summary->last_send_time = last_send_time;
+    free(job.workers);
+
+    /* the partial summaries cannot tell which packets came before the bad
+       one, so find it again in order */
+    if (error)
+    {
+        return scan_serial(summary, p_file_data, data, file_properties, bad_offset);
+    }
+    *bad_offset = data->packets_offset;
+
+    return ASFPARSE_ERROR_OK;
+}
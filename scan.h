@@ -0,0 +1,37 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+/* Includes */
+#include "util.h"
+#include "packet.h"
+
+/* Defines and constants */
+#define SCAN_CHUNK_PACKETS      (256)                       /* packets a worker decodes between looking for more work */
+#define SCAN_MIN_PACKETS        (8 * SCAN_CHUNK_PACKETS)    /* fewer packets are summarised on the calling thread */
+#define SCAN_MAX_THREADS        (256)                       /* maximum number of threads summarising one Data Object */
+
+/* Function prototypes */
+/*****************************************************************************
+* NAME:  packet_scan
+* DESCRIPTION: Decode every data packet of a Data Object and gather their
+*              payload counts. Fixed-size packets are split into chunks
+*              shared out between up to num_threads threads, each of which
+*              keeps its own partial summary and steals chunks from the
+*              others once its own are done; the partial summaries are
+*              merged at the end. Variable-size packets, and Data Objects
+*              with too few packets to be worth the threads, are walked on
+*              the calling thread.
+* RETURNS: asfparse_error_t; on failure the summary covers the packets
+*          before the first one that could not be decoded
+******************************************************************************/
+asfparse_error_t
+packet_scan
+    (packet_summary_t                  *summary             /* [out] payload counts of the decoded packets */
+    ,const char                        *p_file_data         /* [in] first byte of the mapped ASF file */
+    ,const data_object_t               *data                /* [in] struct containing info about data object */
+    ,const file_properties_object_t    *file_properties     /* [in] struct containing info about file properties object */
+    ,int                                num_threads         /* [in] maximum number of threads to decode with */
+    ,size_t                            *bad_offset          /* [out] offset in p_file_data of the packet that failed */
+    );
+
+#endif
@@ -0,0 +1,1191 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "asfparse.h"
+#include "batch.h"
+#include "cursor.h"
+#include "display.h"
+#include "json.h"
+#include "utf16.h"
+#include "search.h"
+
+/* Defines and constants */
+#define SEARCH_MAGIC            "ASFINDEX"  /* first bytes of an index file */
+#define SEARCH_MAGIC_LENGTH     (8)
+#define SEARCH_VERSION          (1)
+#define SECTION_ALIGN           (8)         /* the file and term tables start on this boundary */
+#define FNV_OFFSET_BASIS        (0xcbf29ce484222325ull)
+#define FNV_PRIME               (0x100000001b3ull)
+#define MIN_BUCKETS             (4096)
+#define MIN_POSTINGS_CAPACITY   (8)         /* bytes first allocated for a posting list */
+#define MAX_VARINT_BYTES        (5)         /* bytes in the varint of a 32-bit number */
+#define NUMBER_TERM_LENGTH      (24)        /* room for a 64-bit number in decimal */
+
+/* Enums and structs */
+/* Structure describing the start of an index file. The file is laid out as
+   this header, the posting lists, the file names, the file table, the term
+   table and the term bytes, all in the byte order of the machine that wrote
+   it. */
+typedef struct {
+    char                magic[SEARCH_MAGIC_LENGTH];
+    unsigned int        version;
+    unsigned int        term_size;          /* sizeof(search_term_entry_t), to reject another layout */
+    unsigned long long  num_files;
+    unsigned long long  num_terms;
+    unsigned long long  postings_offset;    /* posting lists, one after another in term order */
+    unsigned long long  names_offset;       /* NUL-terminated file names */
+    unsigned long long  files_offset;       /* num_files + 1 offsets from names_offset */
+    unsigned long long  terms_offset;       /* num_terms + 1 search_term_entry_t */
+    unsigned long long  strings_offset;     /* term bytes, in term order */
+    unsigned long long  file_size;
+} search_file_header_t;
+
+/* Structure describing one entry of the term table. The entry after the
+   last term marks where the term bytes and posting lists end. A posting
+   list holds the file numbers of a term in ascending order, each as the
+   LEB128 varint of its difference from the previous one (the first from
+   0). */
+typedef struct {
+    unsigned long long  string;             /* offset of the term bytes from strings_offset */
+    unsigned long long  postings;           /* offset of the posting list from postings_offset */
+    unsigned int        length;             /* bytes in the term */
+    unsigned int        num_postings;       /* files holding the term */
+} search_term_entry_t;
+
+/* Structure describing an open index file */
+struct search_index_s {
+    mapped_file_t                   file;       /* the whole index file */
+    const search_file_header_t     *header;
+    const unsigned char            *postings;
+    const char                     *names;
+    const unsigned long long       *files;
+    const search_term_entry_t      *terms;
+    const char                     *strings;
+};
+
+/* Structure describing a term while an index is built. The term bytes are
+   held in the same allocation as the entry. */
+typedef struct search_term_s {
+    struct search_term_s   *hash_next;      /* next term in the same bucket */
+    unsigned long long      hash;           /* hash of the term bytes */
+    unsigned char          *p_postings;     /* posting list */
+    unsigned int            postings_length;    /* bytes in p_postings */
+    unsigned int            postings_capacity;  /* bytes allocated for p_postings */
+    unsigned int            num_postings;
+    unsigned int            last_file;      /* number of the last file added, plus one; 0 if none */
+    unsigned int            length;         /* bytes in the term */
+} search_term_t;
+
+/* Structure describing an index being built */
+typedef struct {
+    search_term_t         **buckets;        /* hash chains of the terms, num_buckets entries */
+    size_t                  num_buckets;    /* power of two */
+    size_t                  num_terms;
+    long long               num_postings;
+    output_t                names;          /* NUL-terminated names of the files indexed */
+    unsigned long long     *p_name_offsets; /* offset of each file's name in names */
+    size_t                  num_files;      /* files indexed */
+    size_t                  files_capacity; /* entries allocated in p_name_offsets */
+    const char             *p_filename;     /* name of the file being parsed */
+    int                     is_registered;  /* non-zero once that file has a number */
+    output_t                name_buffer;    /* descriptor name as UTF-8 */
+    output_t                value_buffer;   /* descriptor value as UTF-8 */
+    asfparse_error_t        error;          /* first failure to allocate memory */
+} search_builder_t;
+
+/*****************************************************************************
+* NAME:  hash_term
+* DESCRIPTION: Hash the bytes of a term (64-bit FNV-1a)
+* RETURNS: hash value
+******************************************************************************/
+static unsigned long long
+hash_term
+    (const char    *p_term      /* [in] term bytes */
+    ,size_t         length      /* [in] number of bytes in p_term */
+    )
+{
+    unsigned long long  h = FNV_OFFSET_BASIS;
+    size_t              i;
+
+    for (i = 0; i < length; i++)
+    {
+        h = (h ^ (unsigned char)p_term[i]) * FNV_PRIME;
+    }
+
+    return h;
+}
+
+/*****************************************************************************
+* NAME:  lower_ascii
+* DESCRIPTION: Turn the ASCII capitals of a string to lower case; other bytes,
+*              including those of multi-byte UTF-8 characters, are kept
+* RETURNS: none
+******************************************************************************/
+static void
+lower_ascii
+    (char          *p_text      /* [in,out] bytes */
+    ,size_t         length      /* [in] number of bytes in p_text */
+    )
+{
+    size_t  i;
+
+    for (i = 0; i < length; i++)
+    {
+        if (p_text[i] >= 'A' && p_text[i] <= 'Z')
+        {
+            p_text[i] = (char)(p_text[i] - 'A' + 'a');
+        }
+    }
+}
+
+/*****************************************************************************
+* NAME:  is_word_byte
+* DESCRIPTION: Check whether a byte is part of a word: an ASCII letter or
+*              digit, or any byte of a multi-byte UTF-8 character
+* RETURNS: non-zero if it is
+******************************************************************************/
+static int
+is_word_byte
+    (unsigned char  c           /* [in] byte */
+    )
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+}
+
+/*****************************************************************************
+* NAME:  term_key
+* DESCRIPTION: Get the bytes of a term of an open index, or none if the term
+*              table points outside the file
+* RETURNS: pointer to the term bytes
+******************************************************************************/
+static const char *
+term_key
+    (const search_index_t  *index       /* [in] index handle */
+    ,size_t                 i           /* [in] term number */
+    ,size_t                *length      /* [out] bytes in the term */
+    )
+{
+    const search_term_entry_t  *entry = &index->terms[i];
+    unsigned long long          strings_size = index->header->file_size - index->header->strings_offset;
+
+    if (entry->string > strings_size || entry->length > strings_size - entry->string)
+    {
+        *length = 0;
+        return index->strings;
+    }
+    *length = entry->length;
+
+    return index->strings + entry->string;
+}
+
+/*****************************************************************************
+* NAME:  compare_term
+* DESCRIPTION: Compare a term of an open index with a query term, byte by
+*              byte and then by length
+* RETURNS: negative, zero or positive as the index term sorts before, equal
+*          to or after the query term
+******************************************************************************/
+static int
+compare_term
+    (const search_index_t  *index       /* [in] index handle */
+    ,size_t                 i           /* [in] term number */
+    ,const char            *p_term      /* [in] query term bytes */
+    ,size_t                 length      /* [in] bytes in p_term */
+    )
+{
+    size_t          key_length;
+    const char     *p_key = term_key(index, i, &key_length);
+    int             result = memcmp(p_key, p_term, (key_length < length) ? key_length : length);
+
+    if (result != 0)
+    {
+        return result;
+    }
+
+    return (key_length < length) ? -1 : (key_length > length);
+}
+
+/*****************************************************************************
+* NAME:  decode_postings
+* DESCRIPTION: Append the file numbers of a term of an open index to an array
+* RETURNS: asfparse_error_t; ASFPARSE_ERROR_INVALID_ARG if the posting list
+*          is damaged
+******************************************************************************/
+static asfparse_error_t
+decode_postings
+    (const search_index_t  *index       /* [in] index handle */
+    ,size_t                 i           /* [in] term number */
+    ,unsigned int         **pp_files    /* [in,out] file numbers, grown as needed */
+    ,size_t                *num_files   /* [in,out] entries in use */
+    ,size_t                *capacity    /* [in,out] entries allocated */
+    )
+{
+    const search_file_header_t *header = index->header;
+    unsigned long long          postings_size = header->names_offset - header->postings_offset;
+    unsigned long long          start = index->terms[i].postings;
+    unsigned long long          end = index->terms[i + 1].postings;
+    unsigned long long          file = 0;
+    unsigned long long          delta;
+    unsigned int               *p_grown;
+    unsigned int                j;
+    int                         shift;
+
+    /* each file number takes at least one byte */
+    if (start > end || end > postings_size || index->terms[i].num_postings > end - start)
+    {
+        return ASFPARSE_ERROR_INVALID_ARG;
+    }
+    if (*num_files + index->terms[i].num_postings > *capacity)
+    {
+        while (*num_files + index->terms[i].num_postings > *capacity)
+        {
+            *capacity = (*capacity == 0) ? 64 : *capacity * 2;
+        }
+        p_grown = realloc(*pp_files, *capacity * sizeof(unsigned int));
+        if (p_grown == NULL)
+        {
+            return ASFPARSE_ERROR_OUT_OF_MEMORY;
+        }
+        *pp_files = p_grown;
+    }
+
+    for (j = 0; j < index->terms[i].num_postings; j++)
+    {
+        delta = 0;
+        shift = 0;
+        do
+        {
+            if (start == end || shift > 28)
+            {
+                return ASFPARSE_ERROR_INVALID_ARG;
+            }
+            delta |= (unsigned long long)(index->postings[start] & 0x7f) << shift;
+            shift += 7;
+        } while (index->postings[start++] & 0x80);
+
+        file += delta;
+        if (file >= header->num_files)
+        {
+            return ASFPARSE_ERROR_INVALID_ARG;
+        }
+        (*pp_files)[(*num_files)++] = (unsigned int)file;
+    }
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  compare_file_numbers
+* DESCRIPTION: qsort() comparison of two file numbers
+* RETURNS: negative, zero or positive
+******************************************************************************/
+static int
+compare_file_numbers
+    (const void    *p_a         /* [in] first unsigned int */
+    ,const void    *p_b         /* [in] second unsigned int */
+    )
+{
+    unsigned int    a = *(const unsigned int *)p_a;
+    unsigned int    b = *(const unsigned int *)p_b;
+
+    return (a > b) - (a < b);
+}
+
+/*****************************************************************************
+* NAME:  match_term
+* DESCRIPTION: Find the files holding one query term, or any term starting
+*              with it if it ends in SEARCH_PREFIX_WILDCARD
+* RETURNS: asfparse_error_t; the file numbers are sorted and distinct
+******************************************************************************/
+static asfparse_error_t
+match_term
+    (const search_index_t  *index       /* [in] index handle */
+    ,const char            *p_query     /* [in] query term */
+    ,unsigned int         **pp_files    /* [out] file numbers, to be freed by the caller */
+    ,size_t                *num_files   /* [out] entries in pp_files */
+    )
+{
+    asfparse_error_t    error = ASFPARSE_ERROR_OK;
+    char                term[SEARCH_MAX_TERM_LENGTH + 1];
+    const char         *p_key;
+    size_t              length = strlen(p_query);
+    size_t              capacity = 0;
+    size_t              num_terms = (size_t)index->header->num_terms;
+    size_t              low = 0;
+    size_t              high = num_terms;
+    size_t              middle;
+    size_t              key_length;
+    size_t              i;
+    size_t              j;
+    int                 is_prefix = (length > 0 && p_query[length - 1] == SEARCH_PREFIX_WILDCARD);
+
+    *pp_files = NULL;
+    *num_files = 0;
+    length -= (size_t)is_prefix;
+    if (length > SEARCH_MAX_TERM_LENGTH)
+    {
+        return ASFPARSE_ERROR_OK;
+    }
+    memcpy(term, p_query, length);
+    lower_ascii(term, length);
+
+    /* the first term not sorting before the query term */
+    while (low < high)
+    {
+        middle = low + (high - low) / 2;
+        if (compare_term(index, middle, term, length) < 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    for (i = low; i < num_terms && error == ASFPARSE_ERROR_OK; i++)
+    {
+        if (is_prefix)
+        {
+            p_key = term_key(index, i, &key_length);
+            if (key_length < length || memcmp(p_key, term, length) != 0)
+            {
+                break;
+            }
+        }
+        else if (compare_term(index, i, term, length) != 0)
+        {
+            break;
+        }
+        error = decode_postings(index, i, pp_files, num_files, &capacity);
+        if (!is_prefix)
+        {
+            break;
+        }
+    }
+
+    /* several terms may share files */
+    if (error == ASFPARSE_ERROR_OK && is_prefix && *num_files > 1)
+    {
+        qsort(*pp_files, *num_files, sizeof(unsigned int), compare_file_numbers);
+        for (i = 1, j = 1; i < *num_files; i++)
+        {
+            if ((*pp_files)[i] != (*pp_files)[j - 1])
+            {
+                (*pp_files)[j++] = (*pp_files)[i];
+            }
+        }
+        *num_files = j;
+    }
+
+    return error;
+}
+
+/*****************************************************************************
+* NAME:  search_index_open
+* DESCRIPTION: Map an index file for queries
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+search_index_open
+    (const char        *p_filename  /* [in] name of index file */
+    ,search_index_t   **index       /* [out] new handle */
+    )
+{
+    const search_file_header_t *header;
+    search_index_t             *new_index;
+    asfparse_error_t            error;
+    unsigned long long          size;
+
+    *index = NULL;
+    new_index = calloc(1, sizeof(search_index_t));
+    if (new_index == NULL)
+    {
+        return ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
+    error = map_file(p_filename, &new_index->file);
+    if (error)
+    {
+        free(new_index);
+        return error;
+    }
+
+    /* every section must lie inside the file, in order, and hold its
+       tables; the names must end in a NUL */
+    header = (const search_file_header_t *)new_index->file.p_data;
+    size = new_index->file.size;
+    if (size < sizeof(search_file_header_t)
+        || memcmp(header->magic, SEARCH_MAGIC, SEARCH_MAGIC_LENGTH) != 0
+        || header->version != SEARCH_VERSION
+        || header->term_size != sizeof(search_term_entry_t)
+        || header->file_size != size
+        || header->postings_offset < sizeof(search_file_header_t)
+        || header->names_offset < header->postings_offset
+        || header->files_offset < header->names_offset
+        || header->terms_offset < header->files_offset
+        || header->strings_offset < header->terms_offset
+        || header->strings_offset > size
+        || header->files_offset % SECTION_ALIGN != 0
+        || header->terms_offset % SECTION_ALIGN != 0
+        || header->num_files + 1 != (header->terms_offset - header->files_offset) / sizeof(unsigned long long)
+        || header->num_terms + 1 != (header->strings_offset - header->terms_offset) / sizeof(search_term_entry_t)
+        || (header->num_files > 0
+            && (header->names_offset == header->files_offset
+                || new_index->file.p_data[header->files_offset - 1] != '\0')))
+    {
+        unmap_file(&new_index->file);
+        free(new_index);
+        return ASFPARSE_ERROR_INVALID_ARG;
+    }
+
+    new_index->header = header;
+    new_index->postings = (const unsigned char *)new_index->file.p_data + header->postings_offset;
+    new_index->names = new_index->file.p_data + header->names_offset;
+    new_index->files = (const unsigned long long *)(new_index->file.p_data + header->files_offset);
+    new_index->terms = (const search_term_entry_t *)(new_index->file.p_data + header->terms_offset);
+    new_index->strings = new_index->file.p_data + header->strings_offset;
+    *index = new_index;
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  search_index_close
+* DESCRIPTION: Release an index handle
+* RETURNS: none
+******************************************************************************/
+void
+search_index_close
+    (search_index_t    *index       /* [in] index handle, or NULL */
+    )
+{
+    if (index != NULL)
+    {
+        unmap_file(&index->file);
+        free(index);
+    }
+}
+
+/*****************************************************************************
+* NAME:  search_index_query
+* DESCRIPTION: Find the files that match every query term
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+search_index_query
+    (const search_index_t  *index       /* [in] index handle */
+    ,char * const          *pp_terms    /* [in] query terms */
+    ,int                    num_terms   /* [in] number of entries in pp_terms, at least 1 */
+    ,unsigned int         **pp_files    /* [out] numbers of the matching files */
+    ,size_t                *num_files   /* [out] number of entries in pp_files */
+    )
+{
+    asfparse_error_t    error;
+    unsigned int       *p_matches;
+    size_t              num_matches;
+    size_t              i;
+    size_t              j;
+    size_t              k;
+    int                 t;
+
+    error = match_term(index, pp_terms[0], pp_files, num_files);
+
+    /* keep the files that also hold each further term; both lists are
+       sorted, so one merge pass each */
+    for (t = 1; t < num_terms && error == ASFPARSE_ERROR_OK && *num_files > 0; t++)
+    {
+        error = match_term(index, pp_terms[t], &p_matches, &num_matches);
+        for (i = 0, j = 0, k = 0; error == ASFPARSE_ERROR_OK && i < *num_files && j < num_matches; )
+        {
+            if ((*pp_files)[i] < p_matches[j])
+            {
+                i++;
+            }
+            else if ((*pp_files)[i] > p_matches[j])
+            {
+                j++;
+            }
+            else
+            {
+                (*pp_files)[k++] = (*pp_files)[i++];
+                j++;
+            }
+        }
+        if (error == ASFPARSE_ERROR_OK)
+        {
+            *num_files = k;
+        }
+        free(p_matches);
+    }
+
+    if (error)
+    {
+        free(*pp_files);
+        *pp_files = NULL;
+        *num_files = 0;
+    }
+
+    return error;
+}
+
+/*****************************************************************************
+* NAME:  search_index_file_name
+* DESCRIPTION: Get the name of a file in an index
+* RETURNS: NUL-terminated name, valid until the index is closed
+******************************************************************************/
+const char *
+search_index_file_name
+    (const search_index_t  *index       /* [in] index handle */
+    ,unsigned int           file        /* [in] file number from search_index_query */
+    )
+{
+    unsigned long long  offset = index->files[file];
+
+    /* the names section ends in a NUL, so any offset inside it is a string */
+    if (offset >= index->header->files_offset - index->header->names_offset)
+    {
+        return "";
+    }
+
+    return index->names + offset;
+}
+
+/*****************************************************************************
+* NAME:  add_term
+* DESCRIPTION: Add the file being parsed to the posting list of a term,
+*              numbering the file when it gets its first term
+* RETURNS: none; builder->error is set if memory runs out
+******************************************************************************/
+static void
+add_term
+    (search_builder_t  *builder     /* [in,out] index being built */
+    ,const char        *p_term      /* [in] term bytes */
+    ,size_t             length      /* [in] number of bytes in p_term */
+    )
+{
+    unsigned long long  hash;
+    unsigned long long *p_offsets;
+    search_term_t     **link;
+    search_term_t     **buckets;
+    search_term_t      *term;
+    search_term_t      *moved;
+    search_term_t      *next;
+    unsigned char      *p_postings;
+    unsigned int        file = (unsigned int)builder->num_files;
+    unsigned int        delta;
+    size_t              i;
+
+    if (length == 0 || length > SEARCH_MAX_TERM_LENGTH || builder->error)
+    {
+        return;
+    }
+    if (builder->is_registered)
+    {
+        file--;
+    }
+
+    hash = hash_term(p_term, length);
+    link = &builder->buckets[hash & (builder->num_buckets - 1)];
+    while (*link != NULL
+           && ((*link)->hash != hash || (*link)->length != length || memcmp(*link + 1, p_term, length) != 0))
+    {
+        link = &(*link)->hash_next;
+    }
+    term = *link;
+
+    if (term == NULL)
+    {
+        term = malloc(sizeof(search_term_t) + length);
+        if (term == NULL)
+        {
+            builder->error = ASFPARSE_ERROR_OUT_OF_MEMORY;
+            return;
+        }
+        memset(term, 0, sizeof(search_term_t));
+        term->hash = hash;
+        term->length = (unsigned int)length;
+        memcpy(term + 1, p_term, length);
+        *link = term;
+        builder->num_terms++;
+
+        /* double the table when it averages one term per bucket */
+        if (builder->num_terms > builder->num_buckets)
+        {
+            buckets = calloc(builder->num_buckets * 2, sizeof(search_term_t *));
+            if (buckets != NULL)
+            {
+                for (i = 0; i < builder->num_buckets; i++)
+                {
+                    for (moved = builder->buckets[i]; moved != NULL; moved = next)
+                    {
+                        next = moved->hash_next;
+                        moved->hash_next = buckets[moved->hash & (builder->num_buckets * 2 - 1)];
+                        buckets[moved->hash & (builder->num_buckets * 2 - 1)] = moved;
+                    }
+                }
+                free(builder->buckets);
+                builder->buckets = buckets;
+                builder->num_buckets *= 2;
+            }
+        }
+    }
+
+    /* a term counts once per file */
+    if (term->last_file == file + 1)
+    {
+        return;
+    }
+
+    if (!builder->is_registered)
+    {
+        if (builder->num_files == builder->files_capacity)
+        {
+            builder->files_capacity = (builder->files_capacity == 0) ? 1024 : builder->files_capacity * 2;
+            p_offsets = realloc(builder->p_name_offsets, builder->files_capacity * sizeof(unsigned long long));
+            if (p_offsets == NULL)
+            {
+                builder->error = ASFPARSE_ERROR_OUT_OF_MEMORY;
+                return;
+            }
+            builder->p_name_offsets = p_offsets;
+        }
+        builder->p_name_offsets[builder->num_files++] = builder->names.length;
+        output_write(&builder->names, builder->p_filename, strlen(builder->p_filename) + 1);
+        builder->is_registered = 1;
+    }
+
+    if (term->postings_length + MAX_VARINT_BYTES > term->postings_capacity)
+    {
+        p_postings = realloc(term->p_postings, (term->postings_capacity == 0)
+                                               ? MIN_POSTINGS_CAPACITY : term->postings_capacity * 2);
+        if (p_postings == NULL)
+        {
+            builder->error = ASFPARSE_ERROR_OUT_OF_MEMORY;
+            return;
+        }
+        term->p_postings = p_postings;
+        term->postings_capacity = (term->postings_capacity == 0) ? MIN_POSTINGS_CAPACITY : term->postings_capacity * 2;
+    }
+    delta = file - ((term->last_file > 0) ? term->last_file - 1 : 0);
+    while (delta >= 0x80)
+    {
+        term->p_postings[term->postings_length++] = (unsigned char)(delta | 0x80);
+        delta >>= 7;
+    }
+    term->p_postings[term->postings_length++] = (unsigned char)delta;
+    term->num_postings++;
+    term->last_file = file + 1;
+    builder->num_postings++;
+}
+
+/*****************************************************************************
+* NAME:  add_words
+* DESCRIPTION: Add each word of a descriptor value as a term, both alone and
+*              after the descriptor's name
+* RETURNS: none
+******************************************************************************/
+static void
+add_words
+    (search_builder_t  *builder     /* [in,out] index being built */
+    ,const char        *p_name      /* [in] lower-cased descriptor name followed by '=' */
+    ,size_t             name_length /* [in] bytes in p_name, 0 if the name is not indexed */
+    ,char              *p_value     /* [in,out] value as UTF-8, lower-cased here */
+    ,size_t             length      /* [in] bytes in p_value */
+    )
+{
+    char    term[SEARCH_MAX_TERM_LENGTH];
+    size_t  start;
+    size_t  end = 0;
+
+    lower_ascii(p_value, length);
+    while (end < length)
+    {
+        for (start = end; start < length && !is_word_byte((unsigned char)p_value[start]); start++)
+        {
+        }
+        for (end = start; end < length && is_word_byte((unsigned char)p_value[end]); end++)
+        {
+        }
+        if (end == start || end - start > SEARCH_MAX_TERM_LENGTH)
+        {
+            continue;
+        }
+
+        add_term(builder, p_value + start, end - start);
+        if (name_length > 0 && name_length + (end - start) <= SEARCH_MAX_TERM_LENGTH)
+        {
+            memcpy(term, p_name, name_length);
+            memcpy(term + name_length, p_value + start, end - start);
+            add_term(builder, term, name_length + (end - start));
+        }
+    }
+}
+
+/*****************************************************************************
+* NAME:  to_utf8
+* DESCRIPTION: Convert a UTF-16LE string, up to any NUL terminator, into a
+*              buffer that is reused for each string
+* RETURNS: number of UTF-8 bytes, at the start of buffer->p_data
+******************************************************************************/
+static size_t
+to_utf8
+    (output_t      *buffer      /* [in,out] buffer receiving the string */
+    ,const char    *p_data      /* [in] UTF-16LE bytes */
+    ,int            length      /* [in] number of bytes in p_data */
+    )
+{
+    size_t  num_units = utf16le_length(p_data, (size_t)length / 2);
+
+    output_reset(buffer);
+
+    return utf16le_to_utf8(output_reserve(buffer, num_units * UTF8_MAX_BYTES_PER_UTF16_UNIT + 1), p_data, num_units);
+}
+
+/*****************************************************************************
+* NAME:  index_descriptor
+* DESCRIPTION: Add the terms of one content descriptor
+* RETURNS: none
+******************************************************************************/
+static void
+index_descriptor
+    (search_builder_t              *builder     /* [in,out] index being built */
+    ,const content_descriptor_t    *descriptor  /* [in] descriptor */
+    )
+{
+    char                number[NUMBER_TERM_LENGTH];
+    char               *p_name;
+    size_t              name_length;
+    size_t              value_length;
+    size_t              width;
+
+    /* the name term keeps the whole name, '=' marking its end */
+    name_length = to_utf8(&builder->name_buffer, descriptor->name, descriptor->name_length);
+    p_name = builder->name_buffer.p_data;
+    p_name[name_length++] = '=';
+    lower_ascii(p_name, name_length);
+    if (name_length == 1 || name_length > SEARCH_MAX_TERM_LENGTH)
+    {
+        name_length = 0;
+    }
+    add_term(builder, p_name, name_length);
+
+    /* numeric values are little-endian and bounded by the value length */
+    width = (size_t)descriptor->value_length;
+    switch (descriptor->value_data_type)
+    {
+    case 0:	/* unicode string */
+        value_length = to_utf8(&builder->value_buffer, descriptor->value, descriptor->value_length);
+        add_words(builder, p_name, name_length, builder->value_buffer.p_data, value_length);
+        break;
+    case 2:	/* bool */
+        strcpy(number, load_uint_le(descriptor->value, (width < 4) ? width : 4) ? "true" : "false");
+        add_words(builder, p_name, name_length, number, strlen(number));
+        break;
+    case 3:	/* 32-bit word */
+    case 4:	/* 64-bit word */
+    case 5:	/* 16-bit word */
+        width = (descriptor->value_data_type == 3) ? ((width < 4) ? width : 4)
+              : (descriptor->value_data_type == 4) ? ((width < 8) ? width : 8)
+              : ((width < 2) ? width : 2);
+        sprintf(number, "%llu", load_uint_le(descriptor->value, width));
+        add_words(builder, p_name, name_length, number, strlen(number));
+        break;
+    case 1:	/* byte array */
+    default:
+        break;
+    }
+}
+
+/*****************************************************************************
+* NAME:  index_event
+* DESCRIPTION: Callback receiving the parse events of a file being indexed
+* RETURNS: 0 to continue parsing
+******************************************************************************/
+static int
+index_event
+    (void                      *p_user      /* [in] search_builder_t */
+    ,const asfparse_event_t    *event       /* [in] parse event */
+    )
+{
+    search_builder_t                               *builder = p_user;
+    const extended_content_description_object_t    *ext_content_descr;
+    int                                             i;
+
+    if (event->kind == ASFPARSE_EVENT_OBJECT && event->type == OBJECT_TYPE_EXTENDED_CONTENT_DESCRIPTION)
+    {
+        ext_content_descr = event->object;
+        for (i = 0; i < ext_content_descr->descriptor_count; i++)
+        {
+            index_descriptor(builder, &ext_content_descr->descriptor[i]);
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************
+* NAME:  compare_terms
+* DESCRIPTION: qsort() comparison of two terms, byte by byte and then by
+*              length
+* RETURNS: negative, zero or positive
+******************************************************************************/
+static int
+compare_terms
+    (const void    *p_a         /* [in] first search_term_t pointer */
+    ,const void    *p_b         /* [in] second search_term_t pointer */
+    )
+{
+    const search_term_t    *a = *(search_term_t * const *)p_a;
+    const search_term_t    *b = *(search_term_t * const *)p_b;
+    int                     result = memcmp(a + 1, b + 1, (a->length < b->length) ? a->length : b->length);
+
+    if (result != 0)
+    {
+        return result;
+    }
+
+    return (a->length > b->length) - (a->length < b->length);
+}
+
+/*****************************************************************************
+* NAME:  write_padding
+* DESCRIPTION: Write zero bytes up to the next section boundary
+* RETURNS: file offset after the padding
+******************************************************************************/
+static unsigned long long
+write_padding
+    (FILE                  *p_file      /* [in] index file being written */
+    ,unsigned long long     offset      /* [in] current file offset */
+    )
+{
+    static const char   zeros[SECTION_ALIGN] = {0};
+    size_t              num_bytes = (size_t)((SECTION_ALIGN - offset % SECTION_ALIGN) % SECTION_ALIGN);
+
+    fwrite(zeros, 1, num_bytes, p_file);
+
+    return offset + num_bytes;
+}
+
+/*****************************************************************************
+* NAME:  write_index
+* DESCRIPTION: Write the terms of an index in sorted order to a temporary
+*              file and rename it over the index file
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+write_index
+    (search_builder_t      *builder     /* [in] index built */
+    ,const char            *p_filename  /* [in] name of index file */
+    ,long long             *index_size  /* [out] bytes written */
+    )
+{
+    asfparse_error_t        error = ASFPARSE_ERROR_OK;
+    search_file_header_t    header;
+    search_term_entry_t     entry;
+    search_term_t         **pp_terms;
+    search_term_t          *term;
+    FILE                   *p_file;
+    char                   *p_tmp_filename;
+    unsigned long long      offset;
+    unsigned long long      end_offset = 0;
+    size_t                  n = 0;
+    size_t                  i;
+
+    pp_terms = malloc((builder->num_terms + 1) * sizeof(search_term_t *));
+    p_tmp_filename = malloc(strlen(p_filename) + 32);
+    if (pp_terms == NULL || p_tmp_filename == NULL)
+    {
+        free(pp_terms);
+        free(p_tmp_filename);
+        return ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
+    for (i = 0; i < builder->num_buckets; i++)
+    {
+        for (term = builder->buckets[i]; term != NULL; term = term->hash_next)
+        {
+            pp_terms[n++] = term;
+        }
+    }
+    qsort(pp_terms, n, sizeof(search_term_t *), compare_terms);
+
+    /* lay out the sections */
+    memset(&header, 0, sizeof(search_file_header_t));
+    memcpy(header.magic, SEARCH_MAGIC, SEARCH_MAGIC_LENGTH);
+    header.version = SEARCH_VERSION;
+    header.term_size = sizeof(search_term_entry_t);
+    header.num_files = builder->num_files;
+    header.num_terms = n;
+    header.postings_offset = sizeof(search_file_header_t);
+    header.names_offset = header.postings_offset;
+    for (i = 0; i < n; i++)
+    {
+        header.names_offset += pp_terms[i]->postings_length;
+    }
+    header.files_offset = header.names_offset + builder->names.length;
+    header.files_offset += (SECTION_ALIGN - header.files_offset % SECTION_ALIGN) % SECTION_ALIGN;
+    header.terms_offset = header.files_offset + (builder->num_files + 1) * sizeof(unsigned long long);
+    header.strings_offset = header.terms_offset + (n + 1) * sizeof(search_term_entry_t);
+    header.file_size = header.strings_offset;
+    for (i = 0; i < n; i++)
+    {
+        header.file_size += pp_terms[i]->length;
+    }
+
+    sprintf(p_tmp_filename, "%s.%ld.tmp", p_filename, (long)getpid());
+    p_file = fopen(p_tmp_filename, "wb");
+    if (p_file == NULL)
+    {
+        free(pp_terms);
+        free(p_tmp_filename);
+        return ASFPARSE_ERROR_OPEN_FILE;
+    }
+
+    fwrite(&header, sizeof(search_file_header_t), 1, p_file);
+    for (i = 0; i < n; i++)
+    {
+        fwrite(pp_terms[i]->p_postings, 1, pp_terms[i]->postings_length, p_file);
+    }
+    if (builder->num_files > 0)
+    {
+        fwrite(builder->names.p_data, 1, builder->names.length, p_file);
+    }
+    write_padding(p_file, header.names_offset + builder->names.length);
+
+    /* the entry after the last one marks the ends of the sections */
+    if (builder->num_files > 0)
+    {
+        fwrite(builder->p_name_offsets, sizeof(unsigned long long), builder->num_files, p_file);
+    }
+    offset = builder->names.length;
+    fwrite(&offset, sizeof(unsigned long long), 1, p_file);
+    offset = 0;
+    for (i = 0; i <= n; i++)
+    {
+        memset(&entry, 0, sizeof(search_term_entry_t));
+        entry.string = end_offset;
+        entry.postings = offset;
+        if (i < n)
+        {
+            entry.length = pp_terms[i]->length;
+            entry.num_postings = pp_terms[i]->num_postings;
+            end_offset += pp_terms[i]->length;
+            offset += pp_terms[i]->postings_length;
+        }
+        fwrite(&entry, sizeof(search_term_entry_t), 1, p_file);
+    }
+    for (i = 0; i < n; i++)
+    {
+        fwrite(pp_terms[i] + 1, 1, pp_terms[i]->length, p_file);
+    }
+
+    if (ferror(p_file) || fflush(p_file) != 0 || fsync(fileno(p_file)) != 0)
+    {
+        error = ASFPARSE_ERROR_WRITE_FILE;
+    }
+    if (fclose(p_file) != 0 && error == ASFPARSE_ERROR_OK)
+    {
+        error = ASFPARSE_ERROR_WRITE_FILE;
+    }
+    if (error == ASFPARSE_ERROR_OK && rename(p_tmp_filename, p_filename) != 0)
+    {
+        error = ASFPARSE_ERROR_WRITE_FILE;
+    }
+    if (error)
+    {
+        unlink(p_tmp_filename);
+    }
+    *index_size = (long long)header.file_size;
+
+    free(pp_terms);
+    free(p_tmp_filename);
+
+    return error;
+}
+
+/*****************************************************************************
+* NAME:  free_builder
+* DESCRIPTION: Release everything held by an index being built
+* RETURNS: none
+******************************************************************************/
+static void
+free_builder
+    (search_builder_t  *builder     /* [in,out] index being built */
+    )
+{
+    search_term_t  *term;
+    search_term_t  *next;
+    size_t          i;
+
+    for (i = 0; builder->buckets != NULL && i < builder->num_buckets; i++)
+    {
+        for (term = builder->buckets[i]; term != NULL; term = next)
+        {
+            next = term->hash_next;
+            free(term->p_postings);
+            free(term);
+        }
+    }
+    free(builder->buckets);
+    free(builder->p_name_offsets);
+    output_free(&builder->names);
+    output_free(&builder->name_buffer);
+    output_free(&builder->value_buffer);
+}
+
+/*****************************************************************************
+* NAME:  build_search_index
+* DESCRIPTION: Index the Extended Content Description Object of every input
+*              file and append a summary to an output buffer
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+build_search_index
+    (const params_t    *params      /* [in] structure containing user-defined parameters */
+    ,output_t          *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    asfparse_error_t        first_error = ASFPARSE_ERROR_OK;
+    asfparse_error_t        error = ASFPARSE_ERROR_OK;
+    search_build_result_t   result;
+    search_builder_t        builder;
+    asfparse_options_t      options;
+    asfparse_ctx_t         *ctx;
+    path_source_t           source;
+    const char             *p_path;
+
+    memset(&result, 0, sizeof(search_build_result_t));
+    memset(&builder, 0, sizeof(search_builder_t));
+    output_init(&builder.names);
+    output_init(&builder.name_buffer);
+    output_init(&builder.value_buffer);
+    builder.num_buckets = MIN_BUCKETS;
+    builder.buckets = calloc(builder.num_buckets, sizeof(search_term_t *));
+
+    /* reading each header stops once its descriptors are found */
+    memset(&options, 0, sizeof(asfparse_options_t));
+    options.object_mask = OBJECT_MASK(OBJECT_TYPE_EXTENDED_CONTENT_DESCRIPTION);
+    ctx = asfparse_create(&options);
+    if (builder.buckets == NULL || ctx == NULL)
+    {
+        error = ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
+    else if (path_source_open(&source, params) != ASFPARSE_ERROR_OK)
+    {
+        error = ASFPARSE_ERROR_OPEN_FILE;
+    }
+    else
+    {
+        while (builder.error == ASFPARSE_ERROR_OK && (p_path = path_source_next(&source)) != NULL)
+        {
+            builder.p_filename = p_path;
+            builder.is_registered = 0;
+            result.num_files++;
+            error = asfparse_parse_file(ctx, p_path, index_event, &builder);
+            if (error)
+            {
+                result.num_errors++;
+                if (first_error == ASFPARSE_ERROR_OK)
+                {
+                    first_error = error;
+                }
+            }
+        }
+        path_source_close(&source);
+
+        error = builder.error;
+        if (error == ASFPARSE_ERROR_OK)
+        {
+            error = write_index(&builder, params->p_search_filename, &result.index_size);
+        }
+    }
+    asfparse_destroy(ctx);
+
+    result.num_indexed = (long long)builder.num_files;
+    result.num_terms = (long long)builder.num_terms;
+    result.num_postings = builder.num_postings;
+    free_builder(&builder);
+
+    /* files that could not be parsed are counted; only a failure to build
+       the index is reported as such */
+    if (params->output_format == OUTPUT_FORMAT_JSON)
+    {
+        output_write(out, "{\"index\":", 9);
+        json_write_string(out, params->p_search_filename, strlen(params->p_search_filename));
+        output_write(out, ",\"build\":", 9);
+        json_search_build_result(&result, out);
+        if (error)
+        {
+            output_printf(out, ",\"error\":{\"code\":%d,\"message\":\"%s\"}", error, asfparse_error_string(error));
+        }
+        output_write(out, "}\n", 2);
+    }
+    else
+    {
+        output_printf(out, "BUILDING INDEX FILE:\n    %s\n", params->p_search_filename);
+        output_printf(out, "\n--------------------------------------------------\n");
+        if (error)
+        {
+            output_printf(out, "Error building index file: %s\n", asfparse_error_string(error));
+        }
+        display_search_build_result(&result, out);
+    }
+
+    return error ? error : first_error;
+}
+
+/*****************************************************************************
+* NAME:  query_search_index
+* DESCRIPTION: Look up the files that match every query term and append them
+*              to an output buffer
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+query_search_index
+    (const params_t    *params      /* [in] structure containing user-defined parameters */
+    ,output_t          *out         /* [in,out] buffer receiving the formatted text */
+    )
+{
+    asfparse_error_t    error;
+    search_index_t     *index = NULL;
+    unsigned int       *p_files = NULL;
+    size_t              num_files = 0;
+
+    error = search_index_open(params->p_search_filename, &index);
+    if (error == ASFPARSE_ERROR_OK)
+    {
+        error = search_index_query(index, params->pp_filenames, params->num_filenames, &p_files, &num_files);
+    }
+
+    if (params->output_format == OUTPUT_FORMAT_JSON)
+    {
+        output_write(out, "{\"index\":", 9);
+        json_write_string(out, params->p_search_filename, strlen(params->p_search_filename));
+        output_write(out, ",\"query\":", 9);
+        json_search_matches(index, params->pp_filenames, params->num_filenames, p_files, num_files, out);
+        if (error)
+        {
+            output_printf(out, ",\"error\":{\"code\":%d,\"message\":\"%s\"}", error, asfparse_error_string(error));
+        }
+        output_write(out, "}\n", 2);
+    }
+    else
+    {
+        output_printf(out, "SEARCHING INDEX FILE:\n    %s\n", params->p_search_filename);
+        output_printf(out, "\n--------------------------------------------------\n");
+        if (error)
+        {
+            output_printf(out, "Error searching index file: %s\n", asfparse_error_string(error));
+        }
+        else
+        {
+            display_search_matches(index, params->pp_filenames, params->num_filenames, p_files, num_files, out);
+        }
+    }
+
+    free(p_files);
+    search_index_close(index);
+
+    return error;
+}
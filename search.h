@@ -0,0 +1,114 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+/* Includes */
+#include <stddef.h>
+#include "util.h"
+#include "cli.h"
+#include "output.h"
+
+/* Defines and constants */
+#define SEARCH_MAX_TERM_LENGTH  (255)       /* longest term indexed (bytes); longer words are skipped */
+#define SEARCH_PREFIX_WILDCARD  '*'         /* a query term ending in this matches every term it starts */
+
+/* Enums and structs */
+/* Structure describing the outcome of building a search index */
+typedef struct {
+    long long       num_files;              /* input files read */
+    long long       num_indexed;            /* files with at least one term */
+    long long       num_errors;             /* files that could not be parsed */
+    long long       num_terms;              /* distinct terms */
+    long long       num_postings;           /* (term, file) pairs */
+    long long       index_size;             /* bytes in the index file */
+} search_build_result_t;
+
+/* Opaque handle on an index file mapped into memory. The file holds a term
+   dictionary sorted by bytes, a posting list of file numbers per term and
+   the names of the files. Terms are the names of Extended Content
+   Description descriptors, lower-cased and followed by '=' ("wm/genre="),
+   and each word of their string and number values, both alone ("jazz") and
+   after the descriptor name ("wm/genre=jazz"). */
+typedef struct search_index_s search_index_t;
+
+/* Function prototypes */
+/*****************************************************************************
+* NAME:  search_index_open
+* DESCRIPTION: Map an index file for queries
+* RETURNS: asfparse_error_t; ASFPARSE_ERROR_INVALID_ARG if the file is not an
+*          index file
+******************************************************************************/
+asfparse_error_t
+search_index_open
+    (const char        *p_filename  /* [in] name of index file */
+    ,search_index_t   **index       /* [out] new handle */
+    );
+
+/*****************************************************************************
+* NAME:  search_index_close
+* DESCRIPTION: Release an index handle
+* RETURNS: none
+******************************************************************************/
+void
+search_index_close
+    (search_index_t    *index       /* [in] index handle, or NULL */
+    );
+
+/*****************************************************************************
+* NAME:  search_index_query
+* DESCRIPTION: Find the files that match every query term. A term is matched
+*              without regard to ASCII case; one ending in
+*              SEARCH_PREFIX_WILDCARD matches every term that starts with the
+*              rest of it.
+* RETURNS: asfparse_error_t; the file numbers are in ascending order and
+*          must be freed by the caller
+******************************************************************************/
+asfparse_error_t
+search_index_query
+    (const search_index_t  *index       /* [in] index handle */
+    ,char * const          *pp_terms    /* [in] query terms */
+    ,int                    num_terms   /* [in] number of entries in pp_terms, at least 1 */
+    ,unsigned int         **pp_files    /* [out] numbers of the matching files */
+    ,size_t                *num_files   /* [out] number of entries in pp_files */
+    );
+
+/*****************************************************************************
+* NAME:  search_index_file_name
+* DESCRIPTION: Get the name of a file in an index
+* RETURNS: NUL-terminated name, valid until the index is closed
+******************************************************************************/
+const char *
+search_index_file_name
+    (const search_index_t  *index       /* [in] index handle */
+    ,unsigned int           file        /* [in] file number from search_index_query */
+    );
+
+/*****************************************************************************
+* NAME:  build_search_index
+* DESCRIPTION: Parse the Extended Content Description Object of every input
+*              file named in params, write an index of their terms to the
+*              index file named in params and append a summary to an output
+*              buffer. The index is written to a temporary file that then
+*              replaces the old one.
+* RETURNS: asfparse_error_t; writing the index failing takes precedence over
+*          the first file (in input order) that could not be parsed
+******************************************************************************/
+asfparse_error_t
+build_search_index
+    (const params_t    *params      /* [in] structure containing user-defined parameters */
+    ,output_t          *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+/*****************************************************************************
+* NAME:  query_search_index
+* DESCRIPTION: Look up the files that match every query term given as input
+*              in params in the index file named in params and append them to
+*              an output buffer
+* RETURNS: asfparse_error_t
+******************************************************************************/
+asfparse_error_t
+query_search_index
+    (const params_t    *params      /* [in] structure containing user-defined parameters */
+    ,output_t          *out         /* [in,out] buffer receiving the formatted text */
+    );
+
+#endif
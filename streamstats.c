@@ -0,0 +1,291 @@
+#include <string.h>
+
+#include "cursor.h"
+#include "streamstats.h"
+
+/* Defines and constants */
+#define MIN_REPLICATED_LENGTH   (8)     /* media object size and presentation time */
+#define BITRATE_RECORD_LENGTH   (6)     /* flags and average bitrate */
+#define BITRATE_STREAM_MASK     (0x7f)  /* bitrate record flags: stream number */
+
+/*****************************************************************************
+* NAME:  close_window
+* DESCRIPTION: Take the bitrate of the window being filled as one sample and
+*              count any windows without payloads up to the given one
+* RETURNS: none
+******************************************************************************/
+static void
+close_window
+    (stream_stats_t    *stats       /* [in,out] statistics of one stream */
+    ,long long          window      /* [in] window to start filling */
+    )
+{
+    long long   bitrate = stats->window_bytes * 8 * 1000 / STATS_WINDOW_MS;
+
+    if (stats->num_windows == 0 || bitrate < stats->min_bitrate)
+    {
+        stats->min_bitrate = bitrate;
+    }
+    if (bitrate > stats->max_bitrate)
+    {
+        stats->max_bitrate = bitrate;
+    }
+    stats->num_windows++;
+
+    /* windows in which nothing was sent are samples of 0 bps */
+    if (window > stats->window + 1)
+    {
+        stats->min_bitrate = 0;
+        stats->num_windows += window - stats->window - 1;
+    }
+
+    stats->window = window;
+    stats->window_bytes = 0;
+}
+
+/*****************************************************************************
+* NAME:  add_media_object
+* DESCRIPTION: Update the presentation time and key frame statistics with a
+*              media object started in the stream
+* RETURNS: none
+******************************************************************************/
+static void
+add_media_object
+    (stream_stats_t    *stats               /* [in,out] statistics of one stream */
+    ,long long          presentation_time   /* [in] milliseconds */
+    ,int                is_key_frame        /* [in] non-zero for a key frame */
+    )
+{
+    long long   delta;
+    long long   variation;
+
+    stats->num_media_objects++;
+
+    if (stats->last_presentation_time >= 0)
+    {
+        delta = presentation_time - stats->last_presentation_time;
+        if (delta < 0)
+        {
+            /* reordered frames; the next delta starts from here */
+            stats->num_backward_steps++;
+            stats->last_delta = -1;
+        }
+        else
+        {
+            if (stats->num_deltas > 0 && delta * stats->num_deltas > STATS_GAP_FACTOR * stats->delta_sum)
+            {
+                stats->num_gaps++;
+            }
+            if (stats->last_delta >= 0)
+            {
+                variation = (delta > stats->last_delta) ? delta - stats->last_delta : stats->last_delta - delta;
+                stats->jitter += ((double)variation - stats->jitter) / STATS_JITTER_GAIN;
+            }
+            if (delta > stats->max_delta)
+            {
+                stats->max_delta = delta;
+            }
+            stats->num_deltas++;
+            stats->delta_sum += delta;
+            stats->last_delta = delta;
+        }
+    }
+    stats->last_presentation_time = presentation_time;
+
+    if (!is_key_frame)
+    {
+        return;
+    }
+    stats->num_key_frames++;
+    if (stats->last_key_frame_time >= 0 && presentation_time >= stats->last_key_frame_time)
+    {
+        delta = presentation_time - stats->last_key_frame_time;
+        if (stats->num_key_frame_intervals == 0 || delta < stats->min_key_frame_interval)
+        {
+            stats->min_key_frame_interval = delta;
+        }
+        if (delta > stats->max_key_frame_interval)
+        {
+            stats->max_key_frame_interval = delta;
+        }
+        stats->num_key_frame_intervals++;
+        stats->key_frame_interval_sum += delta;
+    }
+    stats->last_key_frame_time = presentation_time;
+}
+
+/*****************************************************************************
+* NAME:  add_payload
+* DESCRIPTION: Update the statistics of a stream with one payload
+* RETURNS: none
+******************************************************************************/
+static void
+add_payload
+    (stream_stats_t        *stats       /* [in,out] statistics of one stream */
+    ,const data_packet_t   *packet      /* [in] packet carrying the payload */
+    ,const payload_t       *payload     /* [in] payload */
+    )
+{
+    cursor_t        cur;
+    long long       window = packet->send_time / STATS_WINDOW_MS;
+    unsigned int    presentation_time;
+    unsigned int    delta;
+
+    if (stats->num_payloads == 0)
+    {
+        stats->first_send_time = packet->send_time;
+        stats->window = window;
+    }
+    stats->last_send_time = packet->send_time;
+    stats->last_packet_duration = packet->duration;
+    stats->num_payloads++;
+    stats->payload_bytes += payload->payload_data_length;
+
+    if (window > stats->window)
+    {
+        close_window(stats, window);
+    }
+    stats->window_bytes += payload->payload_data_length;
+
+    if (payload->is_compressed)
+    {
+        /* each sub-payload is a whole media object, spaced by the
+           presentation time delta held in the replicated data */
+        presentation_time = payload->offset_into_media_object;
+        delta = (unsigned char)payload->replicated_data[0];
+        cursor_init(&cur, payload->payload_data, payload->payload_data_length);
+        while (cursor_remaining(&cur) > 0)
+        {
+            cursor_skip(&cur, cursor_read_uint8(&cur));
+            add_media_object(stats, presentation_time, payload->is_key_frame);
+            presentation_time += delta;
+        }
+    }
+    else if (payload->offset_into_media_object == 0
+             && payload->replicated_data_length >= MIN_REPLICATED_LENGTH)
+    {
+        presentation_time = load_uint32_le(payload->replicated_data + 4);
+        add_media_object(stats, presentation_time, payload->is_key_frame);
+    }
+}
+
+/*****************************************************************************
+* NAME:  stream_analysis_init
+* DESCRIPTION: Prepare to gather stream statistics
+* RETURNS: none
+******************************************************************************/
+void
+stream_analysis_init
+    (stream_analysis_t     *analysis    /* [out] stream statistics */
+    )
+{
+    stream_stats_t *stats;
+    int             i;
+
+    memset(analysis, 0, sizeof(stream_analysis_t));
+    for (i = 0; i <= MAX_STREAM_NUMBER; i++)
+    {
+        stats = &analysis->stream[i];
+        stats->declared_bitrate = -1;
+        stats->window = -1;
+        stats->last_presentation_time = -1;
+        stats->last_delta = -1;
+        stats->last_key_frame_time = -1;
+    }
+}
+
+/*****************************************************************************
+* NAME:  stream_analysis_add_bitrates
+* DESCRIPTION: Record the declared average bitrate of each stream listed in a
+*              Stream Bitrate Properties Object
+* RETURNS: none
+******************************************************************************/
+void
+stream_analysis_add_bitrates
+    (stream_analysis_t                         *analysis                    /* [in,out] stream statistics */
+    ,const stream_bitrate_properties_object_t  *stream_bitrate_properties   /* [in] struct containing info about stream bitrate properties object */
+    )
+{
+    cursor_t    cur;
+    int         stream_number;
+    int         i;
+
+    cursor_init(&cur, stream_bitrate_properties->bitrate_records,
+                (size_t)stream_bitrate_properties->bitrate_records_count * BITRATE_RECORD_LENGTH);
+    for (i = 0; i < stream_bitrate_properties->bitrate_records_count; i++)
+    {
+        stream_number = (int)cursor_read_uint16(&cur) & BITRATE_STREAM_MASK;
+        analysis->stream[stream_number].declared_bitrate = cursor_read_uint32(&cur);
+    }
+}
+
+/*****************************************************************************
+* NAME:  stream_analysis_add_packet
+* DESCRIPTION: Update the statistics of each stream with a payload in a data
+*              packet
+* RETURNS: none
+******************************************************************************/
+void
+stream_analysis_add_packet
+    (stream_analysis_t     *analysis    /* [in,out] stream statistics */
+    ,const data_packet_t   *packet      /* [in] decoded data packet */
+    )
+{
+    const payload_t    *payload;
+    int                 i;
+
+    for (i = 0; i < packet->num_payloads; i++)
+    {
+        payload = &packet->payload[i];
+        add_payload(&analysis->stream[payload->stream_number], packet, payload);
+    }
+}
+
+/*****************************************************************************
+* NAME:  stream_analysis_finish
+* DESCRIPTION: Account for the bitrate windows still being filled once the
+*              last packet has been added
+* RETURNS: none
+******************************************************************************/
+void
+stream_analysis_finish
+    (stream_analysis_t     *analysis    /* [in,out] stream statistics */
+    )
+{
+    stream_stats_t *stats;
+    int             i;
+
+    /* the last window is usually cut short, so it only counts when it is
+       the only one */
+    for (i = 0; i <= MAX_STREAM_NUMBER; i++)
+    {
+        stats = &analysis->stream[i];
+        if (stats->num_payloads > 0 && stats->num_windows == 0)
+        {
+            close_window(stats, stats->window + 1);
+        }
+    }
+}
+
+/*****************************************************************************
+* NAME:  stream_stats_mean_bitrate
+* DESCRIPTION: Work out the observed average bitrate of a stream over the
+*              send time of its packets
+* RETURNS: bits per second, or 0 if the stream spans no time
+******************************************************************************/
+long long
+stream_stats_mean_bitrate
+    (const stream_stats_t  *stats       /* [in] statistics of one stream */
+    )
+{
+    long long   duration;
+
+    /* the last packet is sent for its duration after its send time */
+    duration = (long long)stats->last_send_time - stats->first_send_time + stats->last_packet_duration;
+    if (stats->num_payloads == 0 || duration <= 0)
+    {
+        return 0;
+    }
+
+    return stats->payload_bytes * 8 * 1000 / duration;
+}
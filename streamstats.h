@@ -0,0 +1,116 @@
+#ifndef STREAMSTATS_H
+#define STREAMSTATS_H
+
+/* Includes */
+#include "util.h"
+#include "packet.h"
+
+/* Defines and constants */
+#define STATS_WINDOW_MS         (1000)  /* send time covered by one bitrate sample */
+#define STATS_GAP_FACTOR        (2)     /* a delta this many times the mean so far counts as a gap */
+#define STATS_JITTER_GAIN       (16)    /* jitter moves 1/16 of the way to each new delta variation */
+
+/* Enums and structs */
+/* Structure describing the statistics gathered for one stream number in a
+   single pass over the data packets. Presentation times are those of the
+   media objects started in the stream, taken from the replicated data, or
+   from the payload header for compressed payloads. */
+typedef struct {
+    long long       num_payloads;
+    long long       payload_bytes;
+    long long       num_media_objects;          /* media objects started */
+    long long       num_key_frames;             /* key frame media objects started */
+    unsigned int    first_send_time;            /* milliseconds */
+    unsigned int    last_send_time;             /* milliseconds */
+    unsigned int    last_packet_duration;       /* duration of the last packet carrying the stream (ms) */
+    long long       declared_bitrate;           /* average bitrate from the Stream Bitrate Properties Object, or -1 */
+
+    /* payload bytes per STATS_WINDOW_MS of send time */
+    long long       window;                     /* window being filled, or -1 */
+    long long       window_bytes;               /* bytes sent in that window so far */
+    long long       num_windows;                /* complete windows measured */
+    long long       min_bitrate;                /* bits per second */
+    long long       max_bitrate;                /* bits per second */
+
+    /* presentation time deltas between successive media objects */
+    long long       last_presentation_time;     /* milliseconds, or -1 */
+    long long       last_delta;                 /* milliseconds, or -1 */
+    long long       num_deltas;
+    long long       delta_sum;                  /* milliseconds */
+    long long       max_delta;                  /* milliseconds */
+    long long       num_gaps;                   /* deltas more than STATS_GAP_FACTOR times the mean so far */
+    long long       num_backward_steps;         /* presentation time went backwards */
+    double          jitter;                     /* smoothed variation between successive deltas (ms) */
+
+    /* presentation time between key frames */
+    long long       last_key_frame_time;        /* milliseconds, or -1 */
+    long long       num_key_frame_intervals;
+    long long       key_frame_interval_sum;     /* milliseconds */
+    long long       min_key_frame_interval;     /* milliseconds */
+    long long       max_key_frame_interval;     /* milliseconds */
+} stream_stats_t;
+
+/* Structure describing the statistics of every stream number; the memory
+   needed does not depend on the length of the file */
+typedef struct {
+    stream_stats_t  stream[MAX_STREAM_NUMBER + 1];
+} stream_analysis_t;
+
+/* Function prototypes */
+/*****************************************************************************
+* NAME:  stream_analysis_init
+* DESCRIPTION: Prepare to gather stream statistics
+* RETURNS: none
+******************************************************************************/
+void
+stream_analysis_init
+    (stream_analysis_t     *analysis    /* [out] stream statistics */
+    );
+
+/*****************************************************************************
+* NAME:  stream_analysis_add_bitrates
+* DESCRIPTION: Record the declared average bitrate of each stream listed in a
+*              Stream Bitrate Properties Object
+* RETURNS: none
+******************************************************************************/
+void
+stream_analysis_add_bitrates
+    (stream_analysis_t                         *analysis                    /* [in,out] stream statistics */
+    ,const stream_bitrate_properties_object_t  *stream_bitrate_properties   /* [in] struct containing info about stream bitrate properties object */
+    );
+
+/*****************************************************************************
+* NAME:  stream_analysis_add_packet
+* DESCRIPTION: Update the statistics of each stream with a payload in a data
+*              packet. Packets must be added in file order.
+* RETURNS: none
+******************************************************************************/
+void
+stream_analysis_add_packet
+    (stream_analysis_t     *analysis    /* [in,out] stream statistics */
+    ,const data_packet_t   *packet      /* [in] decoded data packet */
+    );
+
+/*****************************************************************************
+* NAME:  stream_analysis_finish
+* DESCRIPTION: Account for the bitrate windows still being filled once the
+*              last packet has been added
+* RETURNS: none
+******************************************************************************/
+void
+stream_analysis_finish
+    (stream_analysis_t     *analysis    /* [in,out] stream statistics */
+    );
+
+/*****************************************************************************
+* NAME:  stream_stats_mean_bitrate
+* DESCRIPTION: Work out the observed average bitrate of a stream over the
+*              send time of its packets
+* RETURNS: bits per second, or 0 if the stream spans no time
+******************************************************************************/
+long long
+stream_stats_mean_bitrate
+    (const stream_stats_t  *stats       /* [in] statistics of one stream */
+    );
+
+#endif
@@ -0,0 +1,232 @@
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "utf16.h"
+
+/* Defines and constants */
+#define HIGH_SURROGATE_FIRST    (0xd800)
+#define LOW_SURROGATE_FIRST     (0xdc00)
+#define SURROGATE_LAST          (0xdfff)
+#define REPLACEMENT_CHARACTER   (0xfffd)
+
+/*****************************************************************************
+* NAME:  read_unit
+* DESCRIPTION: Read one little-endian UTF-16 code unit
+* RETURNS: unsigned int
+******************************************************************************/
+static inline unsigned int
+read_unit
+    (const unsigned char   *p_src   /* [in] first byte of the code unit */
+    )
+{
+    return p_src[0] | ((unsigned int)p_src[1] << 8);
+}
+
+#if defined(__SSE2__)
+/*****************************************************************************
+* NAME:  ascii_run_sse2
+* DESCRIPTION: Convert leading blocks of 16 code units that are all ASCII,
+*              narrowing each block with one pack instruction
+* RETURNS: number of code units converted
+******************************************************************************/
+static size_t
+ascii_run_sse2
+    (unsigned char         *p_dest      /* [out] ASCII bytes */
+    ,const unsigned char   *p_src       /* [in] UTF-16LE code units */
+    ,size_t                 num_units   /* [in] number of code units available */
+    )
+{
+    const __m128i   non_ascii = _mm_set1_epi16((short)0xff80);
+    const __m128i   zero = _mm_setzero_si128();
+    __m128i         lo;
+    __m128i         hi;
+    size_t          i = 0;
+
+    while (i + 16 <= num_units)
+    {
+        lo = _mm_loadu_si128((const __m128i *)(p_src + 2 * i));
+        hi = _mm_loadu_si128((const __m128i *)(p_src + 2 * i + 16));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(_mm_or_si128(lo, hi), non_ascii), zero)) != 0xffff)
+        {
+            break;
+        }
+        _mm_storeu_si128((__m128i *)(p_dest + i), _mm_packus_epi16(lo, hi));
+        i += 16;
+    }
+
+    return i;
+}
+
+/*****************************************************************************
+* NAME:  ascii_run_avx2
+* DESCRIPTION: Convert leading blocks of 32 code units that are all ASCII,
+*              then hand any shorter remainder to the SSE2 path
+* RETURNS: number of code units converted
+******************************************************************************/
+__attribute__((target("avx2")))
+static size_t
+ascii_run_avx2
+    (unsigned char         *p_dest      /* [out] ASCII bytes */
+    ,const unsigned char   *p_src       /* [in] UTF-16LE code units */
+    ,size_t                 num_units   /* [in] number of code units available */
+    )
+{
+    const __m256i   non_ascii = _mm256_set1_epi16((short)0xff80);
+    __m256i         lo;
+    __m256i         hi;
+    __m256i         packed;
+    size_t          i = 0;
+
+    while (i + 32 <= num_units)
+    {
+        lo = _mm256_loadu_si256((const __m256i *)(p_src + 2 * i));
+        hi = _mm256_loadu_si256((const __m256i *)(p_src + 2 * i + 32));
+        if (!_mm256_testz_si256(_mm256_or_si256(lo, hi), non_ascii))
+        {
+            break;
+        }
+
+        /* the pack works within 128-bit lanes, so restore the qword order */
+        packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xd8);
+        _mm256_storeu_si256((__m256i *)(p_dest + i), packed);
+        i += 32;
+    }
+
+    return i + ascii_run_sse2(p_dest + i, p_src + 2 * i, num_units - i);
+}
+#endif
+
+/*****************************************************************************
+* NAME:  ascii_run
+* DESCRIPTION: Convert a leading run of ASCII code units a block at a time,
+*              using the widest vector instructions the CPU supports
+* RETURNS: number of code units converted (may stop short of the run's end)
+******************************************************************************/
+static inline size_t
+ascii_run
+    (unsigned char         *p_dest      /* [out] ASCII bytes */
+    ,const unsigned char   *p_src       /* [in] UTF-16LE code units */
+    ,size_t                 num_units   /* [in] number of code units available */
+    )
+{
+#if defined(__SSE2__)
+    if (num_units >= 32 && __builtin_cpu_supports("avx2"))
+    {
+        return ascii_run_avx2(p_dest, p_src, num_units);
+    }
+    return ascii_run_sse2(p_dest, p_src, num_units);
+#else
+    (void)p_dest;
+    (void)p_src;
+    (void)num_units;
+    return 0;
+#endif
+}
+
+/*****************************************************************************
+* NAME:  utf16le_length
+* DESCRIPTION: Count the UTF-16 code units of a string before its NUL
+*              terminator, if it has one
+* RETURNS: number of code units
+******************************************************************************/
+size_t
+utf16le_length
+    (const char    *p_src       /* [in] UTF-16LE code units */
+    ,size_t         num_units   /* [in] maximum number of code units to examine */
+    )
+{
+    const unsigned char    *p = (const unsigned char *)p_src;
+    size_t                  i;
+
+    for (i = 0; i < num_units; i++)
+    {
+        if ((p[2 * i] | p[2 * i + 1]) == 0)
+        {
+            break;
+        }
+    }
+
+    return i;
+}
+
+/*****************************************************************************
+* NAME:  utf16le_to_utf8
+* DESCRIPTION: Transcode a UTF-16LE string to UTF-8
+* RETURNS: number of bytes written to p_dest
+******************************************************************************/
+size_t
+utf16le_to_utf8
+    (char          *p_dest      /* [out] UTF-8 bytes */
+    ,const char    *p_src       /* [in] UTF-16LE code units, any alignment */
+    ,size_t         num_units   /* [in] number of code units to convert */
+    )
+{
+    const unsigned char    *p_in = (const unsigned char *)p_src;
+    unsigned char          *p_out = (unsigned char *)p_dest;
+    unsigned int            unit;
+    unsigned int            next;
+    unsigned int            code_point;
+    size_t                  run;
+    size_t                  i = 0;
+
+    while (i < num_units)
+    {
+        /* bulk-convert ASCII, then take the scalar path until the next
+           ASCII character so that non-Latin text does not retry the
+           vector check after every character */
+        run = ascii_run(p_out, p_in + 2 * i, num_units - i);
+        i += run;
+        p_out += run;
+
+        while (i < num_units)
+        {
+            unit = read_unit(p_in + 2 * i);
+            i++;
+
+            if (unit < 0x80)
+            {
+                *p_out++ = (unsigned char)unit;
+                break;
+            }
+            else if (unit < 0x800)
+            {
+                *p_out++ = (unsigned char)(0xc0 | (unit >> 6));
+                *p_out++ = (unsigned char)(0x80 | (unit & 0x3f));
+                continue;
+            }
+
+            code_point = unit;
+            if (unit >= HIGH_SURROGATE_FIRST && unit <= SURROGATE_LAST)
+            {
+                /* a high surrogate must be followed by a low surrogate */
+                next = (i < num_units) ? read_unit(p_in + 2 * i) : 0;
+                if (unit < LOW_SURROGATE_FIRST && next >= LOW_SURROGATE_FIRST && next <= SURROGATE_LAST)
+                {
+                    code_point = 0x10000 + ((unit - HIGH_SURROGATE_FIRST) << 10) + (next - LOW_SURROGATE_FIRST);
+                    i++;
+                }
+                else
+                {
+                    code_point = REPLACEMENT_CHARACTER;
+                }
+            }
+
+            if (code_point < 0x10000)
+            {
+                *p_out++ = (unsigned char)(0xe0 | (code_point >> 12));
+                *p_out++ = (unsigned char)(0x80 | ((code_point >> 6) & 0x3f));
+                *p_out++ = (unsigned char)(0x80 | (code_point & 0x3f));
+            }
+            else
+            {
+                *p_out++ = (unsigned char)(0xf0 | (code_point >> 18));
+                *p_out++ = (unsigned char)(0x80 | ((code_point >> 12) & 0x3f));
+                *p_out++ = (unsigned char)(0x80 | ((code_point >> 6) & 0x3f));
+                *p_out++ = (unsigned char)(0x80 | (code_point & 0x3f));
+            }
+        }
+    }
+
+    return (size_t)(p_out - (unsigned char *)p_dest);
+}
@@ -0,0 +1,41 @@
+#ifndef UTF16_H
+#define UTF16_H
+
+/* Includes */
+#include <stddef.h>
+
+/* Defines and constants */
+#define UTF8_MAX_BYTES_PER_UTF16_UNIT   (3)     /* a BMP character takes at most 3 bytes; a surrogate pair (2 units) takes 4 */
+
+/* Function prototypes */
+/*****************************************************************************
+* NAME:  utf16le_length
+* DESCRIPTION: Count the UTF-16 code units of a string before its NUL
+*              terminator, if it has one
+* RETURNS: number of code units
+******************************************************************************/
+size_t
+utf16le_length
+    (const char    *p_src       /* [in] UTF-16LE code units */
+    ,size_t         num_units   /* [in] maximum number of code units to examine */
+    );
+
+/*****************************************************************************
+* NAME:  utf16le_to_utf8
+* DESCRIPTION: Transcode a UTF-16LE string to UTF-8. Runs of ASCII are
+*              converted 16 or 32 code units at a time with SSE2 or AVX2
+*              where available; other characters, including surrogate pairs,
+*              take a scalar path. Unpaired surrogates become U+FFFD.
+*              p_dest must have room for
+*              num_units * UTF8_MAX_BYTES_PER_UTF16_UNIT bytes and is not
+*              NUL-terminated.
+* RETURNS: number of bytes written to p_dest
+******************************************************************************/
+size_t
+utf16le_to_utf8
+    (char          *p_dest      /* [out] UTF-8 bytes */
+    ,const char    *p_src       /* [in] UTF-16LE code units, any alignment */
+    ,size_t         num_units   /* [in] number of code units to convert */
+    );
+
+#endif
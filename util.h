@@ -2,78 +2,25 @@
 #define UTIL_H
 
 /* Includes */
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
 /* Defines and constants */
-#define NUM_COMMAND_LINE_ARGS   (2)                     /* number of expected arguments from the command line */
+#define OBJECT_MASK(type)       (1u << (type))          /* bit representing an object_type_t in an object mask */
 #define GUID_LENGTH_IN_BYTES    (16)                    /* length of Globally Unique Identifier in bytes */
-#define MAX_BYTES_TO_READ       (GUID_LENGTH_IN_BYTES)  /* maximum number of bytes to read from a file pointer */
-#define MAX_LENGTH_DATA         (5000)                  /* maximum number of bytes in stream properties and header 
-                                                           extension data */
-#define MAX_NUM_CODEC_ENTRIES   (4)                     /* maximum number of codec entries in a codec list object */
-#define MAX_LENGTH_CODEC_NAME   (256)                   /* maximum number of bytes in a codec name */
-#define MAX_NUM_CONTENT_DESC    (256)                   /* maximum number of content descriptors in an extended content
-                                                           description object */
-#define MAX_LENGTH_DESC_NAME    (256)                   /* maximum number of bytes in a content descriptor name */
-#define MAX_LENGTH_DESC_VALUE   (128)                   /* maximum number of bytes in a content descriptor value */
-
-/* Top-level Header Object GUID, defined in Section 10.1 of the ASF Specification */
-static const char ASF_HEADER_OBJECT_GUID[GUID_LENGTH_IN_BYTES] =
-{
-    0x30, 0x26, 0xb2, 0x75, 0x8e, 0x66, 0xcf, 0x11,
-    0xa6, 0xd9, 0x00, 0xaa, 0x00, 0x62, 0xce, 0x6c
-};
-
-/* Header Object GUIDs, defined in Section 10.2 of the ASF Specification */
-static const char ASF_FILE_PROPERTIES_OBJECT_GUID[GUID_LENGTH_IN_BYTES] =
-{
-    0xa1, 0xdc, 0xab, 0x8c, 0x47, 0xa9, 0xcf, 0x11,
-    0x8e, 0xe4, 0x00, 0xc0, 0x0c, 0x20, 0x53, 0x65
-};
-
-static const char ASF_STREAM_PROPERTIES_OBJECT_GUID[GUID_LENGTH_IN_BYTES] =
-{
-    0x91, 0x07, 0xdc, 0xb7, 0xb7, 0xa9, 0xcf, 0x11,
-    0x8e, 0xe6, 0x00, 0xc0, 0x0c, 0x20, 0x53, 0x65
-};
-
-static const char ASF_HEADER_EXTENSION_OBJECT_GUID[GUID_LENGTH_IN_BYTES] =
-{
-    0xb5, 0x03, 0xbf, 0x5f, 0x2e, 0xa9, 0xcf, 0x11,
-    0x8e, 0xe3, 0x00, 0xc0, 0x0c, 0x20, 0x53, 0x65
-};
-
-static const char ASF_CODEC_LIST_OBJECT_GUID[GUID_LENGTH_IN_BYTES] =
-{
-    0x40, 0x52, 0xd1, 0x86, 0x1d, 0x31, 0xd0, 0x11,
-    0xa3, 0xa4, 0x00, 0xa0, 0xc9, 0x03, 0x48, 0xf6
-};
-
-static const char ASF_EXTENDED_CONTENT_DESCRIPTION_OBJECT_GUID[GUID_LENGTH_IN_BYTES] =
-{
-    0x40, 0xa4, 0xd0, 0xd2, 0x07, 0xe3, 0xd2, 0x11,
-    0x97, 0xf0, 0x00, 0xa0, 0xc9, 0x5e, 0xa8, 0x50
-};
 
-static const char ASF_STREAM_BITRATE_PROPERTIES_OBJECT_GUID[GUID_LENGTH_IN_BYTES] =
-{
-    0xce, 0x75, 0xf8, 0x7b, 0x8d, 0x46, 0xd1, 0x11,
-    0x8d, 0x82, 0x00, 0x60, 0x97, 0xc9, 0xa2, 0xb2
-};
-
-/* Stream Properties Object Stream Type GUIDs, defined in Section 10.4 of the ASF Specification */
-static const char ASF_AUDIO_MEDIA_GUID[GUID_LENGTH_IN_BYTES] =
-{
-    0x40, 0x9e, 0x69, 0xf8, 0x4d, 0x5b, 0xcf, 0x11,
-    0xa8, 0xfd, 0x00, 0x80, 0x5f, 0x5c, 0x44, 0x2b
-};
-
-static const char ASF_VIDEO_MEDIA_GUID[GUID_LENGTH_IN_BYTES] =
-{
-    0xc0, 0xef, 0x19, 0xbc, 0x4d, 0x5b, 0xcf, 0x11,
-    0xa8, 0xfd, 0x00, 0x80, 0x5f, 0x5c, 0x44, 0x2b
-};
+/* ASF integers are little-endian; a big-endian host swaps each value after
+   loading it */
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define LE16_TO_HOST(x)         __builtin_bswap16(x)
+#define LE32_TO_HOST(x)         __builtin_bswap32(x)
+#define LE64_TO_HOST(x)         __builtin_bswap64(x)
+#else
+#define LE16_TO_HOST(x)         (x)
+#define LE32_TO_HOST(x)         (x)
+#define LE64_TO_HOST(x)         (x)
+#endif
 
 /* Enums and structs */
 /* Enum describing possible errors */
@@ -83,6 +30,10 @@ typedef enum {
     ,ASFPARSE_ERROR_OPEN_FILE
     ,ASFPARSE_ERROR_INVALID_ASF_FILE
     ,ASFPARSE_ERROR_UNSUPPORTED_OBJECT_TYPE
+    ,ASFPARSE_ERROR_TRUNCATED_OBJECT
+    ,ASFPARSE_ERROR_OUT_OF_MEMORY
+    ,ASFPARSE_ERROR_OBJECT_NOT_FOUND
+    ,ASFPARSE_ERROR_WRITE_FILE
 } asfparse_error_t;
 
 /* Enum describing possible object types */
@@ -95,154 +46,235 @@ typedef enum {
     ,OBJECT_TYPE_HEADER_EXTENSION
     ,OBJECT_TYPE_EXTENDED_CONTENT_DESCRIPTION
     ,OBJECT_TYPE_STREAM_BITRATE_PROPERTIES
+    ,OBJECT_TYPE_DATA
+    ,OBJECT_TYPE_SIMPLE_INDEX
+    ,OBJECT_TYPE_INDEX
+    ,NUM_OBJECT_TYPES
 } object_type_t;
 
-/* Structure describing user-defined parameters */
-typedef struct {
-    const char     *p_filename;
-    FILE           *p_file;
-} params_t;
+/* Mask of the object types that can appear inside the Header Object */
+#define HEADER_OBJECTS_MASK     (OBJECT_MASK(OBJECT_TYPE_FILE_PROPERTIES)               \
+                                | OBJECT_MASK(OBJECT_TYPE_STREAM_PROPERTIES)            \
+                                | OBJECT_MASK(OBJECT_TYPE_CODEC_LIST)                   \
+                                | OBJECT_MASK(OBJECT_TYPE_HEADER_EXTENSION)             \
+                                | OBJECT_MASK(OBJECT_TYPE_EXTENDED_CONTENT_DESCRIPTION) \
+                                | OBJECT_MASK(OBJECT_TYPE_STREAM_BITRATE_PROPERTIES))
 
 /* Structure describing a header object, defined in Section 3.1 of the ASF
    Specification */
 typedef struct {
-    int             object_size;
-    int             num_objects;
+    long long       object_size;
+    long long       num_objects;
 } header_object_t;
 
 /* Structure describing a file properties object, defined in Section 3.2 of 
    the ASF Specification */
 typedef struct {
-    int             object_size;
-    int             file_size;
-    int             creation_date;
-    int             data_packets_count;
-    int             play_duration;
-    int             send_duration;
-    int             preroll;
-    int             flags;
-    int             min_data_packet_size;
-    int             max_data_packet_size;
-    int             max_bitrate;
+    long long       object_size;
+    long long       file_size;
+    long long       creation_date;              /* 100-nanosecond units since January 1, 1601 */
+    long long       data_packets_count;
+    long long       play_duration;              /* 100-nanosecond units */
+    long long       send_duration;              /* 100-nanosecond units */
+    long long       preroll;                    /* milliseconds */
+    long long       flags;
+    long long       min_data_packet_size;
+    long long       max_data_packet_size;
+    long long       max_bitrate;                /* bits per second */
 } file_properties_object_t;
 
 /* Structure describing a stream properties object, defined in Section 3.3 of 
-   the ASF Specification */
+   the ASF Specification. Pointer members refer into the mapped input file. */
 typedef struct {
-    int             object_size;
-    char            stream_type[GUID_LENGTH_IN_BYTES];
-    char            err_correction_type[GUID_LENGTH_IN_BYTES];
-    int             time_offset;
-    int             type_specific_data_length;
-    int             err_correction_data_length;
+    long long       object_size;
+    const char     *stream_type;
+    const char     *err_correction_type;
+    long long       time_offset;                /* 100-nanosecond units */
+    long long       type_specific_data_length;
+    long long       err_correction_data_length;
     int             flags;
-    char            type_specific_data[MAX_LENGTH_DATA];
-    unsigned char	err_correction_data[MAX_LENGTH_DATA];
+    const char     *type_specific_data;
+    const char     *err_correction_data;
 } stream_properties_object_t;
 
 /* Structure describing a header extension object, defined in Section 3.4 of 
-   the ASF Specification */
+   the ASF Specification. The data member refers into the mapped input file. */
 typedef struct {
-    int             object_size;
-    int             data_size;
-    char            data[MAX_LENGTH_DATA];
+    long long       object_size;
+    long long       data_size;
+    const char     *data;
 } header_extension_object_t;
 
 /* Structures describing a codec entry and a codec list object, defined in 
-   Section 3.5 of the ASF Specification */
+   Section 3.5 of the ASF Specification. Strings refer into the mapped input
+   file; the codec entry array is allocated from the per-file arena. */
 typedef struct {
     int             codec_type;
     int             codec_name_length;
-    char            codec_name[MAX_LENGTH_CODEC_NAME];
+    const char     *codec_name;
     int             codec_description_length;
-    char            codec_description[MAX_LENGTH_CODEC_NAME];
+    const char     *codec_description;
     int             codec_information_length;
-    char            codec_information[MAX_LENGTH_CODEC_NAME];
+    const char     *codec_information;
 } codec_entry_t;
 
 typedef struct {
-    int             object_size;
-    int             codec_entry_count;
-    codec_entry_t   codec_entry[MAX_NUM_CODEC_ENTRIES];
+    long long       object_size;
+    long long       codec_entry_count;
+    codec_entry_t  *codec_entry;
 } codec_list_object_t;
 
 /* Structures describing a content descriptor and an extended content
-   description object, defined in Section 3.11 of the ASF Specification */
+   description object, defined in Section 3.11 of the ASF Specification.
+   Names and values refer into the mapped input file; the descriptor array
+   is allocated from the per-file arena. */
 typedef struct {
     int             name_length;
-    char            name[MAX_LENGTH_DESC_NAME];
+    const char     *name;
     int             value_data_type;
     int             value_length;
-    char            value[MAX_LENGTH_DESC_VALUE];
+    const char     *value;
 } content_descriptor_t;
 
 typedef struct {
-    int                     object_size;
+    long long               object_size;
     int                     descriptor_count;
-    content_descriptor_t    descriptor[MAX_NUM_CONTENT_DESC];
+    content_descriptor_t   *descriptor;
 } extended_content_description_object_t;
 
 /* Structure describing a stream bitrate properties object, defined in
-   Section 3.12 of the ASF Specification */
+   Section 3.12 of the ASF Specification. Bitrate records (6 bytes each: a
+   flags WORD holding the stream number, and the average bitrate in bits per
+   second) are left in the mapped input file. */
 typedef struct {
-    int             object_size;
+    long long       object_size;
     int             bitrate_records_count;
+    const char     *bitrate_records;
 } stream_bitrate_properties_object_t;
 
+/* Structure describing a data object, defined in Section 5.1 of the ASF
+   Specification */
+typedef struct {
+    long long       object_size;
+    long long       total_data_packets;
+    size_t          packets_offset;     /* offset of the first data packet in the file */
+    size_t          packets_size;       /* number of bytes of data packets in the file */
+} data_object_t;
+
+/* Structure describing a simple index object, defined in Section 6.1 of the
+   ASF Specification. Index entries (6 bytes each) are left in the mapped
+   input file. */
+typedef struct {
+    long long       object_size;
+    long long       index_entry_time_interval;  /* 100-nanosecond units */
+    long long       max_packet_count;
+    long long       index_entries_count;
+    const char     *index_entries;
+} simple_index_object_t;
+
+/* Structure describing an index object, defined in Section 6.2 of the ASF
+   Specification. Index specifiers (4 bytes each) and index blocks are left
+   in the mapped input file. */
+typedef struct {
+    long long       object_size;
+    long long       index_entry_time_interval;  /* milliseconds */
+    int             index_specifiers_count;
+    long long       index_blocks_count;
+    const char     *index_specifiers;
+    const char     *index_blocks;
+    size_t          index_blocks_size;
+} index_object_t;
+
 
 /* Function prototypes */
 /*****************************************************************************
-* NAME:  display_banner
-* DESCRIPTION: Display version and configuration info
-* RETURNS: none
+* NAME: load_uint16_le
+* DESCRIPTION: Load a little-endian 16-bit integer from any alignment
+* RETURNS: unsigned int
 ******************************************************************************/
-void
-display_banner
-    (
-    );
+static inline unsigned int
+load_uint16_le
+    (const char    *p           /* [in] first of 2 bytes */
+    )
+{
+    uint16_t    value;
+
+    memcpy(&value, p, sizeof(value));
+
+    return LE16_TO_HOST(value);
+}
 
 /*****************************************************************************
-* NAME: show_usage
-* DESCRIPTION: Display usage to command line
-* RETURNS: none
+* NAME: load_uint32_le
+* DESCRIPTION: Load a little-endian 32-bit integer from any alignment
+* RETURNS: unsigned int
 ******************************************************************************/
-void
-show_usage
-    (
-    );
+static inline unsigned int
+load_uint32_le
+    (const char    *p           /* [in] first of 4 bytes */
+    )
+{
+    uint32_t    value;
+
+    memcpy(&value, p, sizeof(value));
+
+    return LE32_TO_HOST(value);
+}
 
 /*****************************************************************************
-* NAME: parse_command_line
-* DESCRIPTION: Parse command-line input
-* RETURNS: asfparse_error_t
+* NAME: load_uint64_le
+* DESCRIPTION: Load a little-endian 64-bit integer from any alignment
+* RETURNS: unsigned long long
 ******************************************************************************/
-asfparse_error_t
-parse_command_line
-    (int        argc        /* [in] number of command line arguments */
-    ,char      *p_argv[]    /* [in] array of command line arguments */
-    ,params_t  *params      /* [out] structure containing user-defined parameters */
-    );
+static inline unsigned long long
+load_uint64_le
+    (const char    *p           /* [in] first of 8 bytes */
+    )
+{
+    uint64_t    value;
+
+    memcpy(&value, p, sizeof(value));
+
+    return LE64_TO_HOST(value);
+}
 
 /*****************************************************************************
-* NAME: convert_char_bytes_to_int
-* DESCRIPTION: Convert an array of bytes to an integer value
-* RETURNS: long long
+* NAME: load_uint_le
+* DESCRIPTION: Load a little-endian integer of up to 8 bytes whose width is
+*              only known at run time, such as a content descriptor value
+*              that may be shorter than its data type
+* RETURNS: unsigned long long (0 if num_bytes is 0 or more than 8)
 ******************************************************************************/
-long long
-convert_char_bytes_to_int
-    (char      *buffer      /* [in] char buffer */
-    ,int        num_bytes   /* [in] number of bytes in buffer */
-    );
+static inline unsigned long long
+load_uint_le
+    (const char    *p           /* [in] first byte */
+    ,size_t         num_bytes   /* [in] width of the integer in bytes */
+    )
+{
+    unsigned long long  value = 0;
+
+    if (num_bytes > 8)
+    {
+        return 0;
+    }
+    while (num_bytes > 0)
+    {
+        num_bytes--;
+        value = (value << 8) | (unsigned char)p[num_bytes];
+    }
+
+    return value;
+}
 
 /*****************************************************************************
-* NAME: get_object_type
-* DESCRIPTION: Get ASF object type from its GUID (Globally Unique Identifier)
-* RETURNS: asfparse_error
+* NAME: get_object_name
+* DESCRIPTION: Get the short name of an ASF object type, as accepted by the
+*              -o option and used in JSON output
+* RETURNS: constant NUL-terminated string
 ******************************************************************************/
-asfparse_error_t
-get_object_type
-    (char          *guid        /* [in] char buffer containing object's GUID */
-    ,object_type_t *obj_type    /* [out] object type */
+const char *
+get_object_name
+    (object_type_t  obj_type    /* [in] object type */
     );
 
-#endif
\ No newline at end of file
+#endif
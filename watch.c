@@ -0,0 +1,815 @@
+#include <dirent.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+
+#include "cache.h"
+#include "json.h"
+#include "output.h"
+#include "process.h"
+#include "watch.h"
+
+/* Defines and constants */
+#define FNV_OFFSET_BASIS        (0xcbf29ce484222325ull)
+#define FNV_PRIME               (0x100000001b3ull)
+#define MIN_BUCKETS             (1024)
+
+/* Events watched on every directory */
+#define WATCH_MASK              (IN_CREATE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO \
+                                 | IN_DELETE | IN_ONLYDIR | IN_DONT_FOLLOW)
+
+/* Names of media files that are watched */
+static const char *media_extensions[] = {".asf", ".wmv", ".wma"};
+
+/* Enums and structs */
+/* Structure describing a media file seen under a watched directory. The
+   path is held in the same allocation as the entry. */
+typedef struct watch_file_s {
+    struct watch_file_s    *hash_next;      /* next file in the same bucket */
+    struct watch_file_s    *pending_next;   /* next file waiting to settle */
+    unsigned long long      hash;           /* hash of the path */
+    const char             *p_path;         /* NUL-terminated path */
+    header_cache_key_t      key;            /* identity of the file when it was last parsed or found */
+    int                     is_known;       /* non-zero once key is valid */
+    int                     is_pending;     /* non-zero while in the pending list */
+    unsigned long long      deadline;       /* time (ns) at which the file is taken as settled */
+    unsigned int            generation;     /* last rescan that found the file */
+} watch_file_t;
+
+/* Structure describing the state of a watch */
+typedef struct {
+    const params_t     *params;             /* user-defined parameters */
+    asfparse_ctx_t     *ctx;                /* parser context */
+    output_t            out;                /* output of the file being parsed */
+    output_t            record;             /* change record being written */
+    int                 fd;                 /* inotify descriptor */
+    char              **pp_directories;     /* path of each watched directory, by watch descriptor */
+    int                 num_directories;    /* entries in pp_directories */
+    watch_file_t      **buckets;            /* hash chains of the files, num_buckets entries */
+    size_t              num_buckets;        /* power of two */
+    size_t              num_files;
+    watch_file_t       *pending;            /* files waiting to settle */
+    unsigned int        generation;         /* number of the last rescan */
+} watcher_t;
+
+/*****************************************************************************
+* NAME:  now_ns
+* DESCRIPTION: Read the monotonic clock
+* RETURNS: nanoseconds since an arbitrary point
+******************************************************************************/
+static unsigned long long
+now_ns
+    (
+    )
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (unsigned long long)ts.tv_sec * 1000000000ull + (unsigned long long)ts.tv_nsec;
+}
+
+/*****************************************************************************
+* NAME:  hash_path
+* DESCRIPTION: Hash a path (64-bit FNV-1a)
+* RETURNS: hash value
+******************************************************************************/
+static unsigned long long
+hash_path
+    (const char    *p_path      /* [in] NUL-terminated path */
+    )
+{
+    unsigned long long  h = FNV_OFFSET_BASIS;
+
+    while (*p_path != '\0')
+    {
+        h = (h ^ (unsigned char)*p_path++) * FNV_PRIME;
+    }
+
+    return h;
+}
+
+/*****************************************************************************
+* NAME:  is_media_name
+* DESCRIPTION: Check whether a file name has one of the watched extensions,
+*              in any case
+* RETURNS: non-zero if it does
+******************************************************************************/
+static int
+is_media_name
+    (const char    *p_name      /* [in] file name */
+    )
+{
+    size_t  length = strlen(p_name);
+    size_t  i;
+
+    for (i = 0; i < sizeof(media_extensions) / sizeof(media_extensions[0]); i++)
+    {
+        if (length > strlen(media_extensions[i])
+            && strcasecmp(p_name + length - strlen(media_extensions[i]), media_extensions[i]) == 0)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************
+* NAME:  join_path
+* DESCRIPTION: Build the path of a directory entry
+* RETURNS: new NUL-terminated path to be freed by the caller, or NULL if out
+*          of memory
+******************************************************************************/
+static char *
+join_path
+    (const char    *p_directory /* [in] directory path */
+    ,const char    *p_name      /* [in] entry name */
+    )
+{
+    size_t  directory_length = strlen(p_directory);
+    size_t  name_length = strlen(p_name);
+    char   *p_path = malloc(directory_length + name_length + 2);
+
+    if (p_path != NULL)
+    {
+        memcpy(p_path, p_directory, directory_length);
+        p_path[directory_length] = '/';
+        memcpy(p_path + directory_length + 1, p_name, name_length + 1);
+    }
+
+    return p_path;
+}
+
+/*****************************************************************************
+* NAME:  find_file
+* DESCRIPTION: Find the bucket link that points to the entry of a path
+* RETURNS: the link, which points to NULL if the path is not known
+******************************************************************************/
+static watch_file_t **
+find_file
+    (watcher_t             *watcher     /* [in] watch state */
+    ,const char            *p_path      /* [in] path */
+    ,unsigned long long     hash        /* [in] hash of p_path */
+    )
+{
+    watch_file_t  **link = &watcher->buckets[hash & (watcher->num_buckets - 1)];
+
+    while (*link != NULL && ((*link)->hash != hash || strcmp((*link)->p_path, p_path) != 0))
+    {
+        link = &(*link)->hash_next;
+    }
+
+    return link;
+}
+
+/*****************************************************************************
+* NAME:  add_file
+* DESCRIPTION: Get the entry of a path, adding an unknown one if there is
+*              none, and double the hash table when it averages one file per
+*              bucket
+* RETURNS: the entry, or NULL if out of memory
+******************************************************************************/
+static watch_file_t *
+add_file
+    (watcher_t     *watcher     /* [in,out] watch state */
+    ,const char    *p_path      /* [in] path */
+    )
+{
+    unsigned long long  hash = hash_path(p_path);
+    watch_file_t      **link = find_file(watcher, p_path, hash);
+    watch_file_t      **buckets;
+    watch_file_t       *file;
+    watch_file_t       *next;
+    size_t              path_length;
+    size_t              i;
+
+    if (*link != NULL)
+    {
+        return *link;
+    }
+
+    if (watcher->num_files >= watcher->num_buckets)
+    {
+        buckets = calloc(watcher->num_buckets * 2, sizeof(watch_file_t *));
+        if (buckets != NULL)
+        {
+            for (i = 0; i < watcher->num_buckets; i++)
+            {
+                for (file = watcher->buckets[i]; file != NULL; file = next)
+                {
+                    next = file->hash_next;
+                    file->hash_next = buckets[file->hash & (watcher->num_buckets * 2 - 1)];
+                    buckets[file->hash & (watcher->num_buckets * 2 - 1)] = file;
+                }
+            }
+            free(watcher->buckets);
+            watcher->buckets = buckets;
+            watcher->num_buckets *= 2;
+            link = find_file(watcher, p_path, hash);
+        }
+    }
+
+    path_length = strlen(p_path) + 1;
+    file = malloc(sizeof(watch_file_t) + path_length);
+    if (file == NULL)
+    {
+        return NULL;
+    }
+    memset(file, 0, sizeof(watch_file_t));
+    file->hash = hash;
+    file->p_path = (char *)(file + 1);
+    memcpy((char *)(file + 1), p_path, path_length);
+    file->generation = watcher->generation;
+    *link = file;
+    watcher->num_files++;
+
+    return file;
+}
+
+/*****************************************************************************
+* NAME:  remove_file
+* DESCRIPTION: Forget a file and free its entry
+* RETURNS: none
+******************************************************************************/
+static void
+remove_file
+    (watcher_t     *watcher     /* [in,out] watch state */
+    ,watch_file_t  *file        /* [in] entry to remove */
+    )
+{
+    watch_file_t  **link;
+
+    if (file->is_pending)
+    {
+        for (link = &watcher->pending; *link != file; link = &(*link)->pending_next)
+        {
+        }
+        *link = file->pending_next;
+    }
+    link = find_file(watcher, file->p_path, file->hash);
+    *link = file->hash_next;
+    watcher->num_files--;
+    free(file);
+}
+
+/*****************************************************************************
+* NAME:  write_record
+* DESCRIPTION: Write a change record without file output to stdout
+* RETURNS: none
+******************************************************************************/
+static void
+write_record
+    (watcher_t         *watcher     /* [in,out] watch state */
+    ,const char        *p_change    /* [in] kind of change */
+    ,const char        *p_path      /* [in] path the change is about, or NULL */
+    ,asfparse_error_t   error       /* [in] error to report, or ASFPARSE_ERROR_OK */
+    )
+{
+    output_reset(&watcher->record);
+    output_printf(&watcher->record, "{\"change\":\"%s\"", p_change);
+    if (p_path != NULL)
+    {
+        output_write(&watcher->record, ",\"file\":", 8);
+        json_write_string(&watcher->record, p_path, strlen(p_path));
+    }
+    if (error)
+    {
+        output_printf(&watcher->record, ",\"error\":{\"code\":%d,\"message\":\"%s\"}", error, asfparse_error_string(error));
+    }
+    output_write(&watcher->record, "}\n", 2);
+    output_flush(&watcher->record, STDOUT_FILENO);
+}
+
+/*****************************************************************************
+* NAME:  schedule_file
+* DESCRIPTION: Parse a file once the settle time has passed without another
+*              write to it
+* RETURNS: none
+******************************************************************************/
+static void
+schedule_file
+    (watcher_t     *watcher     /* [in,out] watch state */
+    ,const char    *p_path      /* [in] path of the file */
+    )
+{
+    watch_file_t   *file = add_file(watcher, p_path);
+
+    if (file == NULL)
+    {
+        write_record(watcher, "error", p_path, ASFPARSE_ERROR_OUT_OF_MEMORY);
+        return;
+    }
+    file->deadline = now_ns() + (unsigned long long)watcher->params->settle_ms * 1000000ull;
+    if (!file->is_pending)
+    {
+        file->is_pending = 1;
+        file->pending_next = watcher->pending;
+        watcher->pending = file;
+    }
+}
+
+/*****************************************************************************
+* NAME:  postpone_file
+* DESCRIPTION: Restart the settle time of a file waiting to be parsed
+* RETURNS: none
+******************************************************************************/
+static void
+postpone_file
+    (watcher_t     *watcher     /* [in,out] watch state */
+    ,const char    *p_path      /* [in] path of the file */
+    )
+{
+    watch_file_t   *file = *find_file(watcher, p_path, hash_path(p_path));
+
+    if (file != NULL && file->is_pending)
+    {
+        file->deadline = now_ns() + (unsigned long long)watcher->params->settle_ms * 1000000ull;
+    }
+}
+
+/*****************************************************************************
+* NAME:  forget_file
+* DESCRIPTION: Handle the removal of a file, reporting it if it was known
+* RETURNS: none
+******************************************************************************/
+static void
+forget_file
+    (watcher_t     *watcher     /* [in,out] watch state */
+    ,watch_file_t  *file        /* [in] entry of the removed file */
+    )
+{
+    if (file->is_known)
+    {
+        write_record(watcher, "removed", file->p_path, ASFPARSE_ERROR_OK);
+    }
+    remove_file(watcher, file);
+}
+
+/*****************************************************************************
+* NAME:  parse_settled
+* DESCRIPTION: Parse the pending files whose settle time has passed and
+*              whose identity changed, writing a change record for each
+* RETURNS: time (ns) until the next pending file settles, or 0 if none is
+*          pending
+******************************************************************************/
+static unsigned long long
+parse_settled
+    (watcher_t     *watcher     /* [in,out] watch state */
+    )
+{
+    unsigned long long  now = now_ns();
+    unsigned long long  wait = 0;
+    watch_file_t      **link = &watcher->pending;
+    watch_file_t       *file;
+    header_cache_key_t  key;
+
+    while (*link != NULL)
+    {
+        file = *link;
+        if (file->deadline > now)
+        {
+            if (wait == 0 || file->deadline - now < wait)
+            {
+                wait = file->deadline - now;
+            }
+            link = &file->pending_next;
+            continue;
+        }
+        *link = file->pending_next;
+        file->is_pending = 0;
+
+        if (header_cache_stat(file->p_path, &key) != ASFPARSE_ERROR_OK)
+        {
+            forget_file(watcher, file);
+            continue;
+        }
+        if (file->is_known && memcmp(&file->key, &key, sizeof(header_cache_key_t)) == 0)
+        {
+            continue;
+        }
+
+        /* the file's JSON object follows the kind of change in the same
+           record */
+        output_reset(&watcher->out);
+        process_file(file->p_path, watcher->params, watcher->ctx, &watcher->out);
+        output_reset(&watcher->record);
+        output_printf(&watcher->record, "{\"change\":\"%s\",", file->is_known ? "modified" : "added");
+        output_write(&watcher->record, watcher->out.p_data + 1, watcher->out.length - 1);
+        output_flush(&watcher->record, STDOUT_FILENO);
+
+        file->key = key;
+        file->is_known = 1;
+    }
+
+    return wait;
+}
+
+/*****************************************************************************
+* NAME:  watch_directory
+* DESCRIPTION: Add an inotify watch on a directory and remember its path
+* RETURNS: asfparse_error_t
+******************************************************************************/
+static asfparse_error_t
+watch_directory
+    (watcher_t     *watcher     /* [in,out] watch state */
+    ,const char    *p_path      /* [in] directory path */
+    )
+{
+    char  **pp_directories;
+    char   *p_copy;
+    int     wd;
+    int     num_directories;
+
+    wd = inotify_add_watch(watcher->fd, p_path, WATCH_MASK);
+    if (wd < 0)
+    {
+        return ASFPARSE_ERROR_OPEN_FILE;
+    }
+
+    if (wd >= watcher->num_directories)
+    {
+        num_directories = (watcher->num_directories > 0) ? watcher->num_directories : MIN_BUCKETS;
+        while (num_directories <= wd)
+        {
+            num_directories *= 2;
+        }
+        pp_directories = realloc(watcher->pp_directories, (size_t)num_directories * sizeof(char *));
+        if (pp_directories == NULL)
+        {
+            inotify_rm_watch(watcher->fd, wd);
+            return ASFPARSE_ERROR_OUT_OF_MEMORY;
+        }
+        memset(pp_directories + watcher->num_directories, 0,
+               (size_t)(num_directories - watcher->num_directories) * sizeof(char *));
+        watcher->pp_directories = pp_directories;
+        watcher->num_directories = num_directories;
+    }
+
+    /* a directory watched again keeps its descriptor */
+    p_copy = malloc(strlen(p_path) + 1);
+    if (p_copy == NULL)
+    {
+        inotify_rm_watch(watcher->fd, wd);
+        return ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
+    strcpy(p_copy, p_path);
+    free(watcher->pp_directories[wd]);
+    watcher->pp_directories[wd] = p_copy;
+
+    return ASFPARSE_ERROR_OK;
+}
+
+/*****************************************************************************
+* NAME:  scan_directory
+* DESCRIPTION: Watch a directory and its subdirectories and look at the
+*              media files in them. The watch is added before the directory
+*              is read, so a file written meanwhile is seen either way.
+* RETURNS: none
+******************************************************************************/
+static void
+scan_directory
+    (watcher_t     *watcher     /* [in,out] watch state */
+    ,const char    *p_path      /* [in] directory path */
+    ,int            report      /* [in] non-zero to parse new and changed files, 0 to only take note of them */
+    )
+{
+    asfparse_error_t    error;
+    DIR                *p_dir;
+    struct dirent      *p_entry;
+    struct stat         st;
+    watch_file_t       *file;
+    header_cache_key_t  key;
+    char               *p_child;
+
+    error = watch_directory(watcher, p_path);
+    if (error)
+    {
+        write_record(watcher, "error", p_path, error);
+        return;
+    }
+    p_dir = opendir(p_path);
+    if (p_dir == NULL)
+    {
+        return;
+    }
+
+    while ((p_entry = readdir(p_dir)) != NULL)
+    {
+        if (strcmp(p_entry->d_name, ".") == 0 || strcmp(p_entry->d_name, "..") == 0)
+        {
+            continue;
+        }
+        p_child = join_path(p_path, p_entry->d_name);
+        if (p_child == NULL || lstat(p_child, &st) != 0)
+        {
+            free(p_child);
+            continue;
+        }
+
+        if (S_ISDIR(st.st_mode))
+        {
+            scan_directory(watcher, p_child, report);
+        }
+        else if (S_ISREG(st.st_mode) && is_media_name(p_entry->d_name)
+                 && header_cache_stat(p_child, &key) == ASFPARSE_ERROR_OK)
+        {
+            file = add_file(watcher, p_child);
+            if (file != NULL)
+            {
+                file->generation = watcher->generation;
+                if (!report && !file->is_known)
+                {
+                    file->key = key;
+                    file->is_known = 1;
+                }
+                else if (!file->is_known || memcmp(&file->key, &key, sizeof(header_cache_key_t)) != 0)
+                {
+                    schedule_file(watcher, p_child);
+                }
+            }
+        }
+        free(p_child);
+    }
+    closedir(p_dir);
+}
+
+/*****************************************************************************
+* NAME:  drop_directory
+* DESCRIPTION: Handle the removal of a directory from the watched tree:
+*              report its media files as removed and stop watching it and
+*              its subdirectories
+* RETURNS: none
+******************************************************************************/
+static void
+drop_directory
+    (watcher_t     *watcher     /* [in,out] watch state */
+    ,const char    *p_path      /* [in] directory path */
+    )
+{
+    size_t          length = strlen(p_path);
+    watch_file_t   *file;
+    watch_file_t   *next;
+    size_t          i;
+    int             wd;
+
+    for (i = 0; i < watcher->num_buckets; i++)
+    {
+        for (file = watcher->buckets[i]; file != NULL; file = next)
+        {
+            next = file->hash_next;
+            if (strncmp(file->p_path, p_path, length) == 0 && file->p_path[length] == '/')
+            {
+                forget_file(watcher, file);
+            }
+        }
+    }
+
+    for (wd = 0; wd < watcher->num_directories; wd++)
+    {
+        if (watcher->pp_directories[wd] != NULL
+            && strncmp(watcher->pp_directories[wd], p_path, length) == 0
+            && (watcher->pp_directories[wd][length] == '/' || watcher->pp_directories[wd][length] == '\0'))
+        {
+            inotify_rm_watch(watcher->fd, wd);
+            free(watcher->pp_directories[wd]);
+            watcher->pp_directories[wd] = NULL;
+        }
+    }
+}
+
+/*****************************************************************************
+* NAME:  rescan
+* DESCRIPTION: Walk every watched tree again after inotify dropped events,
+*              parsing new and changed files and reporting those that are
+*              gone
+* RETURNS: none
+******************************************************************************/
+static void
+rescan
+    (watcher_t     *watcher     /* [in,out] watch state */
+    )
+{
+    watch_file_t   *file;
+    watch_file_t   *next;
+    size_t          i;
+    int             j;
+
+    write_record(watcher, "overflow", NULL, ASFPARSE_ERROR_OK);
+    watcher->generation++;
+    for (j = 0; j < watcher->params->num_filenames; j++)
+    {
+        scan_directory(watcher, watcher->params->pp_filenames[j], 1);
+    }
+
+    for (i = 0; i < watcher->num_buckets; i++)
+    {
+        for (file = watcher->buckets[i]; file != NULL; file = next)
+        {
+            next = file->hash_next;
+            if (file->generation != watcher->generation && !file->is_pending)
+            {
+                forget_file(watcher, file);
+            }
+        }
+    }
+}
+
+/*****************************************************************************
+* NAME:  handle_event
+* DESCRIPTION: Act on one inotify event
+* RETURNS: none
+******************************************************************************/
+static void
+handle_event
+    (watcher_t                     *watcher     /* [in,out] watch state */
+    ,const struct inotify_event    *event       /* [in] event read */
+    )
+{
+    const char     *p_directory;
+    watch_file_t   *file;
+    char           *p_path;
+
+    if (event->mask & IN_Q_OVERFLOW)
+    {
+        rescan(watcher);
+        return;
+    }
+    if (event->wd < 0 || event->wd >= watcher->num_directories || watcher->pp_directories[event->wd] == NULL)
+    {
+        return;
+    }
+    p_directory = watcher->pp_directories[event->wd];
+    if (event->mask & IN_IGNORED)
+    {
+        free(watcher->pp_directories[event->wd]);
+        watcher->pp_directories[event->wd] = NULL;
+        return;
+    }
+    if (event->len == 0 || event->name[0] == '\0')
+    {
+        return;
+    }
+
+    p_path = join_path(p_directory, event->name);
+    if (p_path == NULL)
+    {
+        write_record(watcher, "error", p_directory, ASFPARSE_ERROR_OUT_OF_MEMORY);
+        return;
+    }
+
+    /* a directory renamed within the tree is reported as removed from its
+       old place and added at the new one */
+    if (event->mask & IN_ISDIR)
+    {
+        if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+        {
+            drop_directory(watcher, p_path);
+        }
+        else if (event->mask & (IN_CREATE | IN_MOVED_TO))
+        {
+            scan_directory(watcher, p_path, 1);
+        }
+    }
+    else if (is_media_name(event->name))
+    {
+        if (event->mask & (IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO))
+        {
+            schedule_file(watcher, p_path);
+        }
+        else if (event->mask & IN_MODIFY)
+        {
+            postpone_file(watcher, p_path);
+        }
+        else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+        {
+            file = *find_file(watcher, p_path, hash_path(p_path));
+            if (file != NULL)
+            {
+                forget_file(watcher, file);
+            }
+        }
+    }
+    free(p_path);
+}
+
+/*****************************************************************************
+* NAME:  run_watch
+* DESCRIPTION: Watch the input directories and write a JSON change record
+*              for every media file added, changed or removed
+* RETURNS: asfparse_error_t; only returns if watching fails
+******************************************************************************/
+asfparse_error_t
+run_watch
+    (const params_t    *params      /* [in] structure containing user-defined parameters */
+    )
+{
+    asfparse_error_t            error = ASFPARSE_ERROR_OK;
+    watcher_t                   watcher;
+    const struct inotify_event *event;
+    struct pollfd               poll_fd;
+    struct stat                 st;
+    unsigned long long          wait;
+    char                       *p_events;
+    ssize_t                     length;
+    ssize_t                     offset;
+    watch_file_t               *file;
+    watch_file_t               *next;
+    size_t                      j;
+    int                         timeout;
+    int                         i;
+
+    for (i = 0; i < params->num_filenames; i++)
+    {
+        if (stat(params->pp_filenames[i], &st) != 0 || !S_ISDIR(st.st_mode))
+        {
+            printf("Error: %s is not a directory\n", params->pp_filenames[i]);
+            return ASFPARSE_ERROR_OPEN_FILE;
+        }
+    }
+
+    memset(&watcher, 0, sizeof(watcher_t));
+    watcher.params = params;
+    watcher.num_buckets = MIN_BUCKETS;
+    watcher.buckets = calloc(watcher.num_buckets, sizeof(watch_file_t *));
+    watcher.ctx = process_create_context(params);
+    p_events = malloc(WATCH_EVENT_BUFFER_SIZE);
+    watcher.fd = inotify_init1(IN_CLOEXEC);
+    output_init(&watcher.out);
+    output_init(&watcher.record);
+    if (watcher.buckets == NULL || watcher.ctx == NULL || p_events == NULL)
+    {
+        error = ASFPARSE_ERROR_OUT_OF_MEMORY;
+    }
+    else if (watcher.fd < 0)
+    {
+        printf("Error starting inotify\n");
+        error = ASFPARSE_ERROR_OPEN_FILE;
+    }
+
+    /* files already present are the starting point, not changes */
+    for (i = 0; error == ASFPARSE_ERROR_OK && i < params->num_filenames; i++)
+    {
+        scan_directory(&watcher, params->pp_filenames[i], 0);
+    }
+
+    poll_fd.fd = watcher.fd;
+    poll_fd.events = POLLIN;
+    while (error == ASFPARSE_ERROR_OK)
+    {
+        /* sleep until an event arrives or the next pending file settles */
+        wait = parse_settled(&watcher);
+        timeout = (wait == 0) ? -1 : (int)((wait + 999999) / 1000000);
+        if (poll(&poll_fd, 1, timeout) <= 0)
+        {
+            continue;
+        }
+
+        length = read(watcher.fd, p_events, WATCH_EVENT_BUFFER_SIZE);
+        if (length < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (length <= 0)
+        {
+            error = ASFPARSE_ERROR_OPEN_FILE;
+            break;
+        }
+        for (offset = 0; offset < length; offset += (ssize_t)(sizeof(struct inotify_event) + event->len))
+        {
+            event = (const struct inotify_event *)(p_events + offset);
+            handle_event(&watcher, event);
+        }
+    }
+
+    for (j = 0; watcher.buckets != NULL && j < watcher.num_buckets; j++)
+    {
+        for (file = watcher.buckets[j]; file != NULL; file = next)
+        {
+            next = file->hash_next;
+            free(file);
+        }
+    }
+    for (i = 0; i < watcher.num_directories; i++)
+    {
+        free(watcher.pp_directories[i]);
+    }
+    free(watcher.pp_directories);
+    free(watcher.buckets);
+    output_free(&watcher.out);
+    output_free(&watcher.record);
+    if (watcher.fd >= 0)
+    {
+        close(watcher.fd);
+    }
+    free(p_events);
+    asfparse_destroy(watcher.ctx);
+
+    return error;
+}
@@ -0,0 +1,28 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+/* Includes */
+#include "cli.h"
+
+/* Defines and constants */
+#define WATCH_DEFAULT_SETTLE_MS (1000)          /* quiet time after the last write before a file is parsed */
+#define WATCH_MAX_SETTLE_MS     (3600000)       /* longest settle time accepted */
+#define WATCH_EVENT_BUFFER_SIZE (64 * 1024)     /* bytes of inotify events read at a time */
+
+/* Function prototypes */
+/*****************************************************************************
+* NAME:  run_watch
+* DESCRIPTION: Watch the input directories and their subdirectories, and
+*              each time an .asf, .wmv or .wma file is added, changed or
+*              removed, write one JSON change record to stdout. A file is
+*              parsed once no write to it has been seen for the settle time
+*              and only if its device, inode, size or modification time
+*              changed. Files present when watching starts are not reported.
+* RETURNS: asfparse_error_t; only returns if watching fails
+******************************************************************************/
+asfparse_error_t
+run_watch
+    (const params_t    *params      /* [in] structure containing user-defined parameters */
+    );
+
+#endif